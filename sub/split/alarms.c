@@ -0,0 +1,211 @@
+#include "alarms.h"
+#include <string.h>
+
+#define QUEUE_MASK (ALARM_QUEUE_CAPACITY - 1)
+
+typedef struct
+{
+  const char *name;
+  int sense;
+  float warning;
+  float critical;
+  float hysteresis;
+} AlarmChannelInfo;
+
+static const AlarmChannelInfo channels[ALARM_CHANNEL_COUNT] = {
+#define ALARM_INFO(name, label, sense, warning, critical, hysteresis) {label, sense, warning, critical, hysteresis},
+    ALARM_CHANNELS(ALARM_INFO)
+#undef ALARM_INFO
+};
+
+// Banner per channel and level (warning, critical, casualty), given the reading
+static const char *const banners[ALARM_CHANNEL_COUNT][3] = {
+    [ALARM_REACTOR] = {"*** REACTOR OVERHEATING: %.0f°C *** REDUCE POWER ***",
+                       "*** REACTOR CRITICAL: %.0f°C *** EMERGENCY COOLING REQUIRED ***",
+                       "*** REACTOR CORE MELTDOWN *** ABANDON SHIP *** REACTOR CORE MELTDOWN ***"},
+    [ALARM_HULL] = {"*** HULL DAMAGE: %.1f%% *** REDUCE DEPTH ***",
+                    "*** HULL BREACH IMMINENT *** EMERGENCY SURFACE *** HULL BREACH IMMINENT ***"},
+    [ALARM_OXYGEN] = {"*** LOW OXYGEN: %.1f%% *** ACTIVATE LIFE SUPPORT ***",
+                      "*** OXYGEN CRITICAL *** EMERGENCY SURFACE *** OXYGEN CRITICAL ***"},
+    [ALARM_POWER] = {"*** LOW POWER: %.1f%% *** START REACTOR ***",
+                     "*** TOTAL POWER FAILURE *** ACTIVATE BACKUP POWER ***"},
+    [ALARM_DEPTH] = {"*** APPROACHING CRUSH DEPTH: %.0fm ***",
+                     "*** CRUSH DEPTH EXCEEDED *** EMERGENCY BALLAST BLOW ***"},
+};
+
+static const char *const levelNames[ALARM_LEVEL_COUNT] = {"normal", "WARNING", "CRITICAL", "CASUALTY"};
+
+static float alarmReading(AlarmChannel channel, const SubmarineState *sub)
+{
+  switch (channel)
+  {
+  case ALARM_REACTOR:
+    return sub->reactor_temp;
+  case ALARM_HULL:
+    return sub->hull_integrity;
+  case ALARM_OXYGEN:
+    return sub->oxygen;
+  case ALARM_POWER:
+    return sub->battery_level;
+  case ALARM_DEPTH:
+    return sub->depth;
+  default:
+    return 0.0f;
+  }
+}
+
+// A level holds until the reading is back past its threshold by the hysteresis
+static AlarmLevel thresholdLevel(const AlarmChannelInfo *info, float value, AlarmLevel current)
+{
+  float worse = info->sense * value; // Bigger is worse on every channel
+  float critical = info->sense * info->critical;
+  float warning = info->sense * info->warning;
+
+  if (worse > critical || (current >= ALARM_CRITICAL && worse > critical - info->hysteresis))
+    return ALARM_CRITICAL;
+  if (worse > warning || (current >= ALARM_WARNING && worse > warning - info->hysteresis))
+    return ALARM_WARNING;
+  return ALARM_NORMAL;
+}
+
+void initAlarmMonitor(AlarmMonitor *monitor)
+{
+  memset(monitor, 0, sizeof(*monitor));
+}
+
+int alarmMonitorUpdate(AlarmMonitor *monitor, const SubmarineState *sub, uint64_t tick, AlarmEvent *out)
+{
+  int count = 0;
+  for (int c = 0; c < ALARM_CHANNEL_COUNT; c++)
+  {
+    AlarmLevel current = monitor->level[c];
+    float value = alarmReading(c, sub);
+
+    AlarmLevel level;
+    if (c == ALARM_REACTOR && systemOn(sub, SYS_REACTOR_DESTROYED))
+      level = ALARM_CASUALTY;
+    else if (c == ALARM_POWER && systemOn(sub, SYS_BACKUP_POWER))
+      level = ALARM_NORMAL;
+    else
+      level = thresholdLevel(&channels[c], value, current);
+
+    if (level != current)
+    {
+      out[count++] = (AlarmEvent){tick, (uint8_t)c, (uint8_t)level, (uint8_t)current, value};
+      monitor->level[c] = (uint8_t)level;
+    }
+  }
+  return count;
+}
+
+bool alarmQueuePush(AlarmQueue *queue, const AlarmEvent *event)
+{
+  uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+  uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+  if (tail - head == ALARM_QUEUE_CAPACITY)
+    return false;
+
+  queue->slots[tail & QUEUE_MASK] = *event;
+  __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool alarmQueuePop(AlarmQueue *queue, AlarmEvent *out)
+{
+  uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+  uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+  if (head == tail)
+    return false;
+
+  *out = queue->slots[head & QUEUE_MASK];
+  __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+const char *alarmChannelName(AlarmChannel channel)
+{
+  return channel < ALARM_CHANNEL_COUNT ? channels[channel].name : "?";
+}
+
+const char *alarmLevelName(AlarmLevel level)
+{
+  return level < ALARM_LEVEL_COUNT ? levelNames[level] : "?";
+}
+
+int alarmClockStamp(uint64_t tick, char *out, size_t size)
+{
+  uint64_t seconds = (uint64_t)(tick * SIM_TICK_DT);
+  return snprintf(out, size, "[%02llu:%02llu:%02llu]", (unsigned long long)(seconds / 3600),
+                  (unsigned long long)(seconds / 60 % 60), (unsigned long long)(seconds % 60));
+}
+
+void alarmEventLine(const AlarmEvent *event, char *out, size_t size)
+{
+  int n = alarmClockStamp(event->tick, out, size);
+  snprintf(out + n, size - n, " %s %s -> %s at %.1f", alarmChannelName(event->channel),
+           alarmLevelName(event->previous), alarmLevelName(event->level), event->value);
+}
+
+void initAlarmBoard(AlarmBoard *board)
+{
+  memset(board, 0, sizeof(*board));
+}
+
+static char *nextLogLine(AlarmBoard *board)
+{
+  return board->log[board->log_count++ % ALARM_LOG_SIZE];
+}
+
+static void countUnacknowledged(AlarmBoard *board)
+{
+  board->unacknowledged = 0;
+  for (int c = 0; c < ALARM_CHANNEL_COUNT; c++)
+    board->unacknowledged += board->active[c].level != ALARM_NORMAL && !board->active[c].acknowledged;
+}
+
+void alarmBoardApply(AlarmBoard *board, const AlarmEvent *event)
+{
+  if (event->channel >= ALARM_CHANNEL_COUNT)
+    return;
+
+  AlarmEntry *entry = &board->active[event->channel];
+  AlarmLevel level = event->level < ALARM_LEVEL_COUNT ? event->level : ALARM_CASUALTY;
+  if (level == ALARM_NORMAL)
+  {
+    entry->level = ALARM_NORMAL;
+    entry->text[0] = '\0';
+  }
+  else
+  {
+    // Anything worse than what was acknowledged needs acknowledging again
+    if (level > entry->level)
+    {
+      entry->acknowledged = false;
+      entry->raised_tick = event->tick;
+    }
+    entry->level = level;
+    const char *banner = banners[event->channel][level - ALARM_WARNING];
+    if (!banner)
+      banner = banners[event->channel][ALARM_CRITICAL - ALARM_WARNING];
+    snprintf(entry->text, sizeof(entry->text), banner, event->value);
+  }
+
+  alarmEventLine(event, nextLogLine(board), ALARM_TEXT_LENGTH);
+  countUnacknowledged(board);
+}
+
+int alarmBoardAcknowledge(AlarmBoard *board, uint64_t tick)
+{
+  int waiting = board->unacknowledged;
+  if (waiting == 0)
+    return 0;
+
+  for (int c = 0; c < ALARM_CHANNEL_COUNT; c++)
+    board->active[c].acknowledged = true;
+  board->unacknowledged = 0;
+
+  char *line = nextLogLine(board);
+  int n = alarmClockStamp(tick, line, ALARM_TEXT_LENGTH);
+  snprintf(line + n, ALARM_TEXT_LENGTH - n, " %d alarm%s acknowledged", waiting, waiting == 1 ? "" : "s");
+  return waiting;
+}
@@ -0,0 +1,122 @@
+#ifndef ALARMS_H
+#define ALARMS_H
+
+#include "constants.h"
+
+// Alarms as events. The sim thread checks each channel once per step against
+// its thresholds and emits an AlarmEvent only when the level changes; a level
+// is left again only once the value has recovered by the channel's hysteresis,
+// so a reading sitting on a threshold doesn't chatter. Events cross to the
+// render thread through a single-producer/single-consumer ring and land on an
+// AlarmBoard: the standing alarms with their banner text (formatted once, when
+// raised), whether the operator has acknowledged them, and a log of every
+// change for review after the watch.
+
+typedef enum
+{
+  ALARM_NORMAL,
+  ALARM_WARNING,
+  ALARM_CRITICAL,
+  ALARM_CASUALTY, // Beyond recovery - reactor destroyed
+  ALARM_LEVEL_COUNT
+} AlarmLevel;
+
+// name, label, sense (+1 alarms above the thresholds, -1 below), warning, critical, hysteresis
+#define ALARM_CHANNELS(X)                                                                             \
+  X(REACTOR, "REACTOR", 1, REACTOR_WARNING_TEMP, REACTOR_CRITICAL_TEMP, 5.0f) /* °C */                 \
+  X(HULL, "HULL", -1, 50.0f, 25.0f, 2.0f)                                     /* % integrity */        \
+  X(OXYGEN, "OXYGEN", -1, 30.0f, 15.0f, 1.0f)                                 /* % */                  \
+  X(POWER, "POWER", -1, 15.0f, 5.0f, 1.0f)                /* % battery, quiet on backup power */       \
+  X(DEPTH, "DEPTH", 1, REALISTIC_CRUSH_DEPTH * 0.8f, REALISTIC_CRUSH_DEPTH, 20.0f) /* m */
+
+typedef enum
+{
+#define ALARM_ENUM(name, label, sense, warning, critical, hysteresis) ALARM_##name,
+  ALARM_CHANNELS(ALARM_ENUM)
+#undef ALARM_ENUM
+  ALARM_CHANNEL_COUNT
+} AlarmChannel;
+
+typedef struct
+{
+  uint64_t tick;     // Sim tick the change was seen on
+  uint8_t channel;   // AlarmChannel
+  uint8_t level;     // AlarmLevel, new
+  uint8_t previous;  // AlarmLevel, before
+  float value;       // Channel reading at the change
+} AlarmEvent;
+
+// Sim side: the level each channel is standing at
+typedef struct
+{
+  uint8_t level[ALARM_CHANNEL_COUNT];
+} AlarmMonitor;
+
+#define ALARM_QUEUE_CAPACITY 64 // Power of two; every channel changing twice a frame still fits
+
+typedef struct
+{
+  AlarmEvent slots[ALARM_QUEUE_CAPACITY];
+  uint32_t head __attribute__((aligned(64))); // Next to pop, written by the render thread
+  uint32_t tail __attribute__((aligned(64))); // Next to push, written by the sim thread
+} AlarmQueue;
+
+#define ALARM_TEXT_LENGTH 96
+#define ALARM_LOG_SIZE 128 // Newest kept on the board; alarms.log keeps the lot
+
+typedef struct
+{
+  AlarmLevel level;
+  bool acknowledged;
+  uint64_t raised_tick;
+  char text[ALARM_TEXT_LENGTH]; // Banner, with the reading at the time it was raised
+} AlarmEntry;
+
+// Render side
+typedef struct AlarmBoard
+{
+  AlarmEntry active[ALARM_CHANNEL_COUNT];
+  char log[ALARM_LOG_SIZE][ALARM_TEXT_LENGTH]; // Ring, oldest overwritten
+  uint32_t log_count;                          // Lines ever written
+  int unacknowledged;
+} AlarmBoard;
+
+void initAlarmMonitor(AlarmMonitor *monitor);
+
+// Checks every channel, writes the changes to out (at most
+// ALARM_CHANNEL_COUNT) and returns how many there were
+int alarmMonitorUpdate(AlarmMonitor *monitor, const SubmarineState *sub, uint64_t tick, AlarmEvent *out);
+
+// False when the ring is full (the event is dropped)
+bool alarmQueuePush(AlarmQueue *queue, const AlarmEvent *event);
+bool alarmQueuePop(AlarmQueue *queue, AlarmEvent *out);
+
+const char *alarmChannelName(AlarmChannel channel);
+const char *alarmLevelName(AlarmLevel level);
+
+// "[hh:mm:ss]" of sim time, returns its length
+int alarmClockStamp(uint64_t tick, char *out, size_t size);
+
+// One line for the log: time, channel, transition and reading
+void alarmEventLine(const AlarmEvent *event, char *out, size_t size);
+
+void initAlarmBoard(AlarmBoard *board);
+void alarmBoardApply(AlarmBoard *board, const AlarmEvent *event);
+
+// Marks every standing alarm acknowledged and logs it; returns how many were waiting
+int alarmBoardAcknowledge(AlarmBoard *board, uint64_t tick);
+
+// i-th newest log line, i < MIN(log_count, ALARM_LOG_SIZE)
+static inline const char *alarmBoardLogLine(const AlarmBoard *board, uint32_t i)
+{
+  return board->log[(board->log_count - 1 - i) % ALARM_LOG_SIZE];
+}
+
+#ifndef SUB_HEADLESS
+// Banners for the standing alarms across the top, unacknowledged ones flashing (renderer.c)
+void drawTopAlarmBanners(const AlarmBoard *board, RenderState *view);
+// The newest log lines in a panel at x, y (renderer.c)
+void renderAlarmLog(const AlarmBoard *board, int x, int y, int lines);
+#endif
+
+#endif
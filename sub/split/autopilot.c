@@ -0,0 +1,243 @@
+#define _POSIX_C_SOURCE 200112L
+#include "autopilot.h"
+#include <string.h>
+#include <time.h>
+
+#define ROLLOUT_DT (AUTOPILOT_ROLLOUT_TICKS * SIM_TICK_DT)
+#define ROLLOUT_STEPS ((int)(AUTOPILOT_HORIZON * SIM_TICK_RATE) / AUTOPILOT_ROLLOUT_TICKS)
+
+// Short segments up front where precision matters, long ones out at the horizon
+static const float segmentStarts[AUTOPILOT_SEGMENTS] = {0.0f, 1.0f, 2.0f, 4.0f, 8.0f, 16.0f};
+
+// Cost weights, per second flown. Depth error is the point; a 1 m/s climb
+// rate costs like 0.7 m of error, full shaft like 3 m, full planes like 3 m.
+#define COST_VERTICAL_SPEED 0.5f
+#define COST_THRUST 0.001f
+#define COST_TRIM 0.01f
+#define COST_HULL 1000.0f // Per % of hull lost over the horizon
+
+// Random perturbation around the warm start, scaled per candidate
+#define NOISE_BALLAST 8.0f
+#define NOISE_TRIM 4.0f
+#define NOISE_THRUST 25.0f
+
+typedef struct
+{
+  const SubmarineState *start;
+  const AutopilotPlan *plans;
+  float *costs;
+} RolloutJob;
+
+void initPredictiveAutopilot(PredictiveAutopilot *pilot, ThreadPool *pool, int candidates)
+{
+  memset(pilot, 0, sizeof(*pilot));
+  pilot->pool = pool;
+  pilot->candidates = MAX(4 * AUTOPILOT_ROUNDS, MIN(AUTOPILOT_MAX_CANDIDATES, candidates));
+  pilot->rng_state = 0x2545F491u;
+}
+
+static int segmentAt(float seconds)
+{
+  int s = 0;
+  while (s + 1 < AUTOPILOT_SEGMENTS && seconds >= segmentStarts[s + 1])
+    s++;
+  return s;
+}
+
+// Commands that move the boat's setpoints to sp (only the ones that differ)
+static int setpointCommands(const SubmarineState *sub, const AutopilotSetpoint *sp, SubmarineCommand out[3])
+{
+  int n = 0;
+  if (sub->autopilot_ballast != sp->ballast)
+    out[n++] = (SubmarineCommand){CMD_AUTOPILOT_BALLAST, sp->ballast};
+  if (sub->autopilot_trim != sp->trim)
+    out[n++] = (SubmarineCommand){CMD_AUTOPILOT_TRIM, sp->trim};
+  if (sub->autopilot_thrust != sp->thrust)
+    out[n++] = (SubmarineCommand){CMD_AUTOPILOT_THRUST, sp->thrust};
+  return n;
+}
+
+float autopilotRolloutCost(const SubmarineState *start, const AutopilotPlan *plan)
+{
+  SubmarineState sim = *start;
+  float cost = 0.0f;
+  int segment = -1;
+
+  for (int step = 0; step < ROLLOUT_STEPS; step++)
+  {
+    // Setpoints change through the same commands the real boat gets
+    int now = segmentAt(step * ROLLOUT_DT);
+    if (now != segment)
+    {
+      segment = now;
+      SubmarineCommand cmds[3];
+      int count = setpointCommands(&sim, &plan->segments[segment], cmds);
+      for (int c = 0; c < count; c++)
+        applySubmarineCommand(&sim, cmds[c]);
+    }
+
+    updateSubmarineState(&sim, ROLLOUT_DT);
+
+    float error = sim.depth - sim.target_depth;
+    cost += (error * error + COST_VERTICAL_SPEED * sim.vertical_speed * sim.vertical_speed +
+             COST_THRUST * sim.thrust * sim.thrust + COST_TRIM * sim.trim_angle * sim.trim_angle) *
+            ROLLOUT_DT;
+  }
+
+  cost += COST_HULL * MAX(0.0f, start->hull_integrity - sim.hull_integrity);
+  return cost / AUTOPILOT_HORIZON;
+}
+
+static void rolloutJob(int index, void *ctx)
+{
+  RolloutJob *job = ctx;
+  job->costs[index] = autopilotRolloutCost(job->start, &job->plans[index]);
+}
+
+// Uniform in [-1, 1), xorshift like the model's own stream
+static float randomUnit(unsigned int *state)
+{
+  unsigned int x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return (x >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+static AutopilotSetpoint clampSetpoint(AutopilotSetpoint sp)
+{
+  return (AutopilotSetpoint){
+      MAX(0.0f, MIN(100.0f, sp.ballast)),
+      MAX(-30.0f, MIN(30.0f, sp.trim)),
+      MAX(-100.0f, MIN(100.0f, sp.thrust)),
+  };
+}
+
+// Perturb a whole plan: one offset shared by every segment (a different
+// trim point) plus a smaller independent wobble per segment
+static AutopilotPlan perturbPlan(const AutopilotPlan *base, float scale, unsigned int *rng)
+{
+  AutopilotSetpoint shift = {
+      NOISE_BALLAST * scale * randomUnit(rng),
+      NOISE_TRIM * scale * randomUnit(rng),
+      NOISE_THRUST * scale * randomUnit(rng),
+  };
+  AutopilotPlan out;
+  for (int s = 0; s < AUTOPILOT_SEGMENTS; s++)
+  {
+    AutopilotSetpoint sp = base->segments[s];
+    sp.ballast += shift.ballast + 0.5f * NOISE_BALLAST * scale * randomUnit(rng);
+    sp.trim += shift.trim + 0.5f * NOISE_TRIM * scale * randomUnit(rng);
+    sp.thrust += shift.thrust + 0.5f * NOISE_THRUST * scale * randomUnit(rng);
+    out.segments[s] = clampSetpoint(sp);
+  }
+  return out;
+}
+
+// First round: the last plan moved on to now (or a hold of the current
+// setpoints), a plain hold, some constant setpoints from anywhere in the
+// control range and perturbations of the first. Later rounds only perturb
+// the best plan so far, each with half the spread of the one before.
+static void generateCandidates(PredictiveAutopilot *pilot, const SubmarineState *sub, uint64_t tick, int round,
+                               const AutopilotPlan *best, AutopilotPlan *plans, int count)
+{
+  float scale = 1.0f / (float)(1 << round);
+  int c = 0;
+
+  if (round == 0)
+  {
+    AutopilotSetpoint hold = {sub->autopilot_ballast, sub->autopilot_trim, sub->autopilot_thrust};
+    float elapsed = (float)(tick - pilot->plan_tick) * SIM_TICK_DT;
+    for (int s = 0; s < AUTOPILOT_SEGMENTS; s++)
+    {
+      plans[0].segments[s] = pilot->planned ? pilot->plan.segments[segmentAt(segmentStarts[s] + elapsed)] : hold;
+      plans[1].segments[s] = hold;
+    }
+    best = &plans[0];
+    c = 2;
+
+    // Manoeuvres: tanks anywhere for the first few seconds, then back on the warm plan
+    for (int manoeuvres = count / 4; manoeuvres > 0 && c < count; manoeuvres--, c++)
+    {
+      plans[c] = plans[0];
+      for (int s = 0; s < 4; s++)
+        plans[c].segments[s].ballast = 50.0f + 50.0f * randomUnit(&pilot->rng_state);
+    }
+
+    // Whole new trim points
+    for (int roaming = count / 8; roaming > 0 && c < count; roaming--, c++)
+    {
+      AutopilotSetpoint sp = {
+          50.0f + 50.0f * randomUnit(&pilot->rng_state),
+          30.0f * randomUnit(&pilot->rng_state),
+          100.0f * randomUnit(&pilot->rng_state),
+      };
+      for (int s = 0; s < AUTOPILOT_SEGMENTS; s++)
+        plans[c].segments[s] = sp;
+    }
+  }
+
+  for (; c < count; c++)
+    plans[c] = perturbPlan(best, scale * fabsf(randomUnit(&pilot->rng_state)), &pilot->rng_state);
+}
+
+static void planAhead(PredictiveAutopilot *pilot, const SubmarineState *sub, uint64_t tick)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  // Rounds of candidates, each one searching closer around the best so far
+  int per_round = pilot->candidates / AUTOPILOT_ROUNDS;
+  int best = 0;
+  for (int round = 0; round < AUTOPILOT_ROUNDS; round++)
+  {
+    AutopilotPlan *plans = pilot->scratch + round * per_round;
+    float *costs = pilot->costs + round * per_round;
+    generateCandidates(pilot, sub, tick, round, &pilot->scratch[best], plans, per_round);
+
+    RolloutJob job = {sub, plans, costs};
+    if (pilot->pool)
+      threadPoolParallelFor(pilot->pool, per_round, rolloutJob, &job);
+    else
+      for (int c = 0; c < per_round; c++)
+        rolloutJob(c, &job);
+
+    // Lowest index wins ties, so the choice doesn't depend on thread timing
+    for (int c = round * per_round; c < (round + 1) * per_round; c++)
+    {
+      if (pilot->costs[c] < pilot->costs[best])
+        best = c;
+    }
+  }
+
+  pilot->plan = pilot->scratch[best];
+  pilot->cost = pilot->costs[best];
+  pilot->plan_tick = tick;
+  pilot->planned = true;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  pilot->plans++;
+  pilot->rollouts += per_round * AUTOPILOT_ROUNDS;
+  pilot->rollout_steps += (uint64_t)per_round * AUTOPILOT_ROUNDS * ROLLOUT_STEPS;
+  pilot->plan_seconds += (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+int predictiveAutopilotUpdate(PredictiveAutopilot *pilot, const SubmarineState *sub, uint64_t tick,
+                              SubmarineCommand out[3])
+{
+  if (!systemOn(sub, SYS_AUTOPILOT) || !systemOn(sub, SYS_AUTOPILOT_PREDICTIVE))
+  {
+    pilot->planned = false;
+    return 0;
+  }
+
+  // The clock went backwards (quick-load) - the old plan means nothing now
+  if (tick < pilot->plan_tick)
+    pilot->planned = false;
+  if (!pilot->planned || tick - pilot->plan_tick >= AUTOPILOT_REPLAN_TICKS)
+    planAhead(pilot, sub, tick);
+
+  float elapsed = (float)(tick - pilot->plan_tick) * SIM_TICK_DT;
+  return setpointCommands(sub, &pilot->plan.segments[segmentAt(elapsed)], out);
+}
@@ -0,0 +1,69 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include "constants.h"
+#include "threadpool.h"
+
+// Model-predictive depth autopilot. Every AUTOPILOT_REPLAN_TICKS it forks the
+// boat's state, flies a few hundred candidate setpoint schedules (tank level,
+// planes, shaft) a minute ahead through the real model on the thread pool and
+// keeps the cheapest. Only the start of each plan is ever flown - the next
+// plan begins from wherever the boat actually got to, so flooding, narcosis
+// or a dead gyro are corrected for as they happen.
+//
+// The chosen setpoints leave as CMD_AUTOPILOT_* commands: they go through the
+// journal like any other input, and replays never re-run the planner.
+
+#define AUTOPILOT_SEGMENTS 6        // Setpoint changes per plan (starts at 0, 1, 2, 4, 8, 16 s)
+#define AUTOPILOT_HORIZON 60.0f     // Seconds every candidate is flown
+#define AUTOPILOT_ROLLOUT_TICKS 6   // Model ticks per rollout step (20 Hz)
+#define AUTOPILOT_REPLAN_TICKS 120  // Plan once a sim second
+#define AUTOPILOT_ROUNDS 8  // Candidates are flown in rounds, each searching closer around the best
+#define AUTOPILOT_DEFAULT_CANDIDATES 256
+#define AUTOPILOT_MAX_CANDIDATES 1024
+
+typedef struct
+{
+  float ballast; // Tank level %
+  float trim;    // Planes, degrees
+  float thrust;  // Shaft %
+} AutopilotSetpoint;
+
+typedef struct
+{
+  AutopilotSetpoint segments[AUTOPILOT_SEGMENTS];
+} AutopilotPlan;
+
+typedef struct
+{
+  ThreadPool *pool; // NULL flies every rollout on the calling thread
+  int candidates;
+
+  AutopilotPlan plan; // Best plan, segment 0 starts at plan_tick
+  uint64_t plan_tick;
+  bool planned;       // plan belongs to the current engagement
+  float cost;         // Mean cost per second of the plan (~ squared depth error)
+  unsigned int rng_state;
+
+  // Candidate scratch for the pool jobs
+  AutopilotPlan scratch[AUTOPILOT_MAX_CANDIDATES];
+  float costs[AUTOPILOT_MAX_CANDIDATES];
+
+  // Counters since init
+  uint64_t plans;
+  uint64_t rollouts;
+  uint64_t rollout_steps; // updateSubmarineState calls inside rollouts
+  double plan_seconds;    // Wall time spent planning
+} PredictiveAutopilot;
+
+void initPredictiveAutopilot(PredictiveAutopilot *pilot, ThreadPool *pool, int candidates);
+
+// Setpoint commands to issue before this tick (at most 3), planning first
+// when a plan is due. Returns 0 while the boat isn't in predictive mode.
+int predictiveAutopilotUpdate(PredictiveAutopilot *pilot, const SubmarineState *sub, uint64_t tick,
+                              SubmarineCommand out[3]);
+
+// Fly one plan from this state for AUTOPILOT_HORIZON and score it
+float autopilotRolloutCost(const SubmarineState *start, const AutopilotPlan *plan);
+
+#endif
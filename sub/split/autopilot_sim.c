@@ -0,0 +1,190 @@
+// Depth-holding shoot-out - flies the same cracked, flooding boat once on the
+// PID autopilot and once on the predictive one (autopilot.h), then reports how
+// tightly each held depth and how many rollouts per second the planner got.
+//
+//   ./sub_autopilot [-c candidates] [-j threads] [-t seconds] [-d depth] [-H hull] [-S step] [-B seabed_seed] [-o out.csv]
+//
+// The target steps down by -S meters halfway through. -B flies over the
+// seabed the game uses (every rollout tick then queries the bottom), so the
+// rollout rate can be compared with open ocean. The CSV has one row per
+// sim second and controller; the summary goes to stderr.
+
+#define _GNU_SOURCE
+#include "autopilot.h"
+#include "seabed.h"
+#include <string.h>
+#include <time.h>
+
+typedef struct
+{
+  const char *name;
+  double error_squares; // Sum over ticks, for the RMS
+  float max_error;
+  float final_hull;
+  long ticks;
+  double seconds;
+} FlightSummary;
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-c candidates] [-j threads] [-t seconds] [-d depth] [-H hull] [-S step] [-B seabed_seed] [-o out.csv]\n"
+          "  -c  candidate plans per replan (default %d, max %d)\n"
+          "  -j  planner threads (default one per core)\n"
+          "  -t  sim seconds per flight (default 300)\n"
+          "  -d  depth to hold in meters (default 400)\n"
+          "  -H  starting hull integrity, below 50 floods (default 20)\n"
+          "  -S  target step halfway through in meters (default 100)\n"
+          "  -B  seabed seed to fly over, 0 = open ocean (default 0, the game uses %d)\n"
+          "  -o  write the CSV here instead of stdout\n",
+          prog, AUTOPILOT_DEFAULT_CANDIDATES, AUTOPILOT_MAX_CANDIDATES, SEABED_SEED);
+}
+
+// Backup power, life support, a normal reactor start and the whole nav panel, settled
+static SubmarineState cruisingBoat(float depth, float hull)
+{
+  static const SubmarineCommandType startup[] = {
+      CMD_BACKUP_POWER, CMD_AIR_CIRCULATION, CMD_CO2_SCRUBBERS, CMD_O2_GENERATOR, CMD_MAIN_O2_SYSTEM,
+      CMD_COOLANT_PUMPS, CMD_STEAM_GENERATOR, CMD_POWER_TURBINE, CMD_CONTAINMENT, CMD_CONTROL_RODS,
+      CMD_MAIN_REACTOR, CMD_COOLING, CMD_GYROSCOPE, CMD_NAV_COMPUTER, CMD_DEPTH_CONTROL,
+      CMD_BALLAST_CONTROL, CMD_COMMUNICATIONS};
+  SubmarineState sub = initSubmarine();
+  for (size_t i = 0; i < sizeof(startup) / sizeof(startup[0]); i++)
+    applySubmarineCommand(&sub, (SubmarineCommand){startup[i], 0.0f});
+  for (int t = 0; t < 300 * (int)SIM_TICK_RATE; t++)
+    updateSubmarineState(&sub, SIM_TICK_DT);
+
+  sub.depth = depth;
+  sub.vertical_speed = 0.0f;
+  sub.ballast_level = 50.0f; // Neutral before the flooding starts
+  sub.hull_integrity = hull;
+  return sub;
+}
+
+static FlightSummary fly(const char *name, SubmarineState sub, SubmarineCommandType engage, PredictiveAutopilot *pilot,
+                         float seconds, float step, FILE *out)
+{
+  FlightSummary summary = {.name = name};
+  applySubmarineCommand(&sub, (SubmarineCommand){engage, 0.0f});
+  float target = sub.target_depth;
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  long ticks = (long)(seconds * SIM_TICK_RATE);
+  for (long t = 0; t < ticks; t++)
+  {
+    if (t == ticks / 2)
+      applySubmarineCommand(&sub, (SubmarineCommand){CMD_TARGET_DEPTH, target + step});
+
+    SubmarineCommand cmds[3];
+    int count = pilot ? predictiveAutopilotUpdate(pilot, &sub, (uint64_t)t, cmds) : 0;
+    for (int c = 0; c < count; c++)
+      applySubmarineCommand(&sub, cmds[c]);
+
+    updateSubmarineState(&sub, SIM_TICK_DT);
+
+    float error = sub.depth - sub.target_depth;
+    summary.error_squares += (double)error * error;
+    summary.max_error = MAX(summary.max_error, fabsf(error));
+
+    if ((t + 1) % (int)SIM_TICK_RATE == 0)
+      fprintf(out, "%s,%.0f,%.2f,%.0f,%.2f,%.2f,%.2f,%.2f,%.2f\n", name, (t + 1) * SIM_TICK_DT, sub.depth,
+              sub.target_depth, error, sub.vertical_speed, sub.ballast_level, sub.trim_angle, sub.thrust);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  summary.seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+  summary.ticks = ticks;
+  summary.final_hull = sub.hull_integrity;
+  return summary;
+}
+
+static void printSummary(const FlightSummary *s)
+{
+  fprintf(stderr, "%-10s rms error %7.2f m  max %7.2f m  hull %5.1f  %.2fs wall\n", s->name,
+          sqrt(s->error_squares / MAX(1, s->ticks)), s->max_error, s->final_hull, s->seconds);
+}
+
+int main(int argc, char **argv)
+{
+  int candidates = AUTOPILOT_DEFAULT_CANDIDATES;
+  int threads = 0;
+  float seconds = 300.0f;
+  float depth = 400.0f;
+  float hull = 20.0f;
+  float step = 100.0f;
+  unsigned int seabed_seed = 0;
+  const char *out_path = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (strcmp(arg, "-c") == 0 && has_value)
+      candidates = atoi(argv[++i]);
+    else if (strcmp(arg, "-j") == 0 && has_value)
+      threads = atoi(argv[++i]);
+    else if (strcmp(arg, "-t") == 0 && has_value)
+      seconds = strtof(argv[++i], NULL);
+    else if (strcmp(arg, "-d") == 0 && has_value)
+      depth = strtof(argv[++i], NULL);
+    else if (strcmp(arg, "-H") == 0 && has_value)
+      hull = strtof(argv[++i], NULL);
+    else if (strcmp(arg, "-S") == 0 && has_value)
+      step = strtof(argv[++i], NULL);
+    else if (strcmp(arg, "-B") == 0 && has_value)
+      seabed_seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else if (strcmp(arg, "-o") == 0 && has_value)
+      out_path = argv[++i];
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  FILE *out = out_path ? fopen(out_path, "w") : stdout;
+  if (!out)
+  {
+    perror(out_path);
+    return 1;
+  }
+
+  // Tiles load on the first query that misses them - the boat hardly moves sideways
+  if (seabed_seed)
+    seabedTerrain = seabedCreate(seabed_seed, 0);
+  SubmarineState boat = cruisingBoat(MAX(0.0f, MIN(MAX_DEPTH, depth)), MAX(0.0f, MIN(100.0f, hull)));
+
+  // The planner's state is ~80 KB of candidate scratch, keep it off the stack
+  static PredictiveAutopilot pilot;
+  ThreadPool *pool = threadPoolCreate(threads);
+  initPredictiveAutopilot(&pilot, pool, candidates);
+
+  fprintf(out, "controller,time,depth,target,error,vertical_speed,ballast,trim,thrust\n");
+  FlightSummary pid = fly("pid", boat, CMD_AUTOPILOT, NULL, seconds, step, out);
+  FlightSummary mpc = fly("predictive", boat, CMD_PREDICTIVE_AUTOPILOT, &pilot, seconds, step, out);
+
+  printSummary(&pid);
+  printSummary(&mpc);
+  fprintf(stderr, "planner: %llu plans x %d candidates on %d threads, %.1f ms/plan, %.0f rollouts/s, %.2f M model steps/s\n",
+          (unsigned long long)pilot.plans, pilot.candidates, threadPoolWorkerCount(pool),
+          pilot.plans ? pilot.plan_seconds * 1000.0 / pilot.plans : 0.0,
+          pilot.plan_seconds > 0 ? pilot.rollouts / pilot.plan_seconds : 0.0,
+          pilot.plan_seconds > 0 ? pilot.rollout_steps / pilot.plan_seconds / 1e6 : 0.0);
+
+  if (seabedTerrain)
+  {
+    SeabedStats bottom = seabedStats(seabedTerrain);
+    fprintf(stderr, "seabed: %llu queries, %.2f%% from resident tiles\n",
+            (unsigned long long)(bottom.hits + bottom.misses),
+            100.0 * bottom.hits / MAX(1, bottom.hits + bottom.misses));
+  }
+
+  threadPoolDestroy(pool);
+  seabedDestroy(seabedTerrain);
+  if (out != stdout)
+    fclose(out);
+  return 0;
+}
@@ -0,0 +1,465 @@
+// Headless batch runner - plays scripted control timelines against the
+// submarine model on every core and prints one summary line per run.
+//
+//   ./sub_batch [-n runs] [-j threads] [-t seconds] [-s seed] [-J jitter] [-x factor] [-P file.params] [-C basin.cur] [-B seabed_seed] [-o out.csv] [scenario files...]
+//
+// Scenario files are plain text, one event per line:
+//   name scram_drill
+//   duration 600
+//   0 backup_power
+//   12 main_reactor
+//   300 helm 1
+// Times are simulation seconds, commands use the names from submarineCommandName().
+// "time_compression 1000" switches a run to adaptive steps (timewarp.h), which
+// is how multi-hour patrols and battery/oxygen budgets stay cheap; -x starts
+// every run compressed, -P runs them all with a parameter file (params.h),
+// -C in an ocean-current field (currents.h) instead of still water, -B over
+// procedural seabed (seabed.h) instead of open ocean.
+// Without files the built-in procedure library below is swept.
+
+#define _GNU_SOURCE
+#include "constants.h"
+#include "currents.h"
+#include "params.h"
+#include "seabed.h"
+#include "threadpool.h"
+#include "timewarp.h"
+#include <string.h>
+#include <time.h>
+
+#define MAX_SCENARIOS 64
+#define MAX_SCENARIO_EVENTS 256
+#define SCENARIO_NAME_LEN 32
+
+typedef struct
+{
+  float time;
+  SubmarineCommand cmd;
+} ScenarioEvent;
+
+typedef struct
+{
+  char name[SCENARIO_NAME_LEN];
+  float duration;
+  int event_count;
+  ScenarioEvent events[MAX_SCENARIO_EVENTS];
+} Scenario;
+
+typedef struct
+{
+  int scenario;
+  unsigned int seed;
+  long ticks;
+  long evaluations; // updateSubmarineState calls - fewer than ticks under compression
+  float sim_time;
+  float final_depth;
+  float max_depth;
+  float max_reactor_temp;
+  float final_reactor_temp;
+  float min_hull;
+  float min_oxygen;
+  float final_battery;
+  float trip_time; // First time the model itself shut the reactor down (-1 = never)
+  bool destroyed;
+  bool lost;     // Hull or oxygen ran out
+  float distance; // m from the start point at the end, current set included
+} RunSummary;
+
+typedef struct
+{
+  const Scenario *scenarios;
+  int scenario_count;
+  int runs_per_scenario;
+  unsigned int base_seed;
+  float jitter;            // +- fraction applied to event times
+  float duration_override; // > 0 replaces every scenario duration
+  int compression;         // Time compression every run starts at
+  RunSummary *results;
+} BatchJob;
+
+// Every built-in drill opens with the same checklist: backup power, life
+// support, then a normal reactor start
+#define STARTUP_PROCEDURE                                                     \
+  "0 backup_power\n1 air_circulation\n1 co2_scrubbers\n1 o2_generator\n"      \
+  "2 main_o2_system\n3 coolant_pumps\n4 steam_generator\n6 power_turbine\n" \
+  "8 containment\n10 control_rods\n12 main_reactor\n"
+
+static const char *builtinScenarios[] = {
+    "name startup_hold\n"
+    "duration 600\n"
+    STARTUP_PROCEDURE
+    "60 cooling\n",
+
+    "name scram_runaway\n"
+    "duration 600\n"
+    STARTUP_PROCEDURE,
+
+    "name dive_and_blow\n"
+    "duration 400\n"
+    STARTUP_PROCEDURE
+    "40 cooling\n"
+    "20 ballast_control\n30 ballast\n30 helm 1\n120 helm 0\n180 ballast\n240 ballast_blow\n",
+
+    "name blackout\n"
+    "duration 600\n"
+    STARTUP_PROCEDURE
+    "40 cooling\n"
+    "200 main_reactor\n210 backup_power\n",
+
+    "name emergency_surface\n"
+    "duration 400\n"
+    STARTUP_PROCEDURE
+    "40 cooling\n"
+    "20 ballast_control\n30 ballast\n150 emergency_surface\n",
+};
+
+// Parse one scenario from text. Returns false on a malformed line.
+static bool parseScenario(const char *text, const char *fallback_name, Scenario *out)
+{
+  memset(out, 0, sizeof(*out));
+  snprintf(out->name, sizeof(out->name), "%s", fallback_name);
+  out->duration = 300.0f;
+
+  const char *line = text;
+  int line_number = 0;
+  while (*line)
+  {
+    const char *end = strchr(line, '\n');
+    size_t len = end ? (size_t)(end - line) : strlen(line);
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%.*s", (int)MIN(len, sizeof(buf) - 1), line);
+    line = end ? end + 1 : line + len;
+    line_number++;
+
+    char *hash = strchr(buf, '#');
+    if (hash)
+      *hash = '\0';
+
+    char word[64];
+    float time, value = 0.0f;
+    if (sscanf(buf, " %63s", word) != 1)
+      continue; // Blank line
+
+    if (strcmp(word, "name") == 0)
+    {
+      sscanf(buf, " name %31s", out->name);
+    }
+    else if (strcmp(word, "duration") == 0)
+    {
+      sscanf(buf, " duration %f", &out->duration);
+    }
+    else
+    {
+      int fields = sscanf(buf, " %f %63s %f", &time, word, &value);
+      SubmarineCommandType type = fields >= 2 ? submarineCommandFromName(word) : CMD_NONE;
+      if (type == CMD_NONE)
+      {
+        fprintf(stderr, "%s:%d: unknown event '%s'\n", fallback_name, line_number, buf);
+        return false;
+      }
+      if (out->event_count >= MAX_SCENARIO_EVENTS)
+      {
+        fprintf(stderr, "%s: more than %d events\n", fallback_name, MAX_SCENARIO_EVENTS);
+        return false;
+      }
+      out->events[out->event_count++] = (ScenarioEvent){time, {type, value}};
+    }
+  }
+
+  // Keep events in time order (stable, so same-time events keep file order)
+  for (int i = 1; i < out->event_count; i++)
+  {
+    ScenarioEvent e = out->events[i];
+    int j = i - 1;
+    while (j >= 0 && out->events[j].time > e.time)
+    {
+      out->events[j + 1] = out->events[j];
+      j--;
+    }
+    out->events[j + 1] = e;
+  }
+  return true;
+}
+
+static bool loadScenarioFile(const char *path, Scenario *out)
+{
+  FILE *f = fopen(path, "rb");
+  if (!f)
+  {
+    perror(path);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  char *text = malloc(size + 1);
+  size_t got = fread(text, 1, size, f);
+  text[got] = '\0';
+  fclose(f);
+
+  bool ok = parseScenario(text, path, out);
+  free(text);
+  return ok;
+}
+
+static float randomUnit(unsigned int *state)
+{
+  unsigned int x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+static void runScenario(int index, void *ctx)
+{
+  BatchJob *job = ctx;
+  int scenario_index = index / job->runs_per_scenario;
+  const Scenario *sc = &job->scenarios[scenario_index];
+  RunSummary *r = &job->results[index];
+
+  unsigned int seed = (job->base_seed + (unsigned int)index * 2654435761u) | 1u;
+  unsigned int jitter_state = seed;
+
+  // Jitter the gaps between scripted events so each run is a slightly
+  // different crew, but checklist order is never broken
+  float event_times[MAX_SCENARIO_EVENTS];
+  float prev_time = 0.0f, prev_jittered = 0.0f;
+  for (int i = 0; i < sc->event_count; i++)
+  {
+    float gap = sc->events[i].time - prev_time;
+    if (job->jitter > 0.0f)
+      gap *= 1.0f + job->jitter * (randomUnit(&jitter_state) * 2.0f - 1.0f);
+    prev_time = sc->events[i].time;
+    prev_jittered += gap;
+    event_times[i] = prev_jittered;
+  }
+
+  SubmarineState sub = initSubmarine();
+  sub.rng_state = seed;
+  TimeWarp warp = initTimeWarp();
+  timeWarpCommand(&warp, &sub, (SubmarineCommand){CMD_TIME_COMPRESSION, (float)job->compression});
+
+  float duration = job->duration_override > 0.0f ? job->duration_override : sc->duration;
+  long total_ticks = (long)(duration * SIM_TICK_RATE);
+  bool applied[MAX_SCENARIO_EVENTS] = {false};
+
+  *r = (RunSummary){
+      .scenario = scenario_index,
+      .seed = seed,
+      .min_hull = sub.hull_integrity,
+      .min_oxygen = sub.oxygen,
+      .trip_time = -1.0f};
+
+  long tick = 0;
+  while (tick < total_ticks)
+  {
+    float t = tick * SIM_TICK_DT;
+
+    // Events fire on the first step boundary at or after their time, and
+    // compressed steps are cut short so that boundary is the exact tick
+    long next_event = total_ticks;
+    for (int i = 0; i < sc->event_count; i++)
+    {
+      if (!applied[i] && event_times[i] <= t)
+      {
+        timeWarpCommand(&warp, &sub, sc->events[i].cmd);
+        applied[i] = true;
+      }
+      else if (!applied[i])
+        next_event = MIN(next_event, (long)ceilf(event_times[i] * SIM_TICK_RATE));
+    }
+
+    bool was_active = systemOn(&sub, SYS_REACTOR);
+    long ticks_left = MAX(1, MIN(next_event, total_ticks) - tick);
+    tick += timeWarpStep(&warp, &sub, (uint32_t)MIN(ticks_left, (long)UINT32_MAX));
+    if (was_active && !systemOn(&sub, SYS_REACTOR) && r->trip_time < 0.0f)
+      r->trip_time = t;
+
+    r->max_depth = MAX(r->max_depth, sub.depth);
+    r->max_reactor_temp = MAX(r->max_reactor_temp, sub.reactor_temp);
+    r->min_hull = MIN(r->min_hull, sub.hull_integrity);
+    r->min_oxygen = MIN(r->min_oxygen, sub.oxygen);
+
+    if (sub.hull_integrity <= 0 || sub.oxygen <= 0)
+    {
+      r->lost = true;
+      break;
+    }
+  }
+
+  r->ticks = tick;
+  r->evaluations = (long)warp.evaluations;
+  r->sim_time = tick * SIM_TICK_DT;
+  r->final_depth = sub.depth;
+  r->final_reactor_temp = sub.reactor_temp;
+  r->final_battery = sub.battery_level;
+  r->distance = (float)hypot(sub.north, sub.east);
+  r->destroyed = systemOn(&sub, SYS_REACTOR_DESTROYED);
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-n runs] [-j threads] [-t seconds] [-s seed] [-J jitter] [-x factor] [-P file.params] [-C basin.cur] [-B seabed_seed] [-o out.csv] [scenario...]\n"
+          "  -n  runs per scenario (default 1000)\n"
+          "  -j  worker threads (default: all cores)\n"
+          "  -t  override scenario duration in sim seconds\n"
+          "  -s  base random seed (default 1)\n"
+          "  -J  event time jitter fraction (default 0.2)\n"
+          "  -x  time compression every run starts at, 1-1000 (default 1)\n"
+          "  -P  physics parameter file (default: the constants.h values)\n"
+          "  -C  ocean-current field the boats drift in (default: still water)\n"
+          "  -B  seabed seed to ground on, 0 = open ocean (default 0, the game uses %d)\n"
+          "  -o  write the summary CSV here instead of stdout\n",
+          prog, SEABED_SEED);
+}
+
+int main(int argc, char **argv)
+{
+  int runs = 1000;
+  int threads = 0;
+  float duration = 0.0f;
+  unsigned int seed = 1;
+  float jitter = 0.2f;
+  int compression = 1;
+  const char *out_path = NULL;
+  static CurrentField currents;
+
+  static Scenario scenarios[MAX_SCENARIOS];
+  int scenario_count = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (strcmp(arg, "-n") == 0 && has_value)
+      runs = atoi(argv[++i]);
+    else if (strcmp(arg, "-j") == 0 && has_value)
+      threads = atoi(argv[++i]);
+    else if (strcmp(arg, "-t") == 0 && has_value)
+      duration = strtof(argv[++i], NULL);
+    else if (strcmp(arg, "-s") == 0 && has_value)
+      seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else if (strcmp(arg, "-J") == 0 && has_value)
+      jitter = strtof(argv[++i], NULL);
+    else if (strcmp(arg, "-x") == 0 && has_value)
+      compression = atoi(argv[++i]);
+    else if (strcmp(arg, "-P") == 0 && has_value)
+    {
+      if (!simParametersLoad(argv[++i], &simParameters))
+        return 1;
+    }
+    else if (strcmp(arg, "-C") == 0 && has_value)
+    {
+      if (!currentFieldMap(&currents, argv[++i]))
+      {
+        fprintf(stderr, "%s: not an ocean-current field\n", argv[i]);
+        return 1;
+      }
+      oceanCurrents = &currents;
+    }
+    else if (strcmp(arg, "-B") == 0 && has_value)
+    {
+      // Tiles are generated by whichever run first sails onto them
+      unsigned int seabed_seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+      seabedDestroy(seabedTerrain);
+      seabedTerrain = seabed_seed ? seabedCreate(seabed_seed, 0) : NULL;
+    }
+    else if (strcmp(arg, "-o") == 0 && has_value)
+      out_path = argv[++i];
+    else if (arg[0] == '-')
+    {
+      usage(argv[0]);
+      return 1;
+    }
+    else if (scenario_count < MAX_SCENARIOS)
+    {
+      if (!loadScenarioFile(arg, &scenarios[scenario_count]))
+        return 1;
+      scenario_count++;
+    }
+  }
+
+  if (scenario_count == 0)
+  {
+    int builtin_count = sizeof(builtinScenarios) / sizeof(builtinScenarios[0]);
+    for (int i = 0; i < builtin_count; i++)
+    {
+      if (!parseScenario(builtinScenarios[i], "builtin", &scenarios[scenario_count]))
+        return 1;
+      scenario_count++;
+    }
+  }
+
+  if (runs <= 0)
+    runs = 1;
+
+  int total_runs = scenario_count * runs;
+  BatchJob job = {
+      .scenarios = scenarios,
+      .scenario_count = scenario_count,
+      .runs_per_scenario = runs,
+      .base_seed = seed,
+      .jitter = jitter,
+      .duration_override = duration,
+      .compression = compression,
+      .results = calloc(total_runs, sizeof(RunSummary))};
+
+  ThreadPool *pool = threadPoolCreate(threads);
+  if (!job.results || !pool)
+  {
+    fprintf(stderr, "could not allocate %d runs\n", total_runs);
+    return 1;
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  threadPoolParallelFor(pool, total_runs, runScenario, &job);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  FILE *out = out_path ? fopen(out_path, "w") : stdout;
+  if (!out)
+  {
+    perror(out_path);
+    return 1;
+  }
+
+  long total_ticks = 0, total_evaluations = 0;
+  fprintf(out, "run,scenario,seed,sim_time,final_depth,max_depth,max_reactor_temp,final_reactor_temp,"
+               "min_hull,min_oxygen,final_battery,trip_time,destroyed,lost,distance\n");
+  for (int i = 0; i < total_runs; i++)
+  {
+    const RunSummary *r = &job.results[i];
+    total_ticks += r->ticks;
+    total_evaluations += r->evaluations;
+    fprintf(out, "%d,%s,%u,%.2f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.2f,%d,%d,%.1f\n",
+            i, scenarios[r->scenario].name, r->seed, r->sim_time,
+            r->final_depth, r->max_depth, r->max_reactor_temp, r->final_reactor_temp,
+            r->min_hull, r->min_oxygen, r->final_battery, r->trip_time,
+            r->destroyed ? 1 : 0, r->lost ? 1 : 0, r->distance);
+  }
+  if (out != stdout)
+    fclose(out);
+
+  double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+  fprintf(stderr, "%d runs, %ld ticks (%ld model steps) in %.2fs on %d threads (%.1f Mticks/s)\n",
+          total_runs, total_ticks, total_evaluations, seconds, threadPoolWorkerCount(pool),
+          seconds > 0 ? total_ticks / seconds / 1e6 : 0.0);
+
+  if (seabedTerrain)
+  {
+    SeabedStats bottom = seabedStats(seabedTerrain);
+    fprintf(stderr, "seabed: %llu tiles generated, %llu evicted, %.1f%% of %llu queries from the cache\n",
+            (unsigned long long)bottom.generated, (unsigned long long)bottom.evicted,
+            100.0 * bottom.hits / MAX(1, bottom.hits + bottom.misses), (unsigned long long)(bottom.hits + bottom.misses));
+  }
+
+  threadPoolDestroy(pool);
+  seabedDestroy(seabedTerrain);
+  free(job.results);
+  return 0;
+}
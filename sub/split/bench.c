@@ -0,0 +1,319 @@
+// Microbenchmarks for the submarine model - times every update stage on its
+// own over a few representative boats and prints one CSV row per
+// (state, stage) so runs can be diffed between releases.
+//
+//   ./sub_bench [-S samples] [-i iterations] [-o out.csv] [-c baseline.csv] [-r percent]
+//
+// Each sample restores the prepared state, then calls the stage `iterations`
+// times back to back; ns/tick is that sample's time divided by iterations.
+// fields_touched counts SubmarineState fields the stage changed at least once
+// (a write of the same value can't be seen), system_bits counts switch bits.
+// With -c, stages whose p50 grew more than -r percent over the baseline CSV
+// are listed on stderr and the exit status is 2.
+
+#define _GNU_SOURCE
+#include "constants.h"
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_BENCH_SAMPLES 100000
+#define MAX_BASELINE_ROWS 512
+
+typedef struct
+{
+  const char *name;
+  size_t offset;
+  size_t size;
+} BenchField;
+
+static const BenchField benchFields[] = {
+#define BENCH_FIELD(name) {#name, offsetof(SubmarineState, name), sizeof(((SubmarineState *)0)->name)},
+    SUBMARINE_STATE_FIELDS(BENCH_FIELD)
+#undef BENCH_FIELD
+};
+#define BENCH_FIELD_COUNT ((int)(sizeof(benchFields) / sizeof(benchFields[0])))
+
+typedef struct
+{
+  const char *name;
+  SubmarineState state;
+} BenchState;
+
+typedef struct
+{
+  char state[32];
+  char stage[32];
+  double p50;
+} BaselineRow;
+
+static void runFor(SubmarineState *sub, float seconds)
+{
+  long ticks = (long)(seconds * SIM_TICK_RATE);
+  for (long t = 0; t < ticks; t++)
+    updateSubmarineState(sub, SIM_TICK_DT);
+}
+
+static void applyAll(SubmarineState *sub, const SubmarineCommandType *commands, int count)
+{
+  for (int i = 0; i < count; i++)
+    applySubmarineCommand(sub, (SubmarineCommand){commands[i], 0.0f});
+}
+
+// Backup power, life support, then a normal reactor start, settled for a few minutes
+static SubmarineState fullPowerState(void)
+{
+  static const SubmarineCommandType startup[] = {
+      CMD_BACKUP_POWER, CMD_AIR_CIRCULATION, CMD_CO2_SCRUBBERS, CMD_O2_GENERATOR, CMD_MAIN_O2_SYSTEM,
+      CMD_COOLANT_PUMPS, CMD_STEAM_GENERATOR, CMD_POWER_TURBINE, CMD_CONTAINMENT, CMD_CONTROL_RODS,
+      CMD_MAIN_REACTOR, CMD_COOLING, CMD_HULL_MONITORING, CMD_LIGHTS, CMD_SONAR};
+  SubmarineState sub = initSubmarine();
+  applyAll(&sub, startup, sizeof(startup) / sizeof(startup[0]));
+  runFor(&sub, 300.0f);
+  return sub;
+}
+
+static int prepareStates(BenchState *states)
+{
+  int n = 0;
+
+  states[n++] = (BenchState){"cold_start", initSubmarine()};
+
+  SubmarineState full = fullPowerState();
+  states[n++] = (BenchState){"full_power", full};
+
+  // Holding depth on autopilot with every navigation system up
+  SubmarineState cruise = full;
+  static const SubmarineCommandType nav[] = {CMD_GYROSCOPE, CMD_NAV_COMPUTER, CMD_DEPTH_CONTROL,
+                                             CMD_BALLAST_CONTROL, CMD_COMMUNICATIONS};
+  applyAll(&cruise, nav, sizeof(nav) / sizeof(nav[0]));
+  cruise.depth = 1200.0f;
+  applySubmarineCommand(&cruise, (SubmarineCommand){CMD_AUTOPILOT, 0.0f});
+  applySubmarineCommand(&cruise, (SubmarineCommand){CMD_TARGET_DEPTH, 1500.0f});
+  runFor(&cruise, 30.0f);
+  states[n++] = (BenchState){"autopilot_cruise", cruise};
+
+  // Deep, cracked and flooding - pressure damage and breach branches all live
+  SubmarineState breach = full;
+  breach.depth = MAX_DEPTH * 0.9f;
+  breach.hull_integrity = 20.0f;
+  runFor(&breach, 1.0f);
+  states[n++] = (BenchState){"hull_breach", breach};
+
+  // Reactor and backup gone, battery flat - everything electrical dropping out
+  SubmarineState blackout = full;
+  applySubmarineCommand(&blackout, (SubmarineCommand){CMD_MAIN_REACTOR, 0.0f});
+  applySubmarineCommand(&blackout, (SubmarineCommand){CMD_BACKUP_POWER, 0.0f});
+  blackout.battery_level = 0.0f;
+  runFor(&blackout, 1.0f);
+  states[n++] = (BenchState){"blackout", blackout};
+
+  return n;
+}
+
+static double nowNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+  double da = *(const double *)a, db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+static void updateWholeTick(SubmarineState *sub, float deltaTime)
+{
+  updateSubmarineState(sub, deltaTime);
+}
+
+// Fields (and switch bits) a stage changes when stepped from this state
+static int touchedFields(const SubmarineState *start, void (*update)(SubmarineState *, float),
+                         int iterations, bool touched[BENCH_FIELD_COUNT], int *system_bits)
+{
+  SubmarineState sub = *start;
+  uint64_t bits = 0;
+  memset(touched, 0, BENCH_FIELD_COUNT * sizeof(bool));
+
+  for (int i = 0; i < iterations; i++)
+  {
+    SubmarineState before = sub;
+    update(&sub, SIM_TICK_DT);
+    for (int f = 0; f < BENCH_FIELD_COUNT; f++)
+    {
+      const BenchField *field = &benchFields[f];
+      if (memcmp((const char *)&before + field->offset, (const char *)&sub + field->offset, field->size) != 0)
+        touched[f] = true;
+    }
+    bits |= before.systems ^ sub.systems;
+  }
+
+  int count = 0;
+  for (int f = 0; f < BENCH_FIELD_COUNT; f++)
+    count += touched[f];
+  *system_bits = __builtin_popcountll(bits);
+  return count;
+}
+
+static int loadBaseline(const char *path, BaselineRow *rows)
+{
+  FILE *f = fopen(path, "r");
+  if (!f)
+  {
+    perror(path);
+    return -1;
+  }
+
+  char line[1024];
+  int count = 0;
+  // state,stage,samples,iterations,ns_min,ns_p50,...
+  while (fgets(line, sizeof(line), f) && count < MAX_BASELINE_ROWS)
+  {
+    BaselineRow *row = &rows[count];
+    double ns_min;
+    int samples, iterations;
+    if (sscanf(line, "%31[^,],%31[^,],%d,%d,%lf,%lf", row->state, row->stage,
+               &samples, &iterations, &ns_min, &row->p50) == 6)
+      count++;
+  }
+  fclose(f);
+  return count;
+}
+
+static const BaselineRow *findBaseline(const BaselineRow *rows, int count, const char *state, const char *stage)
+{
+  for (int i = 0; i < count; i++)
+  {
+    if (strcmp(rows[i].state, state) == 0 && strcmp(rows[i].stage, stage) == 0)
+      return &rows[i];
+  }
+  return NULL;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-S samples] [-i iterations] [-o out.csv] [-c baseline.csv] [-r percent]\n"
+          "  -S  timed samples per stage (default 200)\n"
+          "  -i  stage calls per sample (default 1000)\n"
+          "  -o  write the CSV here instead of stdout\n"
+          "  -c  compare p50 against an earlier CSV, exit 2 on regressions\n"
+          "  -r  allowed p50 slowdown in percent for -c (default 10)\n",
+          prog);
+}
+
+int main(int argc, char **argv)
+{
+  int samples = 200;
+  int iterations = 1000;
+  const char *out_path = NULL;
+  const char *baseline_path = NULL;
+  double tolerance = 10.0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (strcmp(arg, "-S") == 0 && has_value)
+      samples = atoi(argv[++i]);
+    else if (strcmp(arg, "-i") == 0 && has_value)
+      iterations = atoi(argv[++i]);
+    else if (strcmp(arg, "-o") == 0 && has_value)
+      out_path = argv[++i];
+    else if (strcmp(arg, "-c") == 0 && has_value)
+      baseline_path = argv[++i];
+    else if (strcmp(arg, "-r") == 0 && has_value)
+      tolerance = strtod(argv[++i], NULL);
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  samples = MAX(1, MIN(MAX_BENCH_SAMPLES, samples));
+  iterations = MAX(1, iterations);
+
+  static BaselineRow baseline[MAX_BASELINE_ROWS];
+  int baseline_count = 0;
+  if (baseline_path && (baseline_count = loadBaseline(baseline_path, baseline)) < 0)
+    return 1;
+
+  FILE *out = out_path ? fopen(out_path, "w") : stdout;
+  if (!out)
+  {
+    perror(out_path);
+    return 1;
+  }
+
+  BenchState states[8];
+  int state_count = prepareStates(states);
+
+  // Every stage on its own, then the whole tick for reference
+  SubmarineStage stages[32];
+  int stage_count = 0;
+  for (int i = 0; i < submarineStageCount && stage_count < 31; i++)
+    stages[stage_count++] = submarineStages[i];
+  stages[stage_count++] = (SubmarineStage){"tick", updateWholeTick};
+
+  double *ns = malloc(samples * sizeof(double));
+  int regressions = 0;
+
+  fprintf(out, "state,stage,samples,iterations,ns_min,ns_p50,ns_p90,ns_p99,ns_mean,fields_touched,system_bits,touched\n");
+  for (int s = 0; s < state_count; s++)
+  {
+    for (int g = 0; g < stage_count; g++)
+    {
+      const SubmarineStage *stage = &stages[g];
+
+      bool touched[BENCH_FIELD_COUNT];
+      int system_bits;
+      int touched_count = touchedFields(&states[s].state, stage->update, iterations, touched, &system_bits);
+
+      double total = 0.0;
+      for (int k = 0; k < samples; k++)
+      {
+        SubmarineState sub = states[s].state;
+        double start = nowNs();
+        for (int i = 0; i < iterations; i++)
+          stage->update(&sub, SIM_TICK_DT);
+        ns[k] = (nowNs() - start) / iterations;
+        total += ns[k];
+      }
+      qsort(ns, samples, sizeof(double), compareDoubles);
+
+      double p50 = ns[samples / 2];
+      fprintf(out, "%s,%s,%d,%d,%.2f,%.2f,%.2f,%.2f,%.2f,%d,%d,",
+              states[s].name, stage->name, samples, iterations, ns[0], p50,
+              ns[samples * 90 / 100], ns[samples * 99 / 100], total / samples, touched_count, system_bits);
+      const char *separator = "";
+      for (int f = 0; f < BENCH_FIELD_COUNT; f++)
+      {
+        if (touched[f])
+        {
+          fprintf(out, "%s%s", separator, benchFields[f].name);
+          separator = "|";
+        }
+      }
+      fprintf(out, "\n");
+
+      const BaselineRow *base = findBaseline(baseline, baseline_count, states[s].name, stage->name);
+      if (base && base->p50 > 0.0 && p50 > base->p50 * (1.0 + tolerance / 100.0))
+      {
+        fprintf(stderr, "regression: %s/%s p50 %.2f ns vs %.2f ns (+%.1f%%)\n",
+                states[s].name, stage->name, p50, base->p50, (p50 / base->p50 - 1.0) * 100.0);
+        regressions++;
+      }
+    }
+  }
+
+  if (out != stdout)
+    fclose(out);
+  free(ns);
+
+  if (baseline_path)
+    fprintf(stderr, "%d regressions over %.0f%% against %s\n", regressions, tolerance, baseline_path);
+  return regressions > 0 ? 2 : 0;
+}
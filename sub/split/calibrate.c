@@ -0,0 +1,537 @@
+// Physics calibration - runs the headless model with many sets of the
+// params.h rates on every core and scores each set against reference
+// behaviour ("SCRAM from 350°C is back at 285°C in N seconds").
+//
+//   ./sub_calibrate [-g name=min:max:steps]... [-r name=min:max]... [-n samples] [-i rounds]
+//                   [-T reference=target[:tolerance]]... [-P base.params] [-s seed] [-j threads]
+//                   [-k best] [-w best.params] [-o out.csv]
+//
+// -g axes are swept as a grid, -r axes sampled uniformly -n times per grid
+// point. With -i each further round searches again around the best set so
+// far with every axis range halved. Score is the sum of squared misses in
+// tolerances, so 1 means one reference off by its whole tolerance. Without
+// any axes it just measures the base set. The CSV has one row per set;
+// the best few go to stderr and -w writes the best as a parameter file.
+
+#define _GNU_SOURCE
+#include "params.h"
+#include "threadpool.h"
+#include <string.h>
+#include <time.h>
+
+#define MAX_AXES 16
+#define MAX_SCRIPT_EVENTS 32
+#define MISS_PENALTY 100.0f // Score for a reference that never happened at all
+
+typedef struct
+{
+  float time;
+  SubmarineCommand cmd;
+} ScriptEvent;
+
+typedef struct
+{
+  int param;
+  float min, max;
+  int steps; // 0 = random axis
+} Axis;
+
+// Every reference opens with sub_batch's startup checklist
+#define STARTUP_PROCEDURE                                                     \
+  "0 backup_power\n1 air_circulation\n1 co2_scrubbers\n1 o2_generator\n"      \
+  "2 main_o2_system\n3 coolant_pumps\n4 steam_generator\n6 power_turbine\n" \
+  "8 containment\n10 control_rods\n12 main_reactor\n"
+
+typedef struct Reference Reference;
+
+// A scripted run of the model and the one number it is judged by
+struct Reference
+{
+  const char *name;
+  const char *description;
+  const char *script; // sub_batch scenario lines, "<seconds> <command> [value]"
+  float limit;        // Sim seconds before giving up
+  float (*measure)(const Reference *ref);
+  float target;
+  float tolerance;
+
+  ScriptEvent events[MAX_SCRIPT_EVENTS];
+  int event_count;
+};
+
+typedef struct
+{
+  const Reference *ref;
+  SubmarineState sub;
+  int next;
+  long tick;
+} ScriptRun;
+
+static void startRun(ScriptRun *run, const Reference *ref)
+{
+  run->ref = ref;
+  run->sub = initSubmarine();
+  run->next = 0;
+  run->tick = 0;
+}
+
+static float runTime(const ScriptRun *run)
+{
+  return run->tick * SIM_TICK_DT;
+}
+
+// One fixed tick, with the script's commands that are due applied first
+static void stepRun(ScriptRun *run)
+{
+  float now = runTime(run);
+  while (run->next < run->ref->event_count && run->ref->events[run->next].time <= now)
+    applySubmarineCommand(&run->sub, run->ref->events[run->next++].cmd);
+  updateSubmarineState(&run->sub, SIM_TICK_DT);
+  run->tick++;
+}
+
+static bool runUntil(ScriptRun *run, float limit, bool (*done)(const SubmarineState *sub))
+{
+  while (runTime(run) < limit)
+  {
+    if (done(&run->sub))
+      return true;
+    stepRun(run);
+  }
+  return false;
+}
+
+static bool reactorTripped(const SubmarineState *sub)
+{
+  return !systemOn(sub, SYS_REACTOR) && systemOn(sub, SYS_CONTROL_RODS_INSERTED);
+}
+
+static bool coreAtNormal(const SubmarineState *sub)
+{
+  return sub->reactor_temp <= REACTOR_NORMAL_TEMP;
+}
+
+static bool coreHot(const SubmarineState *sub)
+{
+  return sub->reactor_temp >= REACTOR_NORMAL_TEMP;
+}
+
+static bool tanksFull(const SubmarineState *sub)
+{
+  return sub->ballast_level >= 100.0f;
+}
+
+static bool reactorRunning(const SubmarineState *sub)
+{
+  return systemOn(sub, SYS_REACTOR);
+}
+
+// Seconds from the automatic SCRAM until the core is back at normal temperature
+static float measureScramCooldown(const Reference *ref)
+{
+  ScriptRun run;
+  startRun(&run, ref);
+  if (!runUntil(&run, ref->limit, reactorRunning) || !runUntil(&run, ref->limit, reactorTripped))
+    return NAN;
+  float scram = runTime(&run);
+  return runUntil(&run, ref->limit, coreAtNormal) ? runTime(&run) - scram : NAN;
+}
+
+// Seconds from pulling the rods until the core reaches normal temperature
+static float measureHeatup(const Reference *ref)
+{
+  ScriptRun run;
+  startRun(&run, ref);
+  if (!runUntil(&run, ref->limit, reactorRunning))
+    return NAN;
+  float start = runTime(&run);
+  return runUntil(&run, ref->limit, coreHot) ? runTime(&run) - start : NAN;
+}
+
+// Core temperature the cooled plant settles at
+static float measureSteadyCore(const Reference *ref)
+{
+  ScriptRun run;
+  startRun(&run, ref);
+  while (runTime(&run) < ref->limit)
+    stepRun(&run);
+  return run.sub.reactor_temp;
+}
+
+// Seconds for the ballast tanks to fill from empty
+static float measureBallastFill(const Reference *ref)
+{
+  ScriptRun run;
+  startRun(&run, ref);
+  while (run.next < ref->event_count && runTime(&run) < ref->limit)
+    stepRun(&run);
+  float start = runTime(&run);
+  return runUntil(&run, ref->limit, tanksFull) ? runTime(&run) - start : NAN;
+}
+
+// Battery percent used over the run, starting charged
+static float measureBatteryUse(const Reference *ref)
+{
+  ScriptRun run;
+  startRun(&run, ref);
+  run.sub.battery_level = 100.0f;
+  float start = run.sub.battery_level;
+  while (runTime(&run) < ref->limit)
+    stepRun(&run);
+  return start - run.sub.battery_level;
+}
+
+static Reference references[] = {
+    {"scram_cooldown", "s from the SCRAM at 350°C until the core is back at 285°C, cooling off",
+     STARTUP_PROCEDURE, 1800.0f, measureScramCooldown, 240.0f, 30.0f},
+    {"startup_heatup", "s from pulling the rods until the core reaches 285°C",
+     STARTUP_PROCEDURE "12 cooling\n", 900.0f, measureHeatup, 90.0f, 15.0f},
+    {"steady_core", "°C the cooled core settles at after 10 minutes",
+     STARTUP_PROCEDURE "12 cooling\n", 600.0f, measureSteadyCore, REACTOR_NORMAL_TEMP, 10.0f},
+    {"ballast_fill", "s to fill the ballast tanks from empty",
+     "0 backup_power\n1 ballast_control\n2 ballast\n", 60.0f, measureBallastFill, 3.0f, 0.5f},
+    {"battery_use", "% of a full battery for 5 minutes of lights and sonar without the reactor",
+     "0 backup_power\n1 lights\n1 sonar\n", 300.0f, measureBatteryUse, 10.0f, 2.0f},
+};
+#define REFERENCE_COUNT ((int)(sizeof(references) / sizeof(references[0])))
+
+static bool parseScript(Reference *ref)
+{
+  ref->event_count = 0;
+  const char *line = ref->script;
+  while (*line)
+  {
+    const char *end = strchr(line, '\n');
+    size_t len = end ? (size_t)(end - line) : strlen(line);
+    char buf[128], word[64];
+    float time, value = 0.0f;
+    snprintf(buf, sizeof(buf), "%.*s", (int)MIN(len, sizeof(buf) - 1), line);
+    line = end ? end + 1 : line + len;
+
+    int fields = sscanf(buf, " %f %63s %f", &time, word, &value);
+    if (fields <= 0)
+      continue;
+    SubmarineCommandType type = fields >= 2 ? submarineCommandFromName(word) : CMD_NONE;
+    if (type == CMD_NONE || ref->event_count == MAX_SCRIPT_EVENTS)
+    {
+      fprintf(stderr, "%s: bad script line '%s'\n", ref->name, buf);
+      return false;
+    }
+    ref->events[ref->event_count++] = (ScriptEvent){time, {type, value}};
+  }
+  return true;
+}
+
+static float randomUnit(unsigned int *state)
+{
+  unsigned int x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+typedef struct
+{
+  int set;
+  float values[MAX_AXES];
+  float measured[REFERENCE_COUNT];
+  float score;
+} SetResult;
+
+typedef struct
+{
+  const SimParameters *base;
+  const Axis *axes;
+  int axis_count;
+  int samples; // Per grid point
+  unsigned int seed;
+  SetResult *results;
+} CalibrationJob;
+
+// Axis values of set index: grid axes by mixed radix, random ones from the set's own stream
+static void setValues(const CalibrationJob *job, int index, float *values)
+{
+  int grid = index / job->samples;
+  unsigned int state = (job->seed + (unsigned int)index * 2654435761u) | 1u;
+  for (int a = 0; a < job->axis_count; a++)
+  {
+    const Axis *axis = &job->axes[a];
+    float t;
+    if (axis->steps > 0)
+    {
+      t = axis->steps > 1 ? (float)(grid % axis->steps) / (axis->steps - 1) : 0.5f;
+      grid /= axis->steps;
+    }
+    else
+      t = randomUnit(&state);
+    values[a] = axis->min + (axis->max - axis->min) * t;
+  }
+}
+
+static float scoreSet(const float *measured)
+{
+  float score = 0.0f;
+  for (int r = 0; r < REFERENCE_COUNT; r++)
+  {
+    float miss = (measured[r] - references[r].target) / references[r].tolerance;
+    score += isfinite(miss) ? miss * miss : MISS_PENALTY;
+  }
+  return score;
+}
+
+static void evaluateSet(int index, void *ctx)
+{
+  CalibrationJob *job = ctx;
+  SetResult *result = &job->results[index];
+  result->set = index;
+
+  SimParameters params = *job->base;
+  setValues(job, index, result->values);
+  for (int a = 0; a < job->axis_count; a++)
+    *simParameterField(&params, job->axes[a].param) = result->values[a];
+  simParametersUpdate(&params);
+
+  // This worker runs the model with this set until the next one
+  simParametersOverride = &params;
+  for (int r = 0; r < REFERENCE_COUNT; r++)
+    result->measured[r] = references[r].measure(&references[r]);
+  simParametersOverride = NULL;
+
+  result->score = scoreSet(result->measured);
+}
+
+static int byScore(const void *a, const void *b)
+{
+  float sa = ((const SetResult *)a)->score, sb = ((const SetResult *)b)->score;
+  return (sa > sb) - (sa < sb);
+}
+
+static bool parseAxis(const char *text, bool grid, Axis *axis)
+{
+  char name[64];
+  int consumed = 0;
+  if (sscanf(text, "%63[^=]=%n", name, &consumed) != 1 || consumed == 0)
+    return false;
+  axis->param = simParameterIndex(name);
+  axis->steps = 0;
+  int fields = grid ? sscanf(text + consumed, "%f:%f:%d", &axis->min, &axis->max, &axis->steps)
+                    : sscanf(text + consumed, "%f:%f", &axis->min, &axis->max);
+  if (axis->param < 0)
+    fprintf(stderr, "unknown parameter '%s'\n", name);
+  return axis->param >= 0 && fields == (grid ? 3 : 2) && (!grid || axis->steps > 0);
+}
+
+static bool parseTarget(const char *text)
+{
+  char name[64];
+  float target, tolerance;
+  int fields = sscanf(text, "%63[^=]=%f:%f", name, &target, &tolerance);
+  for (int r = 0; fields >= 2 && r < REFERENCE_COUNT; r++)
+  {
+    if (strcmp(references[r].name, name) == 0)
+    {
+      references[r].target = target;
+      if (fields == 3 && tolerance > 0.0f)
+        references[r].tolerance = tolerance;
+      return true;
+    }
+  }
+  fprintf(stderr, "bad reference target '%s'\n", text);
+  return false;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-g name=min:max:steps]... [-r name=min:max]... [-n samples] [-i rounds]\n"
+          "       [-T reference=target[:tolerance]]... [-P base.params] [-s seed] [-j threads]\n"
+          "       [-k best] [-w best.params] [-o out.csv]\n"
+          "  -g  sweep a parameter over a grid\n"
+          "  -r  sample a parameter uniformly\n"
+          "  -n  random samples per grid point (default 256 with -r axes)\n"
+          "  -i  search rounds, each around the best so far with halved ranges (default 1)\n"
+          "  -T  change a reference's target and tolerance\n"
+          "  -P  parameter file the sets start from (default: constants.h)\n"
+          "  -s  random seed (default 1)\n"
+          "  -j  worker threads (default: all cores)\n"
+          "  -k  best sets to list on stderr (default 5)\n"
+          "  -w  write the best set as a parameter file\n"
+          "  -o  write the CSV here instead of stdout\n"
+          "references:\n",
+          prog);
+  for (int r = 0; r < REFERENCE_COUNT; r++)
+    fprintf(stderr, "  %-15s %g +- %g  %s\n", references[r].name, references[r].target, references[r].tolerance,
+            references[r].description);
+  fprintf(stderr, "parameters:");
+  for (int i = 0; i < SIM_PARAMETER_COUNT; i++)
+    fprintf(stderr, " %s", simParameterName(i));
+  fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+  static Axis axes[MAX_AXES];
+  int axis_count = 0;
+  int samples = 0;
+  int rounds = 1;
+  int threads = 0;
+  int best_count = 5;
+  unsigned int seed = 1;
+  const char *out_path = NULL;
+  const char *best_path = NULL;
+  SimParameters base = defaultSimParameters();
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if ((strcmp(arg, "-g") == 0 || strcmp(arg, "-r") == 0) && has_value && axis_count < MAX_AXES)
+    {
+      if (!parseAxis(argv[++i], arg[1] == 'g', &axes[axis_count++]))
+      {
+        usage(argv[0]);
+        return 1;
+      }
+    }
+    else if (strcmp(arg, "-n") == 0 && has_value)
+      samples = atoi(argv[++i]);
+    else if (strcmp(arg, "-i") == 0 && has_value)
+      rounds = atoi(argv[++i]);
+    else if (strcmp(arg, "-T") == 0 && has_value)
+    {
+      if (!parseTarget(argv[++i]))
+        return 1;
+    }
+    else if (strcmp(arg, "-P") == 0 && has_value)
+    {
+      if (!simParametersLoad(argv[++i], &base))
+        return 1;
+    }
+    else if (strcmp(arg, "-s") == 0 && has_value)
+      seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else if (strcmp(arg, "-j") == 0 && has_value)
+      threads = atoi(argv[++i]);
+    else if (strcmp(arg, "-k") == 0 && has_value)
+      best_count = atoi(argv[++i]);
+    else if (strcmp(arg, "-w") == 0 && has_value)
+      best_path = argv[++i];
+    else if (strcmp(arg, "-o") == 0 && has_value)
+      out_path = argv[++i];
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  for (int r = 0; r < REFERENCE_COUNT; r++)
+    if (!parseScript(&references[r]))
+      return 1;
+
+  int grid_points = 1;
+  bool any_random = false;
+  for (int a = 0; a < axis_count; a++)
+  {
+    if (axes[a].steps > 0)
+      grid_points *= axes[a].steps;
+    else
+      any_random = true;
+  }
+  samples = any_random ? (samples > 0 ? samples : 256) : 1;
+  rounds = MAX(1, rounds);
+  int set_count = grid_points * samples;
+
+  FILE *out = out_path ? fopen(out_path, "w") : stdout;
+  if (!out)
+  {
+    perror(out_path);
+    return 1;
+  }
+
+  fprintf(out, "round,set,score");
+  for (int a = 0; a < axis_count; a++)
+    fprintf(out, ",%s", simParameterName(axes[a].param));
+  for (int r = 0; r < REFERENCE_COUNT; r++)
+    fprintf(out, ",%s", references[r].name);
+  fprintf(out, "\n");
+
+  SetResult *results = calloc(set_count, sizeof(SetResult));
+  ThreadPool *pool = threadPoolCreate(threads);
+  if (!results || !pool)
+  {
+    fprintf(stderr, "could not allocate %d sets\n", set_count);
+    return 1;
+  }
+  SetResult best = {.score = INFINITY};
+  double seconds = 0.0;
+
+  for (int round = 0; round < rounds; round++)
+  {
+    CalibrationJob job = {&base, axes, axis_count, samples, seed + (unsigned int)round * 7919u, results};
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    threadPoolParallelFor(pool, set_count, evaluateSet, &job);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds += (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+
+    for (int s = 0; s < set_count; s++)
+    {
+      const SetResult *result = &results[s];
+      fprintf(out, "%d,%d,%.4g", round, result->set, result->score);
+      for (int a = 0; a < axis_count; a++)
+        fprintf(out, ",%.6g", result->values[a]);
+      for (int r = 0; r < REFERENCE_COUNT; r++)
+        fprintf(out, ",%.4g", result->measured[r]);
+      fprintf(out, "\n");
+      if (result->score < best.score)
+        best = *result;
+    }
+
+    // Next round: the same axes, half as wide, centred on the best set so far
+    for (int a = 0; a < axis_count; a++)
+    {
+      float half = (axes[a].max - axes[a].min) * 0.25f;
+      axes[a].min = best.values[a] - half;
+      axes[a].max = best.values[a] + half;
+    }
+
+    // The best few of this round
+    qsort(results, set_count, sizeof(SetResult), byScore);
+    for (int k = 0; k < MIN(best_count, set_count); k++)
+    {
+      const SetResult *result = &results[k];
+      fprintf(stderr, "round %d set %d: score %.4g", round, result->set, result->score);
+      for (int a = 0; a < axis_count; a++)
+        fprintf(stderr, " %s=%.6g", simParameterName(job.axes[a].param), result->values[a]);
+      fprintf(stderr, " |");
+      for (int r = 0; r < REFERENCE_COUNT; r++)
+        fprintf(stderr, " %s=%.4g", references[r].name, result->measured[r]);
+      fprintf(stderr, "\n");
+    }
+  }
+  if (out != stdout)
+    fclose(out);
+
+  fprintf(stderr, "%d sets x %d rounds x %d references in %.2fs on %d threads (%.1f sets/s), best score %.4g\n",
+          set_count, rounds, REFERENCE_COUNT, seconds, threadPoolWorkerCount(pool),
+          seconds > 0 ? set_count * rounds / seconds : 0.0, best.score);
+
+  if (best_path)
+  {
+    SimParameters params = base;
+    for (int a = 0; a < axis_count; a++)
+      *simParameterField(&params, axes[a].param) = best.values[a];
+    simParametersUpdate(&params);
+    if (!simParametersSave(best_path, &params))
+      return 1;
+    fprintf(stderr, "best set written to %s\n", best_path);
+  }
+
+  threadPoolDestroy(pool);
+  free(results);
+  return 0;
+}
@@ -1,9 +1,16 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
+// SUB_HEADLESS builds the model without raylib (batch runs, tools)
+#ifndef SUB_HEADLESS
 #include "raylib.h"
+#else
+#define PI 3.14159265358979323846f
+#define DEG2RAD (PI / 180.0f)
+#endif
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <math.h>
 #include <stdlib.h>
 
@@ -28,9 +35,28 @@
 #define REACTOR_BASE_HEAT_RATE 5.0f       // Base heating when active (°C/sec)
 #define REACTOR_EXPONENTIAL_FACTOR 0.001f // Exponential heating factor
 #define REACTOR_RESIDUAL_HEAT_RATE 0.5f   // Heat even when shut down (decay heat)
-#define REACTOR_COOL_RATE 1.2f            // Cooling rate with pumps
-#define REACTOR_WARMUP_RATE 5.0f          // Startup heating
-#define REACTOR_EMERGENCY_COOL_RATE 3.0f  // Emergency cooling effectiveness
+
+// Reactor neutronics (kinetics.h)
+#define REACTOR_FISSION_HEAT_RATE 69.0f            // Core heating at 100 % neutron power (°C/sec)
+#define REACTOR_TEMPERATURE_COEFFICIENT -3.0e-5f   // Fuel (Doppler) reactivity per °C of core temperature
+
+// Reactor thermal network (thermal.h) - heat in core-°C, so the core capacity is 1
+#define THERMAL_CORE_CAPACITY 1.0f
+#define THERMAL_COOLANT_CAPACITY 0.3f
+#define THERMAL_STEAM_CAPACITY 0.3f
+#define THERMAL_CABIN_CAPACITY 0.06f
+#define THERMAL_PUMPED_CONDUCTANCE 0.5f        // Core -> coolant with the pumps running
+#define THERMAL_NATURAL_CONDUCTANCE 0.05f      // Core -> coolant by natural circulation
+#define THERMAL_STEAM_CONDUCTANCE 0.2f         // Coolant -> steam generator
+#define THERMAL_STEAM_IDLE_CONDUCTANCE 0.01f
+#define THERMAL_TURBINE_CONDUCTANCE 0.004f     // Steam generator -> sea through turbine and condenser
+#define THERMAL_TURBINE_IDLE_CONDUCTANCE 0.001f
+#define THERMAL_SEA_CONDUCTANCE 0.005f         // Coolant loop losses through the hull
+#define THERMAL_EMERGENCY_CONDUCTANCE 0.04f    // Emergency cooling dumps coolant heat overboard
+#define THERMAL_CABIN_CONDUCTANCE 0.004f       // Coolant -> cabin air
+#define THERMAL_ENVIRONMENT_CONDUCTANCE 0.03f  // Cabin air -> its environment target
+#define THERMAL_COOLER_CONDUCTANCE 2.0f        // Active cooling loop at full capacity
+#define THERMAL_COOLER_SETPOINT 95.0f          // Cooler holds the coolant this far above the sea
 
 // Critical temperatures (realistic for naval reactors)
 #define REACTOR_NORMAL_TEMP 285.0f   // Normal operating temperature (°C)
@@ -40,7 +66,6 @@
 #define REACTOR_SCRAM_TEMP 350.0f    // Auto-scram temperature
 
 #define BATTERY_CHARGE_RATE 0.8f
-#define COOLING_POWER 15.0f // More effective cooling
 
 // Power consumption (more realistic)
 #define BATTERY_DRAIN_RATE 0.3f
@@ -67,67 +92,105 @@
 #define BALLAST_RESPONSE_TIME 10.0f
 #define TRIM_EFFECTIVENESS 0.5f
 
+// Horizontal navigation (MAX_SPEED and ACCELERATION above set the shaft's pull)
+#define NAV_TURN_RATE 3.0f // °/s the rudder turns the boat at MAX_SPEED, less when slower
+
 // Sonar constants
 #define SONAR_RANGE 2000.0f      // Maximum sonar range in meters
 #define SONAR_PING_INTERVAL 2.0f // Time between pings in seconds
 
-typedef struct
-{
-  float depth;
-  float speed;
-  float vertical_speed; // New: separate vertical movement
-  float oxygen;
-  float reactor_temp;
-  float hull_integrity;
-  float battery_level;
-  float nitrogen_level;       // New: nitrogen narcosis simulation
-  float pressure_hull_stress; // New: structural stress
+// Simulation clock - physics always steps at a fixed rate, rendering interpolates
+#define SIM_TICK_RATE 120.0f                 // Simulation ticks per second
+#define SIM_TICK_DT (1.0f / SIM_TICK_RATE)   // Fixed timestep in seconds
+#define SIM_MAX_CATCHUP_TICKS 12             // Max ticks per frame before we drop time
 
+// Subsystem switches, packed into SubmarineState.systems. Append new bits at
+// the end so existing masks keep their meaning.
+typedef enum
+{
   // Main systems
-  bool reactor_active;
-  bool sonar_active;
-  bool ballast_tanks_filled;
-  bool lights_active;
-  bool oxygen_system_active;
-  bool emergency_surface; // New: emergency surface mode
-  bool cooling_active;
-  bool autopilot_active; // New: depth autopilot
+  SYS_REACTOR,
+  SYS_SONAR,
+  SYS_BALLAST_TANKS_FILLED,
+  SYS_LIGHTS,
+  SYS_OXYGEN_SYSTEM,
+  SYS_EMERGENCY_SURFACE, // Emergency surface mode
+  SYS_COOLING,
+  SYS_AUTOPILOT, // Depth autopilot
 
   // Reactor sub-systems
-  bool reactor_control_rods_inserted;  // Control rods position
-  bool reactor_coolant_pumps_active;   // Coolant circulation
-  bool reactor_steam_generator_active; // Steam generation
-  bool reactor_power_turbine_active;   // Power turbine
+  SYS_CONTROL_RODS_INSERTED, // Control rods position
+  SYS_COOLANT_PUMPS,         // Coolant circulation
+  SYS_STEAM_GENERATOR,       // Steam generation
+  SYS_POWER_TURBINE,         // Power turbine
 
   // Life support sub-systems
-  bool oxygen_scrubbers_active; // CO2 scrubbers
-  bool oxygen_generator_active; // O2 generator
-  bool air_circulation_active;  // Air circulation fans
+  SYS_CO2_SCRUBBERS,   // CO2 scrubbers
+  SYS_O2_GENERATOR,    // O2 generator
+  SYS_AIR_CIRCULATION, // Air circulation fans
 
   // Navigation sub-systems
-  bool navigation_computer_active; // Navigation computer
-  bool gyroscope_active;           // Gyroscope system
-  bool depth_control_active;       // Depth control system
+  SYS_NAV_COMPUTER,  // Navigation computer
+  SYS_GYROSCOPE,     // Gyroscope system
+  SYS_DEPTH_CONTROL, // Depth control system
 
   // Additional reactor sub-systems
-  bool reactor_containment_active; // Reactor containment
-  bool emergency_cooling_active;   // Emergency cooling
+  SYS_CONTAINMENT,       // Reactor containment
+  SYS_EMERGENCY_COOLING, // Emergency cooling
 
   // Additional life support sub-systems
-  bool hull_monitoring_active; // Hull monitoring
-  bool backup_power_active;    // Backup power
+  SYS_HULL_MONITORING, // Hull monitoring
+  SYS_BACKUP_POWER,    // Backup power
 
   // Additional navigation sub-systems
-  bool ballast_control_active; // Ballast control
-  bool communications_active;  // Communications
+  SYS_BALLAST_CONTROL, // Ballast control
+  SYS_COMMUNICATIONS,  // Communications
 
   // Emergency/General subsystems
-  bool manual_bilge_pumps_active;   // Manual bilge pumps
-  bool emergency_lighting_active;   // Emergency lighting
-  bool emergency_air_supply_active; // Emergency air supply
-  bool manual_ballast_blow_active;  // Manual ballast blow
-  bool distress_beacon_active;      // Distress beacon
-  bool fire_suppression_active;     // Fire suppression
+  SYS_BILGE_PUMPS,        // Manual bilge pumps
+  SYS_EMERGENCY_LIGHTING, // Emergency lighting
+  SYS_EMERGENCY_AIR,      // Emergency air supply
+  SYS_BALLAST_BLOW,       // Manual ballast blow
+  SYS_DISTRESS_BEACON,    // Distress beacon
+  SYS_FIRE_SUPPRESSION,   // Fire suppression
+
+  // Status
+  SYS_REACTOR_DESTROYED, // Reactor explosion state
+
+  // Autopilot mode
+  SYS_AUTOPILOT_PREDICTIVE, // Autopilot follows the planner's setpoints (autopilot.h) instead of its PID
+
+  SYS_COUNT
+} SubmarineSystem;
+
+#define SYS_BIT(s) (1ULL << (s))
+
+// Switch groups that fail or count together
+#define SYS_REACTOR_ELECTRIC (SYS_BIT(SYS_COOLANT_PUMPS) | SYS_BIT(SYS_STEAM_GENERATOR) | SYS_BIT(SYS_POWER_TURBINE))
+#define SYS_O2_SUBSYSTEMS (SYS_BIT(SYS_CO2_SCRUBBERS) | SYS_BIT(SYS_O2_GENERATOR) | SYS_BIT(SYS_AIR_CIRCULATION))
+#define SYS_LIFE_SUPPORT (SYS_O2_SUBSYSTEMS | SYS_BIT(SYS_OXYGEN_SYSTEM))
+#define SYS_NAVIGATION (SYS_BIT(SYS_NAV_COMPUTER) | SYS_BIT(SYS_GYROSCOPE) | SYS_BIT(SYS_DEPTH_CONTROL) | SYS_BIT(SYS_AUTOPILOT))
+#define SYS_NAV_OPERATIONAL (SYS_BIT(SYS_NAV_COMPUTER) | SYS_BIT(SYS_GYROSCOPE) | SYS_BIT(SYS_DEPTH_CONTROL) | SYS_BIT(SYS_REACTOR))
+#define SYS_REACTOR_READY (SYS_BIT(SYS_COOLANT_PUMPS) | SYS_BIT(SYS_STEAM_GENERATOR) | SYS_BIT(SYS_POWER_TURBINE) | SYS_BIT(SYS_CONTAINMENT))
+
+#define FLOOD_COMPARTMENTS 8 // Watertight compartments in the hull (flooding.h)
+#define ELECTRICAL_BUSES 3   // Switchboards in the electrical plant (electrical.h)
+#define KINETICS_GROUPS 6    // Delayed-neutron precursor groups (kinetics.h)
+
+typedef struct
+{
+  float depth;
+  float speed;
+  float vertical_speed; // New: separate vertical movement
+  float oxygen;
+  float reactor_temp;
+  float hull_integrity;
+  float battery_level;
+  float nitrogen_level;       // New: nitrogen narcosis simulation
+  float pressure_hull_stress; // New: structural stress
+
+  // Every on/off switch and status bit, one bit per SubmarineSystem
+  uint64_t systems;
 
   float power_consumption;
   float ballast_level;
@@ -137,10 +200,259 @@ typedef struct
   float target_depth;      // New: autopilot target
   float hull_temperature;  // New: hull heating from reactor
   float water_temperature; // New: external water temp
-  bool reactor_destroyed;  // NEW: reactor explosion state
+  float coolant_temp;         // Primary coolant loop (thermal.h)
+  float steam_generator_temp; // Steam generator secondary side
   float sonar_ping_timer;  // NEW: timer for sonar pings
+  int helm_input;          // Dive control held this tick: -1 = rise (UP), 0 = idle, 1 = dive (DOWN)
+
+  // Controller memory - lives in the state so every boat is independent
+  float gyro_drift_timer;
+  float autopilot_integral;
+  float autopilot_prev_error;
+  float autopilot_ballast; // Predictive autopilot setpoints: tank level %, planes °, shaft %
+  float autopilot_trim;
+  float autopilot_thrust;
+  unsigned int rng_state;        // Per-boat random stream (never 0)
+  unsigned int sonar_ping_count; // Bumped on every ping, the UI plays the sound
+  uint64_t subsystem_inputs;     // Signals the dependency graph last settled on, 0 = never (subsystems.h)
+
+  // Damage control (flooding.h)
+  float flood_water[FLOOD_COMPARTMENTS]; // m³ of sea in each compartment
+  float breach_area[FLOOD_COMPARTMENTS]; // m² of hull open to the sea
+  uint32_t doors_shut;                   // One bit per watertight door, 0 = all open
+  uint32_t flood_wet;                    // Compartments holding water or breached
+
+  // Electrical plant (electrical.h)
+  float bus_demand[ELECTRICAL_BUSES]; // Switched load on each bus, summed for power_loads
+  float power_supply;                 // Source capacity on line this tick
+  float propulsion_supply;            // Share of the shaft's demand the plant could carry, 0-1
+  uint64_t power_loads;               // Load switches bus_demand was summed for
+  uint64_t power_shed;                // Loads switched off by the shedder, restored as supply returns
+  uint32_t breakers_open;             // One bit per breaker, 0 = all closed
+
+  // Reactor neutronics (kinetics.h)
+  float neutron_power;                // Fission rate, 1 = rated thermal power
+  float precursors[KINETICS_GROUPS];  // Delayed-neutron precursor populations, same units
+  float rod_position;                 // Control rods' withdrawn fraction, 0 = fully in
+  float rod_target;                   // Where the drives take the rods while withdrawn (CMD_ROD_POSITION)
+
+  // Horizontal navigation - position from the start point, depth is the third axis
+  double north, east;         // m - double, so a metre-per-tick step still counts 1000 km out
+  float heading;              // ° true, 0 = north
+  float course;               // ° true the helm steers onto (CMD_COURSE)
+  float forward_speed;        // m/s through the water, negative astern
+  float current_east;         // m/s of current at the boat (currents.h), sampled this tick
+  float current_north;
+  float bottom_depth;         // m, seabed under the boat (seabed.h), MAX_DEPTH in open ocean
 } SubmarineState;
 
+// Every SubmarineState field, in declaration order - keep in sync with the struct
+#define SUBMARINE_STATE_FIELDS(X) \
+  X(depth)                        \
+  X(speed)                        \
+  X(vertical_speed)               \
+  X(oxygen)                       \
+  X(reactor_temp)                 \
+  X(hull_integrity)               \
+  X(battery_level)                \
+  X(nitrogen_level)               \
+  X(pressure_hull_stress)         \
+  X(systems)                      \
+  X(power_consumption)            \
+  X(ballast_level)                \
+  X(thrust)                       \
+  X(trim_angle)                   \
+  X(reactor_power)                \
+  X(target_depth)                 \
+  X(hull_temperature)             \
+  X(water_temperature)            \
+  X(coolant_temp)                 \
+  X(steam_generator_temp)         \
+  X(sonar_ping_timer)             \
+  X(helm_input)                   \
+  X(gyro_drift_timer)             \
+  X(autopilot_integral)           \
+  X(autopilot_prev_error)         \
+  X(autopilot_ballast)            \
+  X(autopilot_trim)               \
+  X(autopilot_thrust)             \
+  X(rng_state)                    \
+  X(sonar_ping_count)             \
+  X(subsystem_inputs)             \
+  X(flood_water)                  \
+  X(breach_area)                  \
+  X(doors_shut)                   \
+  X(flood_wet)                    \
+  X(bus_demand)                   \
+  X(power_supply)                 \
+  X(propulsion_supply)            \
+  X(power_loads)                  \
+  X(power_shed)                   \
+  X(breakers_open)                \
+  X(neutron_power)                \
+  X(precursors)                   \
+  X(rod_position)                 \
+  X(rod_target)                   \
+  X(north)                        \
+  X(east)                         \
+  X(heading)                      \
+  X(course)                       \
+  X(forward_speed)                \
+  X(current_east)                 \
+  X(current_north)                \
+  X(bottom_depth)
+
+// Subsystem switch helpers
+static inline bool systemOn(const SubmarineState *sub, SubmarineSystem s)
+{
+  return (sub->systems >> s) & 1;
+}
+
+static inline void setSystem(SubmarineState *sub, SubmarineSystem s, bool on)
+{
+  sub->systems = (sub->systems & ~SYS_BIT(s)) | ((uint64_t)(on ? 1 : 0) << s);
+}
+
+static inline void toggleSystem(SubmarineState *sub, SubmarineSystem s)
+{
+  sub->systems ^= SYS_BIT(s);
+}
+
+static inline bool allSystemsOn(const SubmarineState *sub, uint64_t mask)
+{
+  return (sub->systems & mask) == mask;
+}
+
+static inline int countSystemsOn(const SubmarineState *sub, uint64_t mask)
+{
+  return __builtin_popcountll(sub->systems & mask);
+}
+
+// Electrical draw per switch bit and of a whole switch set (same scale as power_consumption)
+extern const float systemPowerDrawTable[64];
+float systemsPowerDraw(uint64_t systems);
+
+// Every operator action on the boat. Panels, scripts and replays all go
+// through applySubmarineCommand so the power/interlock rules live in one place.
+typedef enum
+{
+  CMD_NONE = 0,
+
+  // Reactor panel
+  CMD_CONTROL_RODS,
+  CMD_COOLANT_PUMPS,
+  CMD_STEAM_GENERATOR,
+  CMD_POWER_TURBINE,
+  CMD_CONTAINMENT,
+  CMD_EMERGENCY_COOLING, // Reactor panel switch - needs power
+  CMD_MAIN_REACTOR,
+
+  // Life support panel
+  CMD_AIR_CIRCULATION,
+  CMD_CO2_SCRUBBERS,
+  CMD_O2_GENERATOR,
+  CMD_HULL_MONITORING,
+  CMD_MAIN_O2_SYSTEM,
+  CMD_BACKUP_POWER,
+
+  // Navigation panel
+  CMD_GYROSCOPE,
+  CMD_NAV_COMPUTER,
+  CMD_DEPTH_CONTROL,
+  CMD_BALLAST_CONTROL,
+  CMD_COMMUNICATIONS,
+
+  // Emergency panel - all manual
+  CMD_EMERGENCY_LIGHTING,
+  CMD_EMERGENCY_COOLING_MANUAL,
+  CMD_EMERGENCY_AIR,
+  CMD_BILGE_PUMPS,
+  CMD_FIRE_SUPPRESSION,
+  CMD_BALLAST_BLOW,
+  CMD_DISTRESS_BEACON,
+
+  // Main controls
+  CMD_BALLAST,
+  CMD_LIGHTS,
+  CMD_SONAR,
+  CMD_EMERGENCY_SURFACE,
+  CMD_AUTOPILOT,
+  CMD_COOLING,
+
+  // Helm (value carries the setting)
+  CMD_HELM,         // -1 rise, 0 idle, 1 dive
+  CMD_TARGET_DEPTH, // Autopilot target in meters
+
+  // Predictive autopilot - the planner's setpoints arrive as commands, so
+  // journals replay them without re-running the planner
+  CMD_PREDICTIVE_AUTOPILOT, // Toggle, engages the autopilot in predictive mode
+  CMD_AUTOPILOT_BALLAST,    // Tank level setpoint in %
+  CMD_AUTOPILOT_TRIM,       // Planes setpoint in degrees
+  CMD_AUTOPILOT_THRUST,     // Shaft setpoint in %
+
+  // Clock (value = compression factor) - no effect on the boat, handled by
+  // timeWarpCommand and journaled so replays step the same way
+  CMD_TIME_COMPRESSION,
+
+  // Scenario fault (scenario.h) - value = the SubmarineSystem that drops out
+  CMD_SYSTEM_FAILURE,
+
+  // Damage control - value = the door to swing, or < 0 to shut every door (open them all if already shut)
+  CMD_WATERTIGHT_DOOR,
+
+  // Electrical plant - value = the breaker to trip or close (electrical.h)
+  CMD_BREAKER,
+
+  // Rod drives - value = withdrawn position in % the rods go to while not inserted
+  CMD_ROD_POSITION,
+
+  // Helm - value = ordered course in degrees true
+  CMD_COURSE,
+
+  CMD_COUNT
+} SubmarineCommandType;
+
+typedef struct
+{
+  SubmarineCommandType type;
+  float value;
+} SubmarineCommand;
+
+// Function declarations
+SubmarineState initSubmarine(void);
+void updateSubmarineState(SubmarineState *sub, float deltaTime); // CORRECTED function name
+
+// The tick broken into its named stages, in run order (for profiling)
+typedef struct
+{
+  const char *name;
+  void (*update)(SubmarineState *sub, float deltaTime);
+} SubmarineStage;
+extern const SubmarineStage submarineStages[];
+extern const int submarineStageCount;
+SubmarineState interpolateSubmarineState(const SubmarineState *prev, const SubmarineState *curr, float alpha);
+uint64_t submarineStateHash(const SubmarineState *sub); // FNV-1a over every field's bits (padding ignored)
+bool applySubmarineCommand(SubmarineState *sub, SubmarineCommand cmd);
+const char *submarineCommandName(SubmarineCommandType type);
+SubmarineCommandType submarineCommandFromName(const char *name);
+const char *submarineSystemName(SubmarineSystem system);
+SubmarineSystem submarineSystemFromName(const char *name); // SYS_COUNT if unknown
+
+// Display-only state the renderer keeps between frames (lives in main, saved with snapshots)
+typedef struct
+{
+  float hold_depth;        // Depth marker set with H, < 0 = none
+  float alarm_flash_timer; // Alarm banner flash phase
+  float bubble_timer;      // Ballast bubble animation
+  float sonar_pulse;       // Sonar ring animation
+} RenderState;
+
+static inline RenderState initRenderState(void)
+{
+  return (RenderState){.hold_depth = -1.0f};
+}
+
+#ifndef SUB_HEADLESS
 typedef struct
 {
   Rectangle bounds;
@@ -148,12 +460,12 @@ typedef struct
   bool pressed;
 } Button;
 
-// Function declarations
-SubmarineState initSubmarine(void);
-void updateSubmarineState(SubmarineState *sub, float deltaTime); // CORRECTED function name
+struct AlarmBoard; // alarms.h
+
 void initAudio(void);
-void renderSubmarine(SubmarineState sub, float deltaTime, Button *buttons);
-void handleSubSystemInput(SubmarineState *sub);
+void renderSubmarine(const SubmarineState *sub, const struct AlarmBoard *alarms, RenderState *view, float deltaTime,
+                     Button *buttons);
+SubmarineCommand handleSubSystemInput(void); // Panel button clicked this frame, type CMD_NONE if none
 void drawDial(int centerX, int centerY, int radius, float value, float maxValue, Color color, const char *label, const char *unit);
 void drawSmallDial(int centerX, int centerY, int radius, float value, float maxValue, Color color, const char *label);
 
@@ -161,6 +473,7 @@ void drawSmallDial(int centerX, int centerY, int radius, float value, float maxV
 extern Sound reactorHum;
 extern Sound sonarPing;
 extern bool audioInitialized;
+#endif
 
 // Emergency panel coordinates
 #define EMERGENCY_PANEL_X 350
@@ -168,4 +481,12 @@ extern bool audioInitialized;
 #define EMERGENCY_PANEL_WIDTH 320
 #define EMERGENCY_PANEL_HEIGHT 360
 
+// Damage-control strip in the emergency panel - a box per compartment, the doors in the gaps
+#define DAMAGE_STRIP_X (EMERGENCY_PANEL_X + 10)
+#define DAMAGE_STRIP_Y (EMERGENCY_PANEL_Y + 240)
+#define DAMAGE_BOX_WIDTH 32
+#define DAMAGE_BOX_HEIGHT 36
+#define DAMAGE_BOX_GAP 6
+#define DAMAGE_DOORS_BUTTON_Y (EMERGENCY_PANEL_Y + 292) // Shut/open every door
+
 #endif
\ No newline at end of file
@@ -0,0 +1,327 @@
+#define _POSIX_C_SOURCE 200112L
+#include "contacts.h"
+#include <string.h>
+
+#define GRID_CELL_COUNT (CONTACT_GRID_CELLS * CONTACT_GRID_CELLS)
+#define SHIPPING_LANES 6
+#define LANE_WIDTH 3000.0f // m across
+
+static const char *contactTypeNames[CONTACT_TYPE_COUNT] = {
+    [CONTACT_SURFACE_SHIP] = "surface",
+    [CONTACT_SUBMARINE] = "submarine",
+    [CONTACT_BIOLOGIC] = "biologic",
+    [CONTACT_WRECK] = "wreck",
+};
+
+const char *contactTypeName(ContactType type)
+{
+  return (int)type >= 0 && type < CONTACT_TYPE_COUNT ? contactTypeNames[type] : "unknown";
+}
+
+bool contactsInit(ContactDatabase *db, int capacity)
+{
+  memset(db, 0, sizeof(*db));
+  db->capacity = MAX(1, capacity);
+
+  bool ok = true;
+#define CONTACT_ALLOC(name, type, count)                                              \
+  if (posix_memalign((void **)&db->name, 64, (size_t)(count) * sizeof(type)) != 0) \
+    ok = false;
+#define CONTACT_ALLOC_FLOAT(name) CONTACT_ALLOC(name, float, db->capacity)
+  CONTACT_FLOAT_FIELDS(CONTACT_ALLOC_FLOAT)
+  CONTACT_ALLOC(id, uint32_t, db->capacity)
+  CONTACT_ALLOC(type, uint8_t, db->capacity)
+  CONTACT_ALLOC(order, int, db->capacity)
+  CONTACT_ALLOC(spare, float, db->capacity)
+  CONTACT_ALLOC(cell_start, int, GRID_CELL_COUNT + 1)
+#undef CONTACT_ALLOC_FLOAT
+#undef CONTACT_ALLOC
+
+  if (!ok)
+  {
+    contactsFree(db);
+    return false;
+  }
+  memset(db->cell_start, 0, (GRID_CELL_COUNT + 1) * sizeof(int));
+  return true;
+}
+
+void contactsFree(ContactDatabase *db)
+{
+#define CONTACT_FREE(name) free(db->name);
+  CONTACT_FLOAT_FIELDS(CONTACT_FREE)
+  CONTACT_FREE(id)
+  CONTACT_FREE(type)
+  CONTACT_FREE(order)
+  CONTACT_FREE(spare)
+  CONTACT_FREE(cell_start)
+#undef CONTACT_FREE
+  memset(db, 0, sizeof(*db));
+}
+
+static float wrapCoordinate(float v)
+{
+  v = fmodf(v, CONTACT_WORLD_SIZE);
+  return v < 0.0f ? v + CONTACT_WORLD_SIZE : v;
+}
+
+// Shortest way from a to b across the wrapped world
+static float wrapDelta(float d)
+{
+  return d - CONTACT_WORLD_SIZE * roundf(d / CONTACT_WORLD_SIZE);
+}
+
+static int cellOf(float v)
+{
+  return MIN(CONTACT_GRID_CELLS - 1, (int)(v * (1.0f / CONTACT_CELL_SIZE)));
+}
+
+int contactsAdd(ContactDatabase *db, Contact contact)
+{
+  if (db->count >= db->capacity)
+    return -1;
+
+  // Unindexed until the next query, which moves it on from index_time like everyone else
+  int i = db->count++;
+  db->x[i] = contact.x;
+  db->y[i] = contact.y;
+  db->depth[i] = MAX(0.0f, MIN(MAX_DEPTH, contact.depth));
+  db->vx[i] = contact.vx;
+  db->vy[i] = contact.vy;
+  db->source_level[i] = contact.source_level;
+  db->signature[i] = contact.signature;
+  db->id[i] = (uint32_t)i;
+  db->type[i] = (uint8_t)contact.type;
+  db->max_speed = MAX(db->max_speed, sqrtf(contact.vx * contact.vx + contact.vy * contact.vy));
+  db->dirty = true;
+  return i;
+}
+
+void contactPosition(const ContactDatabase *db, int i, double time, float *x, float *y)
+{
+  float elapsed = (float)(time - db->index_time);
+  *x = wrapCoordinate(db->x[i] + db->vx[i] * elapsed);
+  *y = wrapCoordinate(db->y[i] + db->vy[i] * elapsed);
+}
+
+// Move everyone to time and counting-sort the arrays by cell
+static void reindex(ContactDatabase *db, double time)
+{
+  int *counts = db->cell_start;
+  memset(counts, 0, (GRID_CELL_COUNT + 1) * sizeof(int));
+
+  for (int i = 0; i < db->count; i++)
+  {
+    contactPosition(db, i, time, &db->x[i], &db->y[i]);
+    counts[cellOf(db->y[i]) * CONTACT_GRID_CELLS + cellOf(db->x[i]) + 1]++;
+  }
+  for (int c = 0; c < GRID_CELL_COUNT; c++)
+    counts[c + 1] += counts[c];
+
+  // cell_start[c] doubles as the fill cursor, then gets put back
+  for (int i = 0; i < db->count; i++)
+    db->order[db->cell_start[cellOf(db->y[i]) * CONTACT_GRID_CELLS + cellOf(db->x[i])]++] = i;
+  for (int c = GRID_CELL_COUNT; c > 0; c--)
+    db->cell_start[c] = db->cell_start[c - 1];
+  db->cell_start[0] = 0;
+
+#define CONTACT_PERMUTE(name, type)                                  \
+  {                                                                  \
+    type *scratch = (type *)db->spare;                               \
+    for (int i = 0; i < db->count; i++)                              \
+      scratch[i] = db->name[db->order[i]];                           \
+    memcpy(db->name, scratch, db->count * sizeof(type));             \
+  }
+#define CONTACT_PERMUTE_FLOAT(name) CONTACT_PERMUTE(name, float)
+  CONTACT_FLOAT_FIELDS(CONTACT_PERMUTE_FLOAT)
+  CONTACT_PERMUTE(id, uint32_t)
+  CONTACT_PERMUTE(type, uint8_t)
+#undef CONTACT_PERMUTE_FLOAT
+#undef CONTACT_PERMUTE
+
+  db->index_time = time;
+  db->dirty = false;
+  db->reindexes++;
+}
+
+int contactsInRange(ContactDatabase *db, double time, float x, float y, float radius, int *out, int max_out)
+{
+  float drift = db->max_speed * (float)fabs(time - db->index_time);
+  if (db->dirty || drift > CONTACT_REINDEX_DRIFT)
+  {
+    reindex(db, time);
+    drift = 0.0f;
+  }
+  db->queries++;
+
+  // Cells anyone in range could still be filed under
+  float reach = radius + drift;
+  int first_x = (int)floorf((x - reach) / CONTACT_CELL_SIZE), last_x = (int)floorf((x + reach) / CONTACT_CELL_SIZE);
+  int first_y = (int)floorf((y - reach) / CONTACT_CELL_SIZE), last_y = (int)floorf((y + reach) / CONTACT_CELL_SIZE);
+  last_x = MIN(last_x, first_x + CONTACT_GRID_CELLS - 1); // Never visit a wrapped cell twice
+  last_y = MIN(last_y, first_y + CONTACT_GRID_CELLS - 1);
+
+  float elapsed = (float)(time - db->index_time);
+  float radius2 = radius * radius;
+  int found = 0;
+  for (int gy = first_y; gy <= last_y; gy++)
+  {
+    int row = ((gy % CONTACT_GRID_CELLS) + CONTACT_GRID_CELLS) % CONTACT_GRID_CELLS;
+    for (int gx = first_x; gx <= last_x; gx++)
+    {
+      int cell = row * CONTACT_GRID_CELLS + ((gx % CONTACT_GRID_CELLS) + CONTACT_GRID_CELLS) % CONTACT_GRID_CELLS;
+      int end = db->cell_start[cell + 1];
+      db->candidates += end - db->cell_start[cell];
+      for (int i = db->cell_start[cell]; i < end; i++)
+      {
+        float dx = wrapDelta(db->x[i] + db->vx[i] * elapsed - x);
+        float dy = wrapDelta(db->y[i] + db->vy[i] * elapsed - y);
+        if (dx * dx + dy * dy <= radius2 && found < max_out)
+          out[found++] = i;
+      }
+    }
+  }
+  return found;
+}
+
+int contactsInRangeLinear(const ContactDatabase *db, double time, float x, float y, float radius, int *out,
+                          int max_out)
+{
+  float elapsed = (float)(time - db->index_time);
+  float radius2 = radius * radius;
+  int found = 0;
+  for (int i = 0; i < db->count && found < max_out; i++)
+  {
+    float dx = wrapDelta(db->x[i] + db->vx[i] * elapsed - x);
+    float dy = wrapDelta(db->y[i] + db->vy[i] * elapsed - y);
+    if (dx * dx + dy * dy <= radius2)
+      out[found++] = i;
+  }
+  return found;
+}
+
+static int louderFirst(const void *a, const void *b)
+{
+  float sa = ((const SonarDetection *)a)->signal_excess, sb = ((const SonarDetection *)b)->signal_excess;
+  if (sa != sb)
+    return sa < sb ? 1 : -1;
+  uint32_t ia = ((const SonarDetection *)a)->id, ib = ((const SonarDetection *)b)->id;
+  return (ia > ib) - (ia < ib);
+}
+
+int contactsPing(ContactDatabase *db, double time, float x, float y, const SonarField *sonar, SonarDetection *out,
+                 int max_out)
+{
+  int nearby[CONTACT_MAX_DETECTIONS * 4];
+  int count = contactsInRange(db, time, x, y, SONAR_RANGE, nearby, CONTACT_MAX_DETECTIONS * 4);
+
+  int heard = 0;
+  for (int n = 0; n < count && heard < max_out; n++)
+  {
+    int i = nearby[n];
+    float cx, cy;
+    contactPosition(db, i, time, &cx, &cy);
+    float dx = wrapDelta(cx - x), dy = wrapDelta(cy - y);
+    float range = sqrtf(dx * dx + dy * dy);
+
+    float excess = sonarSignalExcess(sonar, range, db->depth[i], db->source_level[i]);
+    if (excess <= 0.0f)
+      continue;
+
+    float bearing = atan2f(dx, dy) / DEG2RAD;
+    out[heard++] = (SonarDetection){
+        .id = db->id[i],
+        .type = (ContactType)db->type[i],
+        .range = range,
+        .bearing = bearing < 0.0f ? bearing + 360.0f : bearing,
+        .depth = db->depth[i],
+        .signal_excess = excess,
+        .signature = db->signature[i],
+    };
+  }
+
+  qsort(out, heard, sizeof(SonarDetection), louderFirst);
+  return heard;
+}
+
+// Uniform in [0, 1), xorshift like the model's own stream
+static float randomFraction(unsigned int *state)
+{
+  unsigned int x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+static float randomBetween(unsigned int *state, float lo, float hi)
+{
+  return lo + (hi - lo) * randomFraction(state);
+}
+
+void contactsGenerateScenario(ContactDatabase *db, int count, unsigned int seed)
+{
+  unsigned int rng = seed ? seed : 0x9E3779B9u;
+
+  // Straight lanes across the world, the first one a few km from our boat
+  float lane_x[SHIPPING_LANES], lane_y[SHIPPING_LANES], lane_heading[SHIPPING_LANES];
+  for (int l = 0; l < SHIPPING_LANES; l++)
+  {
+    lane_x[l] = l == 0 ? 3000.0f : randomBetween(&rng, 0.0f, CONTACT_WORLD_SIZE);
+    lane_y[l] = l == 0 ? 0.0f : randomBetween(&rng, 0.0f, CONTACT_WORLD_SIZE);
+    lane_heading[l] = randomBetween(&rng, 0.0f, 2.0f * PI);
+  }
+
+  for (int n = 0; n < count; n++)
+  {
+    float pick = randomFraction(&rng);
+    Contact c = {0};
+    float heading = randomBetween(&rng, 0.0f, 2.0f * PI), speed;
+
+    if (pick < 0.80f)
+    {
+      // Merchant traffic, either way down a lane
+      int l = (int)(randomFraction(&rng) * SHIPPING_LANES);
+      float along = randomBetween(&rng, -0.5f, 0.5f) * CONTACT_WORLD_SIZE;
+      float across = randomBetween(&rng, -0.5f, 0.5f) * LANE_WIDTH;
+      float ux = sinf(lane_heading[l]), uy = cosf(lane_heading[l]);
+      c = (Contact){CONTACT_SURFACE_SHIP, lane_x[l] + ux * along + uy * across, lane_y[l] + uy * along - ux * across,
+                    randomBetween(&rng, 3.0f, 12.0f)};
+      heading = lane_heading[l] + (randomFraction(&rng) < 0.5f ? 0.0f : PI);
+      speed = randomBetween(&rng, 5.0f, 12.0f);
+      c.source_level = randomBetween(&rng, 150.0f, 180.0f);
+      c.signature = randomBetween(&rng, 50.0f, 300.0f); // Blade rate and machinery lines
+    }
+    else if (pick < 0.84f)
+    {
+      c = (Contact){CONTACT_SUBMARINE, randomBetween(&rng, 0.0f, CONTACT_WORLD_SIZE),
+                    randomBetween(&rng, 0.0f, CONTACT_WORLD_SIZE), randomBetween(&rng, 50.0f, 500.0f)};
+      speed = randomBetween(&rng, 2.0f, 8.0f);
+      c.source_level = randomBetween(&rng, 105.0f, 130.0f);
+      c.signature = randomBetween(&rng, 20.0f, 60.0f);
+    }
+    else if (pick < 0.94f)
+    {
+      c = (Contact){CONTACT_BIOLOGIC, randomBetween(&rng, 0.0f, CONTACT_WORLD_SIZE),
+                    randomBetween(&rng, 0.0f, CONTACT_WORLD_SIZE), randomBetween(&rng, 0.0f, 600.0f)};
+      speed = randomBetween(&rng, 0.5f, 3.0f);
+      c.source_level = randomBetween(&rng, 140.0f, 185.0f); // Whale song carries
+      c.signature = randomBetween(&rng, 15.0f, 40.0f);
+    }
+    else
+    {
+      c = (Contact){CONTACT_WRECK, randomBetween(&rng, 0.0f, CONTACT_WORLD_SIZE),
+                    randomBetween(&rng, 0.0f, CONTACT_WORLD_SIZE), randomBetween(&rng, 100.0f, 3000.0f)};
+      speed = 0.0f;
+      c.source_level = randomBetween(&rng, 70.0f, 90.0f); // Creaks and current noise, close in only
+      c.signature = 0.0f;
+    }
+
+    c.x = wrapCoordinate(c.x);
+    c.y = wrapCoordinate(c.y);
+    c.vx = sinf(heading) * speed;
+    c.vy = cosf(heading) * speed;
+    contactsAdd(db, c);
+  }
+}
@@ -0,0 +1,124 @@
+#ifndef CONTACTS_H
+#define CONTACTS_H
+
+#include "constants.h"
+#include "sonar.h"
+
+// Everything else in the water - ships, other boats, whales, wrecks. The
+// world is a CONTACT_WORLD_SIZE square that wraps at the edges, in the same
+// metres east / north as the boat's own position, so a boat that sails off
+// one edge comes back in at the other among the same traffic.
+//
+// Contacts move in straight lines, so they are stored as a position at
+// index_time plus a velocity and nobody updates them per frame. The arrays
+// are kept sorted by grid cell (a counting sort) so a range query walks a few
+// contiguous runs. The index only has to be rebuilt once the fastest contact
+// could have drifted CONTACT_REINDEX_DRIFT out of its cell; until then queries
+// just widen their search by that much.
+
+#define CONTACT_CELL_SIZE 2000.0f // m, = SONAR_RANGE so a ping touches ~9 cells
+#define CONTACT_GRID_CELLS 200    // Per side
+#define CONTACT_WORLD_SIZE (CONTACT_CELL_SIZE * CONTACT_GRID_CELLS) // 400 km
+#define CONTACT_REINDEX_DRIFT (0.5f * CONTACT_CELL_SIZE)
+#define CONTACT_MAX_DETECTIONS 256 // Per ping
+
+typedef enum
+{
+  CONTACT_SURFACE_SHIP,
+  CONTACT_SUBMARINE,
+  CONTACT_BIOLOGIC,
+  CONTACT_WRECK,
+  CONTACT_TYPE_COUNT
+} ContactType;
+
+typedef struct
+{
+  ContactType type;
+  float x, y;        // m east / north, anywhere (wrapped into the world)
+  float depth;       // m
+  float vx, vy;      // m/s
+  float source_level; // dB re 1 uPa at 1 m, broadband radiated noise
+  float signature;    // Hz, strongest tonal - what the operator classifies by
+} Contact;
+
+// Per-contact fields in storage order
+#define CONTACT_FLOAT_FIELDS(X) \
+  X(x)                          \
+  X(y)                          \
+  X(depth)                      \
+  X(vx)                         \
+  X(vy)                         \
+  X(source_level)               \
+  X(signature)
+
+typedef struct
+{
+  int count;
+  int capacity;
+
+  // Structure of arrays, sorted by cell after every reindex
+#define CONTACT_DECLARE_FLOAT(name) float *name;
+  CONTACT_FLOAT_FIELDS(CONTACT_DECLARE_FLOAT)
+#undef CONTACT_DECLARE_FLOAT
+  uint32_t *id;  // Stable across reindexing, in order of contactsAdd
+  uint8_t *type; // ContactType
+
+  int *cell_start;   // CONTACT_GRID_CELLS^2 + 1 offsets into the arrays
+  int *order;        // Reindex scratch: new position -> old
+  float *spare;      // Reindex scratch: one field being permuted
+  double index_time; // Sim seconds the stored x/y belong to
+  float max_speed;   // Fastest contact, bounds the drift since index_time
+  bool dirty;        // Contacts added since the last reindex
+
+  // Counters since init
+  uint64_t reindexes;
+  uint64_t queries;
+  uint64_t candidates; // Contacts range-tested by queries
+} ContactDatabase;
+
+typedef struct
+{
+  uint32_t id;
+  ContactType type;
+  float range;   // m, horizontal
+  float bearing; // Degrees true, 0 = north
+  float depth;
+  float signal_excess; // dB over the detection threshold
+  float signature;
+} SonarDetection;
+
+bool contactsInit(ContactDatabase *db, int capacity);
+void contactsFree(ContactDatabase *db);
+
+// Position is taken as of the database's index_time (0 until the first
+// query). Returns the new contact's id, or -1 when the database is full.
+int contactsAdd(ContactDatabase *db, Contact contact);
+
+// Shipping lanes, a few other boats, whales and wrecks - count contacts in
+// all, the same world for the same seed
+void contactsGenerateScenario(ContactDatabase *db, int count, unsigned int seed);
+
+// Storage indices of every contact within radius (horizontally) of x, y at
+// time, at most max_out. May reindex first, which reorders the storage.
+int contactsInRange(ContactDatabase *db, double time, float x, float y, float radius, int *out, int max_out);
+
+// Same answer by checking every contact, for tests and benchmarks
+int contactsInRangeLinear(const ContactDatabase *db, double time, float x, float y, float radius, int *out,
+                          int max_out);
+
+// Contact i's position at time, wrapped into the world
+void contactPosition(const ContactDatabase *db, int i, double time, float *x, float *y);
+
+// One sonar ping from a boat at x, y: every contact in SONAR_RANGE the
+// propagation field says we can hear, loudest first
+int contactsPing(ContactDatabase *db, double time, float x, float y, const SonarField *sonar, SonarDetection *out,
+                 int max_out);
+
+const char *contactTypeName(ContactType type);
+
+#ifndef SUB_HEADLESS
+// Last ping's detections over renderSonarField's picture at x, y, plus the loudest few as a list (renderer.c)
+void renderSonarContacts(const SonarField *field, const SonarDetection *heard, int count, int x, int y);
+#endif
+
+#endif
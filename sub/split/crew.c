@@ -0,0 +1,639 @@
+#define _GNU_SOURCE
+#include "crew.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+_Static_assert((CREW_HISTORY & (CREW_HISTORY - 1)) == 0, "CREW_HISTORY must be a power of two");
+_Static_assert(CMD_COUNT <= 64, "station permissions are a 64-bit mask of command types");
+_Static_assert(CREW_MAX_PENDING <= 255, "an update's command count is one byte");
+
+// Each SubmarineState field's place in the struct, in SUBMARINE_STATE_FIELDS
+// order - bit n of a snapshot's field mask is entry n
+typedef struct
+{
+  size_t offset, size;
+} StateField;
+
+#define STATE_FIELD_ENTRY(name) {offsetof(SubmarineState, name), sizeof(((SubmarineState *)0)->name)},
+static const StateField stateFields[] = {SUBMARINE_STATE_FIELDS(STATE_FIELD_ENTRY)};
+#undef STATE_FIELD_ENTRY
+#define STATE_FIELD_COUNT ((int)(sizeof(stateFields) / sizeof(stateFields[0])))
+
+_Static_assert(sizeof(stateFields) / sizeof(stateFields[0]) <= 64, "a snapshot's field mask is 64 bits");
+_Static_assert(sizeof(CrewSnapshotHeader) + sizeof(SubmarineState) <= CREW_PACKET_MAX,
+               "a whole state must fit one packet");
+
+#define COMMAND_BIT(type) (1ULL << (type))
+
+// The conn may give any order; the clock and scenario faults belong to
+// whoever runs the host, not the crew
+#define CONN_COMMANDS (~0ULL & ~COMMAND_BIT(CMD_NONE) & ~COMMAND_BIT(CMD_TIME_COMPRESSION) & \
+                       ~COMMAND_BIT(CMD_SYSTEM_FAILURE))
+
+#define HELM_COMMANDS                                                                                          \
+  (COMMAND_BIT(CMD_BALLAST) | COMMAND_BIT(CMD_HELM) | COMMAND_BIT(CMD_TARGET_DEPTH) |                          \
+   COMMAND_BIT(CMD_AUTOPILOT) | COMMAND_BIT(CMD_PREDICTIVE_AUTOPILOT) | COMMAND_BIT(CMD_AUTOPILOT_BALLAST) |  \
+   COMMAND_BIT(CMD_AUTOPILOT_TRIM) | COMMAND_BIT(CMD_AUTOPILOT_THRUST) | COMMAND_BIT(CMD_COURSE) |             \
+   COMMAND_BIT(CMD_GYROSCOPE) | COMMAND_BIT(CMD_NAV_COMPUTER) | COMMAND_BIT(CMD_DEPTH_CONTROL) |              \
+   COMMAND_BIT(CMD_BALLAST_CONTROL) | COMMAND_BIT(CMD_BALLAST_BLOW) | COMMAND_BIT(CMD_EMERGENCY_SURFACE) |     \
+   COMMAND_BIT(CMD_LIGHTS))
+
+// The engineering watch: reactor panel, the plant's breakers and life support
+#define REACTOR_COMMANDS                                                                                       \
+  (COMMAND_BIT(CMD_CONTROL_RODS) | COMMAND_BIT(CMD_COOLANT_PUMPS) | COMMAND_BIT(CMD_STEAM_GENERATOR) |         \
+   COMMAND_BIT(CMD_POWER_TURBINE) | COMMAND_BIT(CMD_CONTAINMENT) | COMMAND_BIT(CMD_EMERGENCY_COOLING) |        \
+   COMMAND_BIT(CMD_MAIN_REACTOR) | COMMAND_BIT(CMD_ROD_POSITION) | COMMAND_BIT(CMD_COOLING) |                  \
+   COMMAND_BIT(CMD_EMERGENCY_COOLING_MANUAL) | COMMAND_BIT(CMD_BACKUP_POWER) | COMMAND_BIT(CMD_BREAKER) |      \
+   COMMAND_BIT(CMD_AIR_CIRCULATION) | COMMAND_BIT(CMD_CO2_SCRUBBERS) | COMMAND_BIT(CMD_O2_GENERATOR) |         \
+   COMMAND_BIT(CMD_MAIN_O2_SYSTEM))
+
+#define SONAR_COMMANDS (COMMAND_BIT(CMD_SONAR) | COMMAND_BIT(CMD_COMMUNICATIONS) | COMMAND_BIT(CMD_DISTRESS_BEACON))
+
+static const uint64_t stationCommands[CREW_STATION_COUNT] = {
+    [CREW_CONN] = CONN_COMMANDS,
+    [CREW_HELM] = HELM_COMMANDS,
+    [CREW_REACTOR] = REACTOR_COMMANDS,
+    [CREW_SONAR] = SONAR_COMMANDS,
+};
+
+static const char *const stationNames[CREW_STATION_COUNT] = {
+#define CREW_STATION_NAME(id, name) [id] = name,
+    CREW_STATION_TABLE(CREW_STATION_NAME)
+#undef CREW_STATION_NAME
+};
+
+const char *crewStationName(CrewStation station)
+{
+  return station < CREW_STATION_COUNT ? stationNames[station] : "unknown";
+}
+
+CrewStation crewStationFromName(const char *name)
+{
+  for (int i = 0; i < CREW_STATION_COUNT; i++)
+    if (strcmp(name, stationNames[i]) == 0)
+      return (CrewStation)i;
+  return CREW_STATION_COUNT;
+}
+
+bool crewStationAllows(CrewStation station, SubmarineCommandType type)
+{
+  if (station >= CREW_STATION_COUNT || type <= CMD_NONE || type >= CMD_COUNT)
+    return false;
+  return (stationCommands[station] >> type) & 1;
+}
+
+double crewNow(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t nanoseconds(double seconds)
+{
+  return (uint64_t)(seconds * 1e9);
+}
+
+void crewSetLoss(float *loss, unsigned int *rng, float fraction, unsigned int seed)
+{
+  *loss = MAX(0.0f, MIN(1.0f, fraction));
+  *rng = seed ? seed : 1;
+}
+
+// xorshift32 - a drop decision per packet, independent of the model's RNG
+static bool dropPacket(float loss, unsigned int *rng)
+{
+  if (loss <= 0.0f)
+    return false;
+  unsigned int x = *rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *rng = x;
+  return (x >> 8) * (1.0f / 16777216.0f) < loss;
+}
+
+static CrewHeader packetHeader(CrewPacketType type, CrewStation station)
+{
+  return (CrewHeader){.magic = CREW_MAGIC, .version = CREW_PROTOCOL_VERSION, .type = type, .station = station};
+}
+
+static bool validHeader(const void *packet, ssize_t size)
+{
+  const CrewHeader *header = packet;
+  return size >= (ssize_t)sizeof(CrewHeader) && header->magic == CREW_MAGIC &&
+         header->version == CREW_PROTOCOL_VERSION;
+}
+
+// One datagram, counted against both sets of counters (peer may be NULL).
+// A full socket buffer drops the packet like the network would.
+static void sendPacket(int socket, const struct sockaddr_in *to, const void *data, size_t size, float loss,
+                       unsigned int *rng, CrewCounters *counters, CrewCounters *peer)
+{
+  CrewCounters *both[2] = {counters, peer};
+  bool dropped = dropPacket(loss, rng) ||
+                 sendto(socket, data, size, 0, (const struct sockaddr *)to, sizeof(*to)) != (ssize_t)size;
+  for (int i = 0; i < 2; i++)
+  {
+    if (!both[i])
+      continue;
+    both[i]->packets_sent++;
+    both[i]->bytes_sent += size;
+    both[i]->packets_dropped += dropped;
+  }
+}
+
+static int openSocket(uint16_t port)
+{
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0)
+    return -1;
+
+  int yes = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  struct sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_ANY)};
+  if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void recordRoundTrip(CrewCounters *counters, float ms)
+{
+  counters->rtt_ms = counters->rtt_ms > 0.0f ? counters->rtt_ms + (ms - counters->rtt_ms) * 0.125f : ms;
+  counters->rtt_max_ms = MAX(counters->rtt_max_ms, ms);
+}
+
+// Fields of state that differ from base (every field without one) into
+// out, returning its length
+static size_t encodeState(const SubmarineState *state, const SubmarineState *base, uint64_t *fields, uint8_t *out)
+{
+  const uint8_t *from = (const uint8_t *)state, *against = (const uint8_t *)base;
+  size_t size = 0;
+  *fields = 0;
+  for (int i = 0; i < STATE_FIELD_COUNT; i++)
+  {
+    const StateField *field = &stateFields[i];
+    if (base && memcmp(from + field->offset, against + field->offset, field->size) == 0)
+      continue;
+    memcpy(out + size, from + field->offset, field->size);
+    size += field->size;
+    *fields |= 1ULL << i;
+  }
+  return size;
+}
+
+// base (zeros without one) with the fields in data laid over it - false if
+// data isn't exactly as long as the mask says
+static bool decodeState(const SubmarineState *base, uint64_t fields, const uint8_t *data, size_t size,
+                        SubmarineState *state)
+{
+  if (fields >> STATE_FIELD_COUNT)
+    return false;
+
+  SubmarineState decoded;
+  if (base)
+    decoded = *base;
+  else
+    memset(&decoded, 0, sizeof(decoded));
+
+  uint8_t *to = (uint8_t *)&decoded;
+  size_t used = 0;
+  for (int i = 0; i < STATE_FIELD_COUNT; i++)
+  {
+    if (!((fields >> i) & 1))
+      continue;
+    const StateField *field = &stateFields[i];
+    if (used + field->size > size)
+      return false;
+    memcpy(to + field->offset, data + used, field->size);
+    used += field->size;
+  }
+  if (used != size)
+    return false;
+  *state = decoded;
+  return true;
+}
+
+static const SubmarineState *historyState(const CrewHistoryEntry *history, uint32_t sequence)
+{
+  const CrewHistoryEntry *entry = &history[sequence & (CREW_HISTORY - 1)];
+  return sequence && entry->sequence == sequence ? &entry->state : NULL;
+}
+
+static void rememberState(CrewHistoryEntry *history, uint32_t sequence, const SubmarineState *state)
+{
+  CrewHistoryEntry *entry = &history[sequence & (CREW_HISTORY - 1)];
+  entry->sequence = sequence;
+  entry->state = *state;
+}
+
+// ---------------------------------------------------------------- Host
+
+bool crewHostOpen(CrewHost *host, uint16_t port, const SubmarineState *start)
+{
+  memset(host, 0, sizeof(*host));
+  host->socket = openSocket(port);
+  host->sub = *start;
+  crewSetLoss(&host->loss, &host->rng, 0.0f, 1);
+  return host->socket >= 0;
+}
+
+void crewHostClose(CrewHost *host)
+{
+  if (host->socket >= 0)
+    close(host->socket);
+  host->socket = -1;
+}
+
+static CrewPeer *findPeer(CrewHost *host, const struct sockaddr_in *address)
+{
+  for (int i = 0; i < CREW_MAX_STATIONS; i++)
+  {
+    CrewPeer *peer = &host->peers[i];
+    if (peer->active && peer->address.sin_addr.s_addr == address->sin_addr.s_addr &&
+        peer->address.sin_port == address->sin_port)
+      return peer;
+  }
+  return NULL;
+}
+
+static void hostHello(CrewHost *host, const CrewHello *hello, const struct sockaddr_in *from, double now)
+{
+  CrewStation station = hello->header.station;
+  CrewPeer *peer = findPeer(host, from);
+
+  // A known station saying hello again lost our welcome - just repeat it
+  if (!peer && station < CREW_STATION_COUNT && hello->state_size == sizeof(SubmarineState))
+  {
+    for (int i = 0; i < CREW_MAX_STATIONS && !peer; i++)
+      if (!host->peers[i].active)
+        peer = &host->peers[i];
+    if (peer)
+      *peer = (CrewPeer){.active = true, .address = *from, .station = station, .last_heard = now};
+  }
+
+  CrewWelcome welcome = {.header = packetHeader(CREW_WELCOME, station),
+                         .accepted = peer != NULL,
+                         .snapshot_rate = CREW_SNAPSHOT_RATE,
+                         .tick_rate = (uint16_t)SIM_TICK_RATE};
+  sendPacket(host->socket, from, &welcome, sizeof(welcome), host->loss, &host->rng, &host->counters,
+             peer ? &peer->counters : NULL);
+}
+
+static void hostUpdate(CrewHost *host, CrewPeer *peer, const uint8_t *packet, ssize_t size, double now)
+{
+  const CrewUpdateHeader *update = (const CrewUpdateHeader *)packet;
+  if (size < (ssize_t)sizeof(*update) ||
+      size != (ssize_t)(sizeof(*update) + update->command_count * sizeof(CrewCommand)))
+    return;
+
+  // Updates can overtake each other, so only a newer ack moves the base on
+  if (update->snapshot_ack > peer->snapshot_ack && update->snapshot_ack <= host->sequence)
+  {
+    peer->snapshot_ack = update->snapshot_ack;
+    float ms = (float)((nanoseconds(now) - update->echo_time) * 1e-6 - update->held_us * 1e-3);
+    recordRoundTrip(&peer->counters, MAX(0.0f, ms));
+    recordRoundTrip(&host->counters, MAX(0.0f, ms));
+  }
+
+  // Commands this station has sent before are skipped, ones after a gap wait
+  // for it to be resent
+  const CrewCommand *commands = (const CrewCommand *)(packet + sizeof(*update));
+  for (int i = 0; i < update->command_count; i++)
+  {
+    uint32_t number = update->first_command + i;
+    if (number != peer->command_applied + 1)
+      continue;
+    peer->command_applied = number;
+
+    // A NaN or infinity would reach every station through the state
+    SubmarineCommand cmd = {.type = commands[i].type, .value = commands[i].value};
+    if (!crewStationAllows(peer->station, cmd.type) || !isfinite(cmd.value))
+    {
+      peer->counters.commands_rejected++;
+      host->counters.commands_rejected++;
+      continue;
+    }
+    applySubmarineCommand(&host->sub, cmd);
+    peer->counters.commands_applied++;
+    host->counters.commands_applied++;
+  }
+  peer->last_heard = now;
+}
+
+void crewHostPoll(CrewHost *host, double now)
+{
+  uint8_t packet[CREW_PACKET_MAX];
+  struct sockaddr_in from;
+  socklen_t from_size = sizeof(from);
+  ssize_t size;
+  while ((size = recvfrom(host->socket, packet, sizeof(packet), 0, (struct sockaddr *)&from, &from_size)) >= 0 ||
+         errno == EINTR || errno == ECONNREFUSED)
+  {
+    from_size = sizeof(from);
+    if (size < 0 || !validHeader(packet, size))
+      continue;
+
+    CrewPeer *peer = findPeer(host, &from);
+    host->counters.packets_received++;
+    host->counters.bytes_received += size;
+    if (peer)
+    {
+      peer->counters.packets_received++;
+      peer->counters.bytes_received += size;
+    }
+
+    const CrewHeader *header = (const CrewHeader *)packet;
+    if (header->type == CREW_HELLO && size >= (ssize_t)sizeof(CrewHello))
+      hostHello(host, (const CrewHello *)packet, &from, now);
+    else if (header->type == CREW_UPDATE && peer)
+      hostUpdate(host, peer, packet, size, now);
+  }
+
+  for (int i = 0; i < CREW_MAX_STATIONS; i++)
+    if (host->peers[i].active && now - host->peers[i].last_heard > CREW_TIMEOUT)
+      host->peers[i].active = false;
+}
+
+// Snapshot host->sequence (state) to one station, against its newest ack
+static void sendSnapshot(CrewHost *host, CrewPeer *peer, const SubmarineState *state, uint64_t sent_at)
+{
+  uint8_t packet[CREW_PACKET_MAX];
+  CrewSnapshotHeader *snapshot = (CrewSnapshotHeader *)packet;
+  const SubmarineState *base = historyState(host->history, peer->snapshot_ack);
+  *snapshot = (CrewSnapshotHeader){.header = packetHeader(CREW_SNAPSHOT, peer->station),
+                                   .sequence = host->sequence,
+                                   .baseline = base ? peer->snapshot_ack : 0,
+                                   .tick = host->tick,
+                                   .host_time = sent_at,
+                                   .command_ack = peer->command_applied,
+                                   .rtt_us = (uint32_t)(peer->counters.rtt_ms * 1e3f)};
+  uint64_t fields;
+  size_t state_size = encodeState(state, base, &fields, packet + sizeof(*snapshot));
+  snapshot->fields = fields;
+
+  CrewCounters *both[2] = {&host->counters, &peer->counters};
+  for (int c = 0; c < 2; c++)
+  {
+    both[c]->snapshots_full += base == NULL;
+    both[c]->snapshots_delta += base != NULL;
+    both[c]->state_bytes += state_size;
+    both[c]->state_raw_bytes += sizeof(SubmarineState);
+  }
+  sendPacket(host->socket, &peer->address, packet, sizeof(*snapshot) + state_size, host->loss, &host->rng,
+             &host->counters, &peer->counters);
+}
+
+void crewHostBroadcast(CrewHost *host)
+{
+  host->sequence++;
+  rememberState(host->history, host->sequence, &host->sub);
+  uint64_t sent_at = nanoseconds(crewNow());
+  for (int i = 0; i < CREW_MAX_STATIONS; i++)
+    if (host->peers[i].active)
+      sendSnapshot(host, &host->peers[i], &host->sub, sent_at);
+}
+
+void crewHostResend(CrewHost *host)
+{
+  // Anything changed since (an order that came in late) is a new snapshot
+  const SubmarineState *last = historyState(host->history, host->sequence);
+  if (!last || submarineStateHash(last) != submarineStateHash(&host->sub))
+  {
+    crewHostBroadcast(host);
+    return;
+  }
+  uint64_t sent_at = nanoseconds(crewNow());
+  for (int i = 0; i < CREW_MAX_STATIONS; i++)
+    if (host->peers[i].active && host->peers[i].snapshot_ack != host->sequence)
+      sendSnapshot(host, &host->peers[i], last, sent_at);
+}
+
+void crewHostEnd(CrewHost *host)
+{
+  const SubmarineState *last = historyState(host->history, host->sequence);
+  for (int i = 0; i < CREW_MAX_STATIONS; i++)
+  {
+    CrewPeer *peer = &host->peers[i];
+    if (!peer->active)
+      continue;
+    CrewBye bye = {.header = packetHeader(CREW_BYE, peer->station),
+                   .sequence = host->sequence,
+                   .state_hash = submarineStateHash(last ? last : &host->sub)};
+    sendPacket(host->socket, &peer->address, &bye, sizeof(bye), host->loss, &host->rng, &host->counters,
+               &peer->counters);
+  }
+}
+
+int crewHostStations(const CrewHost *host)
+{
+  int stations = 0;
+  for (int i = 0; i < CREW_MAX_STATIONS; i++)
+    stations += host->peers[i].active;
+  return stations;
+}
+
+bool crewHostSynced(const CrewHost *host)
+{
+  for (int i = 0; i < CREW_MAX_STATIONS; i++)
+    if (host->peers[i].active && host->peers[i].snapshot_ack != host->sequence)
+      return false;
+  return true;
+}
+
+// ---------------------------------------------------------------- Station
+
+bool crewStationOpen(CrewStationLink *link, const char *address, uint16_t port, CrewStation station)
+{
+  memset(link, 0, sizeof(*link));
+  link->socket = -1;
+  link->station = station;
+  link->first_pending = link->next_command = 1;
+  link->last_sent = -CREW_TIMEOUT;
+  crewSetLoss(&link->loss, &link->rng, 0.0f, 1);
+
+  struct addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_DGRAM}, *found;
+  if (station >= CREW_STATION_COUNT || getaddrinfo(address, NULL, &hints, &found) != 0)
+    return false;
+  link->host = *(struct sockaddr_in *)found->ai_addr;
+  link->host.sin_port = htons(port);
+  freeaddrinfo(found);
+
+  link->socket = openSocket(0);
+  return link->socket >= 0;
+}
+
+void crewStationClose(CrewStationLink *link)
+{
+  if (link->socket >= 0)
+    close(link->socket);
+  link->socket = -1;
+}
+
+int crewStationPending(const CrewStationLink *link)
+{
+  return (int)(link->next_command - link->first_pending);
+}
+
+bool crewStationCommand(CrewStationLink *link, SubmarineCommand cmd)
+{
+  if (crewStationPending(link) >= CREW_MAX_PENDING)
+    return false;
+  link->pending[link->next_command % CREW_MAX_PENDING] = (CrewCommand){.type = cmd.type, .value = cmd.value};
+  link->next_command++;
+  link->counters.commands_sent++;
+  link->last_sent = -CREW_TIMEOUT; // Send it with the next poll rather than the next resend
+  return true;
+}
+
+// false if it can't be decoded - out of date, or against a base we no longer hold
+// The ack may cover commands resent since - they're all done with
+static void takeCommandAck(CrewStationLink *link, uint32_t ack)
+{
+  if (ack >= link->first_pending && ack < link->next_command)
+  {
+    link->counters.commands_applied += ack - link->first_pending + 1;
+    link->first_pending = ack + 1;
+  }
+}
+
+static bool stationSnapshot(CrewStationLink *link, const uint8_t *packet, ssize_t size, double now)
+{
+  const CrewSnapshotHeader *snapshot = (const CrewSnapshotHeader *)packet;
+  if (size < (ssize_t)sizeof(*snapshot) || snapshot->sequence <= link->sequence)
+    return false;
+
+  const SubmarineState *base = NULL;
+  if (snapshot->baseline && !(base = historyState(link->history, snapshot->baseline)))
+    return false;
+  size_t state_size = size - sizeof(*snapshot);
+  if (!decodeState(base, snapshot->fields, packet + sizeof(*snapshot), state_size, &link->sub))
+    return false;
+
+  if (link->sequence && snapshot->sequence > link->sequence + 1)
+    link->counters.snapshots_lost += snapshot->sequence - link->sequence - 1;
+  link->sequence = snapshot->sequence;
+  link->tick = snapshot->tick;
+  link->echo_time = snapshot->host_time;
+  link->received_at = now;
+  rememberState(link->history, link->sequence, &link->sub);
+
+  link->counters.snapshots_full += base == NULL;
+  link->counters.snapshots_delta += base != NULL;
+  link->counters.state_bytes += state_size;
+  link->counters.state_raw_bytes += sizeof(SubmarineState);
+  link->counters.rtt_ms = snapshot->rtt_us * 1e-3f;
+  link->counters.rtt_max_ms = MAX(link->counters.rtt_max_ms, link->counters.rtt_ms);
+
+  takeCommandAck(link, snapshot->command_ack);
+  return true;
+}
+
+// The host resending the snapshot we hold (crewHostResend) means our ack went
+// missing - true if so, to send it again
+static bool stationResent(CrewStationLink *link, const uint8_t *packet, ssize_t size)
+{
+  const CrewSnapshotHeader *snapshot = (const CrewSnapshotHeader *)packet;
+  if (size < (ssize_t)sizeof(*snapshot) || !link->sequence || snapshot->sequence != link->sequence)
+    return false;
+  takeCommandAck(link, snapshot->command_ack);
+  return true;
+}
+
+static void stationSendUpdate(CrewStationLink *link, double now)
+{
+  uint8_t packet[sizeof(CrewUpdateHeader) + CREW_MAX_PENDING * sizeof(CrewCommand)];
+  CrewUpdateHeader *update = (CrewUpdateHeader *)packet;
+  int count = crewStationPending(link);
+  *update = (CrewUpdateHeader){.header = packetHeader(CREW_UPDATE, link->station),
+                               .snapshot_ack = link->sequence,
+                               .echo_time = link->echo_time,
+                               .held_us = link->sequence ? (uint32_t)((now - link->received_at) * 1e6) : 0,
+                               .first_command = link->first_pending,
+                               .command_count = (uint8_t)count};
+  CrewCommand *commands = (CrewCommand *)(packet + sizeof(*update));
+  for (int i = 0; i < count; i++)
+    commands[i] = link->pending[(link->first_pending + i) % CREW_MAX_PENDING];
+
+  sendPacket(link->socket, &link->host, packet, sizeof(*update) + count * sizeof(CrewCommand), link->loss,
+             &link->rng, &link->counters, NULL);
+  link->last_sent = now;
+}
+
+void crewStationPoll(CrewStationLink *link, double now)
+{
+  if (link->socket < 0 || link->ended)
+    return;
+
+  uint8_t packet[CREW_PACKET_MAX];
+  struct sockaddr_in from;
+  socklen_t from_size = sizeof(from);
+  ssize_t size;
+  bool fresh = false;
+  while ((size = recvfrom(link->socket, packet, sizeof(packet), 0, (struct sockaddr *)&from, &from_size)) >= 0 ||
+         errno == EINTR || errno == ECONNREFUSED)
+  {
+    from_size = sizeof(from);
+    if (size < 0 || !validHeader(packet, size) || from.sin_addr.s_addr != link->host.sin_addr.s_addr ||
+        from.sin_port != link->host.sin_port)
+      continue;
+    link->counters.packets_received++;
+    link->counters.bytes_received += size;
+    link->last_heard = now;
+
+    const CrewHeader *header = (const CrewHeader *)packet;
+    if (header->type == CREW_WELCOME && size >= (ssize_t)sizeof(CrewWelcome))
+    {
+      link->welcomed = ((const CrewWelcome *)packet)->accepted;
+      link->refused = !link->welcomed;
+    }
+    else if (header->type == CREW_SNAPSHOT)
+    {
+      link->welcomed = true; // Our welcome may have been lost, the snapshots weren't
+      if (stationSnapshot(link, packet, size, now))
+        fresh = true;
+      else
+      {
+        link->counters.snapshots_stale++;
+        fresh |= stationResent(link, packet, size);
+      }
+    }
+    else if (header->type == CREW_BYE && size >= (ssize_t)sizeof(CrewBye))
+    {
+      link->bye_sequence = ((const CrewBye *)packet)->sequence;
+      link->bye_hash = ((const CrewBye *)packet)->state_hash;
+      link->ended = true;
+      return;
+    }
+  }
+
+  if (link->refused)
+    return;
+  if (!link->welcomed)
+  {
+    if (now - link->last_sent >= CREW_HELLO_INTERVAL)
+    {
+      CrewHello hello = {.header = packetHeader(CREW_HELLO, link->station), .state_size = sizeof(SubmarineState)};
+      sendPacket(link->socket, &link->host, &hello, sizeof(hello), link->loss, &link->rng, &link->counters, NULL);
+      link->last_sent = now;
+      if (!link->last_heard)
+        link->last_heard = now; // The timeout runs from the first attempt
+    }
+  }
+  else if (fresh || now - link->last_sent >= (crewStationPending(link) ? CREW_RESEND_INTERVAL : CREW_KEEPALIVE_INTERVAL))
+    stationSendUpdate(link, now);
+
+  if (link->last_heard && now - link->last_heard > CREW_TIMEOUT)
+    link->ended = true;
+}
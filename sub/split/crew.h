@@ -0,0 +1,247 @@
+#ifndef CREW_H
+#define CREW_H
+
+#include "constants.h"
+#include <netinet/in.h>
+
+// Crew stations over UDP - one host owns the SubmarineState and runs the
+// model, stations on the same machine or the LAN each man part of the boat
+// (helm, reactor, sonar, or the conn, which may do anything).
+//
+// Host -> station: a snapshot of the state CREW_SNAPSHOT_RATE times a
+// second. Each is a delta against the newest snapshot that station has
+// acknowledged - a bit per SUBMARINE_STATE_FIELDS entry that changed and
+// then those fields' bytes - or the whole state when the host no longer
+// holds that baseline (or the station has none). A lost snapshot costs
+// nothing to repair: the next one is simply taken against an older base.
+// A station that gets the snapshot it already holds acks it again.
+//
+// Station -> host: an update per snapshot received, carrying the snapshot
+// ack, an echo of the host's send time (the host measures the round trip
+// from it) and every command not yet acknowledged. Commands are numbered;
+// the host applies each once, in order, between ticks, and acknowledges the
+// last in every snapshot, so they survive loss by being sent until they're
+// acknowledged. A command outside the station's role, or with a value that
+// isn't a finite number, is consumed and counted as rejected.
+//
+// Packets are packed structs in the host's byte order, like the snapshot
+// files - every machine in a crew must be the same kind, which HELLO checks
+// through the state's size. The whole state is ~330 bytes, one datagram.
+
+#define CREW_PROTOCOL_VERSION 1
+#define CREW_MAGIC 0x4E425553u       // "SUBN"
+#define CREW_DEFAULT_PORT 27960
+#define CREW_SNAPSHOT_RATE 20        // Hz
+#define CREW_MAX_STATIONS 8
+#define CREW_HISTORY 32              // Snapshots kept as delta baselines, both ends (power of two)
+#define CREW_MAX_PENDING 32          // Commands a station can have awaiting acknowledgement
+#define CREW_HELLO_INTERVAL 0.5      // s between HELLOs until the host answers
+#define CREW_RESEND_INTERVAL 0.1     // s between resends of unacknowledged commands
+#define CREW_KEEPALIVE_INTERVAL 0.5  // s between updates from a station with nothing to say
+#define CREW_TIMEOUT 3.0             // s of silence before either end gives the other up
+#define CREW_PACKET_MAX 1400         // Bytes, under a LAN MTU
+
+// Stations and the commands each may give (crewStationAllows)
+#define CREW_STATION_TABLE(X) \
+  X(CREW_CONN, "conn")        \
+  X(CREW_HELM, "helm")        \
+  X(CREW_REACTOR, "reactor")  \
+  X(CREW_SONAR, "sonar")
+
+typedef enum
+{
+#define CREW_STATION_ENUM(id, name) id,
+  CREW_STATION_TABLE(CREW_STATION_ENUM)
+#undef CREW_STATION_ENUM
+  CREW_STATION_COUNT
+} CrewStation;
+
+typedef enum
+{
+  CREW_HELLO = 1, // Station -> host: join as a station
+  CREW_WELCOME,   // Host -> station: accepted or not
+  CREW_SNAPSHOT,  // Host -> station: state, full or delta
+  CREW_UPDATE,    // Station -> host: snapshot ack, round-trip echo, commands
+  CREW_BYE,       // Host -> station: session over, with the final state's hash
+} CrewPacketType;
+
+typedef struct __attribute__((packed))
+{
+  uint32_t magic;
+  uint8_t version;
+  uint8_t type;    // CrewPacketType
+  uint8_t station; // CrewStation of the sender, or the one addressed
+  uint8_t reserved;
+} CrewHeader;
+
+typedef struct __attribute__((packed))
+{
+  CrewHeader header;
+  uint32_t state_size; // sizeof(SubmarineState), must match the host's
+} CrewHello;
+
+typedef struct __attribute__((packed))
+{
+  CrewHeader header;
+  uint8_t accepted;
+  uint8_t snapshot_rate;
+  uint16_t tick_rate;
+} CrewWelcome;
+
+typedef struct __attribute__((packed))
+{
+  CrewHeader header;
+  uint32_t sequence;    // Snapshots sent, from 1
+  uint32_t baseline;    // Sequence the delta is against, 0 = the whole state
+  uint64_t tick;        // Host ticks run
+  uint64_t host_time;   // ns on the host's clock when sent, echoed back
+  uint32_t command_ack; // Last of this station's commands applied
+  uint32_t rtt_us;      // Host's smoothed round trip to this station
+  uint64_t fields;      // Bit n set = SUBMARINE_STATE_FIELDS entry n follows
+} CrewSnapshotHeader;
+
+typedef struct __attribute__((packed))
+{
+  uint8_t type; // SubmarineCommandType
+  float value;
+} CrewCommand;
+
+typedef struct __attribute__((packed))
+{
+  CrewHeader header;
+  uint32_t snapshot_ack;  // Newest snapshot decoded, 0 = none yet
+  uint64_t echo_time;     // Its host_time
+  uint32_t held_us;       // How long after it arrived this went out
+  uint32_t first_command; // Number of commands[0]
+  uint8_t command_count;
+} CrewUpdateHeader;
+
+typedef struct __attribute__((packed))
+{
+  CrewHeader header;
+  uint32_t sequence;   // Last snapshot sent
+  uint64_t state_hash; // submarineStateHash of it
+} CrewBye;
+
+// Built in, both ends
+typedef struct
+{
+  uint64_t packets_sent, packets_received;
+  uint64_t bytes_sent, bytes_received;
+  uint64_t packets_dropped;  // Thrown away on send by the simulated loss (crewSetLoss)
+  uint64_t snapshots_full, snapshots_delta;
+  uint64_t state_bytes;      // Snapshot payload sent or received
+  uint64_t state_raw_bytes;  // ... and what whole states would have been
+  uint64_t snapshots_lost;   // Station: sequence gaps
+  uint64_t snapshots_stale;  // Station: late, duplicate or against a base it no longer has
+  uint64_t commands_sent;    // Station: first sends, not resends
+  uint64_t commands_applied; // Host: applied / station: acknowledged
+  uint64_t commands_rejected;
+  float rtt_ms, rtt_max_ms;  // Smoothed and worst round trip
+} CrewCounters;
+
+typedef struct
+{
+  bool active;
+  struct sockaddr_in address;
+  CrewStation station;
+  uint32_t snapshot_ack;  // Their newest decoded snapshot - the next delta's base
+  uint64_t echo_time;     // ... its host_time, and how long they sat on it
+  uint32_t held_us;
+  uint32_t command_applied; // Number of the last of their commands applied
+  double last_heard;
+  CrewCounters counters;
+} CrewPeer;
+
+typedef struct
+{
+  uint32_t sequence; // 0 = empty
+  SubmarineState state;
+} CrewHistoryEntry;
+
+typedef struct
+{
+  int socket;
+  SubmarineState sub; // The boat - the host's caller ticks it
+  uint64_t tick;
+  uint32_t sequence;  // Last snapshot sent
+  CrewHistoryEntry history[CREW_HISTORY];
+  CrewPeer peers[CREW_MAX_STATIONS];
+  CrewCounters counters; // All peers together
+  float loss;
+  unsigned int rng;
+} CrewHost;
+
+typedef struct
+{
+  int socket;
+  struct sockaddr_in host;
+  CrewStation station;
+  bool welcomed, refused;
+  bool ended; // CREW_BYE arrived, or the host has been silent CREW_TIMEOUT
+
+  // Newest decoded state, and the ones before it as delta bases
+  SubmarineState sub;
+  uint32_t sequence; // 0 = nothing yet
+  uint64_t tick;
+  CrewHistoryEntry history[CREW_HISTORY];
+  uint64_t echo_time;
+  double received_at;
+
+  CrewCommand pending[CREW_MAX_PENDING]; // Commands first_pending.. awaiting acknowledgement
+  uint32_t first_pending, next_command;  // Numbers; pending count is the difference
+
+  uint32_t bye_sequence; // From CREW_BYE, once ended
+  uint64_t bye_hash;
+
+  double last_sent, last_heard;
+  CrewCounters counters;
+  float loss;
+  unsigned int rng;
+} CrewStationLink;
+
+const char *crewStationName(CrewStation station);
+CrewStation crewStationFromName(const char *name); // CREW_STATION_COUNT if unknown
+bool crewStationAllows(CrewStation station, SubmarineCommandType type);
+
+double crewNow(void); // Monotonic seconds
+
+// Host on port (all interfaces), boat starting at start
+bool crewHostOpen(CrewHost *host, uint16_t port, const SubmarineState *start);
+void crewHostClose(CrewHost *host);
+
+// Take every waiting packet - new stations, acks, commands (applied to
+// host->sub here) - and drop stations silent for CREW_TIMEOUT
+void crewHostPoll(CrewHost *host, double now);
+
+// Snapshot of host->sub to every station, each against its own base
+void crewHostBroadcast(CrewHost *host);
+
+// Once the clock has stopped: the last snapshot again, same sequence, to each
+// station that hasn't acknowledged it (a new one if host->sub has changed
+// since). Rebroadcasting instead would keep moving the goal a station has to
+// ack, which under loss it may not reach for a long time.
+void crewHostResend(CrewHost *host);
+
+// Tell every station the session is over, with the hash of the last
+// snapshot - call it a few times, it's UDP
+void crewHostEnd(CrewHost *host);
+
+int crewHostStations(const CrewHost *host);
+bool crewHostSynced(const CrewHost *host); // Every station has the last snapshot
+
+// Station joining the host at address:port (name or dotted quad)
+bool crewStationOpen(CrewStationLink *link, const char *address, uint16_t port, CrewStation station);
+void crewStationClose(CrewStationLink *link);
+
+// Take every waiting snapshot, then HELLO, ack or resend as due
+void crewStationPoll(CrewStationLink *link, double now);
+
+// Queue a command for the host - false with CREW_MAX_PENDING already unacknowledged
+bool crewStationCommand(CrewStationLink *link, SubmarineCommand cmd);
+int crewStationPending(const CrewStationLink *link);
+
+// Drop this fraction of outgoing packets at random, to try loss on one machine
+void crewSetLoss(float *loss, unsigned int *rng, float fraction, unsigned int seed);
+
+#endif
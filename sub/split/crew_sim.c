@@ -0,0 +1,426 @@
+// Crew stations over UDP (crew.h) - one process hosts the boat in real time,
+// others man its stations from the same machine or anywhere on the LAN.
+//
+//   ./sub_crew host [-p port] [-r snapshot_hz] [-L loss] [-t seconds] [-P file.params] [-C basin.cur] [-B seabed_seed]
+//   ./sub_crew helm|reactor|sonar|conn [-a host_address] [-p port] [-L loss] [-t seconds]
+//   ./sub_crew test [-p port] [-r snapshot_hz] [-L loss] [-t seconds]
+//
+// A station reads orders from stdin, one "<command> [value]" a line in the
+// journal's names (control_rods, target_depth 120, course 270 ...), and
+// prints what its watch needs to see plus the link's counters once a second.
+// The host prints its counters once a second; -t ends the session after that
+// many simulated seconds, when the host stops the clock, waits for every
+// station to hold the last snapshot and says goodbye with its hash, which
+// each station checks against its own copy.
+//
+// test runs a host and a helm, reactor and sonar station as separate
+// processes on localhost, each station giving a few scripted orders (the helm
+// one that isn't its to give), and passes when every station ends holding
+// the host's final state with all its orders acknowledged. -L drops that
+// fraction of every process's outgoing packets to show the link riding it
+// out. Exit status is 0 on a clean session, 3 if a station's state or orders
+// didn't match the host's.
+
+#define _GNU_SOURCE
+#include "crew.h"
+#include "currents.h"
+#include "params.h"
+#include "seabed.h"
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define TICKS_PER_SECOND ((long)SIM_TICK_RATE)
+#define REPORT_INTERVAL 1.0 // s between status lines
+#define END_GRACE 2.0       // s the host waits for stations to catch up before saying goodbye anyway
+#define BYE_REPEATS 10      // Goodbyes sent, one per snapshot interval
+#define TEST_SECONDS 6.0f
+
+typedef struct
+{
+  float at; // s after the station joined
+  const char *order;
+} ScriptedOrder;
+
+// Orders each test station gives, timed from its first snapshot - the helm's
+// control_rods belongs to the reactor, and is meant to be turned away
+static const ScriptedOrder helmScript[] = {
+    {0.5f, "target_depth 80"}, {1.0f, "autopilot"}, {1.5f, "control_rods"}, {2.0f, "course 90"}, {3.0f, "course 135"}, {0}};
+static const ScriptedOrder reactorScript[] = {{0.5f, "rod_position 70"}, {2.5f, "rod_position 85"}, {0}};
+static const ScriptedOrder sonarScript[] = {{0.5f, "sonar"}, {3.5f, "communications"}, {0}};
+
+typedef struct
+{
+  uint16_t port;
+  const char *address;
+  int snapshot_rate;
+  float loss;
+  float seconds; // Simulated seconds the host runs, 0 = until killed; stations' wall-clock limit
+} Options;
+
+static void waitUntil(int fd, double until)
+{
+  double wait = until - crewNow();
+  if (wait <= 0.0)
+    return;
+  struct pollfd pfd = {.fd = fd, .events = POLLIN};
+  struct timespec timeout = {.tv_sec = (time_t)wait, .tv_nsec = (long)((wait - (time_t)wait) * 1e9)};
+  ppoll(&pfd, 1, &timeout, NULL);
+}
+
+static void printCounters(const char *who, const CrewCounters *c, double seconds)
+{
+  uint64_t snapshots = c->snapshots_full + c->snapshots_delta;
+  printf("%s: %llu/%llu packets out/in (%.1f/%.1f kB/s), %llu dropped, %llu snapshots (%llu full), "
+         "%.0f B each (%.0f%% of a whole state), %llu lost, %llu stale, orders %llu sent %llu applied %llu refused, "
+         "rtt %.2f ms (worst %.2f)\n",
+         who, (unsigned long long)c->packets_sent, (unsigned long long)c->packets_received,
+         c->bytes_sent / 1e3 / MAX(seconds, 1e-3), c->bytes_received / 1e3 / MAX(seconds, 1e-3),
+         (unsigned long long)c->packets_dropped, (unsigned long long)snapshots, (unsigned long long)c->snapshots_full,
+         snapshots ? (double)c->state_bytes / snapshots : 0.0,
+         c->state_raw_bytes ? 100.0 * c->state_bytes / c->state_raw_bytes : 0.0,
+         (unsigned long long)c->snapshots_lost, (unsigned long long)c->snapshots_stale,
+         (unsigned long long)c->commands_sent, (unsigned long long)c->commands_applied,
+         (unsigned long long)c->commands_rejected, c->rtt_ms, c->rtt_max_ms);
+  fflush(stdout);
+}
+
+static int runHost(const Options *options)
+{
+  CrewHost host;
+  SubmarineState start = initSubmarine();
+  if (!crewHostOpen(&host, options->port, &start))
+  {
+    fprintf(stderr, "host: can't listen on port %u: %s\n", options->port, strerror(errno));
+    return 1;
+  }
+  crewSetLoss(&host.loss, &host.rng, options->loss, 0x9E3779B9u);
+
+  double begin = crewNow(), next_tick = begin, next_snapshot = begin, next_report = begin + REPORT_INTERVAL;
+  double snapshot_interval = 1.0 / options->snapshot_rate;
+  long last_tick = options->seconds > 0.0f ? (long)(options->seconds * TICKS_PER_SECOND) : -1;
+  printf("host: port %u, %d snapshots/s, %d ticks/s\n", options->port, options->snapshot_rate, (int)TICKS_PER_SECOND);
+  fflush(stdout);
+
+  // Orders are applied as they arrive, which is always between ticks
+  while (last_tick < 0 || (long)host.tick < last_tick)
+  {
+    double now = crewNow();
+    crewHostPoll(&host, now);
+    for (; now >= next_tick && (last_tick < 0 || (long)host.tick < last_tick); next_tick += SIM_TICK_DT)
+    {
+      updateSubmarineState(&host.sub, SIM_TICK_DT);
+      host.tick++;
+    }
+    if (now >= next_snapshot)
+    {
+      crewHostBroadcast(&host);
+      next_snapshot += snapshot_interval;
+    }
+    if (now >= next_report)
+    {
+      printf("host: t %.0fs, %d station%s, depth %.1f m, reactor %.1f °C, hash %016llx\n", host.tick * SIM_TICK_DT,
+             crewHostStations(&host), crewHostStations(&host) == 1 ? "" : "s", host.sub.depth, host.sub.reactor_temp,
+             (unsigned long long)submarineStateHash(&host.sub));
+      printCounters("host", &host.counters, now - begin);
+      next_report += REPORT_INTERVAL;
+    }
+    waitUntil(host.socket, MIN(next_tick, next_snapshot));
+  }
+
+  // Clock stopped: send the final state once more, then resend that same
+  // snapshot to whoever hasn't acked it until everyone holds it, and say
+  // goodbye
+  double grace = crewNow() + END_GRACE;
+  crewHostBroadcast(&host);
+  next_snapshot = crewNow() + snapshot_interval;
+  while (!crewHostSynced(&host) && crewNow() < grace)
+  {
+    double now = crewNow();
+    crewHostPoll(&host, now);
+    if (now >= next_snapshot && !crewHostSynced(&host))
+    {
+      crewHostResend(&host);
+      next_snapshot += snapshot_interval;
+    }
+    waitUntil(host.socket, next_snapshot);
+  }
+  bool synced = crewHostSynced(&host);
+  for (int i = 0; i < BYE_REPEATS; i++)
+  {
+    crewHostEnd(&host);
+    waitUntil(-1, crewNow() + snapshot_interval);
+  }
+
+  printf("host: ended at tick %llu, snapshot %u, %d station%s %s, hash %016llx\n", (unsigned long long)host.tick,
+         host.sequence, crewHostStations(&host), crewHostStations(&host) == 1 ? "" : "s",
+         synced ? "in step" : "NOT in step", (unsigned long long)submarineStateHash(&host.sub));
+  printCounters("host", &host.counters, crewNow() - begin);
+  for (int i = 0; i < CREW_MAX_STATIONS; i++)
+  {
+    if (!host.peers[i].active)
+      continue;
+    char who[32];
+    snprintf(who, sizeof(who), "  %s", crewStationName(host.peers[i].station));
+    printCounters(who, &host.peers[i].counters, crewNow() - begin);
+  }
+  crewHostClose(&host);
+  return synced ? 0 : 3;
+}
+
+// "<command> [value]" -> false (and a message) if it isn't one
+static bool parseOrder(const char *line, SubmarineCommand *cmd)
+{
+  char name[64];
+  float value = 0.0f;
+  if (sscanf(line, "%63s %f", name, &value) < 1)
+    return false;
+  cmd->type = submarineCommandFromName(name);
+  cmd->value = value;
+  if (cmd->type == CMD_NONE)
+  {
+    fprintf(stderr, "%s: no such order\n", name);
+    return false;
+  }
+  return true;
+}
+
+// What each watch looks at
+static void printStation(const CrewStationLink *link)
+{
+  const SubmarineState *sub = &link->sub;
+  printf("%s: t %.1fs ", crewStationName(link->station), link->tick * SIM_TICK_DT);
+  switch (link->station)
+  {
+  case CREW_HELM:
+    printf("depth %.1f m (ordered %.0f), heading %.1f (course %.0f), %.1f m/s, %.0f m under the keel, autopilot %s\n",
+           sub->depth, sub->target_depth, sub->heading, sub->course, sub->forward_speed,
+           sub->bottom_depth - sub->depth, systemOn(sub, SYS_AUTOPILOT) ? "on" : "off");
+    break;
+  case CREW_REACTOR:
+    printf("reactor %.1f °C at %.0f%%, coolant %.1f °C, rods %.0f%% (ordered %.0f%%), battery %.0f%%\n",
+           sub->reactor_temp, sub->reactor_power, sub->coolant_temp, sub->rod_position * 100.0f,
+           sub->rod_target * 100.0f, sub->battery_level);
+    break;
+  case CREW_SONAR:
+    printf("sonar %s, %u pings, bottom %.0f m, position %.0f N %.0f E, comms %s\n",
+           systemOn(sub, SYS_SONAR) ? "on" : "off", sub->sonar_ping_count, sub->bottom_depth, sub->north, sub->east,
+           systemOn(sub, SYS_COMMUNICATIONS) ? "on" : "off");
+    break;
+  default:
+    printf("depth %.1f m, heading %.1f, %.1f m/s, hull %.1f%%, reactor %.1f °C, oxygen %.1f%%\n", sub->depth,
+           sub->heading, sub->forward_speed, sub->hull_integrity, sub->reactor_temp, sub->oxygen);
+    break;
+  }
+}
+
+// script NULL reads orders from stdin; quiet prints only the final report
+static int runStation(const Options *options, CrewStation station, const ScriptedOrder *script, bool quiet)
+{
+  CrewStationLink link;
+  if (!crewStationOpen(&link, options->address, options->port, station))
+  {
+    fprintf(stderr, "%s: can't reach %s:%u\n", crewStationName(station), options->address, options->port);
+    return 1;
+  }
+  crewSetLoss(&link.loss, &link.rng, options->loss, 0x85EBCA6Bu + station);
+
+  double begin = crewNow(), next_report = begin + REPORT_INTERVAL, joined = 0.0;
+  bool reading = script == NULL;
+  char line[256];
+  size_t line_length = 0;
+  while (!link.ended && !link.refused && (options->seconds <= 0.0f || crewNow() - begin < options->seconds))
+  {
+    double now = crewNow();
+    crewStationPoll(&link, now);
+
+    if (link.sequence && !joined)
+      joined = now;
+    for (; script && script->order && joined && now - joined >= script->at; script++)
+    {
+      SubmarineCommand cmd;
+      if (parseOrder(script->order, &cmd) && !crewStationCommand(&link, cmd))
+        fprintf(stderr, "%s: too many orders awaiting acknowledgement\n", crewStationName(station));
+    }
+
+    struct pollfd pfds[2] = {{.fd = link.socket, .events = POLLIN}, {.fd = reading ? STDIN_FILENO : -1, .events = POLLIN}};
+    if (poll(pfds, 2, (int)(CREW_RESEND_INTERVAL * 1000)) > 0 && (pfds[1].revents & (POLLIN | POLLHUP)))
+    {
+      ssize_t got = read(STDIN_FILENO, line + line_length, sizeof(line) - 1 - line_length);
+      if (got <= 0)
+        reading = false;
+      line_length += MAX(0, got);
+      line[line_length] = '\0';
+
+      // Every whole line is an order, what's left waits for the rest
+      char *end;
+      while ((end = strchr(line, '\n')) || line_length == sizeof(line) - 1)
+      {
+        size_t used = end ? (size_t)(end - line) + 1 : line_length;
+        line[used - 1] = '\0';
+        SubmarineCommand cmd;
+        if (parseOrder(line, &cmd) && !crewStationCommand(&link, cmd))
+          fprintf(stderr, "%s: too many orders awaiting acknowledgement\n", crewStationName(station));
+        memmove(line, line + used, line_length - used + 1);
+        line_length -= used;
+      }
+    }
+
+    if (!quiet && now >= next_report && link.sequence)
+    {
+      printStation(&link);
+      printCounters(crewStationName(station), &link.counters, now - begin);
+      next_report += REPORT_INTERVAL;
+    }
+  }
+
+  const char *name = crewStationName(station);
+  bool matched = link.bye_sequence && link.sequence == link.bye_sequence &&
+                 submarineStateHash(&link.sub) == link.bye_hash;
+  if (link.refused)
+    printf("%s: the host turned us away (full, or a different build)\n", name);
+  else if (!link.ended)
+    printf("%s: left before the host ended the session\n", name);
+  else if (!link.welcomed)
+    printf("%s: no answer from %s:%u\n", name, options->address, options->port);
+  else if (!link.bye_sequence)
+    printf("%s: lost the host\n", name);
+  else if (link.sequence != link.bye_sequence)
+    printf("%s: session over at snapshot %u, but the last we decoded was %u\n", name, link.bye_sequence,
+           link.sequence);
+  else
+    printf("%s: session over at snapshot %u, final state %s, %d order%s unacknowledged\n", name, link.bye_sequence,
+           matched ? "matches the host" : "DIFFERS from the host", crewStationPending(&link),
+           crewStationPending(&link) == 1 ? "" : "s");
+  printCounters(name, &link.counters, crewNow() - begin);
+  crewStationClose(&link);
+  return matched && crewStationPending(&link) == 0 ? 0 : 3;
+}
+
+// Host and three stations as separate processes, all on localhost
+static int runTest(Options options)
+{
+  static const struct
+  {
+    CrewStation station;
+    const ScriptedOrder *script;
+  } crew[] = {{CREW_HELM, helmScript}, {CREW_REACTOR, reactorScript}, {CREW_SONAR, sonarScript}};
+  const int stations = sizeof(crew) / sizeof(crew[0]);
+
+  options.address = "127.0.0.1";
+  if (options.seconds <= 0.0f)
+    options.seconds = TEST_SECONDS;
+  float host_seconds = options.seconds;
+  fflush(stdout);
+
+  pid_t pids[1 + sizeof(crew) / sizeof(crew[0])];
+  for (int i = 0; i <= stations; i++)
+  {
+    pids[i] = fork();
+    if (pids[i] < 0)
+    {
+      perror("fork");
+      return 1;
+    }
+    if (pids[i] == 0)
+    {
+      if (i == 0)
+        exit(runHost(&options));
+      options.seconds = host_seconds * 2.0f + END_GRACE + CREW_TIMEOUT; // Backstop, the host's goodbye ends them
+      exit(runStation(&options, crew[i - 1].station, crew[i - 1].script, true));
+    }
+    if (i == 0)
+      usleep(100000); // Let the host bind first - stations would only retry their hello anyway
+  }
+
+  int failures = 0;
+  for (int i = 0; i <= stations; i++)
+  {
+    int status;
+    waitpid(pids[i], &status, 0);
+    failures += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+  }
+  printf("test: %s (%d of %d processes failed)\n", failures ? "FAIL" : "pass", failures, stations + 1);
+  return failures ? 3 : 0;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s host [-p port] [-r snapshot_hz] [-L loss] [-t seconds] [-P file.params] [-C basin.cur] [-B seabed_seed]\n"
+          "       %s helm|reactor|sonar|conn [-a host_address] [-p port] [-L loss] [-t seconds]\n"
+          "       %s test [-p port] [-r snapshot_hz] [-L loss] [-t seconds]\n",
+          prog, prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+  Options options = {.port = CREW_DEFAULT_PORT, .address = "127.0.0.1", .snapshot_rate = CREW_SNAPSHOT_RATE};
+  static CurrentField currents;
+  unsigned int seabed_seed = SEABED_SEED;
+
+  if (argc < 2)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+  const char *mode = argv[1];
+  bool hosting = strcmp(mode, "host") == 0 || strcmp(mode, "test") == 0;
+  CrewStation station = crewStationFromName(mode);
+  if (!hosting && station == CREW_STATION_COUNT)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  for (int i = 2; i < argc; i++)
+  {
+    bool has_value = i + 1 < argc;
+    if (strcmp(argv[i], "-p") == 0 && has_value)
+      options.port = (uint16_t)atoi(argv[++i]);
+    else if (strcmp(argv[i], "-a") == 0 && has_value && !hosting)
+      options.address = argv[++i];
+    else if (strcmp(argv[i], "-r") == 0 && has_value && hosting)
+      options.snapshot_rate = MAX(1, atoi(argv[++i]));
+    else if (strcmp(argv[i], "-L") == 0 && has_value)
+      options.loss = strtof(argv[++i], NULL);
+    else if (strcmp(argv[i], "-t") == 0 && has_value)
+      options.seconds = strtof(argv[++i], NULL);
+    else if (strcmp(argv[i], "-P") == 0 && has_value && hosting)
+    {
+      if (!simParametersLoad(argv[++i], &simParameters))
+        return 1;
+    }
+    else if (strcmp(argv[i], "-C") == 0 && has_value && hosting)
+    {
+      if (!currentFieldMap(&currents, argv[++i]))
+      {
+        fprintf(stderr, "%s: not an ocean-current field\n", argv[i]);
+        return 1;
+      }
+      oceanCurrents = &currents;
+    }
+    else if (strcmp(argv[i], "-B") == 0 && has_value && hosting)
+      seabed_seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  // Only the host runs the model; stations just show its state
+  int status;
+  if (hosting)
+  {
+    if (seabed_seed)
+      seabedTerrain = seabedCreate(seabed_seed, 0);
+    status = strcmp(mode, "test") == 0 ? runTest(options) : runHost(&options);
+    seabedDestroy(seabedTerrain);
+  }
+  else
+    status = runStation(&options, station, NULL, false);
+  return status;
+}
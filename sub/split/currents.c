@@ -0,0 +1,311 @@
+#define _GNU_SOURCE
+#include "currents.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const CurrentField *oceanCurrents;
+
+// Synthetic basins (currentFieldGenerate)
+#define GYRE_SPEED 0.8f       // m/s at the surface where the gyre runs fastest
+#define GYRE_DEPTH 600.0f     // m, e-folding depth of the wind-driven flow
+#define EDDY_COUNT 12
+#define EDDY_SPEED 0.6f       // m/s at an eddy's rim, strongest one
+#define EDDY_DEPTH 1500.0f    // m, eddies reach further down than the gyre
+
+bool currentFieldMap(CurrentField *field, const char *path)
+{
+  memset(field, 0, sizeof(*field));
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  CurrentFieldHeader h;
+  bool valid = fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(h) && pread(fd, &h, sizeof(h), 0) == sizeof(h) &&
+               memcmp(h.magic, CURRENT_MAGIC, sizeof(h.magic)) == 0 && h.version == CURRENT_VERSION &&
+               h.nx >= 2 && h.ny >= 2 && h.nz >= 2 && h.spacing > 0.0f && h.depth_spacing > 0.0f &&
+               (size_t)st.st_size >= sizeof(h) + (size_t)h.nx * h.ny * h.nz * 2 * sizeof(float);
+  if (!valid)
+  {
+    close(fd);
+    return false;
+  }
+
+  // Nothing is read here - pages come in as boats sample them, and a boat's
+  // eight corners are scattered across two layers, so readahead only wastes I/O
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return false;
+  madvise(map, st.st_size, MADV_RANDOM);
+
+  field->map_size = st.st_size;
+  field->header = map;
+  field->points = (const float *)((const char *)map + sizeof(CurrentFieldHeader));
+  field->origin_east = h.origin_east;
+  field->origin_north = h.origin_north;
+  field->inverse_spacing = 1.0f / h.spacing;
+  field->inverse_depth_spacing = 1.0f / h.depth_spacing;
+  field->max_x = (float)(h.nx - 1);
+  field->max_y = (float)(h.ny - 1);
+  field->max_z = (float)(h.nz - 1);
+  field->row_stride = (size_t)h.nx * 2;
+  field->layer_stride = (size_t)h.nx * h.ny * 2;
+  return true;
+}
+
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+{
+  const unsigned char *bytes = data;
+  for (size_t i = 0; i < size; i++)
+    hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  return hash;
+}
+
+uint64_t currentFieldHash(const CurrentField *field)
+{
+  if (!field || !field->header)
+    return 0;
+
+  const CurrentFieldHeader *h = field->header;
+  uint64_t hash = hashBytes(0xcbf29ce484222325ULL, h, sizeof(*h));
+  size_t points = (size_t)h->nx * h->ny * h->nz;
+  size_t samples = MIN(points, (size_t)CURRENT_HASH_SAMPLES);
+  for (size_t i = 0; i < samples; i++)
+    hash = hashBytes(hash, &field->points[(i * (points - 1) / MAX(1, samples - 1)) * 2], 2 * sizeof(float));
+  return hash;
+}
+
+void currentFieldClose(CurrentField *field)
+{
+  if (field->header)
+    munmap((void *)field->header, field->map_size);
+  memset(field, 0, sizeof(*field));
+}
+
+static float randomUnit(unsigned int *state)
+{
+  unsigned int x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+bool currentFieldGenerate(const char *path, uint32_t nx, uint32_t ny, uint32_t nz, float spacing,
+                          float depth_spacing, unsigned int seed)
+{
+  if (nx < 2 || ny < 2 || nz < 2 || spacing <= 0.0f || depth_spacing <= 0.0f)
+    return false;
+
+  // Basin centred on the boat's starting point
+  float width = (nx - 1) * spacing, height = (ny - 1) * spacing;
+  CurrentFieldHeader h = {.version = CURRENT_VERSION, .nx = nx, .ny = ny, .nz = nz,
+                          .origin_east = -0.5f * width, .origin_north = -0.5f * height,
+                          .spacing = spacing, .depth_spacing = depth_spacing};
+  memcpy(h.magic, CURRENT_MAGIC, sizeof(h.magic));
+
+  struct
+  {
+    float x, y, radius, spin;
+  } eddies[EDDY_COUNT];
+  unsigned int rng = seed ? seed : 1u;
+  for (int e = 0; e < EDDY_COUNT; e++)
+  {
+    eddies[e].x = randomUnit(&rng) * width;
+    eddies[e].y = randomUnit(&rng) * height;
+    eddies[e].radius = (0.03f + 0.07f * randomUnit(&rng)) * MIN(width, height);
+    eddies[e].spin = (randomUnit(&rng) < 0.5f ? -1.0f : 1.0f) * (0.3f + 0.7f * randomUnit(&rng));
+  }
+
+  FILE *f = fopen(path, "wb");
+  float *layer = malloc((size_t)nx * ny * 2 * sizeof(float));
+  bool ok = f && layer && fwrite(&h, sizeof(h), 1, f) == 1;
+
+  for (uint32_t k = 0; ok && k < nz; k++)
+  {
+    float depth = k * depth_spacing;
+    float gyre = GYRE_SPEED * expf(-depth / GYRE_DEPTH);
+    float eddy = EDDY_SPEED * expf(-depth / EDDY_DEPTH);
+    for (uint32_t j = 0; j < ny; j++)
+    {
+      float y = j * spacing;
+      for (uint32_t i = 0; i < nx; i++)
+      {
+        // Gyre from the stream function -sin(pi x / W) sin(pi y / H), clockwise
+        float x = i * spacing;
+        float u = -gyre * sinf(PI * x / width) * cosf(PI * y / height);
+        float v = gyre * cosf(PI * x / width) * sinf(PI * y / height);
+
+        // Gaussian vortices, rim speed at r = radius / sqrt(2)
+        for (int e = 0; e < EDDY_COUNT; e++)
+        {
+          float dx = x - eddies[e].x, dy = y - eddies[e].y;
+          float r2 = (dx * dx + dy * dy) / (eddies[e].radius * eddies[e].radius);
+          if (r2 > 16.0f)
+            continue;
+          float swirl = eddy * eddies[e].spin * 2.33f * expf(-r2) / eddies[e].radius;
+          u -= swirl * dy;
+          v += swirl * dx;
+        }
+
+        float *point = layer + ((size_t)j * nx + i) * 2;
+        point[0] = u;
+        point[1] = v;
+      }
+    }
+    ok = fwrite(layer, sizeof(float) * 2, (size_t)nx * ny, f) == (size_t)nx * ny;
+  }
+
+  free(layer);
+  if (f && fclose(f) != 0)
+    ok = false;
+  return ok;
+}
+
+// Lower grid index along one axis and how far towards the next point it is
+static inline int gridCell(float coordinate, float max, float *fraction)
+{
+  coordinate = MAX(0.0f, MIN(max, coordinate));
+  int cell = MIN((int)coordinate, (int)max - 1);
+  *fraction = coordinate - cell;
+  return cell;
+}
+
+CurrentSample sampleCurrent(const CurrentField *field, float east, float north, float depth)
+{
+  if (!field)
+    return (CurrentSample){0.0f, 0.0f};
+
+  float fx, fy, fz;
+  int i = gridCell((east - field->origin_east) * field->inverse_spacing, field->max_x, &fx);
+  int j = gridCell((north - field->origin_north) * field->inverse_spacing, field->max_y, &fy);
+  int k = gridCell(depth * field->inverse_depth_spacing, field->max_z, &fz);
+
+  const float *p = field->points + k * field->layer_stride + j * field->row_stride + (size_t)i * 2;
+  float value[2];
+  for (int c = 0; c < 2; c++)
+  {
+    const float *q = p + c;
+    float upper = (q[0] + (q[2] - q[0]) * fx) * (1.0f - fy) +
+                  (q[field->row_stride] + (q[field->row_stride + 2] - q[field->row_stride]) * fx) * fy;
+    q += field->layer_stride;
+    float lower = (q[0] + (q[2] - q[0]) * fx) * (1.0f - fy) +
+                  (q[field->row_stride] + (q[field->row_stride + 2] - q[field->row_stride]) * fx) * fy;
+    value[c] = upper + (lower - upper) * fz;
+  }
+  return (CurrentSample){value[0], value[1]};
+}
+
+// CURRENT_LANES points per operation - the compiler maps these onto whatever
+// SIMD -march allows, the fleet build gets the widest
+typedef float vfloat __attribute__((vector_size(CURRENT_LANES * sizeof(float))));
+typedef int32_t vint __attribute__((vector_size(CURRENT_LANES * sizeof(int32_t))));
+
+static inline vfloat vsplat(float x) { return (vfloat){0} + x; }
+static inline vfloat vselect(vint mask, vfloat a, vfloat b) { return (vfloat)((mask & (vint)a) | (~mask & (vint)b)); }
+static inline vfloat vclamp(vfloat x, float max) { return vselect(x < 0.0f, vsplat(0.0f), vselect(x > max, vsplat(max), x)); }
+
+// gridCell for every lane
+static inline vint gridCells(vfloat coordinate, float max, vfloat *fraction)
+{
+  coordinate = vclamp(coordinate, max);
+  vint cell = __builtin_convertvector(coordinate, vint);
+  vint last = (vint){0} + ((int)max - 1);
+  vint over = cell > last;
+  cell = (over & last) | (~over & cell);
+  *fraction = coordinate - __builtin_convertvector(cell, vfloat);
+  return cell;
+}
+
+static inline vfloat loadLanes(const float *p)
+{
+  vfloat v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void storeLanes(float *p, vfloat v)
+{
+  memcpy(p, &v, sizeof(v));
+}
+
+void sampleCurrents(const CurrentField *field, const float *east, const float *north, const float *depth,
+                    float *current_east, float *current_north, int count)
+{
+  if (!field)
+  {
+    memset(current_east, 0, count * sizeof(float));
+    memset(current_north, 0, count * sizeof(float));
+    return;
+  }
+
+  int n = 0;
+  for (; n + CURRENT_LANES <= count; n += CURRENT_LANES)
+  {
+    vfloat fx, fy, fz;
+    vint i = gridCells((loadLanes(east + n) - field->origin_east) * field->inverse_spacing, field->max_x, &fx);
+    vint j = gridCells((loadLanes(north + n) - field->origin_north) * field->inverse_spacing, field->max_y, &fy);
+    vint k = gridCells(loadLanes(depth + n) * field->inverse_depth_spacing, field->max_z, &fz);
+
+    // The eight corners' two components, gathered lane by lane - [layer][row][column][component]
+    vfloat corner[2][2][2][2];
+    for (int lane = 0; lane < CURRENT_LANES; lane++)
+    {
+      const float *p = field->points + k[lane] * field->layer_stride + j[lane] * field->row_stride + (size_t)i[lane] * 2;
+      for (int dz = 0; dz < 2; dz++)
+        for (int dy = 0; dy < 2; dy++)
+        {
+          const float *q = p + dz * field->layer_stride + dy * field->row_stride;
+          corner[dz][dy][0][0][lane] = q[0];
+          corner[dz][dy][0][1][lane] = q[1];
+          corner[dz][dy][1][0][lane] = q[2];
+          corner[dz][dy][1][1][lane] = q[3];
+        }
+    }
+
+    vfloat value[2];
+    for (int c = 0; c < 2; c++)
+    {
+      vfloat layer[2];
+      for (int dz = 0; dz < 2; dz++)
+      {
+        vfloat south = corner[dz][0][0][c] + (corner[dz][0][1][c] - corner[dz][0][0][c]) * fx;
+        vfloat north_row = corner[dz][1][0][c] + (corner[dz][1][1][c] - corner[dz][1][0][c]) * fx;
+        layer[dz] = south * (1.0f - fy) + north_row * fy;
+      }
+      value[c] = layer[0] + (layer[1] - layer[0]) * fz;
+    }
+    storeLanes(current_east + n, value[0]);
+    storeLanes(current_north + n, value[1]);
+  }
+
+  for (; n < count; n++)
+  {
+    CurrentSample sample = sampleCurrent(field, east[n], north[n], depth[n]);
+    current_east[n] = sample.east;
+    current_north[n] = sample.north;
+  }
+}
+
+float courseToSteer(CurrentSample current, float track, float speed, float *made_good)
+{
+  float t = track * DEG2RAD;
+  float along = current.east * sinf(t) + current.north * cosf(t);
+  float across = current.east * cosf(t) - current.north * sinf(t); // Positive sets the boat to the right of track
+
+  // Crab into the set: the water speed's cross-track part has to cancel the current's
+  if (speed <= 0.0f || fabsf(across) >= speed)
+  {
+    *made_good = along;
+    return speed <= 0.0f ? wrapHeading(track) : wrapHeading(track - (across > 0.0f ? 90.0f : -90.0f));
+  }
+  float crab = asinf(-across / speed);
+  *made_good = speed * cosf(crab) + along;
+  return wrapHeading(track + crab / DEG2RAD);
+}
@@ -0,0 +1,102 @@
+#ifndef CURRENTS_H
+#define CURRENTS_H
+
+#include "constants.h"
+#include <stddef.h>
+
+// Ocean currents as a gridded volume - horizontal water velocity on a
+// regular east x north x depth lattice, read back by trilinear interpolation
+// wherever a boat is.
+//
+// File layout: CurrentFieldHeader, then nz layers of ny rows of nx points,
+// each point the (east, north) velocity in m/s as two floats. Layer 0 is the
+// surface, row 0 the southern edge, point 0 the western one. A basin file is
+// memory-mapped read-only and never read up front, so a field the size of an
+// ocean costs page faults only where boats actually go; the kernel drops
+// clean pages again under memory pressure. Outside the grid the edge values
+// carry on.
+
+#define CURRENT_MAGIC "SUBCUR01"
+#define CURRENT_VERSION 1
+#define GAME_CURRENTS_PATH "sub.currents" // Mapped by the game (and sub_replay) when present
+
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t nx, ny, nz;            // Grid points east, north and down (each >= 2)
+  float origin_east, origin_north; // m, where grid point (0, 0) sits in boat coordinates
+  float spacing;                  // m between points horizontally
+  float depth_spacing;            // m between layers
+  uint8_t reserved[24];
+} CurrentFieldHeader;
+
+typedef struct
+{
+  size_t map_size;
+  const CurrentFieldHeader *header;
+  const float *points; // (east, north) pairs after the header
+
+  // Read off the header once so the samplers don't touch its page
+  float origin_east, origin_north;
+  float inverse_spacing, inverse_depth_spacing;
+  float max_x, max_y, max_z; // Grid coordinates of the far corner
+  size_t row_stride, layer_stride; // In floats
+} CurrentField;
+
+typedef struct
+{
+  float east, north; // m/s
+} CurrentSample;
+
+// Process-wide field the model drifts the boat in, NULL = still water. Set
+// before any simulation threads start, read-only afterwards.
+extern const CurrentField *oceanCurrents;
+
+// Map a basin file, false if it isn't one or is shorter than its header says
+bool currentFieldMap(CurrentField *field, const char *path);
+void currentFieldClose(CurrentField *field);
+
+// Identity for journals: FNV-1a over the header and CURRENT_HASH_SAMPLES
+// points spread evenly through the grid, so checking a basin faults in a few
+// MB at most rather than reading it all. 0 for still water (field NULL).
+#define CURRENT_HASH_SAMPLES 4096
+uint64_t currentFieldHash(const CurrentField *field);
+
+// Write a synthetic basin - a wind-driven gyre fading with depth plus a few
+// eddies - one layer at a time, so it can be larger than memory
+bool currentFieldGenerate(const char *path, uint32_t nx, uint32_t ny, uint32_t nz, float spacing,
+                          float depth_spacing, unsigned int seed);
+
+// Water velocity at one point; field may be NULL
+CurrentSample sampleCurrent(const CurrentField *field, float east, float north, float depth);
+
+// The same for count points in structure-of-arrays form, CURRENT_LANES at a
+// time with vector arithmetic (the fleet's layout)
+#define CURRENT_LANES 8
+void sampleCurrents(const CurrentField *field, const float *east, const float *north, const float *depth,
+                    float *current_east, float *current_north, int count);
+
+// Transit planning: the heading to steer at speed (m/s through the water)
+// so the current carries the boat along track (degrees true), and the speed
+// it then makes good along it. A current too strong to hold the track
+// against gives the heading straight across it.
+float courseToSteer(CurrentSample current, float track, float speed, float *made_good);
+
+// Degrees in 0..360 - headings are nearly always in range already, so the
+// floor only runs for ones that just went past north
+static inline float wrapHeading(float heading)
+{
+  if (heading >= 0.0f && heading < 360.0f)
+    return heading;
+  heading -= 360.0f * floorf(heading * (1.0f / 360.0f));
+  return heading < 360.0f ? heading : 0.0f;
+}
+
+// Signed turn (-180..180) from one heading to another
+static inline float headingDifference(float to, float from)
+{
+  return wrapHeading(to - from + 180.0f) - 180.0f;
+}
+
+#endif
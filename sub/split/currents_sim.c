@@ -0,0 +1,202 @@
+// Ocean-current fields - writes synthetic basins, checks the lane sampler
+// against the scalar one and times both, and plans a transit through the
+// field the way the navigator would: straight track, course to steer and
+// speed made good leg by leg.
+//
+//   ./sub_currents [-g nx ny nz] [-d spacing depth_spacing] [-s seed] [-n samples] [-T east north knots depth] basin.cur
+//
+// -g writes basin.cur first, nx x ny x nz points centred on the start point
+// (4 km apart and 100 m between layers unless -d says otherwise). -T plans
+// from the start point to east/north km at a water speed in knots and a
+// depth in metres.
+
+#define _GNU_SOURCE
+#include "currents.h"
+#include <string.h>
+#include <time.h>
+
+#define TRANSIT_LEG 10000.0f // m of track per planned leg
+#define KNOT 0.514444f       // m/s
+
+static float randomUnit(unsigned int *state)
+{
+  unsigned int x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+static double secondsSince(const struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+// Scalar sampler against the lane one over random points in the basin
+static void checkSamplers(const CurrentField *field, int samples, unsigned int seed)
+{
+  float *east = malloc(samples * sizeof(float)), *north = malloc(samples * sizeof(float));
+  float *depth = malloc(samples * sizeof(float));
+  float *lane_east = malloc(samples * sizeof(float)), *lane_north = malloc(samples * sizeof(float));
+  float *scalar_east = malloc(samples * sizeof(float)), *scalar_north = malloc(samples * sizeof(float));
+
+  // A tenth past every edge, so the clamping gets exercised too
+  const CurrentFieldHeader *h = field->header;
+  float width = (h->nx - 1) * h->spacing, height = (h->ny - 1) * h->spacing, bottom = (h->nz - 1) * h->depth_spacing;
+  unsigned int rng = seed;
+  for (int i = 0; i < samples; i++)
+  {
+    east[i] = h->origin_east + (randomUnit(&rng) * 1.2f - 0.1f) * width;
+    north[i] = h->origin_north + (randomUnit(&rng) * 1.2f - 0.1f) * height;
+    depth[i] = (randomUnit(&rng) * 1.2f - 0.1f) * bottom;
+  }
+
+  // First pass faults the pages in, so both timings see the same warm mapping
+  sampleCurrents(field, east, north, depth, lane_east, lane_north, samples);
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < samples; i++)
+  {
+    CurrentSample c = sampleCurrent(field, east[i], north[i], depth[i]);
+    scalar_east[i] = c.east;
+    scalar_north[i] = c.north;
+  }
+  double scalar = secondsSince(&start);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  sampleCurrents(field, east, north, depth, lane_east, lane_north, samples);
+  double lanes = secondsSince(&start);
+
+  float worst = 0.0f;
+  for (int i = 0; i < samples; i++)
+    worst = MAX(worst, MAX(fabsf(lane_east[i] - scalar_east[i]), fabsf(lane_north[i] - scalar_north[i])));
+
+  printf("%d samples: scalar %.1f ns, %d lanes %.1f ns per sample, max difference %.2g m/s\n", samples,
+         scalar * 1e9 / samples, CURRENT_LANES, lanes * 1e9 / samples, worst);
+
+  free(east);
+  free(north);
+  free(depth);
+  free(lane_east);
+  free(lane_north);
+  free(scalar_east);
+  free(scalar_north);
+}
+
+// Dead-reckoned plan along the straight track, current taken at each leg's midpoint
+static void planTransit(const CurrentField *field, float to_east, float to_north, float speed, float depth)
+{
+  float length = hypotf(to_east, to_north);
+  float track = wrapHeading(atan2f(to_east, to_north) / DEG2RAD);
+  int legs = MAX(1, (int)ceilf(length / TRANSIT_LEG));
+
+  printf("leg,east_km,north_km,track,set,drift_kn,steer,made_good_kn,eta_h\n");
+  double hours = 0.0;
+  for (int leg = 0; leg < legs; leg++)
+  {
+    float from = leg * length / legs, to = (leg + 1) * length / legs;
+    float middle = 0.5f * (from + to) / length;
+    CurrentSample current = sampleCurrent(field, to_east * middle, to_north * middle, depth);
+
+    float made_good;
+    float steer = courseToSteer(current, track, speed, &made_good);
+    if (made_good <= 0.0f)
+    {
+      printf("%d: the current sets the boat back along track here - no passage at %.1f kn\n", leg, speed / KNOT);
+      return;
+    }
+    hours += (to - from) / made_good / 3600.0;
+    printf("%d,%.1f,%.1f,%.0f,%.0f,%.2f,%.1f,%.2f,%.2f\n", leg, to_east * to / length / 1000.0f,
+           to_north * to / length / 1000.0f, track, wrapHeading(atan2f(current.east, current.north) / DEG2RAD),
+           hypotf(current.east, current.north) / KNOT, steer, made_good / KNOT, hours);
+  }
+  printf("%.0f km in %.2f h, %.2f h in still water\n", length / 1000.0f, hours, length / speed / 3600.0f);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t nx = 0, ny = 0, nz = 0;
+  float spacing = 4000.0f, depth_spacing = 100.0f;
+  unsigned int seed = 1;
+  int samples = 1 << 20;
+  bool transit = false;
+  float to_east = 0.0f, to_north = 0.0f, knots = 0.0f, transit_depth = 0.0f;
+  const char *path = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    int left = argc - i - 1;
+    if (strcmp(argv[i], "-g") == 0 && left >= 3)
+    {
+      nx = (uint32_t)atoi(argv[++i]);
+      ny = (uint32_t)atoi(argv[++i]);
+      nz = (uint32_t)atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-d") == 0 && left >= 2)
+    {
+      spacing = strtof(argv[++i], NULL);
+      depth_spacing = strtof(argv[++i], NULL);
+    }
+    else if (strcmp(argv[i], "-s") == 0 && left >= 1)
+      seed = (unsigned int)strtoul(argv[++i], NULL, 10) | 1u;
+    else if (strcmp(argv[i], "-n") == 0 && left >= 1)
+      samples = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-T") == 0 && left >= 4)
+    {
+      transit = true;
+      to_east = strtof(argv[++i], NULL) * 1000.0f;
+      to_north = strtof(argv[++i], NULL) * 1000.0f;
+      knots = strtof(argv[++i], NULL);
+      transit_depth = strtof(argv[++i], NULL);
+    }
+    else if (argv[i][0] != '-' && !path)
+      path = argv[i];
+    else
+    {
+      path = NULL;
+      break;
+    }
+  }
+  if (!path || (transit && knots <= 0.0f))
+  {
+    fprintf(stderr, "usage: %s [-g nx ny nz] [-d spacing depth_spacing] [-s seed] [-n samples] "
+                    "[-T east north knots depth] basin.cur\n",
+            argv[0]);
+    return 1;
+  }
+
+  if (nx > 0)
+  {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!currentFieldGenerate(path, nx, ny, nz, spacing, depth_spacing, seed))
+    {
+      fprintf(stderr, "%s: could not write a %u x %u x %u basin\n", path, nx, ny, nz);
+      return 1;
+    }
+    printf("wrote %s in %.2fs\n", path, secondsSince(&start));
+  }
+
+  CurrentField field;
+  if (!currentFieldMap(&field, path))
+  {
+    fprintf(stderr, "%s: not an ocean-current field\n", path);
+    return 1;
+  }
+  const CurrentFieldHeader *h = field.header;
+  printf("%s: %u x %u x %u points, %.0f km x %.0f km x %.0f m, %.1f MB mapped\n", path, h->nx, h->ny, h->nz,
+         (h->nx - 1) * h->spacing / 1000.0f, (h->ny - 1) * h->spacing / 1000.0f, (h->nz - 1) * h->depth_spacing,
+         field.map_size / 1e6);
+
+  if (transit)
+    planTransit(&field, to_east, to_north, knots * KNOT, transit_depth);
+  if (samples > 0)
+    checkSamplers(&field, samples, seed);
+
+  currentFieldClose(&field);
+  return 0;
+}
@@ -0,0 +1,189 @@
+#include "electrical.h"
+#include "params.h"
+
+static const char *const busNames[BUS_COUNT] = {
+#define ELECTRICAL_BUS_NAME(name, label) label,
+    ELECTRICAL_BUS_TABLE(ELECTRICAL_BUS_NAME)
+#undef ELECTRICAL_BUS_NAME
+};
+
+static const char *const breakerNames[BREAKER_COUNT] = {
+#define ELECTRICAL_BREAKER_NAME(name, label) label,
+    ELECTRICAL_BREAKER_TABLE(ELECTRICAL_BREAKER_NAME)
+#undef ELECTRICAL_BREAKER_NAME
+};
+
+typedef struct
+{
+  uint8_t system;
+  uint8_t bus;
+  uint8_t priority;
+} ElectricalLoad;
+
+static const ElectricalLoad loads[] = {
+#define ELECTRICAL_LOAD_INFO(system, bus, priority) {system, BUS_##bus, priority},
+    ELECTRICAL_LOAD_TABLE(ELECTRICAL_LOAD_INFO)
+#undef ELECTRICAL_LOAD_INFO
+};
+
+#define LOAD_COUNT ((int)(sizeof(loads) / sizeof(loads[0])))
+
+static uint64_t busLoads[BUS_COUNT]; // Switch bits hanging off each bus
+static uint64_t switchedLoads;       // ... off any bus
+static uint64_t sheddableLoads;      // ... with a priority above 0
+static uint8_t sheddingOrder[LOAD_COUNT]; // Sheddable loads, most expendable first
+static int sheddableCount;
+
+__attribute__((constructor)) static void buildLoadTables(void)
+{
+  for (int l = 0; l < LOAD_COUNT; l++)
+  {
+    busLoads[loads[l].bus] |= SYS_BIT(loads[l].system);
+    switchedLoads |= SYS_BIT(loads[l].system);
+    if (loads[l].priority > 0)
+      sheddableLoads |= SYS_BIT(loads[l].system);
+  }
+
+  // Highest priority number first; within a priority, the later table line first
+  sheddableCount = 0;
+  for (int priority = 255; priority > 0; priority--)
+    for (int l = LOAD_COUNT - 1; l >= 0; l--)
+      if (loads[l].priority == priority)
+        sheddingOrder[sheddableCount++] = (uint8_t)l;
+}
+
+const char *electricalBusName(ElectricalBus bus)
+{
+  return bus < BUS_COUNT ? busNames[bus] : "?";
+}
+
+const char *electricalBreakerName(ElectricalBreaker breaker)
+{
+  return breaker < BREAKER_COUNT ? breakerNames[breaker] : "?";
+}
+
+static float busDemand(uint64_t on, ElectricalBus bus, const float *draw)
+{
+  float total = 0.0f;
+  for (uint64_t set = on & busLoads[bus]; set; set &= set - 1)
+    total += draw[__builtin_ctzll(set)];
+  return total;
+}
+
+// Re-sum the buses whose switches differ from the ones their demand was summed for
+static int resumBuses(SubmarineState *sub, const float *draw)
+{
+  uint64_t on = sub->systems & switchedLoads;
+  uint64_t moved = on ^ sub->power_loads;
+  int resummed = 0;
+  for (int bus = 0; moved && bus < BUS_COUNT; bus++)
+  {
+    if (moved & busLoads[bus])
+    {
+      sub->bus_demand[bus] = busDemand(on, bus, draw);
+      resummed++;
+    }
+  }
+  sub->power_loads = on;
+  return resummed;
+}
+
+int updateElectricalPlant(SubmarineState *sub, bool reactor_feed, float battery_drain_multiplier, float deltaTime)
+{
+  const SimParameters *params = activeSimParameters();
+  const float *draw = params->power_draw;
+
+  int resummed = resumBuses(sub, draw);
+
+  // A shed load the crew switched back on is theirs again
+  sub->power_shed &= ~sub->power_loads;
+
+  // Islands: each bus names the lowest bus it is tied to
+  int island[BUS_COUNT];
+  island[BUS_MAIN] = BUS_MAIN;
+  island[BUS_VITAL] = breakerClosed(sub, BREAKER_MAIN_TIE) ? island[BUS_MAIN] : BUS_VITAL;
+  island[BUS_EMERGENCY] = breakerClosed(sub, BREAKER_EMERGENCY_TIE) ? island[BUS_VITAL] : BUS_EMERGENCY;
+
+  // Sources, in dispatch order: turbine, battery, backup
+  float turbine = reactor_feed && breakerClosed(sub, BREAKER_TURBINE)
+                      ? ELECTRICAL_TURBINE_RATING * sub->reactor_power / 100.0f
+                      : 0.0f;
+  float battery = sub->battery_level > 0.0f && breakerClosed(sub, BREAKER_BATTERY)
+                      ? ELECTRICAL_BATTERY_RATING * MIN(1.0f, sub->battery_level / ELECTRICAL_BATTERY_SAG_LEVEL)
+                      : 0.0f;
+  float backup = systemOn(sub, SYS_BACKUP_POWER) && breakerClosed(sub, BREAKER_BACKUP) ? ELECTRICAL_BACKUP_RATING : 0.0f;
+
+  float supply[BUS_COUNT] = {0}, hotel[BUS_COUNT] = {0};
+  supply[island[BUS_MAIN]] += turbine + battery;
+  supply[island[BUS_EMERGENCY]] += backup;
+  for (int bus = 0; bus < BUS_COUNT; bus++)
+    hotel[island[bus]] += sub->bus_demand[bus];
+  hotel[island[BUS_EMERGENCY]] += ELECTRICAL_BASE_LOAD;
+
+  // Shed the most expendable loads on any island that can't carry them
+  bool short_supply = false;
+  for (int bus = 0; (sub->power_loads & sheddableLoads) && bus < BUS_COUNT; bus++)
+    short_supply |= hotel[bus] > supply[bus];
+
+  uint64_t shed = 0;
+  for (int i = 0; short_supply && i < sheddableCount; i++)
+  {
+    const ElectricalLoad *load = &loads[sheddingOrder[i]];
+    int at = island[load->bus];
+    if (hotel[at] > supply[at] && (sub->power_loads & SYS_BIT(load->system)))
+    {
+      shed |= SYS_BIT(load->system);
+      hotel[at] -= draw[load->system];
+    }
+  }
+
+  // ... and bring shed ones back, most important first, while there's headroom
+  uint64_t restored = 0;
+  for (int i = sheddableCount - 1; i >= 0 && sub->power_shed; i--)
+  {
+    const ElectricalLoad *load = &loads[sheddingOrder[i]];
+    int at = island[load->bus];
+    if ((sub->power_shed & SYS_BIT(load->system)) &&
+        hotel[at] + draw[load->system] <= supply[at] * ELECTRICAL_RESTORE_MARGIN)
+    {
+      restored |= SYS_BIT(load->system);
+      sub->power_shed &= ~SYS_BIT(load->system);
+      hotel[at] += draw[load->system];
+    }
+  }
+
+  if (shed | restored)
+  {
+    sub->systems = (sub->systems & ~shed) | restored;
+    sub->power_shed |= shed;
+    resummed += resumBuses(sub, draw);
+  }
+
+  // Propulsion takes what MAIN's island has left
+  int main_island = island[BUS_MAIN];
+  float propulsion = params->propulsion_power_drain * (fabsf(sub->thrust) / 100.0f);
+  float headroom = MAX(0.0f, supply[main_island] - hotel[main_island]);
+  sub->propulsion_supply = propulsion > 0.0f ? MIN(1.0f, headroom / propulsion) : 1.0f;
+  hotel[main_island] += propulsion * sub->propulsion_supply;
+
+  float served_total = 0.0f, supply_total = 0.0f;
+  float battery_share = 0.0f;
+  for (int bus = 0; bus < BUS_COUNT; bus++)
+  {
+    if (island[bus] != bus)
+      continue;
+    float served = MIN(hotel[bus], supply[bus]);
+    served_total += served;
+    supply_total += supply[bus];
+    if (bus == main_island)
+      battery_share = MIN(battery, MAX(0.0f, served - turbine));
+  }
+  sub->power_consumption = served_total;
+  sub->power_supply = supply_total;
+
+  if (battery_share > 0.0f)
+    sub->battery_level = MAX(0.0f, sub->battery_level - battery_share * params->battery_drain_rate *
+                                                            battery_drain_multiplier * deltaTime);
+
+  return resummed;
+}
@@ -0,0 +1,101 @@
+#ifndef ELECTRICAL_H
+#define ELECTRICAL_H
+
+#include "constants.h"
+
+// The boat's electrical plant as three buses joined by bus-tie breakers:
+//
+//   turbine --+                         backup
+//   battery --+-- MAIN --tie-- VITAL --tie-- EMERGENCY
+//
+// The reactor turbine and the battery feed MAIN, the backup generator feeds
+// EMERGENCY. Closed ties join buses into one island that shares its sources;
+// an open one leaves each side on its own. Every switched load hangs off one
+// bus with a shedding priority. When an island's sources can't carry its
+// loads, the least important are switched off (power_shed) until they can;
+// as supply comes back they are switched on again, most important first.
+// Propulsion is served last from whatever MAIN's island has left over
+// (propulsion_supply scales the shaft in updatePhysics).
+//
+// Bus demand is cached in the state with the load switches it was summed
+// for (power_loads), so a tick where no switch moved costs a mask compare
+// per bus, and the shedder only runs while an island is short or loads are
+// waiting to come back - not with the size of the load table.
+
+// Buses - each is one entry of SubmarineState.bus_demand
+#define ELECTRICAL_BUS_TABLE(X) \
+  X(MAIN, "MAIN")               \
+  X(VITAL, "VITAL")             \
+  X(EMERGENCY, "EMERG")
+
+typedef enum
+{
+#define ELECTRICAL_BUS_ENUM(name, label) BUS_##name,
+  ELECTRICAL_BUS_TABLE(ELECTRICAL_BUS_ENUM)
+#undef ELECTRICAL_BUS_ENUM
+  BUS_COUNT
+} ElectricalBus;
+
+_Static_assert(BUS_COUNT == ELECTRICAL_BUSES, "ELECTRICAL_BUSES in constants.h is out of date");
+
+// Breakers, one bit each of SubmarineState.breakers_open (CMD_BREAKER toggles them)
+#define ELECTRICAL_BREAKER_TABLE(X) \
+  X(TURBINE, "TURB")                \
+  X(BATTERY, "BATT")                \
+  X(BACKUP, "BKUP")                 \
+  X(MAIN_TIE, "TIE M-V")            \
+  X(EMERGENCY_TIE, "TIE V-E")
+
+typedef enum
+{
+#define ELECTRICAL_BREAKER_ENUM(name, label) BREAKER_##name,
+  ELECTRICAL_BREAKER_TABLE(ELECTRICAL_BREAKER_ENUM)
+#undef ELECTRICAL_BREAKER_ENUM
+  BREAKER_COUNT
+} ElectricalBreaker;
+
+// Switched loads: system, bus, shedding priority. 0 is never shed - the
+// reactor's own auxiliaries and the backup set's controls - and higher
+// numbers go first. Draws come from the params.h power_draw table.
+#define ELECTRICAL_LOAD_TABLE(X)             \
+  X(SYS_COOLANT_PUMPS, EMERGENCY, 0)         \
+  X(SYS_STEAM_GENERATOR, EMERGENCY, 0)       \
+  X(SYS_POWER_TURBINE, EMERGENCY, 0)         \
+  X(SYS_CONTAINMENT, EMERGENCY, 0)           \
+  X(SYS_EMERGENCY_COOLING, EMERGENCY, 0)     \
+  X(SYS_BACKUP_POWER, EMERGENCY, 0)          \
+  X(SYS_HULL_MONITORING, VITAL, 1)           \
+  X(SYS_BALLAST_CONTROL, VITAL, 1)           \
+  X(SYS_O2_GENERATOR, VITAL, 2)              \
+  X(SYS_CO2_SCRUBBERS, VITAL, 2)             \
+  X(SYS_AIR_CIRCULATION, VITAL, 2)           \
+  X(SYS_DEPTH_CONTROL, VITAL, 2)             \
+  X(SYS_GYROSCOPE, VITAL, 3)                 \
+  X(SYS_COOLING, MAIN, 3)                    \
+  X(SYS_NAV_COMPUTER, MAIN, 3)               \
+  X(SYS_SONAR, MAIN, 4)                      \
+  X(SYS_COMMUNICATIONS, MAIN, 5)             \
+  X(SYS_LIGHTS, MAIN, 5)
+
+#define ELECTRICAL_BASE_LOAD 0.1f         // Instruments and emergency lighting, always on EMERGENCY
+#define ELECTRICAL_TURBINE_RATING 40.0f   // Turbine generator output at 100 % reactor power
+#define ELECTRICAL_BATTERY_RATING 25.0f   // Battery output while charged
+#define ELECTRICAL_BATTERY_SAG_LEVEL 5.0f // % charge below which the battery's output falls off linearly
+#define ELECTRICAL_BACKUP_RATING 10.0f    // Backup generator output
+#define ELECTRICAL_RESTORE_MARGIN 0.9f    // A shed load comes back only if the island stays under this share of supply
+
+const char *electricalBusName(ElectricalBus bus);
+const char *electricalBreakerName(ElectricalBreaker breaker);
+
+static inline bool breakerClosed(const SubmarineState *sub, ElectricalBreaker breaker)
+{
+  return !((sub->breakers_open >> breaker) & 1);
+}
+
+// One plant step: re-sum the buses whose loads switched, dispatch the
+// sources, shed or restore loads, and drain the battery by its share.
+// reactor_feed says whether the turbine is generating. Returns the buses
+// whose demand was re-summed.
+int updateElectricalPlant(SubmarineState *sub, bool reactor_feed, float battery_drain_multiplier, float deltaTime);
+
+#endif
@@ -0,0 +1,85 @@
+#include "environment.h"
+
+#define WATER_DRAG_PER_FRAME 0.92f // REDUCED drag (was 0.88f)
+#define SURFACE_PRESSURE 1.01325f  // bar
+#define PRESSURE_PER_METER 0.1005f // bar/m, seawater at 1025 kg/m3
+#define SALINITY 35.0f             // ppt, open ocean
+
+static EnvironmentTables tables;
+
+// The exact models the tables are built from
+
+static float waterTemperatureAt(float depth)
+{
+  float temperature;
+  if (depth < THERMAL_LAYER_DEPTH)
+    temperature = 20.0f - (depth / THERMAL_LAYER_DEPTH) * 15.0f;
+  else
+    temperature = 5.0f - (depth - THERMAL_LAYER_DEPTH) / 1000.0f;
+  return MAX(2.0f, temperature);
+}
+
+// Mackenzie (1981) nine-term equation, good to 8 km - past that it just keeps
+// climbing with pressure, which is what real water does too
+static float soundSpeedAt(float depth, float temperature)
+{
+  double t = temperature, d = depth, s = SALINITY - 35.0;
+  return (float)(1448.96 + 4.591 * t - 5.304e-2 * t * t + 2.374e-4 * t * t * t + 1.340 * s + 1.630e-2 * d +
+                 1.675e-7 * d * d - 1.025e-2 * t * s - 7.139e-13 * t * d * d * d);
+}
+
+// Runs before main, so lookups never have to check whether the tables exist yet
+__attribute__((constructor)) static void buildTables(void)
+{
+  for (int row = 0; row < ENVIRONMENT_TABLE_ROWS; row++)
+  {
+    float depth = (float)(row * ENVIRONMENT_TABLE_STEP);
+    float temperature = waterTemperatureAt(depth);
+    tables.values[ENV_PRESSURE][row] = SURFACE_PRESSURE + depth * PRESSURE_PER_METER;
+    tables.values[ENV_LIGHT_LEVEL][row] = MAX(0.001f, MIN(1.0f, expf(-depth / LIGHT_PENETRATION_DEPTH)));
+    tables.values[ENV_WATER_TEMPERATURE][row] = temperature;
+    tables.values[ENV_SOUND_SPEED][row] = soundSpeedAt(depth, temperature);
+  }
+  tables.drag_per_tick = powf(WATER_DRAG_PER_FRAME, SIM_TICK_DT * 60.0f);
+}
+
+const EnvironmentTables *environmentTables(void)
+{
+  return &tables;
+}
+
+// Row below the depth and how far towards the next one it is
+static int tableRow(float depth, float *fraction)
+{
+  float position = MAX(0.0f, MIN(MAX_DEPTH, depth)) * (1.0f / ENVIRONMENT_TABLE_STEP);
+  int row = (int)position;
+  *fraction = position - row;
+  return row;
+}
+
+float environmentField(EnvironmentField field, float depth)
+{
+  const float *values = environmentTables()->values[field];
+  float fraction;
+  int row = tableRow(depth, &fraction);
+  return values[row] + (values[row + 1] - values[row]) * fraction;
+}
+
+EnvironmentSample sampleEnvironment(float depth)
+{
+  const EnvironmentTables *env = environmentTables();
+  float fraction;
+  int row = tableRow(depth, &fraction);
+  return (EnvironmentSample){
+#define ENVIRONMENT_LERP(id, name) .name = env->values[id][row] + (env->values[id][row + 1] - env->values[id][row]) * fraction,
+      ENVIRONMENT_FIELDS(ENVIRONMENT_LERP)
+#undef ENVIRONMENT_LERP
+  };
+}
+
+float waterDrag(float deltaTime)
+{
+  if (deltaTime == SIM_TICK_DT)
+    return environmentTables()->drag_per_tick;
+  return powf(WATER_DRAG_PER_FRAME, deltaTime * 60.0f);
+}
@@ -0,0 +1,56 @@
+#ifndef ENVIRONMENT_H
+#define ENVIRONMENT_H
+
+#include "constants.h"
+
+// Sea environment as a function of depth. Every quantity is tabulated once
+// at startup over 0..MAX_DEPTH at ENVIRONMENT_TABLE_STEP spacing and read
+// back with linear interpolation, so the model, the fleet lanes and the
+// renderer all see the same numbers and nobody pays for expf/powf per boat
+// per tick. The piecewise-linear temperature profile has its breakpoints on
+// table rows and comes back exact.
+
+#define ENVIRONMENT_TABLE_STEP 5 // m between rows
+#define ENVIRONMENT_TABLE_ROWS ((int)MAX_DEPTH / ENVIRONMENT_TABLE_STEP + 2) // +1 so MAX_DEPTH has a row above
+
+#define ENVIRONMENT_FIELDS(X)                                   \
+  X(ENV_PRESSURE, pressure)                   /* bar absolute */ \
+  X(ENV_LIGHT_LEVEL, light_level)             /* 0.001..1 of surface light */ \
+  X(ENV_WATER_TEMPERATURE, water_temperature) /* °C */          \
+  X(ENV_SOUND_SPEED, sound_speed)             /* m/s */
+
+typedef enum
+{
+#define ENVIRONMENT_ENUM(id, name) id,
+  ENVIRONMENT_FIELDS(ENVIRONMENT_ENUM)
+#undef ENVIRONMENT_ENUM
+  ENV_FIELD_COUNT
+} EnvironmentField;
+
+typedef struct
+{
+#define ENVIRONMENT_MEMBER(id, name) float name;
+  ENVIRONMENT_FIELDS(ENVIRONMENT_MEMBER)
+#undef ENVIRONMENT_MEMBER
+} EnvironmentSample;
+
+// One array per field, so a lane gather or a single lookup touches one cache line
+typedef struct
+{
+  float values[ENV_FIELD_COUNT][ENVIRONMENT_TABLE_ROWS];
+  float drag_per_tick; // waterDrag(SIM_TICK_DT), the one every fixed tick asks for
+} EnvironmentTables;
+
+// Built before main, read-only afterwards (safe from pool threads)
+const EnvironmentTables *environmentTables(void);
+
+// One field / every field at a depth, depth clamped to 0..MAX_DEPTH
+float environmentField(EnvironmentField field, float depth);
+EnvironmentSample sampleEnvironment(float depth);
+
+// Fraction of vertical speed left after deltaTime of water drag - the old
+// per-frame 0.92 at 60fps. Only the timestep matters, so the fixed tick gets
+// the cached value and longer compressed steps pay one powf.
+float waterDrag(float deltaTime);
+
+#endif
@@ -0,0 +1,530 @@
+#define _POSIX_C_SOURCE 200112L
+#include "fleet.h"
+#include "currents.h"
+#include "environment.h"
+#include "params.h"
+#include "thermal.h"
+#include <string.h>
+
+// GCC/Clang vector extensions - FLEET_LANES boats per operation. The compiler
+// maps these onto SSE/AVX/AVX-512 (or NEON) depending on -march.
+typedef float vfloat __attribute__((vector_size(FLEET_LANES * sizeof(float))));
+typedef int32_t vint __attribute__((vector_size(FLEET_LANES * sizeof(int32_t))));
+typedef uint64_t vmask __attribute__((vector_size(FLEET_LANES * sizeof(uint64_t))));
+
+// Comparisons give -1 (true) / 0 (false) per lane, so selects are bit blends
+static inline vfloat vselect(vint mask, vfloat a, vfloat b)
+{
+  return (vfloat)((mask & (vint)a) | (~mask & (vint)b));
+}
+
+static inline vfloat vmin(vfloat a, vfloat b) { return vselect(a < b, a, b); }
+static inline vfloat vmax(vfloat a, vfloat b) { return vselect(a > b, a, b); }
+static inline vfloat vabs(vfloat a) { return vselect(a < 0.0f, -a, a); }
+static inline vfloat vsplat(float x) { return (vfloat){0} + x; }
+
+static inline vfloat loadFloats(const float *p)
+{
+  vfloat v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void storeFloats(float *p, vfloat v)
+{
+  memcpy(p, &v, sizeof(v));
+}
+
+static inline vmask loadSystems(const uint64_t *p)
+{
+  vmask m;
+  memcpy(&m, p, sizeof(m));
+  return m;
+}
+
+static inline void storeSystems(uint64_t *p, vmask m)
+{
+  memcpy(p, &m, sizeof(m));
+}
+
+// One SubmarineSystem bit of every lane as a -1/0 lane mask
+static inline vint systemBit(vmask m, SubmarineSystem s)
+{
+  return __builtin_convertvector((m >> (int)s) & 1, vint) != 0;
+}
+
+// Write a lane mask back into one bit of the switch words
+static inline vmask withSystemBit(vmask m, SubmarineSystem s, vint on)
+{
+  vmask bit = __builtin_convertvector(on & 1, vmask) << (int)s;
+  return (m & ~((vmask){0} + SYS_BIT(s))) | bit;
+}
+
+static inline vmask vselectSystems(vint mask, vmask a, vmask b)
+{
+  vmask wide = __builtin_convertvector(mask, vmask);
+  return (wide & a) | (~wide & b);
+}
+
+// sin() for trim angles - odd polynomial, error < 1e-6 up to +-90 degrees
+static inline vfloat vsinSmall(vfloat x)
+{
+  vfloat x2 = x * x;
+  return x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f + x2 * (1.0f / 362880.0f)))));
+}
+
+// sin and cos of any angle >= 0 (headings): reduce to +-45 degrees around the
+// nearest quadrant, then swap and negate by which quadrant it was
+static inline void vsinCos(vfloat x, vfloat *sine, vfloat *cosine)
+{
+  vint quadrant = __builtin_convertvector(x * (2.0f / PI) + 0.5f, vint);
+  vfloat r = x - __builtin_convertvector(quadrant, vfloat) * (PI / 2.0f);
+  vfloat r2 = r * r;
+  vfloat s = r * (1.0f + r2 * (-1.0f / 6.0f + r2 * (1.0f / 120.0f + r2 * (-1.0f / 5040.0f))));
+  vfloat c = 1.0f + r2 * (-0.5f + r2 * (1.0f / 24.0f + r2 * (-1.0f / 720.0f + r2 * (1.0f / 40320.0f))));
+  vint swap = (quadrant & 1) != 0;
+  vfloat sv = vselect(swap, c, s), cv = vselect(swap, s, c);
+  *sine = vselect((quadrant & 2) != 0, -sv, sv);
+  *cosine = vselect(((quadrant + 1) & 2) != 0, -cv, cv);
+}
+
+// environmentField for every lane - same interpolation, the two rows fetched lane by lane
+static inline vfloat gatherEnvironment(const float *values, vfloat depth)
+{
+  vfloat position = vmax(vsplat(0.0f), vmin(vsplat(MAX_DEPTH), depth)) * (1.0f / ENVIRONMENT_TABLE_STEP);
+  vint row = __builtin_convertvector(position, vint);
+  vfloat fraction = position - __builtin_convertvector(row, vfloat);
+  vfloat below, above;
+  for (int lane = 0; lane < FLEET_LANES; lane++)
+  {
+    below[lane] = values[row[lane]];
+    above[lane] = values[row[lane] + 1];
+  }
+  return below + (above - below) * fraction;
+}
+
+bool fleetInit(SubmarineFleet *fleet, int count)
+{
+  memset(fleet, 0, sizeof(*fleet));
+  fleet->count = count;
+  fleet->capacity = (count + FLEET_LANES - 1) / FLEET_LANES * FLEET_LANES;
+
+  bool ok = true;
+#define FLEET_ALLOC(name, type)                                                              \
+  if (posix_memalign((void **)&fleet->name, 64, fleet->capacity * sizeof(type)) == 0)        \
+    memset(fleet->name, 0, fleet->capacity * sizeof(type));                                  \
+  else                                                                                       \
+    ok = false;
+#define FLEET_ALLOC_FLOAT(name) FLEET_ALLOC(name, float)
+  FLEET_FLOAT_FIELDS(FLEET_ALLOC_FLOAT)
+  FLEET_ALLOC(systems, uint64_t)
+#undef FLEET_ALLOC_FLOAT
+#undef FLEET_ALLOC
+
+  if (!ok)
+  {
+    fleetFree(fleet);
+    return false;
+  }
+
+  // Padding lanes get a harmless surfaced, cold boat
+  SubmarineState idle = initSubmarine();
+  for (int i = 0; i < fleet->capacity; i++)
+    fleetStoreBoat(fleet, i, &idle);
+  return true;
+}
+
+void fleetFree(SubmarineFleet *fleet)
+{
+#define FLEET_RELEASE(name) free(fleet->name);
+  FLEET_FLOAT_FIELDS(FLEET_RELEASE)
+#undef FLEET_RELEASE
+  free(fleet->systems);
+  memset(fleet, 0, sizeof(*fleet));
+}
+
+void fleetStoreBoat(SubmarineFleet *fleet, int index, const SubmarineState *sub)
+{
+#define FLEET_STORE_FLOAT(name) fleet->name[index] = sub->name;
+  FLEET_FLOAT_FIELDS(FLEET_STORE_FLOAT)
+#undef FLEET_STORE_FLOAT
+  fleet->systems[index] = sub->systems;
+}
+
+void fleetLoadBoat(const SubmarineFleet *fleet, int index, SubmarineState *sub)
+{
+#define FLEET_LOAD_FLOAT(name) sub->name = fleet->name[index];
+  FLEET_FLOAT_FIELDS(FLEET_LOAD_FLOAT)
+#undef FLEET_LOAD_FLOAT
+  sub->systems = fleet->systems[index];
+}
+
+// ThermalNetwork / ThermalNodes with one lane per boat
+typedef struct
+{
+  vfloat core_heat, core_feedback;
+  vfloat core_coolant, coolant_steam, steam_sea, coolant_sea, coolant_cabin, cabin_environment, cooler;
+  vfloat sea_temp, cabin_target, cooler_temp;
+} FleetThermalNetwork;
+
+typedef struct
+{
+  vfloat core, coolant, steam_generator, cabin;
+} FleetThermalNodes;
+
+static inline FleetThermalNodes fleetThermalRates(const FleetThermalNetwork *net, const FleetThermalNodes *t)
+{
+  const SimParameters *params = activeSimParameters();
+  vfloat to_core = net->core_coolant * (t->coolant - t->core);
+  vfloat to_steam = net->coolant_steam * (t->coolant - t->steam_generator);
+  vfloat to_cabin = net->coolant_cabin * (t->coolant - t->cabin);
+
+  return (FleetThermalNodes){
+      (net->core_heat + net->core_feedback * t->core + to_core) / params->thermal_core_capacity,
+      (-to_core - to_steam - to_cabin + net->coolant_sea * (net->sea_temp - t->coolant) +
+       net->cooler * (net->cooler_temp - t->coolant)) /
+          params->thermal_coolant_capacity,
+      (to_steam + net->steam_sea * (net->sea_temp - t->steam_generator)) / params->thermal_steam_capacity,
+      (to_cabin + net->cabin_environment * (net->cabin_target - t->cabin)) / params->thermal_cabin_capacity,
+  };
+}
+
+// Same star elimination as thermalSolve
+static inline FleetThermalNodes fleetThermalSolve(const FleetThermalNetwork *net, const FleetThermalNodes *r, float h)
+{
+  const SimParameters *params = activeSimParameters();
+  vfloat core_d = params->thermal_core_capacity + h * (net->core_coolant - net->core_feedback);
+  vfloat core_p = (params->thermal_core_capacity * r->core + h * net->core_heat) / core_d;
+  vfloat core_q = h * net->core_coolant / core_d;
+
+  vfloat steam_d = params->thermal_steam_capacity + h * (net->coolant_steam + net->steam_sea);
+  vfloat steam_p = (params->thermal_steam_capacity * r->steam_generator + h * net->steam_sea * net->sea_temp) / steam_d;
+  vfloat steam_q = h * net->coolant_steam / steam_d;
+
+  vfloat cabin_d = params->thermal_cabin_capacity + h * (net->coolant_cabin + net->cabin_environment);
+  vfloat cabin_p = (params->thermal_cabin_capacity * r->cabin + h * net->cabin_environment * net->cabin_target) / cabin_d;
+  vfloat cabin_q = h * net->coolant_cabin / cabin_d;
+
+  vfloat coolant_d = params->thermal_coolant_capacity +
+                     h * (net->core_coolant * (1.0f - core_q) + net->coolant_steam * (1.0f - steam_q) +
+                          net->coolant_cabin * (1.0f - cabin_q) + net->coolant_sea + net->cooler);
+  vfloat coolant = (params->thermal_coolant_capacity * r->coolant +
+                    h * (net->core_coolant * core_p + net->coolant_steam * steam_p + net->coolant_cabin * cabin_p +
+                         net->coolant_sea * net->sea_temp + net->cooler * net->cooler_temp)) /
+                   coolant_d;
+
+  return (FleetThermalNodes){core_p + core_q * coolant, coolant, steam_p + steam_q * coolant, cabin_p + cabin_q * coolant};
+}
+
+void fleetUpdateReactor(SubmarineFleet *fleet, int first, int count, float deltaTime)
+{
+  const SimParameters *params = activeSimParameters();
+  const vfloat zero = vsplat(0.0f);
+
+  for (int i = first; i < first + count; i += FLEET_LANES)
+  {
+    vfloat temp = loadFloats(fleet->reactor_temp + i);
+    vfloat coolant = loadFloats(fleet->coolant_temp + i);
+    vfloat steam_temp = loadFloats(fleet->steam_generator_temp + i);
+    vfloat water = loadFloats(fleet->water_temperature + i);
+    vfloat hull_temp = loadFloats(fleet->hull_temperature + i);
+    vfloat hull = loadFloats(fleet->hull_integrity + i);
+    vfloat battery = loadFloats(fleet->battery_level + i);
+    vfloat depth = loadFloats(fleet->depth + i);
+
+    vmask systems = loadSystems(fleet->systems + i);
+    vint active = systemBit(systems, SYS_REACTOR);
+    vint rods_in = systemBit(systems, SYS_CONTROL_RODS_INSERTED);
+    vint pumps = systemBit(systems, SYS_COOLANT_PUMPS);
+    vint steam = systemBit(systems, SYS_STEAM_GENERATOR);
+    vint turbine = systemBit(systems, SYS_POWER_TURBINE);
+    vint emergency_cooling = systemBit(systems, SYS_EMERGENCY_COOLING);
+    vint cooling = systemBit(systems, SYS_COOLING);
+    vint backup = systemBit(systems, SYS_BACKUP_POWER);
+    vint destroyed = systemBit(systems, SYS_REACTOR_DESTROYED);
+
+    vint powered = (battery > 5.0f) | backup;
+
+    // Thermal network: fission heat with the runaway term, or decay heat
+    FleetThermalNetwork net;
+    vint heating = active & ~rods_in;
+    vint decaying = ~heating & (temp > 20.0f);
+    vint decay_linear = decaying & (temp > REACTOR_NORMAL_TEMP * 0.1f);
+    net.core_heat = vselect(heating, vsplat(params->reactor_base_heat_rate),
+                            vselect(decaying & ~decay_linear, vsplat(params->reactor_residual_heat_rate * 0.1f), zero));
+    net.core_feedback = vselect(heating, vsplat(params->reactor_exponential_factor),
+                                vselect(decay_linear, vsplat(params->reactor_residual_heat_rate / REACTOR_NORMAL_TEMP), zero));
+
+    net.core_coolant = vselect(pumps & powered, vsplat(params->thermal_pumped_conductance), vsplat(params->thermal_natural_conductance));
+    net.coolant_steam = vselect(steam, vsplat(params->thermal_steam_conductance), vsplat(params->thermal_steam_idle_conductance));
+    net.steam_sea = vselect(turbine, vsplat(params->thermal_turbine_conductance), vsplat(params->thermal_turbine_idle_conductance));
+    net.coolant_sea = params->thermal_sea_conductance + vselect(emergency_cooling, vsplat(params->thermal_emergency_conductance), zero);
+    net.coolant_cabin = vsplat(params->thermal_cabin_conductance);
+    net.cabin_environment = vsplat(params->thermal_environment_conductance);
+    net.sea_temp = water;
+    net.cooler_temp = water + params->thermal_cooler_setpoint;
+
+    // Cabin environment target
+    vfloat cabin = water + 10.0f;
+    cabin -= vselect(systemBit(systems, SYS_AIR_CIRCULATION), vsplat(5.0f), zero);
+    cabin -= vselect(emergency_cooling, vsplat(8.0f), zero);
+    cabin -= depth / 1000.0f * 2.0f;
+    vfloat breach_factor = (50.0f - hull) / 50.0f;
+    cabin = vselect(hull < 50.0f, water + (cabin - water) * (1.0f - breach_factor), cabin);
+    cabin += vselect(systemBit(systems, SYS_EMERGENCY_LIGHTING), vsplat(2.0f), zero);
+    net.cabin_target = cabin;
+
+    // Active cooler, pulling only while the coolant is above its setpoint
+    vint cooler_powered = (battery > 10.0f) | backup;
+    vint cooler_on = cooling & cooler_powered & ~destroyed & (pumps | emergency_cooling) & (coolant > net.cooler_temp);
+    vfloat cooler_boost = vselect(emergency_cooling, vselect(pumps, vsplat(1.6f), vsplat(1.3f)), vsplat(1.0f));
+    net.cooler = vselect(cooler_on, params->thermal_cooler_conductance * cooler_boost, zero);
+
+    // TR-BDF2 step, as thermalNetworkStep
+    FleetThermalNodes t0 = {temp, coolant, steam_temp, hull_temp};
+    float h = 0.5f * TRBDF2_GAMMA * deltaTime;
+    FleetThermalNodes rate = fleetThermalRates(&net, &t0);
+    FleetThermalNodes r = {t0.core + h * rate.core, t0.coolant + h * rate.coolant,
+                           t0.steam_generator + h * rate.steam_generator, t0.cabin + h * rate.cabin};
+    FleetThermalNodes tg = fleetThermalSolve(&net, &r, h);
+    r = (FleetThermalNodes){TRBDF2_A * tg.core - TRBDF2_B * t0.core, TRBDF2_A * tg.coolant - TRBDF2_B * t0.coolant,
+                            TRBDF2_A * tg.steam_generator - TRBDF2_B * t0.steam_generator,
+                            TRBDF2_A * tg.cabin - TRBDF2_B * t0.cabin};
+    FleetThermalNodes t1 = fleetThermalSolve(&net, &r, TRBDF2_W * deltaTime);
+
+    temp = vmax(water, t1.core);
+    coolant = vmax(water, t1.coolant);
+    steam_temp = vmax(water, t1.steam_generator);
+    hull_temp = vmax(vsplat(-10.0f), vmin(vsplat(80.0f), t1.cabin));
+
+    // Automatic scram
+    vint scram = (temp > REACTOR_SCRAM_TEMP) & active;
+    active &= ~scram;
+    rods_in |= scram;
+
+    // Destruction
+    vint meltdown = (temp > REACTOR_MELTDOWN_TEMP) & ~destroyed;
+    destroyed |= meltdown;
+    active &= ~meltdown;
+    hull = vselect(meltdown, hull - 50.0f, hull);
+    temp = vselect(meltdown, vsplat(REACTOR_MELTDOWN_TEMP + 100.0f), temp);
+
+    // Power generation
+    vint generating = active & ~destroyed & steam & turbine & powered;
+    vfloat efficiency = vselect(temp > REACTOR_CRITICAL_TEMP, vsplat(0.3f),
+                                vselect(temp > REACTOR_WARNING_TEMP, vsplat(0.7f),
+                                        vselect(temp < 50.0f, vsplat(0.2f), vsplat(1.0f))));
+    vfloat power = vmin(vsplat(100.0f), temp / (REACTOR_NORMAL_TEMP * 0.7f) * 100.0f * efficiency);
+    power = vselect(generating, power, zero);
+
+    vint charging = generating & (power > 10.0f);
+    vfloat charged = vmin(vsplat(100.0f), battery + power / 100.0f * (params->battery_charge_rate * deltaTime));
+    battery = vselect(charging, charged, battery);
+
+    storeFloats(fleet->reactor_temp + i, temp);
+    storeFloats(fleet->coolant_temp + i, coolant);
+    storeFloats(fleet->steam_generator_temp + i, steam_temp);
+    storeFloats(fleet->hull_temperature + i, hull_temp);
+    storeFloats(fleet->hull_integrity + i, hull);
+    storeFloats(fleet->battery_level + i, battery);
+    storeFloats(fleet->reactor_power + i, power);
+    systems = withSystemBit(systems, SYS_REACTOR, active);
+    systems = withSystemBit(systems, SYS_CONTROL_RODS_INSERTED, rods_in);
+    systems = withSystemBit(systems, SYS_REACTOR_DESTROYED, destroyed);
+    storeSystems(fleet->systems + i, systems);
+  }
+}
+
+// Electrical load, water temperature and battery drain - the parts of
+// updatePowerAndEnvironment that feed back into the reactor and physics
+void fleetUpdatePower(SubmarineFleet *fleet, int first, int count, float deltaTime)
+{
+  const SimParameters *params = activeSimParameters();
+  const vfloat zero = vsplat(0.0f);
+  const vmask power_off = ~((vmask){0} + (SYS_BIT(SYS_LIGHTS) | SYS_BIT(SYS_SONAR)));
+  const float *water_table = environmentTables()->values[ENV_WATER_TEMPERATURE];
+
+  for (int i = first; i < first + count; i += FLEET_LANES)
+  {
+    vmask systems = loadSystems(fleet->systems + i);
+    vfloat battery = loadFloats(fleet->battery_level + i);
+    vfloat thrust = loadFloats(fleet->thrust + i);
+    vfloat depth = loadFloats(fleet->depth + i);
+    vfloat temp = loadFloats(fleet->reactor_temp + i);
+    vfloat power = loadFloats(fleet->reactor_power + i);
+
+    vint has_power = (battery > 0.0f) | systemBit(systems, SYS_BACKUP_POWER);
+
+    // Same masked sum as systemsPowerDraw, one switch bit across all lanes at a time
+    vfloat draw = zero;
+    for (int bit = 0; bit < SYS_COUNT; bit++)
+    {
+      if (params->power_draw[bit] != 0.0f)
+        draw += __builtin_convertvector((systems >> bit) & 1, vfloat) * params->power_draw[bit];
+    }
+    vfloat consumption = 0.1f + vselect(has_power, draw, zero);
+    consumption += vselect(has_power, params->propulsion_power_drain * (vabs(thrust) / 100.0f), zero);
+
+    vfloat water = gatherEnvironment(water_table, depth);
+
+    // Battery drains unless the reactor is carrying the load
+    vint overheated = temp > 600.0f;
+    vint reactor_supply = systemBit(systems, SYS_REACTOR) & (power > 30.0f) & ~overheated;
+    vint draining = ~reactor_supply & (battery > 0.0f) & has_power & (consumption > 0.1f);
+    vfloat multiplier = vselect(overheated, vsplat(2.0f), vsplat(1.0f));
+    battery = vselect(draining, vmax(zero, battery - consumption * params->battery_drain_rate * multiplier * deltaTime), battery);
+    battery = vselect(overheated & (battery > 0.0f), vmax(zero, battery - 3.0f * deltaTime), battery);
+
+    systems = vselectSystems(has_power, systems, systems & power_off);
+
+    storeFloats(fleet->power_consumption + i, consumption);
+    storeFloats(fleet->water_temperature + i, water);
+    storeFloats(fleet->battery_level + i, battery);
+    storeSystems(fleet->systems + i, systems);
+  }
+}
+
+void fleetUpdatePhysics(SubmarineFleet *fleet, int first, int count, float deltaTime)
+{
+  const SimParameters *params = activeSimParameters();
+  const vfloat zero = vsplat(0.0f);
+  const vfloat hundred = vsplat(100.0f);
+  // Drag only depends on the timestep, so it's one lookup per call instead of per boat
+  const float drag = waterDrag(deltaTime);
+
+  for (int i = first; i < first + count; i += FLEET_LANES)
+  {
+    vfloat level = loadFloats(fleet->ballast_level + i);
+    vfloat depth = loadFloats(fleet->depth + i);
+    vfloat vspeed = loadFloats(fleet->vertical_speed + i);
+    vfloat trim = loadFloats(fleet->trim_angle + i);
+    vfloat thrust = loadFloats(fleet->thrust + i);
+    vfloat hull = loadFloats(fleet->hull_integrity + i);
+    vfloat battery = loadFloats(fleet->battery_level + i);
+
+    vmask systems = loadSystems(fleet->systems + i);
+    vint backup = systemBit(systems, SYS_BACKUP_POWER);
+    vint ballast_control = systemBit(systems, SYS_BALLAST_CONTROL);
+    vint filled = systemBit(systems, SYS_BALLAST_TANKS_FILLED);
+    vint blow = systemBit(systems, SYS_BALLAST_BLOW);
+    vint gyro = systemBit(systems, SYS_GYROSCOPE);
+    vint depth_control = systemBit(systems, SYS_DEPTH_CONTROL);
+    vint emergency = systemBit(systems, SYS_EMERGENCY_SURFACE);
+
+    // Ballast tanks
+    vint ballast_power = (battery > 0.0f) | backup;
+    vint controlled = ballast_control & ballast_power;
+    level = vselect(controlled & filled & (level < 100.0f), vmin(hundred, level + params->ballast_fill_rate * deltaTime), level);
+    level = vselect(controlled & ~filled & (level > 0.0f), vmax(zero, level - params->ballast_empty_rate * deltaTime), level);
+    level = vselect(blow & (level > 0.0f), vmax(zero, level - params->ballast_empty_rate * 4.0f * deltaTime), level);
+
+    // Buoyancy from ballast plus flooding weight
+    vfloat weight = (level - 50.0f) / 50.0f * 50.0f;
+    weight += vselect(hull < 50.0f, (50.0f - hull) / 50.0f * 12.0f, zero);
+
+    vfloat nav = vselect(gyro, vsplat(1.0f), vsplat(0.85f)) *
+                 vselect(depth_control, vsplat(1.0f), vsplat(0.9f)) *
+                 vselect(controlled, vsplat(1.0f), vsplat(0.5f));
+
+    vfloat trim_effect = vsinSmall(trim * DEG2RAD) * 6.0f * nav;
+    vfloat target = (weight + trim_effect + thrust * 0.12f) * nav;
+
+    vfloat acceleration = 8.0f / (1.0f + vabs(vspeed) * 0.05f);
+    vspeed += (target - vspeed) * acceleration * deltaTime;
+    vspeed *= drag;
+
+    depth = vmax(zero, vmin(vsplat(MAX_DEPTH), depth + vspeed * deltaTime));
+
+    // Surface
+    vint surfaced = depth <= 0.0f;
+    vspeed = vselect(surfaced, vmax(zero, vspeed), vspeed);
+    emergency &= ~surfaced;
+
+    // Emergency surface
+    filled &= ~emergency;
+    blow |= emergency;
+    thrust = vselect(emergency, vsplat(-100.0f), thrust);
+    vspeed = vselect(emergency, vmin(vsplat(-12.0f), vspeed), vspeed);
+
+    // Pressure damage
+    vfloat pressure_ratio = depth / MAX_DEPTH;
+    vint crushing = (pressure_ratio > 0.8f) & (hull > 0.0f);
+    hull = vselect(crushing, vmax(zero, hull - (pressure_ratio - 0.8f) * 15.0f * deltaTime), hull);
+
+    // Hull breach flooding, lumped - no compartments in the fleet (fleet.h)
+    vint breached = hull < 25.0f;
+    vfloat severity = (25.0f - hull) / 25.0f;
+    level = vselect(breached, vmin(hundred, level + severity * 40.0f * deltaTime), level);
+    vint shorting = breached & (hull < 10.0f) & (battery > 0.0f);
+    battery = vselect(shorting, vmax(zero, battery - 5.0f * deltaTime), battery);
+
+    storeFloats(fleet->ballast_level + i, level);
+    storeFloats(fleet->depth + i, depth);
+    storeFloats(fleet->vertical_speed + i, vspeed);
+    storeFloats(fleet->thrust + i, thrust);
+    storeFloats(fleet->hull_integrity + i, hull);
+    storeFloats(fleet->battery_level + i, battery);
+    storeFloats(fleet->speed + i, vabs(vspeed) * 3.6f);
+    systems = withSystemBit(systems, SYS_BALLAST_TANKS_FILLED, filled);
+    systems = withSystemBit(systems, SYS_BALLAST_BLOW, blow);
+    systems = withSystemBit(systems, SYS_EMERGENCY_SURFACE, emergency);
+    storeSystems(fleet->systems + i, systems);
+  }
+}
+
+void fleetUpdateNavigation(SubmarineFleet *fleet, int first, int count, float deltaTime)
+{
+  // Every boat's current in one pass - the trilinear blend runs CURRENT_LANES wide (currents.c)
+  sampleCurrents(oceanCurrents, fleet->east + first, fleet->north + first, fleet->depth + first,
+                 fleet->current_east + first, fleet->current_north + first, count);
+
+  const float pull = MIN(1.0f, ACCELERATION / MAX_SPEED * deltaTime);
+
+  for (int i = first; i < first + count; i += FLEET_LANES)
+  {
+    vfloat speed = loadFloats(fleet->forward_speed + i);
+    vfloat thrust = loadFloats(fleet->thrust + i);
+    speed += (thrust * (MAX_SPEED / 100.0f) - speed) * pull;
+
+    vfloat sine, cosine;
+    vsinCos(loadFloats(fleet->heading + i) * DEG2RAD, &sine, &cosine);
+    vfloat east = loadFloats(fleet->east + i) + (speed * sine + loadFloats(fleet->current_east + i)) * deltaTime;
+    vfloat north = loadFloats(fleet->north + i) + (speed * cosine + loadFloats(fleet->current_north + i)) * deltaTime;
+
+    storeFloats(fleet->forward_speed + i, speed);
+    storeFloats(fleet->east + i, east);
+    storeFloats(fleet->north + i, north);
+  }
+}
+
+void fleetUpdateNitrogenNarcosis(SubmarineFleet *fleet, int first, int count, float deltaTime)
+{
+  const vfloat zero = vsplat(0.0f);
+
+  for (int i = first; i < first + count; i += FLEET_LANES)
+  {
+    vfloat depth = loadFloats(fleet->depth + i);
+    vfloat nitrogen = loadFloats(fleet->nitrogen_level + i);
+
+    vfloat absorbed = vmin(vsplat(100.0f), nitrogen + (depth - NITROGEN_NARCOSIS_DEPTH) / 1000.0f * 0.5f * deltaTime);
+    vfloat recovered = vmax(zero, nitrogen - 2.0f * deltaTime);
+    nitrogen = vselect(depth > NITROGEN_NARCOSIS_DEPTH, absorbed, vselect(nitrogen > 0.0f, recovered, nitrogen));
+
+    storeFloats(fleet->nitrogen_level + i, nitrogen);
+  }
+}
+
+void fleetStepRange(SubmarineFleet *fleet, int first, int count, float deltaTime)
+{
+  // Same order as updateSubmarineState: reactor, environment, physics, navigation, narcosis
+  fleetUpdateReactor(fleet, first, count, deltaTime);
+  fleetUpdatePower(fleet, first, count, deltaTime);
+  fleetUpdatePhysics(fleet, first, count, deltaTime);
+  fleetUpdateNavigation(fleet, first, count, deltaTime);
+  fleetUpdateNitrogenNarcosis(fleet, first, count, deltaTime);
+}
+
+void fleetStep(SubmarineFleet *fleet, float deltaTime)
+{
+  fleetStepRange(fleet, 0, fleet->capacity, deltaTime);
+}
@@ -0,0 +1,84 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include "constants.h"
+#include <stdint.h>
+
+// Structure-of-arrays copy of many SubmarineStates for Monte Carlo runs.
+// Every field lives in its own 64-byte aligned array (switches as one 64-bit
+// mask per boat) so the kernels in fleet.c can step FLEET_LANES boats per
+// vector instruction.
+
+// 8 lanes = one AVX register of floats, build with -DFLEET_LANES=16 for AVX-512
+#ifndef FLEET_LANES
+#define FLEET_LANES 8
+#endif
+
+// Continuous fields touched by the vector kernels
+#define FLEET_FLOAT_FIELDS(X) \
+  X(depth)                    \
+  X(speed)                    \
+  X(vertical_speed)           \
+  X(ballast_level)            \
+  X(trim_angle)               \
+  X(thrust)                   \
+  X(hull_integrity)           \
+  X(battery_level)            \
+  X(reactor_temp)             \
+  X(reactor_power)            \
+  X(hull_temperature)         \
+  X(water_temperature)        \
+  X(coolant_temp)             \
+  X(steam_generator_temp)     \
+  X(nitrogen_level)           \
+  X(power_consumption)        \
+  X(north)                    \
+  X(east)                     \
+  X(heading)                  \
+  X(forward_speed)            \
+  X(current_east)             \
+  X(current_north)
+
+typedef struct
+{
+  int count;    // Boats in use
+  int capacity; // count rounded up to FLEET_LANES, padding lanes are inert
+
+#define FLEET_DECLARE_FLOAT(name) float *name;
+  FLEET_FLOAT_FIELDS(FLEET_DECLARE_FLOAT)
+#undef FLEET_DECLARE_FLOAT
+
+  uint64_t *systems; // SubmarineSystem bits, same layout as SubmarineState.systems
+} SubmarineFleet;
+
+bool fleetInit(SubmarineFleet *fleet, int count);
+void fleetFree(SubmarineFleet *fleet);
+
+// Copy one boat in/out of the fleet (fields the fleet doesn't carry are left alone on load)
+void fleetStoreBoat(SubmarineFleet *fleet, int index, const SubmarineState *sub);
+void fleetLoadBoat(const SubmarineFleet *fleet, int index, SubmarineState *sub);
+
+// Vector kernels - same rules as updateThermalNetwork (thermal.c) plus updateReactor/
+// updatePowerAndEnvironment/updatePhysics/updateNavigation/updateNitrogenNarcosis in submarine.c.
+// Flooding, the electrical plant and the neutronics are the exceptions: the
+// fleet carries no compartments, buses or precursors and keeps the lumped rules
+// (hull integrity -> ballast, one power sum off the battery, fission heat
+// growing with core temperature) that flooding.h, electrical.h and kinetics.h
+// replaced. Boats hold their heading - there is no helm in the fleet - and
+// keep their position in float, which is plenty for a Monte Carlo run's
+// few kilometres. They sail over open ocean - a seabed depth (seabed.h) is a
+// tile or lattice lookup at each boat's own position, a scattered gather per
+// lane the kernels have no way to vectorize, so the fleet leaves grounding to
+// the scalar model.
+// Ranges are in boats and must start on a FLEET_LANES boundary.
+void fleetUpdateReactor(SubmarineFleet *fleet, int first, int count, float deltaTime);
+void fleetUpdatePower(SubmarineFleet *fleet, int first, int count, float deltaTime);
+void fleetUpdatePhysics(SubmarineFleet *fleet, int first, int count, float deltaTime);
+void fleetUpdateNavigation(SubmarineFleet *fleet, int first, int count, float deltaTime);
+void fleetUpdateNitrogenNarcosis(SubmarineFleet *fleet, int first, int count, float deltaTime);
+
+// One full tick of the vector kernels over a range, or over the whole fleet
+void fleetStepRange(SubmarineFleet *fleet, int first, int count, float deltaTime);
+void fleetStep(SubmarineFleet *fleet, float deltaTime);
+
+#endif
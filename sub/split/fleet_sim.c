@@ -0,0 +1,169 @@
+// Monte Carlo fleet driver - steps a large SubmarineFleet with the vector
+// kernels across every core and reports throughput plus a depth/temperature
+// distribution at the end.
+//
+//   ./sub_fleet [-n boats] [-t seconds] [-j threads] [-s seed] [-C basin.cur]
+//
+// -C drifts every boat in an ocean-current field (currents.h); they start on
+// random headings at the origin and the drift distribution is reported too.
+
+#define _GNU_SOURCE
+#include "currents.h"
+#include "fleet.h"
+#include "threadpool.h"
+#include <string.h>
+#include <time.h>
+
+// Boats per parallel job - big enough to amortize dispatch, small enough to balance
+#define FLEET_CHUNK (FLEET_LANES * 512)
+
+typedef struct
+{
+  SubmarineFleet *fleet;
+  float deltaTime;
+} FleetTickJob;
+
+static void stepChunk(int index, void *ctx)
+{
+  FleetTickJob *job = ctx;
+  int first = index * FLEET_CHUNK;
+  int count = MIN(FLEET_CHUNK, job->fleet->capacity - first);
+  fleetStepRange(job->fleet, first, count, job->deltaTime);
+}
+
+static float randomRange(unsigned int *state, float lo, float hi)
+{
+  unsigned int x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return lo + (hi - lo) * ((x >> 8) * (1.0f / 16777216.0f));
+}
+
+static int compareFloats(const void *a, const void *b)
+{
+  float fa = *(const float *)a, fb = *(const float *)b;
+  return (fa > fb) - (fa < fb);
+}
+
+static void printPercentiles(const char *label, const float *values, int count)
+{
+  float *sorted = malloc(count * sizeof(float));
+  memcpy(sorted, values, count * sizeof(float));
+  qsort(sorted, count, sizeof(float), compareFloats);
+  printf("%-14s p5 %9.1f  p50 %9.1f  p95 %9.1f  max %9.1f\n", label,
+         sorted[count * 5 / 100], sorted[count / 2], sorted[count * 95 / 100], sorted[count - 1]);
+  free(sorted);
+}
+
+int main(int argc, char **argv)
+{
+  int boats = 100000;
+  float seconds = 60.0f;
+  int threads = 0;
+  unsigned int seed = 1;
+  static CurrentField currents;
+
+  for (int i = 1; i < argc; i++)
+  {
+    bool has_value = i + 1 < argc;
+    if (strcmp(argv[i], "-n") == 0 && has_value)
+      boats = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-t") == 0 && has_value)
+      seconds = strtof(argv[++i], NULL);
+    else if (strcmp(argv[i], "-j") == 0 && has_value)
+      threads = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-s") == 0 && has_value)
+      seed = (unsigned int)strtoul(argv[++i], NULL, 10) | 1u;
+    else if (strcmp(argv[i], "-C") == 0 && has_value)
+    {
+      if (!currentFieldMap(&currents, argv[++i]))
+      {
+        fprintf(stderr, "%s: not an ocean-current field\n", argv[i]);
+        return 1;
+      }
+      oceanCurrents = &currents;
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [-n boats] [-t seconds] [-j threads] [-s seed] [-C basin.cur]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  SubmarineFleet fleet;
+  if (boats <= 0 || !fleetInit(&fleet, boats))
+  {
+    fprintf(stderr, "could not allocate a fleet of %d boats\n", boats);
+    return 1;
+  }
+
+  // Random crews: running reactor at some temperature, random ballast and trim.
+  // Headings come off their own stream so the rest of the draws stay put.
+  unsigned int rng = seed, heading_rng = seed ^ 0x5bd1e995u;
+  for (int i = 0; i < boats; i++)
+  {
+    SubmarineState sub = initSubmarine();
+    sub.systems = SYS_BIT(SYS_BACKUP_POWER) | SYS_REACTOR_READY | SYS_BIT(SYS_BALLAST_CONTROL) |
+                  SYS_BIT(SYS_GYROSCOPE) | SYS_BIT(SYS_DEPTH_CONTROL);
+    sub.battery_level = randomRange(&rng, 0.0f, 100.0f);
+    setSystem(&sub, SYS_REACTOR, randomRange(&rng, 0.0f, 1.0f) < 0.9f);
+    sub.reactor_temp = randomRange(&rng, 25.0f, 340.0f);
+    sub.coolant_temp = sub.steam_generator_temp = MAX(25.0f, sub.reactor_temp - 10.0f); // Loop near equilibrium
+    setSystem(&sub, SYS_COOLING, randomRange(&rng, 0.0f, 1.0f) < 0.5f);
+    setSystem(&sub, SYS_BALLAST_TANKS_FILLED, randomRange(&rng, 0.0f, 1.0f) < 0.5f);
+    sub.ballast_level = randomRange(&rng, 0.0f, 100.0f);
+    sub.depth = randomRange(&rng, 0.0f, 3000.0f);
+    sub.trim_angle = randomRange(&rng, -20.0f, 20.0f);
+    sub.heading = sub.course = randomRange(&heading_rng, 0.0f, 360.0f);
+    fleetStoreBoat(&fleet, i, &sub);
+  }
+
+  ThreadPool *pool = threadPoolCreate(threads);
+  if (!pool)
+  {
+    fprintf(stderr, "could not start a thread pool\n");
+    return 1;
+  }
+  FleetTickJob job = {&fleet, SIM_TICK_DT};
+  int chunks = (fleet.capacity + FLEET_CHUNK - 1) / FLEET_CHUNK;
+  long ticks = (long)(seconds * SIM_TICK_RATE);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (long t = 0; t < ticks; t++)
+    threadPoolParallelFor(pool, chunks, stepChunk, &job);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+  double boat_ticks = (double)boats * ticks;
+  printf("%d boats x %ld ticks in %.2fs on %d threads, %d lanes: %.1f M boat-ticks/s, %.2f ms/tick\n",
+         boats, ticks, elapsed, threadPoolWorkerCount(pool), FLEET_LANES,
+         elapsed > 0 ? boat_ticks / elapsed / 1e6 : 0.0, elapsed * 1000.0 / MAX(1, ticks));
+
+  printPercentiles("depth", fleet.depth, boats);
+  printPercentiles("reactor_temp", fleet.reactor_temp, boats);
+  printPercentiles("hull", fleet.hull_integrity, boats);
+  if (oceanCurrents)
+  {
+    float *drift = malloc(boats * sizeof(float));
+    for (int i = 0; i < boats; i++)
+      drift[i] = hypotf(fleet.north[i], fleet.east[i]);
+    printPercentiles("drift_m", drift, boats);
+    free(drift);
+  }
+
+  int destroyed = 0, scrammed = 0;
+  for (int i = 0; i < boats; i++)
+  {
+    destroyed += (fleet.systems[i] >> SYS_REACTOR_DESTROYED) & 1;
+    scrammed += (fleet.systems[i] >> SYS_CONTROL_RODS_INSERTED) & 1;
+  }
+  printf("scrammed %d, destroyed %d\n", scrammed, destroyed);
+
+  threadPoolDestroy(pool);
+  fleetFree(&fleet);
+  currentFieldClose(&currents);
+  return 0;
+}
@@ -0,0 +1,196 @@
+#include "flooding.h"
+
+#define GRAVITY 9.81f
+
+static const FloodCompartmentInfo compartments[COMPARTMENT_COUNT] = {
+#define FLOOD_COMPARTMENT_INFO(name, label, volume, area, share) {label, volume, area, share},
+    FLOOD_COMPARTMENT_TABLE(FLOOD_COMPARTMENT_INFO)
+#undef FLOOD_COMPARTMENT_INFO
+};
+
+typedef struct
+{
+  uint8_t a, b;
+  float area;
+} FloodDoorInfo;
+
+static const FloodDoorInfo doors[DOOR_COUNT] = {
+#define FLOOD_DOOR_INFO(name, a, b, area) {COMPARTMENT_##a, COMPARTMENT_##b, area},
+    FLOOD_DOOR_TABLE(FLOOD_DOOR_INFO)
+#undef FLOOD_DOOR_INFO
+};
+
+// Door graph in compressed rows: compartment c's doors are
+// links[first[c]] .. links[first[c + 1] - 1]
+typedef struct
+{
+  uint8_t neighbour;
+  uint8_t door;
+  float own_rate;       // Door conductance over this compartment's floor area, 1/s
+  float neighbour_rate; // ... over the neighbour's
+} FloodLink;
+
+static int first[COMPARTMENT_COUNT + 1];
+static FloodLink links[2 * DOOR_COUNT];
+static float hullVolume;
+
+__attribute__((constructor)) static void buildFloodGraph(void)
+{
+  int degree[COMPARTMENT_COUNT] = {0};
+  for (int d = 0; d < DOOR_COUNT; d++)
+  {
+    degree[doors[d].a]++;
+    degree[doors[d].b]++;
+  }
+  first[0] = 0;
+  for (int c = 0; c < COMPARTMENT_COUNT; c++)
+    first[c + 1] = first[c] + degree[c];
+
+  int fill[COMPARTMENT_COUNT];
+  for (int c = 0; c < COMPARTMENT_COUNT; c++)
+    fill[c] = first[c];
+  for (int d = 0; d < DOOR_COUNT; d++)
+  {
+    float conductance = FLOOD_DOOR_CONDUCTANCE * doors[d].area; // m³/s per m of level difference
+    float rate_a = conductance / compartments[doors[d].a].area;
+    float rate_b = conductance / compartments[doors[d].b].area;
+    links[fill[doors[d].a]++] = (FloodLink){doors[d].b, (uint8_t)d, rate_a, rate_b};
+    links[fill[doors[d].b]++] = (FloodLink){doors[d].a, (uint8_t)d, rate_b, rate_a};
+  }
+
+  hullVolume = 0.0f;
+  for (int c = 0; c < COMPARTMENT_COUNT; c++)
+    hullVolume += compartments[c].volume;
+}
+
+const FloodCompartmentInfo *floodCompartment(FloodCompartment c)
+{
+  return &compartments[c];
+}
+
+float floodHullVolume(void)
+{
+  return hullVolume;
+}
+
+void floodDoorEnds(FloodDoor door, FloodCompartment *a, FloodCompartment *b)
+{
+  *a = doors[door].a;
+  *b = doors[door].b;
+}
+
+float floodTotalWater(const SubmarineState *sub)
+{
+  float total = 0.0f;
+  for (uint32_t wet = sub->flood_wet; wet; wet &= wet - 1)
+    total += sub->flood_water[__builtin_ctz(wet)];
+  return total;
+}
+
+// Hull damage below the breach threshold tears each compartment open by its share
+static void openHullBreaches(SubmarineState *sub)
+{
+  float torn = (FLOOD_BREACH_INTEGRITY - MAX(0.0f, sub->hull_integrity)) / FLOOD_BREACH_INTEGRITY * FLOOD_MAX_BREACH_AREA;
+  for (int c = 0; c < COMPARTMENT_COUNT; c++)
+  {
+    float area = compartments[c].share * torn;
+    if (area > sub->breach_area[c])
+    {
+      sub->breach_area[c] = area;
+      sub->flood_wet |= 1u << c;
+    }
+  }
+}
+
+int updateFlooding(SubmarineState *sub, float deltaTime)
+{
+  if (sub->hull_integrity < FLOOD_BREACH_INTEGRITY)
+    openHullBreaches(sub);
+  if (!sub->flood_wet)
+    return 0;
+
+  // Wet compartments and whatever their open doors lead to
+  uint32_t active = sub->flood_wet;
+  for (uint32_t wet = sub->flood_wet; wet; wet &= wet - 1)
+  {
+    int c = __builtin_ctz(wet);
+    for (int l = first[c]; l < first[c + 1]; l++)
+      if (floodDoorOpen(sub, links[l].door))
+        active |= 1u << links[l].neighbour;
+  }
+
+  // Breach inflow at this depth, frozen for the step, and the open links
+  // between active compartments gathered once - the sweeps only read these
+  float orifice = FLOOD_DISCHARGE_COEFFICIENT * sqrtf(2.0f * GRAVITY * (sub->depth + FLOOD_HEAD_OFFSET));
+  float start[COMPARTMENT_COUNT], inverse_diagonal[COMPARTMENT_COUNT];
+  uint8_t order[COMPARTMENT_COUNT], row[COMPARTMENT_COUNT + 1], column[2 * DOOR_COUNT];
+  float weight[2 * DOOR_COUNT];
+  int count = 0, entries = 0;
+  for (uint32_t set = active; set; set &= set - 1)
+  {
+    int c = __builtin_ctz(set);
+    float diagonal = 1.0f;
+    row[count] = (uint8_t)entries;
+    for (int l = first[c]; l < first[c + 1]; l++)
+    {
+      const FloodLink *link = &links[l];
+      if (!((active >> link->neighbour) & 1) || !floodDoorOpen(sub, link->door))
+        continue;
+      diagonal += deltaTime * link->own_rate;
+      column[entries] = link->neighbour;
+      weight[entries++] = deltaTime * link->neighbour_rate;
+    }
+    start[count] = sub->flood_water[c] + sub->breach_area[c] * orifice * deltaTime;
+    inverse_diagonal[count] = 1.0f / diagonal;
+    order[count++] = (uint8_t)c;
+  }
+  row[count] = (uint8_t)entries;
+
+  // Backward Euler on the door flow: (1 + dt L) V = start, by Gauss-Seidel.
+  // Only links between active compartments count, so no water leaves the set.
+  for (int iteration = 0; iteration < FLOOD_SOLVER_ITERATIONS; iteration++)
+  {
+    float change = 0.0f;
+    for (int i = 0; i < count; i++)
+    {
+      float rhs = start[i];
+      for (int e = row[i]; e < row[i + 1]; e++)
+        rhs += weight[e] * sub->flood_water[column[e]];
+      float water = rhs * inverse_diagonal[i];
+      change = MAX(change, fabsf(water - sub->flood_water[order[i]]));
+      sub->flood_water[order[i]] = water;
+    }
+    if (change < FLOOD_SOLVER_TOLERANCE)
+      break;
+  }
+
+  // A full compartment takes no more; the manual pumps split their capacity
+  int wet_count = 0;
+  for (uint32_t set = active; set; set &= set - 1)
+  {
+    int c = __builtin_ctz(set);
+    sub->flood_water[c] = MIN(compartments[c].volume, sub->flood_water[c]);
+    wet_count += sub->flood_water[c] > FLOOD_DRY_VOLUME;
+  }
+  float pumped = systemOn(sub, SYS_BILGE_PUMPS) && wet_count > 0 ? FLOOD_BILGE_CAPACITY / wet_count * deltaTime : 0.0f;
+
+  uint32_t wet = 0;
+  for (uint32_t set = active; set; set &= set - 1)
+  {
+    int c = __builtin_ctz(set);
+    float water = MAX(0.0f, sub->flood_water[c] - pumped);
+    if (pumped > 0.0f && water < FLOOD_DRY_VOLUME)
+      water = 0.0f;
+    sub->flood_water[c] = water;
+    if (water > 0.0f || sub->breach_area[c] > 0.0f)
+      wet |= 1u << c;
+  }
+  sub->flood_wet = wet;
+
+  // Sea in the battery well shorts the cells
+  const FloodCompartmentInfo *battery_well = &compartments[COMPARTMENT_AUXILIARY];
+  if (sub->flood_water[COMPARTMENT_AUXILIARY] > battery_well->volume * 0.3f && sub->battery_level > 0)
+    sub->battery_level = MAX(0.0f, sub->battery_level - 5.0f * deltaTime);
+
+  return __builtin_popcount(active);
+}
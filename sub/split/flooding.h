@@ -0,0 +1,102 @@
+#ifndef FLOODING_H
+#define FLOODING_H
+
+#include "constants.h"
+
+// Compartment flooding and damage control. The pressure hull is a graph of
+// watertight compartments joined by doors:
+//
+//   torpedo - berthing - control - auxiliary - reactor - engine - maneuvering - steering
+//
+// Each compartment holds flood_water m³ of sea. A breach lets water in at
+// the orifice rate for the depth (Cd * A * sqrt(2 g head)); an open door
+// passes water from the higher water level to the lower in proportion to the
+// difference; the manual bilge pumps share their capacity between the wet
+// compartments. Hull damage below 50 % opens breaches in proportion to each
+// compartment's share of the stressed hull, and the water aboard is what
+// makes a damaged boat heavy (updatePhysics).
+//
+// The door flow is stiff - a big door levels two compartments in seconds - so
+// it's solved implicitly, by Gauss-Seidel over the active set only: the
+// compartments that are wet or breached (flood_wet) plus their neighbours
+// through open doors. A dry boat costs one test, and a breach costs the
+// compartments the water can actually reach, however many the hull has.
+
+// name, label, volume m³, floor area m², hull damage share
+#define FLOOD_COMPARTMENT_TABLE(X)                      \
+  X(TORPEDO_ROOM, "TORP", 250.0f, 50.0f, 0.16f)         \
+  X(BERTHING, "BERTH", 300.0f, 60.0f, 0.08f)            \
+  X(CONTROL_ROOM, "CTRL", 280.0f, 56.0f, 0.06f)         \
+  X(AUXILIARY, "AUX", 260.0f, 52.0f, 0.10f)             \
+  X(REACTOR_COMPARTMENT, "RX", 350.0f, 60.0f, 0.12f)    \
+  X(ENGINE_ROOM, "ENG", 400.0f, 70.0f, 0.18f)           \
+  X(MANEUVERING, "MAN", 200.0f, 45.0f, 0.10f)           \
+  X(STEERING, "STEER", 150.0f, 35.0f, 0.20f)
+
+typedef enum
+{
+#define FLOOD_COMPARTMENT_ENUM(name, label, volume, area, share) COMPARTMENT_##name,
+  FLOOD_COMPARTMENT_TABLE(FLOOD_COMPARTMENT_ENUM)
+#undef FLOOD_COMPARTMENT_ENUM
+  COMPARTMENT_COUNT
+} FloodCompartment;
+
+_Static_assert(COMPARTMENT_COUNT == FLOOD_COMPARTMENTS, "FLOOD_COMPARTMENTS in constants.h is out of date");
+
+// Watertight doors: name, the two compartments, opening m²
+#define FLOOD_DOOR_TABLE(X)                                        \
+  X(TORPEDO_BERTHING, TORPEDO_ROOM, BERTHING, 1.2f)                \
+  X(BERTHING_CONTROL, BERTHING, CONTROL_ROOM, 1.2f)                \
+  X(CONTROL_AUXILIARY, CONTROL_ROOM, AUXILIARY, 1.2f)              \
+  X(AUXILIARY_REACTOR, AUXILIARY, REACTOR_COMPARTMENT, 0.8f)       \
+  X(REACTOR_ENGINE, REACTOR_COMPARTMENT, ENGINE_ROOM, 0.8f)        \
+  X(ENGINE_MANEUVERING, ENGINE_ROOM, MANEUVERING, 1.2f)            \
+  X(MANEUVERING_STEERING, MANEUVERING, STEERING, 1.0f)
+
+typedef enum
+{
+#define FLOOD_DOOR_ENUM(name, a, b, area) DOOR_##name,
+  FLOOD_DOOR_TABLE(FLOOD_DOOR_ENUM)
+#undef FLOOD_DOOR_ENUM
+  DOOR_COUNT
+} FloodDoor;
+
+_Static_assert(DOOR_COUNT <= 32, "doors_shut is a 32-bit mask");
+
+#define FLOOD_DISCHARGE_COEFFICIENT 0.6f // Sharp-edged hull opening
+#define FLOOD_HEAD_OFFSET 5.0f           // m, the waterline over the hull at periscope depth
+#define FLOOD_DOOR_CONDUCTANCE 2.0f      // m³/s per m² of door per m of level difference
+#define FLOOD_MAX_BREACH_AREA 0.05f      // m², every hull share torn open at 0 % integrity
+#define FLOOD_BREACH_INTEGRITY 50.0f     // % hull, breaches open below it
+#define FLOOD_BILGE_CAPACITY 0.5f        // m³/s, the manual pumps between all wet compartments
+#define FLOOD_WEIGHT 80.0f               // m/s of sink rate with the whole hull flooded
+#define FLOOD_DRY_VOLUME 0.01f           // m³, less than this is pumped dry
+#define FLOOD_SOLVER_ITERATIONS 16
+#define FLOOD_SOLVER_TOLERANCE 0.001f    // m³, largest change in the last sweep
+
+typedef struct
+{
+  const char *label;
+  float volume;
+  float area;
+  float share;
+} FloodCompartmentInfo;
+
+const FloodCompartmentInfo *floodCompartment(FloodCompartment c);
+float floodHullVolume(void);
+
+// Compartments joined by a door, and the door's opening
+void floodDoorEnds(FloodDoor door, FloodCompartment *a, FloodCompartment *b);
+
+static inline bool floodDoorOpen(const SubmarineState *sub, FloodDoor door)
+{
+  return !((sub->doors_shut >> door) & 1);
+}
+
+// Sea aboard, m³ and as a fraction of the hull
+float floodTotalWater(const SubmarineState *sub);
+
+// One damage-control step. Returns the compartments the solver visited.
+int updateFlooding(SubmarineState *sub, float deltaTime);
+
+#endif
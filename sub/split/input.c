@@ -0,0 +1,124 @@
+#include "constants.h"
+#include "flooding.h"
+
+// Helper function for button click detection
+static bool checkSubSystemButtonClick(int x, int y, int mouseX, int mouseY)
+{
+  return (mouseX >= x && mouseX <= x + 120 && mouseY >= y && mouseY <= y + 25);
+}
+
+// Find the subsystem button under the cursor - coordinates match the panels in renderer.c
+static SubmarineCommandType subSystemCommandAt(int mx, int my)
+{
+  // REACTOR SYSTEMS PANEL (10, 10, 280, 180)
+  if (mx >= 10 && mx <= 290 && my >= 10 && my <= 190)
+  {
+    if (checkSubSystemButtonClick(20, 40, mx, my))
+      return CMD_CONTROL_RODS;
+    if (checkSubSystemButtonClick(150, 40, mx, my))
+      return CMD_COOLANT_PUMPS;
+    if (checkSubSystemButtonClick(20, 70, mx, my))
+      return CMD_STEAM_GENERATOR;
+    if (checkSubSystemButtonClick(150, 70, mx, my))
+      return CMD_POWER_TURBINE;
+    if (checkSubSystemButtonClick(20, 100, mx, my))
+      return CMD_CONTAINMENT;
+    if (checkSubSystemButtonClick(150, 100, mx, my))
+      return CMD_EMERGENCY_COOLING;
+    if (checkSubSystemButtonClick(75, 130, mx, my))
+      return CMD_MAIN_REACTOR;
+  }
+
+  // LIFE SUPPORT PANEL (10, 200, 280, 180)
+  else if (mx >= 10 && mx <= 290 && my >= 200 && my <= 380)
+  {
+    if (checkSubSystemButtonClick(20, 230, mx, my))
+      return CMD_AIR_CIRCULATION;
+    if (checkSubSystemButtonClick(150, 230, mx, my))
+      return CMD_CO2_SCRUBBERS;
+    if (checkSubSystemButtonClick(20, 260, mx, my))
+      return CMD_O2_GENERATOR;
+    if (checkSubSystemButtonClick(150, 260, mx, my))
+      return CMD_HULL_MONITORING;
+    if (checkSubSystemButtonClick(20, 290, mx, my))
+      return CMD_MAIN_O2_SYSTEM;
+    if (checkSubSystemButtonClick(150, 290, mx, my))
+      return CMD_BACKUP_POWER;
+  }
+
+  // NAVIGATION PANEL (10, 390, 280, 180)
+  else if (mx >= 10 && mx <= 290 && my >= 390 && my <= 570)
+  {
+    if (checkSubSystemButtonClick(20, 420, mx, my))
+      return CMD_GYROSCOPE;
+    if (checkSubSystemButtonClick(150, 420, mx, my))
+      return CMD_NAV_COMPUTER;
+    if (checkSubSystemButtonClick(20, 450, mx, my))
+      return CMD_DEPTH_CONTROL;
+    if (checkSubSystemButtonClick(150, 450, mx, my))
+      return CMD_BALLAST_CONTROL;
+    if (checkSubSystemButtonClick(20, 480, mx, my))
+      return CMD_COMMUNICATIONS;
+  }
+
+  // EMERGENCY/GENERAL SYSTEMS PANEL (350, 10, 320, 360)
+  else if (mx >= 350 && mx <= 670 && my >= 10 && my <= 370)
+  {
+    if (checkSubSystemButtonClick(360, 40, mx, my))
+      return CMD_BACKUP_POWER;
+    if (checkSubSystemButtonClick(490, 40, mx, my))
+      return CMD_EMERGENCY_LIGHTING;
+    if (checkSubSystemButtonClick(360, 70, mx, my))
+      return CMD_EMERGENCY_COOLING_MANUAL;
+    if (checkSubSystemButtonClick(490, 70, mx, my))
+      return CMD_EMERGENCY_AIR;
+    if (checkSubSystemButtonClick(360, 100, mx, my))
+      return CMD_BILGE_PUMPS;
+    if (checkSubSystemButtonClick(490, 100, mx, my))
+      return CMD_FIRE_SUPPRESSION;
+    if (checkSubSystemButtonClick(360, 130, mx, my))
+      return CMD_BALLAST_BLOW;
+    if (checkSubSystemButtonClick(490, 130, mx, my))
+      return CMD_DISTRESS_BEACON;
+  }
+
+  return CMD_NONE;
+}
+
+// Watertight door in the damage-control strip (renderer.c) under the cursor, -1 if none
+static int damageControlDoorAt(int mx, int my)
+{
+  if (my < DAMAGE_STRIP_Y || my > DAMAGE_STRIP_Y + DAMAGE_BOX_HEIGHT)
+    return -1;
+
+  // The gaps are narrow - take a few pixels of the boxes either side too
+  for (int d = 0; d < DOOR_COUNT; d++)
+  {
+    FloodCompartment a, b;
+    floodDoorEnds(d, &a, &b);
+    int gx = DAMAGE_STRIP_X + MIN(a, b) * (DAMAGE_BOX_WIDTH + DAMAGE_BOX_GAP) + DAMAGE_BOX_WIDTH;
+    if (mx >= gx - 4 && mx <= gx + DAMAGE_BOX_GAP + 4)
+      return d;
+  }
+  return -1;
+}
+
+// Subsystem input handling function - main.c applies (and journals) the command
+SubmarineCommand handleSubSystemInput(void)
+{
+  if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+  {
+    Vector2 mousePos = GetMousePosition();
+    int mx = (int)mousePos.x, my = (int)mousePos.y;
+
+    // Damage control works the doors by number
+    int door = damageControlDoorAt(mx, my);
+    if (door >= 0)
+      return (SubmarineCommand){CMD_WATERTIGHT_DOOR, (float)door};
+    if (checkSubSystemButtonClick(DAMAGE_STRIP_X, DAMAGE_DOORS_BUTTON_Y, mx, my))
+      return (SubmarineCommand){CMD_WATERTIGHT_DOOR, -1.0f};
+
+    return (SubmarineCommand){subSystemCommandAt(mx, my), 0.0f};
+  }
+  return (SubmarineCommand){CMD_NONE, 0.0f};
+}
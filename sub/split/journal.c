@@ -0,0 +1,231 @@
+#define _GNU_SOURCE
+#include "journal.h"
+#include "currents.h"
+#include "params.h"
+#include "snapshot.h"
+#include "timewarp.h"
+#include <errno.h>
+#include <string.h>
+
+bool journalOpen(JournalWriter *writer, const char *path)
+{
+  writer->file = NULL;
+
+  char previous[1024];
+  snprintf(previous, sizeof(previous), "%s.prev", path);
+  if (rename(path, previous) != 0 && errno != ENOENT)
+    return false;
+
+  writer->file = fopen(path, "w");
+  if (!writer->file)
+    return false;
+
+  fprintf(writer->file, "journal %d\ntick_rate %d\nparams %016llx\ncurrents %016llx\n", JOURNAL_VERSION,
+          (int)SIM_TICK_RATE, (unsigned long long)simParametersHash(&simParameters),
+          (unsigned long long)currentFieldHash(oceanCurrents));
+  fflush(writer->file);
+  return true;
+}
+
+void journalStart(JournalWriter *writer, const char *snapshot_path, uint64_t tick, const SubmarineState *sub)
+{
+  if (!writer->file)
+    return;
+
+  fprintf(writer->file, "start %s %llu %016llx\n", snapshot_path, (unsigned long long)tick,
+          (unsigned long long)submarineStateHash(sub));
+  fflush(writer->file);
+}
+
+void journalCommand(JournalWriter *writer, uint64_t tick, SubmarineCommand cmd)
+{
+  if (!writer->file)
+    return;
+
+  // %.9g round-trips every float exactly. Commands are a few per second at
+  // most, so flushing each one keeps the journal complete up to a crash.
+  fprintf(writer->file, "%llu %s %.9g\n", (unsigned long long)tick, submarineCommandName(cmd.type), cmd.value);
+  fflush(writer->file);
+}
+
+void journalClose(JournalWriter *writer, uint64_t end_tick, const SubmarineState *final_state)
+{
+  if (!writer->file)
+    return;
+
+  fprintf(writer->file, "end %llu %016llx\n", (unsigned long long)end_tick,
+          (unsigned long long)submarineStateHash(final_state));
+  fclose(writer->file);
+  writer->file = NULL;
+}
+
+bool journalLoad(const char *path, Journal *journal)
+{
+  memset(journal, 0, sizeof(*journal));
+
+  FILE *f = fopen(path, "r");
+  if (!f)
+  {
+    perror(path);
+    return false;
+  }
+
+  int capacity = 0;
+  int version = 0, tick_rate = 0;
+  char line[256];
+  int line_number = 0;
+  bool ok = true;
+
+  while (ok && fgets(line, sizeof(line), f))
+  {
+    line_number++;
+    unsigned long long tick, hash;
+    char name[64];
+    float value;
+
+    if (line[0] == '\n' || line[0] == '#')
+      continue;
+    if (sscanf(line, "journal %d", &version) == 1 || sscanf(line, "tick_rate %d", &tick_rate) == 1)
+      continue;
+
+    if (sscanf(line, "params %llx", &hash) == 1)
+    {
+      journal->params_hash = hash;
+      journal->has_params = true;
+      continue;
+    }
+
+    if (sscanf(line, "currents %llx", &hash) == 1)
+    {
+      journal->currents_hash = hash;
+      journal->has_currents = true;
+      continue;
+    }
+
+    if (sscanf(line, "start %255s %llu %llx", journal->start_snapshot, &tick, &hash) == 3)
+    {
+      journal->has_start = true;
+      journal->start_tick = tick;
+      journal->start_hash = hash;
+      journal->end_tick = MAX(journal->end_tick, tick);
+      continue;
+    }
+
+    if (sscanf(line, "end %llu %llx", &tick, &hash) == 2)
+    {
+      journal->end_tick = tick;
+      journal->final_hash = hash;
+      journal->has_end = true;
+      continue;
+    }
+
+    SubmarineCommandType type = CMD_NONE;
+    if (sscanf(line, "%llu %63s %f", &tick, name, &value) == 3)
+      type = submarineCommandFromName(name);
+    if (type == CMD_NONE || (journal->count > 0 && tick < journal->entries[journal->count - 1].tick))
+    {
+      fprintf(stderr, "%s:%d: bad journal line: %s", path, line_number, line);
+      ok = false;
+      break;
+    }
+
+    if (journal->count == capacity)
+    {
+      capacity = capacity ? capacity * 2 : 256;
+      JournalEntry *grown = realloc(journal->entries, capacity * sizeof(JournalEntry));
+      if (!grown)
+      {
+        ok = false;
+        break;
+      }
+      journal->entries = grown;
+    }
+    journal->entries[journal->count++] = (JournalEntry){tick, {type, value}};
+    if (!journal->has_end)
+      journal->end_tick = MAX(journal->end_tick, tick);
+  }
+  fclose(f);
+
+  if (ok && (version != JOURNAL_VERSION || tick_rate != (int)SIM_TICK_RATE))
+  {
+    fprintf(stderr, "%s: journal version %d at %d Hz, this build plays version %d at %d Hz\n",
+            path, version, tick_rate, JOURNAL_VERSION, (int)SIM_TICK_RATE);
+    ok = false;
+  }
+
+  // A different physics block replays different numbers - say so rather than report a mismatch
+  if (ok && journal->has_params && journal->params_hash != simParametersHash(&simParameters))
+  {
+    fprintf(stderr, "%s: recorded with parameters %016llx, these are %016llx (load the session's file with -P)\n",
+            path, (unsigned long long)journal->params_hash, (unsigned long long)simParametersHash(&simParameters));
+    ok = false;
+  }
+
+  // Same for the water it sailed in
+  if (ok && journal->has_currents && journal->currents_hash != currentFieldHash(oceanCurrents))
+  {
+    fprintf(stderr, "%s: recorded in %s, this is %s (%016llx vs %016llx - pass the session's basin with -C, "
+            "or -C none for still water)\n",
+            path, journal->currents_hash ? "an ocean-current field" : "still water",
+            oceanCurrents ? "an ocean-current field" : "still water", (unsigned long long)journal->currents_hash,
+            (unsigned long long)currentFieldHash(oceanCurrents));
+    ok = false;
+  }
+
+  if (!ok)
+    journalFree(journal);
+  return ok;
+}
+
+void journalFree(Journal *journal)
+{
+  free(journal->entries);
+  memset(journal, 0, sizeof(*journal));
+}
+
+bool replayJournal(const Journal *journal, SubmarineState *out)
+{
+  SubmarineState sub = initSubmarine();
+  uint64_t tick = 0;
+  int next = 0;
+
+  if (journal->has_start)
+  {
+    SubmarineSnapshot snap;
+    if (!snapshotLoad(journal->start_snapshot, &snap) || submarineStateHash(&snap.sub) != journal->start_hash)
+    {
+      fprintf(stderr, "%s: start snapshot missing, damaged or overwritten\n", journal->start_snapshot);
+      return false;
+    }
+    sub = snap.sub;
+    tick = journal->start_tick;
+  }
+
+  // Commands stamped with tick t were applied after t ticks had run. The ones
+  // stamped with end_tick came after the last tick, just before the session
+  // closed. Between commands the clock runs exactly as it did in the game,
+  // compressed stretches in the same adaptive steps, shortened to land on a
+  // command the way the game lands them on scenario events (the player's own
+  // commands already fall between whole steps).
+  TimeWarp warp = initTimeWarp();
+  for (;;)
+  {
+    while (next < journal->count && journal->entries[next].tick == tick)
+      timeWarpCommand(&warp, &sub, journal->entries[next++].cmd);
+
+    if (tick >= journal->end_tick)
+      break;
+
+    uint64_t until = next < journal->count ? MIN(journal->entries[next].tick, journal->end_tick) : journal->end_tick;
+    if (until <= tick)
+    {
+      fprintf(stderr, "journal tick %llu is out of order\n", (unsigned long long)until);
+      return false;
+    }
+    uint32_t span = (uint32_t)MIN(until - tick, UINT32_MAX);
+    tick += timeWarpAdvance(&warp, &sub, span, span);
+  }
+
+  *out = sub;
+  return true;
+}
@@ -0,0 +1,68 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "constants.h"
+#include <stdio.h>
+
+// Input journal - every SubmarineCommand the player issued, stamped with the
+// simulation tick it was applied before. Because the model only changes
+// through commands and fixed ticks, replaying the journal from
+// initSubmarine() reproduces the session bit for bit.
+//
+// Text format, same command names as the batch scenarios:
+//   journal 1
+//   tick_rate 120
+//   params <hash>                         (simParametersHash of the physics the session ran with)
+//   currents <hash>                       (currentFieldHash of the basin it sailed in, 0 = still water)
+//   start <snapshot> <tick> <state hash>  (only for sessions resumed from a quick-load)
+//   <tick> <command> <value>   (time_compression too, see timewarp.h)
+//   end <tick> <state hash>     (missing if the game crashed)
+
+#define JOURNAL_VERSION 1
+
+typedef struct
+{
+  uint64_t tick; // Ticks completed when the command was applied
+  SubmarineCommand cmd;
+} JournalEntry;
+
+typedef struct
+{
+  FILE *file;
+} JournalWriter;
+
+typedef struct
+{
+  JournalEntry *entries;
+  int count;
+  uint64_t end_tick;   // Ticks to run; the last entry's tick without an end line
+  uint64_t final_hash; // submarineStateHash of the recorded final state
+  bool has_end;        // false = the session never closed, nothing to verify against
+  uint64_t params_hash; // Physics the session ran with, if the journal says (older ones don't)
+  bool has_params;
+  uint64_t currents_hash; // Ocean-current field the same way
+  bool has_currents;
+
+  // Session resumed from a snapshot instead of initSubmarine()
+  bool has_start;
+  char start_snapshot[256];
+  uint64_t start_tick;
+  uint64_t start_hash; // submarineStateHash the snapshot must still have
+} Journal;
+
+// Writer. The previous journal at path is kept as <path>.prev.
+bool journalOpen(JournalWriter *writer, const char *path);
+void journalStart(JournalWriter *writer, const char *snapshot_path, uint64_t tick, const SubmarineState *sub);
+void journalCommand(JournalWriter *writer, uint64_t tick, SubmarineCommand cmd);
+void journalClose(JournalWriter *writer, uint64_t end_tick, const SubmarineState *final_state);
+
+// Reader
+bool journalLoad(const char *path, Journal *journal);
+void journalFree(Journal *journal);
+
+// Run the journal from initSubmarine() (or its start snapshot) with no
+// rendering, as fast as the model goes. False if the start snapshot is
+// missing or no longer the one the session was recorded from.
+bool replayJournal(const Journal *journal, SubmarineState *out);
+
+#endif
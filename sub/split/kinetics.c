@@ -0,0 +1,184 @@
+#include "kinetics.h"
+#include "params.h"
+#include "thermal.h"
+
+static const float groupBeta[KINETICS_GROUPS] = {
+#define KINETICS_GROUP_BETA(beta, lambda) beta,
+    KINETICS_GROUP_TABLE(KINETICS_GROUP_BETA)
+#undef KINETICS_GROUP_BETA
+};
+
+static const float groupLambda[KINETICS_GROUPS] = {
+#define KINETICS_GROUP_LAMBDA(beta, lambda) lambda,
+    KINETICS_GROUP_TABLE(KINETICS_GROUP_LAMBDA)
+#undef KINETICS_GROUP_LAMBDA
+};
+
+static float groupYield[KINETICS_GROUPS]; // beta_i / LAMBDA, precursors born per unit n per second
+static float totalBeta;
+
+__attribute__((constructor)) static void buildGroupTables(void)
+{
+  totalBeta = 0.0f;
+  for (int g = 0; g < KINETICS_GROUPS; g++)
+  {
+    groupYield[g] = groupBeta[g] / KINETICS_GENERATION_TIME;
+    totalBeta += groupBeta[g];
+  }
+}
+
+float rodWorthFraction(float position)
+{
+  float x = MAX(0.0f, MIN(1.0f, position));
+  return x - sinf(2.0f * PI * x) / (2.0f * PI);
+}
+
+static float rodReactivity(float position)
+{
+  return ROD_EXCESS_REACTIVITY - ROD_WORTH * (1.0f - rodWorthFraction(position));
+}
+
+float reactorReactivity(const SubmarineState *sub)
+{
+  const SimParameters *params = activeSimParameters();
+  return rodReactivity(sub->rod_position) +
+         params->reactor_temperature_coefficient * (sub->reactor_temp - KINETICS_REFERENCE_TEMP);
+}
+
+typedef struct
+{
+  float n;
+  float c[KINETICS_GROUPS];
+} KineticsNodes;
+
+// Everything in an implicit solve that depends only on the step size h
+typedef struct
+{
+  float h;
+  float coupling;                 // sum of h lambda_i * h b_i / (1 + h lambda_i)
+  float keep[KINETICS_GROUPS];    // 1 / (1 + h lambda_i)
+  float release[KINETICS_GROUPS]; // h lambda_i / (1 + h lambda_i), precursor decay into n
+  float capture[KINETICS_GROUPS]; // h b_i / (1 + h lambda_i), n into the precursors
+} KineticsSolver;
+
+static void kineticsSolverBuild(KineticsSolver *solver, float h)
+{
+  solver->h = h;
+  solver->coupling = 0.0f;
+  for (int g = 0; g < KINETICS_GROUPS; g++)
+  {
+    solver->keep[g] = 1.0f / (1.0f + h * groupLambda[g]);
+    solver->release[g] = h * groupLambda[g] * solver->keep[g];
+    solver->capture[g] = h * groupYield[g] * solver->keep[g];
+    solver->coupling += solver->release[g] * h * groupYield[g];
+  }
+}
+
+// Solve x - h * rates(x) = r for the frozen prompt coefficient a = (rho - beta) / LAMBDA.
+// Each group is C_i = (r_i + h b_i n) / (1 + h lambda_i), which leaves one equation in n.
+static KineticsNodes kineticsSolve(const KineticsSolver *solver, float a, const KineticsNodes *r)
+{
+  float rhs = r->n + solver->h * KINETICS_SOURCE;
+  for (int g = 0; g < KINETICS_GROUPS; g++)
+    rhs += solver->release[g] * r->c[g];
+
+  KineticsNodes x;
+  x.n = rhs / (1.0f - solver->h * a - solver->coupling);
+  for (int g = 0; g < KINETICS_GROUPS; g++)
+    x.c[g] = r->c[g] * solver->keep[g] + solver->capture[g] * x.n;
+  return x;
+}
+
+static KineticsNodes kineticsRates(float a, const KineticsNodes *x)
+{
+  KineticsNodes rate;
+  rate.n = a * x->n + KINETICS_SOURCE;
+  for (int g = 0; g < KINETICS_GROUPS; g++)
+  {
+    float decay = groupLambda[g] * x->c[g];
+    rate.n += decay;
+    rate.c[g] = groupYield[g] * x->n - decay;
+  }
+  return rate;
+}
+
+// rising is dn/dt now - the interlock compares it with n / ROD_PERIOD_LIMIT
+static void driveRods(SubmarineState *sub, float rising, float deltaTime)
+{
+  bool drive_powered = sub->battery_level > 5.0f || systemOn(sub, SYS_BACKUP_POWER);
+
+  if (!systemOn(sub, SYS_REACTOR))
+  {
+    // Shut down or tripped - the rods fall in under gravity, no power needed
+    sub->rod_position = MAX(0.0f, sub->rod_position - ROD_SCRAM_SPEED * deltaTime);
+    return;
+  }
+  if (!drive_powered)
+    return; // Drive motors hold where they are
+
+  float target = systemOn(sub, SYS_CONTROL_RODS_INSERTED) ? 0.0f : sub->rod_target;
+  float step = ROD_DRIVE_SPEED * deltaTime;
+  float move = MAX(-step, MIN(step, target - sub->rod_position));
+
+  // Startup-rate interlock: no withdrawal while the power climbs on a short
+  // period, and the drives step in on their own above rated power
+  if (move > 0.0f && (rising * ROD_PERIOD_LIMIT > sub->neutron_power || sub->neutron_power > ROD_POWER_LIMIT))
+    move = 0.0f;
+  if (sub->neutron_power > ROD_POWER_LIMIT)
+    move = -step;
+  sub->rod_position = MAX(0.0f, sub->rod_position + move);
+}
+
+void updateReactorKinetics(SubmarineState *sub, float deltaTime)
+{
+  // A destroyed core has nothing left to go critical
+  if (systemOn(sub, SYS_REACTOR_DESTROYED))
+  {
+    sub->neutron_power = 0.0f;
+    for (int g = 0; g < KINETICS_GROUPS; g++)
+      sub->precursors[g] = 0.0f;
+    return;
+  }
+
+  // The two solves' coefficients only change with the step size (every run here uses one)
+  static __thread KineticsSolver trapezoid, bdf2;
+  if (trapezoid.h != 0.5f * TRBDF2_GAMMA * deltaTime)
+  {
+    kineticsSolverBuild(&trapezoid, 0.5f * TRBDF2_GAMMA * deltaTime);
+    kineticsSolverBuild(&bdf2, TRBDF2_W * deltaTime);
+  }
+
+  KineticsNodes x0 = {sub->neutron_power};
+  for (int g = 0; g < KINETICS_GROUPS; g++)
+    x0.c[g] = sub->precursors[g];
+
+  // The rods move on the period they see, then the step runs on where they got to
+  const SimParameters *params = activeSimParameters();
+  float feedback = params->reactor_temperature_coefficient * (sub->reactor_temp - KINETICS_REFERENCE_TEMP) - totalBeta;
+  float rods = sub->rod_position;
+  float a = (rodReactivity(rods) + feedback) / KINETICS_GENERATION_TIME;
+  KineticsNodes rate = kineticsRates(a, &x0);
+  driveRods(sub, rate.n, deltaTime);
+  if (sub->rod_position != rods)
+  {
+    float moved = (rodReactivity(sub->rod_position) + feedback) / KINETICS_GENERATION_TIME;
+    rate.n += (moved - a) * x0.n;
+    a = moved;
+  }
+
+  // Trapezoid stage to gamma * dt, then BDF2 to dt - as thermalNetworkStep
+  KineticsNodes r = {x0.n + trapezoid.h * rate.n};
+  for (int g = 0; g < KINETICS_GROUPS; g++)
+    r.c[g] = x0.c[g] + trapezoid.h * rate.c[g];
+  KineticsNodes xg = kineticsSolve(&trapezoid, a, &r);
+
+  r.n = TRBDF2_A * xg.n - TRBDF2_B * x0.n;
+  for (int g = 0; g < KINETICS_GROUPS; g++)
+    r.c[g] = TRBDF2_A * xg.c[g] - TRBDF2_B * x0.c[g];
+  KineticsNodes x = kineticsSolve(&bdf2, a, &r);
+
+  // The trapezoid half can undershoot on a long step through a SCRAM
+  sub->neutron_power = MAX(0.0f, x.n);
+  for (int g = 0; g < KINETICS_GROUPS; g++)
+    sub->precursors[g] = MAX(0.0f, x.c[g]);
+}
@@ -0,0 +1,63 @@
+#ifndef KINETICS_H
+#define KINETICS_H
+
+#include "constants.h"
+
+// Point-kinetics neutronics. The core's fission rate is neutron_power
+// (1 = rated thermal power), carried with the six delayed-neutron precursor
+// groups of U-235:
+//
+//   dn/dt  = (rho - beta) / LAMBDA * n + sum(lambda_i * C_i) + source
+//   dC_i/dt = beta_i / LAMBDA * n - lambda_i * C_i
+//
+// Reactivity rho is the control rods' integral worth at rod_position plus
+// the fuel temperature (Doppler) feedback, which is what makes the core
+// settle: with the rods out a cold core is supercritical, heats, and levels
+// off where the feedback cancels the rods; the heat sinks then set how much
+// power that takes (updateThermalNetwork gets neutron_power as its fission
+// heat). A SCRAM drops the rods and the power falls promptly to a few tens of
+// percent, then decays on the slowest precursor's ~80 s period.
+//
+// The prompt term makes the system stiff - 1/LAMBDA is 10^4 per second - so
+// it is stepped with the thermal network's TR-BDF2 at the normal tick, rho
+// frozen for the step. The equations are linear in n and C, and each C_i
+// only couples to n, so every implicit solve eliminates the six groups into
+// one scalar equation for n.
+
+// Keepin's U-235 thermal fission groups: fraction beta_i, decay constant lambda_i (1/s)
+#define KINETICS_GROUP_TABLE(X) \
+  X(0.000215f, 0.0124f)         \
+  X(0.001424f, 0.0305f)         \
+  X(0.001274f, 0.111f)          \
+  X(0.002568f, 0.301f)          \
+  X(0.000748f, 1.14f)           \
+  X(0.000273f, 3.01f)
+
+#define KINETICS_GROUP_COUNT(beta, lambda) +1
+_Static_assert(0 KINETICS_GROUP_TABLE(KINETICS_GROUP_COUNT) == KINETICS_GROUPS, "KINETICS_GROUPS in constants.h is out of date");
+#undef KINETICS_GROUP_COUNT
+
+#define KINETICS_GENERATION_TIME 1e-4f  // s, prompt neutron generation time LAMBDA
+#define KINETICS_SOURCE 1e-1f           // Startup source, holds a shut-down core at a few 1e-4 of rated power
+#define ROD_WORTH 0.03f                 // Reactivity of the whole rod bank, in to out
+#define ROD_EXCESS_REACTIVITY 0.0080f   // Cold core with the rods fully out - below beta, never prompt critical
+#define ROD_DRIVE_SPEED 0.025f          // Withdrawn fraction per second on the drive motors
+#define ROD_SCRAM_SPEED 0.5f            // ... falling in on a SCRAM
+#define ROD_PERIOD_LIMIT 20.0f          // s, withdrawal blocks while the power rises on a shorter period
+#define ROD_POWER_LIMIT 1.0f            // neutron_power the drives insert the rods to hold below
+#define KINETICS_REFERENCE_TEMP 25.0f   // °C, core temperature the rod worths are quoted at
+#define REACTOR_OVERPOWER_TRIP 1.2f     // neutron_power that SCRAMs the reactor (120 %)
+
+// Rods' share of their worth at a withdrawn fraction - the S-shaped
+// integral worth curve, flat at both ends of travel
+float rodWorthFraction(float position);
+
+// Total reactivity for the state's rods and core temperature
+float reactorReactivity(const SubmarineState *sub);
+
+// Drive the rods toward their target - on the motors while the reactor runs,
+// short of a startup-rate interlock, falling in when it's shut down - and
+// advance n and the precursors
+void updateReactorKinetics(SubmarineState *sub, float deltaTime);
+
+#endif
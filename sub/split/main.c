@@ -1,4 +1,10 @@
 #include "constants.h"
+#include "contacts.h"
+#include "currents.h"
+#include "params.h"
+#include "seabed.h"
+#include "simthread.h"
+#include "sonar.h"
 
 // Global variables
 Sound reactorHum;
@@ -6,25 +12,92 @@ Sound sonarPing;
 bool audioInitialized = false;
 bool isPaused = false; // Add this line
 
-void syncButtonStates(Button buttons[], SubmarineState submarine)
+#define WORLD_CONTACTS 20000 // Shipping lanes, boats, whales and wrecks
+
+void syncButtonStates(Button buttons[], const SubmarineState *submarine)
 {
   // Sync button states with actual submarine state to prevent conflicts
-  buttons[0].pressed = submarine.ballast_tanks_filled;
-  buttons[1].pressed = submarine.lights_active;
-  buttons[2].pressed = submarine.sonar_active;
-  buttons[3].pressed = submarine.emergency_surface;
-  buttons[4].pressed = submarine.autopilot_active;
-  buttons[5].pressed = submarine.cooling_active;
+  buttons[0].pressed = systemOn(submarine, SYS_BALLAST_TANKS_FILLED);
+  buttons[1].pressed = systemOn(submarine, SYS_LIGHTS);
+  buttons[2].pressed = systemOn(submarine, SYS_SONAR);
+  buttons[3].pressed = systemOn(submarine, SYS_EMERGENCY_SURFACE);
+  buttons[4].pressed = systemOn(submarine, SYS_AUTOPILOT);
+  buttons[5].pressed = systemOn(submarine, SYS_COOLING);
+}
+
+// Every player action goes to the sim thread, which journals it at the tick it's applied
+static void issueCommand(SimThread *sim, SubmarineCommand cmd)
+{
+  if (!simThreadCommand(sim, cmd))
+    TraceLog(LOG_WARNING, "Command queue full, dropped %s", submarineCommandName(cmd.type));
 }
 
-int main(void)
+// ./submarine [scenario.scn] - a scenario sets the start and is reloaded whenever it's saved (scenario.h)
+int main(int argc, char **argv)
 {
+  const char *scenarioPath = argc > 1 ? argv[1] : NULL;
+
   InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Advanced Nuclear Submarine Simulator");
   SetTargetFPS(60);
 
   initAudio();
 
-  SubmarineState sub = initSubmarine();
+  RenderState renderState = initRenderState();
+
+  // Calibrated physics (sub_calibrate -w) replace the constants.h rates - before
+  // the sim thread starts, it and the planner only ever read them
+  if (FileExists("sub.params"))
+  {
+    if (simParametersLoad("sub.params", &simParameters))
+      TraceLog(LOG_INFO, "Physics parameters from sub.params");
+    else
+      simParameters = defaultSimParameters();
+  }
+
+  // Ocean currents from a basin file (sub_currents -g writes one), mapped
+  // rather than read, so only the water the boat crosses is ever loaded
+  static CurrentField currents;
+  if (FileExists(GAME_CURRENTS_PATH))
+  {
+    if (currentFieldMap(&currents, GAME_CURRENTS_PATH))
+    {
+      oceanCurrents = &currents;
+      TraceLog(LOG_INFO, "Ocean currents from %s", GAME_CURRENTS_PATH);
+    }
+    else
+      TraceLog(LOG_WARNING, "%s is not an ocean-current field, still water", GAME_CURRENTS_PATH);
+  }
+
+  // The seabed, tiled and generated ahead of the boat on background threads
+  // (fed below every frame) - the model grounds on it from the first tick
+  seabedTerrain = seabedCreate(SEABED_SEED, SEABED_STREAM_THREADS);
+  if (!seabedTerrain)
+    TraceLog(LOG_WARNING, "Seabed disabled: out of memory");
+
+  // The model, journal, flight recorder and predictive autopilot run on their
+  // own thread; this one only reads its snapshots and sends it input
+  static SimThread sim;
+  if (!simThreadStart(&sim, scenarioPath))
+  {
+    TraceLog(LOG_ERROR, "Could not start the simulation thread");
+    CloseWindow();
+    return 1;
+  }
+
+  // Sonar propagation - a few slices of the ray fan are retraced per frame as the boat moves
+  static SonarField sonar;
+  ThreadPool *sonarPool = threadPoolCreate(0);
+  initSonarField(&sonar, sonarPool);
+
+  // Everyone else at sea - checked against the propagation field once per ping
+  ContactDatabase world;
+  SonarDetection heard[CONTACT_MAX_DETECTIONS];
+  int heardCount = 0;
+  bool haveWorld = contactsInit(&world, WORLD_CONTACTS);
+  if (haveWorld)
+    contactsGenerateScenario(&world, WORLD_CONTACTS, 1);
+  else
+    TraceLog(LOG_WARNING, "Contact database disabled: out of memory");
 
   // Updated main control buttons (bottom right) - now includes autopilot
   Button buttons[] = {
@@ -36,79 +109,123 @@ int main(void)
       {(Rectangle){SCREEN_WIDTH - 135, SCREEN_HEIGHT - 90, 100, 30}, "Cooling", false},
   };
 
+  // Standing alarms and their history, fed by the sim thread's alarm events
+  static AlarmBoard alarmBoard;
+  initAlarmBoard(&alarmBoard);
+  bool showAlarmLog = false;
+
+  // What this thread last saw of the simulation, to spot changes between snapshots
+  const SimSnapshot *snap = simThreadLatest(&sim);
+  unsigned int lastPingCount = snap->sub.sonar_ping_count;
+  uint32_t seenLoads = snap->loads;
+  uint32_t seenWarpTrips = snap->warp_trips;
+  uint32_t seenScenarioReloads = snap->scenario_reloads;
+  int sentHelm = snap->sub.helm_input;
+  float warpDroppedTimer = 0.0f; // Shows why compression stopped
+
   while (!WindowShouldClose())
   {
     float deltaTime = GetFrameTime();
 
-    // NEW SUBSYSTEM INPUT HANDLING
-    handleSubSystemInput(&sub);
+    // Newest state the sim thread published, read in place
+    snap = simThreadLatest(&sim);
+    const SubmarineState *sub = &snap->sub;
 
-    // Enhanced keyboard controls
+    // A quick-load replaced the session under us - take its view state too
+    if (snap->loads != seenLoads)
+    {
+      seenLoads = snap->loads;
+      renderState = snap->loaded_view;
+      lastPingCount = sub->sonar_ping_count;
+      sentHelm = sub->helm_input;
+      heardCount = 0;
+    }
+    if (snap->scenario_reloads != seenScenarioReloads)
+    {
+      seenScenarioReloads = snap->scenario_reloads;
+      TraceLog(LOG_INFO, "Scenario %s reloaded", scenarioPath);
+    }
+    AlarmEvent alarm;
+    while (simThreadNextAlarm(&sim, &alarm))
+      alarmBoardApply(&alarmBoard, &alarm);
 
-    // Manual depth control
-    if (!sub.autopilot_active)
+    if (snap->warp_trips != seenWarpTrips)
     {
-      if (IsKeyDown(KEY_UP) && sub.reactor_active)
-      {
-        sub.trim_angle = MAX(-30.0f, sub.trim_angle - 30.0f * deltaTime);
-        sub.thrust = MIN(100.0f, sub.thrust + 50.0f * deltaTime);
-      }
-      else if (IsKeyDown(KEY_DOWN))
-      {
-        sub.trim_angle = MIN(30.0f, sub.trim_angle + 30.0f * deltaTime);
-        sub.thrust = MAX(-50.0f, sub.thrust - 30.0f * deltaTime);
-      }
-      else
-      {
-        sub.trim_angle *= 0.9f;
-        sub.thrust *= 0.95f;
-      }
+      seenWarpTrips = snap->warp_trips;
+      warpDroppedTimer = 4.0f;
     }
 
-    // Autopilot depth adjustment
-    if (sub.autopilot_active)
+    // NEW SUBSYSTEM INPUT HANDLING
+    SubmarineCommand panelCommand = handleSubSystemInput();
+    if (panelCommand.type != CMD_NONE)
     {
-      if (IsKeyDown(KEY_UP))
-      {
-        sub.target_depth = MAX(0, sub.target_depth - 50.0f * deltaTime);
-      }
-      if (IsKeyDown(KEY_DOWN))
-      {
-        sub.target_depth = MIN(MAX_DEPTH, sub.target_depth + 50.0f * deltaTime);
-      }
+      issueCommand(&sim, panelCommand);
+    }
+
+    // Dive control is sampled once per frame and held until it changes
+    int helm = IsKeyDown(KEY_UP) ? -1 : (IsKeyDown(KEY_DOWN) ? 1 : 0);
+    if (helm != sentHelm)
+    {
+      issueCommand(&sim, (SubmarineCommand){CMD_HELM, (float)helm});
+      sentHelm = helm;
+    }
+
+    // Left/right come round 10 degrees from the ordered course
+    int turn = IsKeyPressed(KEY_RIGHT) ? 1 : (IsKeyPressed(KEY_LEFT) ? -1 : 0);
+    if (turn != 0)
+    {
+      issueCommand(&sim, (SubmarineCommand){CMD_COURSE, sub->course + 10.0f * turn});
     }
 
     // Handle pause with Escape key
     if (IsKeyPressed(KEY_ESCAPE))
     {
       isPaused = !isPaused;
+      simThreadSend(&sim, (SimMessage){.type = SIM_MSG_PAUSE, .paused = isPaused});
+    }
+
+    // Time compression is a journaled command so replays take the same steps
+    int warpDirection = IsKeyPressed(KEY_PERIOD) ? 1 : (IsKeyPressed(KEY_COMMA) ? -1 : 0);
+    int warpFactor = timeWarpNextFactor(snap->warp.factor, warpDirection);
+    if (warpFactor != snap->warp.factor)
+    {
+      issueCommand(&sim, (SubmarineCommand){CMD_TIME_COMPRESSION, (float)warpFactor});
+    }
+
+    if (IsKeyPressed(KEY_P))
+    {
+      issueCommand(&sim, (SubmarineCommand){CMD_PREDICTIVE_AUTOPILOT, 0.0f});
+    }
+
+    // A acknowledges every standing alarm, L shows the alarm history
+    if (IsKeyPressed(KEY_A) && alarmBoardAcknowledge(&alarmBoard, snap->tick) > 0)
+    {
+      simThreadSend(&sim, (SimMessage){.type = SIM_MSG_ACKNOWLEDGE});
+    }
+    if (IsKeyPressed(KEY_L))
+    {
+      showAlarmLog = !showAlarmLog;
+    }
+
+    // H marks the current depth on the display
+    if (IsKeyPressed(KEY_H))
+    {
+      renderState.hold_depth = sub->depth;
+    }
+
+    // Quick-save / quick-load of the whole session, done by the sim thread between ticks
+    if (IsKeyPressed(KEY_F5))
+    {
+      simThreadSend(&sim, (SimMessage){.type = SIM_MSG_QUICKSAVE, .view = renderState});
+    }
+    if (IsKeyPressed(KEY_F9))
+    {
+      simThreadSend(&sim, (SimMessage){.type = SIM_MSG_QUICKLOAD});
     }
 
     // Only process game input if not paused
     if (!isPaused)
     {
-      // Handle keyboard input
-      if (IsKeyDown(KEY_UP))
-      {
-        sub.thrust = MIN(100.0f, sub.thrust + 50.0f * deltaTime);
-      }
-      else if (IsKeyDown(KEY_DOWN))
-      {
-        sub.thrust = MAX(-100.0f, sub.thrust - 50.0f * deltaTime);
-      }
-      else
-      {
-        // Gradually reduce thrust when no input
-        if (sub.thrust > 0)
-        {
-          sub.thrust = MAX(0, sub.thrust - 25.0f * deltaTime);
-        }
-        else if (sub.thrust < 0)
-        {
-          sub.thrust = MIN(0, sub.thrust + 25.0f * deltaTime);
-        }
-      }
-
       // Mouse input handling
       Vector2 mousePoint = GetMousePosition();
       bool mousePressed = IsMouseButtonPressed(MOUSE_BUTTON_LEFT);
@@ -124,85 +241,33 @@ int main(void)
 
           if (CheckCollisionPointRec(mousePoint, buttonRect))
           {
-            // Handle each button click
-            switch (i)
-            {
-            case 0: // Ballast - now requires power for normal operation
-              // Check if ballast control system has power
-              if (sub.battery_level > 0.0f || sub.backup_power_active)
-              {
-                sub.ballast_tanks_filled = !sub.ballast_tanks_filled;
-                buttons[i].pressed = sub.ballast_tanks_filled;
-                if (sub.autopilot_active)
-                {
-                  sub.autopilot_active = false;
-                  buttons[4].pressed = false;
-                }
-              }
-              // If no power, ballast button does nothing (except emergency blow still works)
-              break;
-            case 1: // Lights
-              if (sub.battery_level > 5.0f)
-              {
-                sub.lights_active = !sub.lights_active; // CHANGED: use 'sub' not 'submarine'
-                buttons[i].pressed = sub.lights_active;
-              }
-              break;
-            case 2: // Sonar
-              if (sub.battery_level > 5.0f)
-              {
-                sub.sonar_active = !sub.sonar_active; // CHANGED: use 'sub' not 'submarine'
-                buttons[i].pressed = sub.sonar_active;
-              }
-              break;
-            case 3:                                           // Emergency
-              sub.emergency_surface = !sub.emergency_surface; // CHANGED: use 'sub' not 'submarine'
-              buttons[i].pressed = sub.emergency_surface;
-              break;
-            case 4: // Autopilot
-            {
-              bool nav_operational = sub.navigation_computer_active &&
-                                     sub.gyroscope_active &&
-                                     sub.depth_control_active &&
-                                     sub.reactor_active;
-              if (nav_operational)
-              {
-                sub.autopilot_active = !sub.autopilot_active; // CHANGED: use 'sub' not 'submarine'
-                buttons[i].pressed = sub.autopilot_active;
-                if (sub.autopilot_active)
-                {
-                  sub.target_depth = sub.depth;
-                  buttons[0].pressed = sub.ballast_tanks_filled;
-                }
-              }
-            }
-            break;
-            case 5: // Cooling
-            {
-              bool cooling_available = sub.reactor_coolant_pumps_active ||
-                                       sub.emergency_cooling_active;
-              if (cooling_available)
-              {
-                sub.cooling_active = !sub.cooling_active; // CHANGED: use 'sub' not 'submarine'
-                buttons[i].pressed = sub.cooling_active;
-              }
-            }
-            break;
-            }
+            // Each main button maps to one command; interlocks live in the model
+            static const SubmarineCommandType mainButtonCommands[6] = {
+                CMD_BALLAST, CMD_LIGHTS, CMD_SONAR, CMD_EMERGENCY_SURFACE, CMD_AUTOPILOT, CMD_COOLING};
+            issueCommand(&sim, (SubmarineCommand){mainButtonCommands[i], 0.0f});
             break; // Exit loop after handling click
           }
         }
       }
 
-      // Update submarine only if not paused
-      updateSubmarineState(&sub, deltaTime); // CHANGED: use correct function name
-
-      // Sync button states to prevent flickering
-      syncButtonStates(buttons, sub);
+      if (systemOn(sub, SYS_SONAR))
+      {
+        // The bottom the rays bounce off, along the bow
+        float bottom[SONAR_GRID_RANGE_CELLS];
+        seabedProfile(seabedTerrain, sub->east, sub->north, sub->heading, SONAR_GRID_CELL, SONAR_GRID_RANGE_CELLS, bottom);
+        sonarFieldSetBottom(&sonar, bottom);
+        sonarFieldUpdate(&sonar, sub->depth, SONAR_SLICES_PER_FRAME);
+      }
     }
 
+    // Tiles around wherever the boat is now, nearest first
+    seabedStream(seabedTerrain, sub->east, sub->north);
+
+    // Sync button states to prevent flickering
+    syncButtonStates(buttons, sub);
+
     // Audio management - Reactor hum based on TEMPERATURE, not just active state
-    if (sub.reactor_temp > 50.0f) // Hum when hot, even if shut down
+    if (sub->reactor_temp > 50.0f) // Hum when hot, even if shut down
     {
       if (!IsSoundPlaying(reactorHum))
       {
@@ -210,7 +275,7 @@ int main(void)
       }
 
       // Adjust volume based on temperature
-      float volume = MIN(1.0f, (sub.reactor_temp - 50.0f) / 300.0f);
+      float volume = MIN(1.0f, (sub->reactor_temp - 50.0f) / 300.0f);
       SetSoundVolume(reactorHum, volume * 0.6f);
     }
     else
@@ -221,14 +286,19 @@ int main(void)
       }
     }
 
-    // Sonar ping
-    if (sub.sonar_active && sub.battery_level > 5.0f)
+    // Sonar ping - the model counts pings, we make the noise and see who answered
+    if (sub->sonar_ping_count != lastPingCount)
     {
-      sub.sonar_ping_timer -= deltaTime;
-      if (sub.sonar_ping_timer <= 0)
+      lastPingCount = sub->sonar_ping_count;
+      if (haveWorld)
+        heardCount = contactsPing(&world, snap->tick * SIM_TICK_DT, (float)sub->east, (float)sub->north, &sonar, heard,
+                                  CONTACT_MAX_DETECTIONS);
+      if (audioInitialized && !IsSoundPlaying(sonarPing))
       {
+        float depth_factor = 1.0f - (sub->depth / SONAR_RANGE) * 0.3f;
+        depth_factor = MAX(0.3f, depth_factor);
+        SetSoundVolume(sonarPing, 0.6f * depth_factor);
         PlaySound(sonarPing);
-        sub.sonar_ping_timer = SONAR_PING_INTERVAL;
       }
     }
 
@@ -236,7 +306,39 @@ int main(void)
     BeginDrawing();
     ClearBackground(BLACK);
 
-    renderSubmarine(sub, deltaTime, buttons);
+    if (snap->warp.factor > 1)
+    {
+      // Compressed: a summary instead of the cockpit, steps are seconds apart
+      renderTimeWarpSummary(sub, &snap->warp, snap->tick);
+    }
+    else
+    {
+      // Draw between the last two ticks so motion stays smooth at any frame rate -
+      // the view trails the sim by up to one tick
+      const SubmarineState *view = sub;
+      SubmarineState blended;
+      float alpha = (float)((simThreadNow() - snap->tick_time) * SIM_TICK_RATE);
+      if (!isPaused && alpha < 1.0f)
+      {
+        blended = interpolateSubmarineState(&snap->prev, sub, alpha);
+        view = &blended;
+      }
+      renderSubmarine(view, &alarmBoard, &renderState, deltaTime, buttons);
+      if (systemOn(view, SYS_SONAR))
+      {
+        renderSonarField(&sonar, view->depth, 10, 590);
+        renderSonarContacts(&sonar, heard, heardCount, 10, 590);
+      }
+
+      if (showAlarmLog)
+        renderAlarmLog(&alarmBoard, SCREEN_WIDTH - 540, 260, 20);
+
+      if (warpDroppedTimer > 0.0f)
+      {
+        warpDroppedTimer -= deltaTime;
+        DrawText("TIME COMPRESSION STOPPED - AUTOMATIC TRIP", SCREEN_WIDTH / 2 - 260, 120, 24, YELLOW);
+      }
+    }
 
     // Draw pause overlay if paused
     if (isPaused)
@@ -245,8 +347,8 @@ int main(void)
       DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Fade(BLACK, 0.5f));
 
       // Pause menu
-      DrawRectangle(SCREEN_WIDTH / 2 - 200, SCREEN_HEIGHT / 2 - 100, 400, 200, Fade(BLACK, 0.9f));
-      DrawRectangleLines(SCREEN_WIDTH / 2 - 200, SCREEN_HEIGHT / 2 - 100, 400, 200, WHITE);
+      DrawRectangle(SCREEN_WIDTH / 2 - 200, SCREEN_HEIGHT / 2 - 100, 400, 245, Fade(BLACK, 0.9f));
+      DrawRectangleLines(SCREEN_WIDTH / 2 - 200, SCREEN_HEIGHT / 2 - 100, 400, 245, WHITE);
 
       DrawText("GAME PAUSED", SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 80, 24, WHITE);
       DrawText("Press ESCAPE to resume", SCREEN_WIDTH / 2 - 120, SCREEN_HEIGHT / 2 - 40, 16, LIGHTGRAY);
@@ -254,12 +356,24 @@ int main(void)
       DrawText("Click panels to control systems", SCREEN_WIDTH / 2 - 140, SCREEN_HEIGHT / 2 + 10, 14, LIGHTGRAY);
       DrawText("Press H to set hold depth", SCREEN_WIDTH / 2 - 120, SCREEN_HEIGHT / 2 + 30, 14, LIGHTGRAY);
       DrawText("Main controls at bottom right", SCREEN_WIDTH / 2 - 130, SCREEN_HEIGHT / 2 + 50, 14, LIGHTGRAY);
+      DrawText("F5 quick-save, F9 quick-load", SCREEN_WIDTH / 2 - 125, SCREEN_HEIGHT / 2 + 70, 14, LIGHTGRAY);
+      DrawText(", and . change time compression", SCREEN_WIDTH / 2 - 135, SCREEN_HEIGHT / 2 + 88, 14, LIGHTGRAY);
+      DrawText("P toggles the predictive autopilot", SCREEN_WIDTH / 2 - 140, SCREEN_HEIGHT / 2 + 106, 14, LIGHTGRAY);
+      DrawText("A acknowledges alarms, L shows the alarm log", SCREEN_WIDTH / 2 - 180, SCREEN_HEIGHT / 2 + 124, 14, LIGHTGRAY);
+      DrawText("LEFT/RIGHT change course 10 degrees", SCREEN_WIDTH / 2 - 150, SCREEN_HEIGHT / 2 + 142, 14, LIGHTGRAY);
     }
 
     EndDrawing();
   }
 
-  // Cleanup
+  // Cleanup - stopping the sim closes the journal and the flight recorder
+  simThreadStop(&sim);
+  seabedDestroy(seabedTerrain);
+  seabedTerrain = NULL;
+  if (haveWorld)
+    contactsFree(&world);
+  threadPoolDestroy(sonarPool);
+  currentFieldClose(&currents);
   if (audioInitialized)
   {
     UnloadSound(reactorHum);
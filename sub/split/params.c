@@ -0,0 +1,157 @@
+#include "params.h"
+#include <errno.h>
+#include <string.h>
+
+static const char *const parameterNames[SIM_PARAMETER_COUNT] = {
+#define SIM_PARAMETER_NAME(name, value) #name,
+    SIM_PARAMETERS(SIM_PARAMETER_NAME)
+#undef SIM_PARAMETER_NAME
+};
+
+SimParameters defaultSimParameters(void)
+{
+  SimParameters params = {
+#define SIM_PARAMETER_DEFAULT(name, value) .name = value,
+      SIM_PARAMETERS(SIM_PARAMETER_DEFAULT)
+#undef SIM_PARAMETER_DEFAULT
+  };
+  simParametersUpdate(&params);
+  return params;
+}
+
+SimParameters simParameters;
+__thread const SimParameters *simParametersOverride;
+
+// The process-wide block has to be usable before main, like the environment tables
+__attribute__((constructor)) static void initSimParameters(void)
+{
+  simParameters = defaultSimParameters();
+}
+
+void simParametersUpdate(SimParameters *params)
+{
+  memcpy(params->power_draw, systemPowerDrawTable, sizeof(params->power_draw));
+  params->power_draw[SYS_LIGHTS] = params->light_power_drain;
+  params->power_draw[SYS_SONAR] = params->sonar_power_drain;
+  params->power_draw[SYS_COOLING] = params->cooling_system_drain;
+}
+
+int simParameterIndex(const char *name)
+{
+  for (int i = 0; i < SIM_PARAMETER_COUNT; i++)
+    if (strcmp(parameterNames[i], name) == 0)
+      return i;
+  return -1;
+}
+
+const char *simParameterName(int index)
+{
+  return index >= 0 && index < SIM_PARAMETER_COUNT ? parameterNames[index] : "?";
+}
+
+float *simParameterField(SimParameters *params, int index)
+{
+  switch (index)
+  {
+#define SIM_PARAMETER_CASE(name, value) \
+  case PARAM_##name:                    \
+    return &params->name;
+    SIM_PARAMETERS(SIM_PARAMETER_CASE)
+#undef SIM_PARAMETER_CASE
+  default:
+    return NULL;
+  }
+}
+
+static float parameterValue(const SimParameters *params, int index)
+{
+  switch (index)
+  {
+#define SIM_PARAMETER_CASE(name, value) \
+  case PARAM_##name:                    \
+    return params->name;
+    SIM_PARAMETERS(SIM_PARAMETER_CASE)
+#undef SIM_PARAMETER_CASE
+  default:
+    return 0.0f;
+  }
+}
+
+bool simParametersLoad(const char *path, SimParameters *params)
+{
+  FILE *f = fopen(path, "r");
+  if (!f)
+  {
+    perror(path);
+    return false;
+  }
+
+  char line[256];
+  int line_number = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), f))
+  {
+    line_number++;
+    line[strcspn(line, "\r\n")] = '\0';
+    char *hash = strchr(line, '#');
+    if (hash)
+      *hash = '\0';
+
+    char name[64], value_text[64];
+    int fields = sscanf(line, " %63s %63s", name, value_text);
+    if (fields <= 0)
+      continue; // Blank line
+
+    int index = fields == 2 ? simParameterIndex(name) : -1;
+    char *end = NULL;
+    errno = 0;
+    float value = index >= 0 ? strtof(value_text, &end) : 0.0f;
+    if (index < 0 || end == value_text || *end != '\0' || errno != 0 || !isfinite(value))
+    {
+      fprintf(stderr, "%s:%d: bad parameter line: %s\n", path, line_number, line);
+      ok = false;
+      break;
+    }
+    *simParameterField(params, index) = value;
+  }
+  fclose(f);
+
+  simParametersUpdate(params);
+  return ok;
+}
+
+bool simParametersSave(const char *path, const SimParameters *params)
+{
+  FILE *f = fopen(path, "w");
+  if (!f)
+  {
+    perror(path);
+    return false;
+  }
+
+  SimParameters defaults = defaultSimParameters();
+  for (int i = 0; i < SIM_PARAMETER_COUNT; i++)
+  {
+    // %.9g round-trips every float exactly
+    float value = parameterValue(params, i);
+    float fallback = parameterValue(&defaults, i);
+    fprintf(f, "%-34s %.9g", parameterNames[i], value);
+    if (value != fallback)
+      fprintf(f, "  # default %g", fallback);
+    fprintf(f, "\n");
+  }
+  return fclose(f) == 0;
+}
+
+uint64_t simParametersHash(const SimParameters *params)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < SIM_PARAMETER_COUNT; i++)
+  {
+    float value = parameterValue(params, i);
+    const unsigned char *bytes = (const unsigned char *)&value;
+    for (size_t b = 0; b < sizeof(value); b++)
+      hash = (hash ^ bytes[b]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
@@ -0,0 +1,96 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include "constants.h"
+
+// The model's physics rates as a runtime parameter block. constants.h still
+// holds the defaults; a parameter file overrides any of them by name:
+//
+//   # sub.params
+//   ballast_fill_rate 30
+//   thermal_pumped_conductance 0.55
+//
+// The model reads the block through activeSimParameters(): simParameters for
+// the whole process (the game, sub_batch -P and sub_replay -P set it before
+// starting any threads), or a per-thread override, which is how
+// sub_calibrate runs a different set on every core.
+//
+// Thresholds and setpoints the UI and alarms also show (reactor warning,
+// SCRAM, meltdown, crush depth) stay compile-time.
+
+// name, default
+#define SIM_PARAMETERS(X)                                                \
+  X(ballast_fill_rate, BALLAST_FILL_RATE)                                \
+  X(ballast_empty_rate, BALLAST_EMPTY_RATE)                              \
+  X(reactor_base_heat_rate, REACTOR_BASE_HEAT_RATE)                      \
+  X(reactor_exponential_factor, REACTOR_EXPONENTIAL_FACTOR)              \
+  X(reactor_residual_heat_rate, REACTOR_RESIDUAL_HEAT_RATE)              \
+  X(reactor_fission_heat_rate, REACTOR_FISSION_HEAT_RATE)                \
+  X(reactor_temperature_coefficient, REACTOR_TEMPERATURE_COEFFICIENT)    \
+  X(thermal_core_capacity, THERMAL_CORE_CAPACITY)                        \
+  X(thermal_coolant_capacity, THERMAL_COOLANT_CAPACITY)                  \
+  X(thermal_steam_capacity, THERMAL_STEAM_CAPACITY)                      \
+  X(thermal_cabin_capacity, THERMAL_CABIN_CAPACITY)                      \
+  X(thermal_pumped_conductance, THERMAL_PUMPED_CONDUCTANCE)              \
+  X(thermal_natural_conductance, THERMAL_NATURAL_CONDUCTANCE)            \
+  X(thermal_steam_conductance, THERMAL_STEAM_CONDUCTANCE)                \
+  X(thermal_steam_idle_conductance, THERMAL_STEAM_IDLE_CONDUCTANCE)      \
+  X(thermal_turbine_conductance, THERMAL_TURBINE_CONDUCTANCE)            \
+  X(thermal_turbine_idle_conductance, THERMAL_TURBINE_IDLE_CONDUCTANCE)  \
+  X(thermal_sea_conductance, THERMAL_SEA_CONDUCTANCE)                    \
+  X(thermal_emergency_conductance, THERMAL_EMERGENCY_CONDUCTANCE)        \
+  X(thermal_cabin_conductance, THERMAL_CABIN_CONDUCTANCE)                \
+  X(thermal_environment_conductance, THERMAL_ENVIRONMENT_CONDUCTANCE)    \
+  X(thermal_cooler_conductance, THERMAL_COOLER_CONDUCTANCE)              \
+  X(thermal_cooler_setpoint, THERMAL_COOLER_SETPOINT)                    \
+  X(battery_charge_rate, BATTERY_CHARGE_RATE)                            \
+  X(battery_drain_rate, BATTERY_DRAIN_RATE)                              \
+  X(light_power_drain, LIGHT_POWER_DRAIN)                                \
+  X(sonar_power_drain, SONAR_POWER_DRAIN)                                \
+  X(cooling_system_drain, COOLING_SYSTEM_DRAIN)                          \
+  X(propulsion_power_drain, PROPULSION_POWER_DRAIN)
+
+typedef enum
+{
+#define SIM_PARAMETER_ENUM(name, value) PARAM_##name,
+  SIM_PARAMETERS(SIM_PARAMETER_ENUM)
+#undef SIM_PARAMETER_ENUM
+  SIM_PARAMETER_COUNT
+} SimParameterId;
+
+typedef struct
+{
+#define SIM_PARAMETER_MEMBER(name, value) float name;
+  SIM_PARAMETERS(SIM_PARAMETER_MEMBER)
+#undef SIM_PARAMETER_MEMBER
+
+  // Derived by simParametersUpdate: systemPowerDrawTable with the drains above
+  float power_draw[64];
+} SimParameters;
+
+extern SimParameters simParameters;                        // Process-wide, defaults until loaded
+extern __thread const SimParameters *simParametersOverride; // This thread only, NULL = simParameters
+
+static inline const SimParameters *activeSimParameters(void)
+{
+  return simParametersOverride ? simParametersOverride : &simParameters;
+}
+
+SimParameters defaultSimParameters(void);
+
+// Rebuild the derived fields after changing any named one
+void simParametersUpdate(SimParameters *params);
+
+// Reads "name value" lines over whatever params holds. False (with a message)
+// on a missing file, an unknown name or a bad value.
+bool simParametersLoad(const char *path, SimParameters *params);
+bool simParametersSave(const char *path, const SimParameters *params);
+
+int simParameterIndex(const char *name); // -1 if unknown
+const char *simParameterName(int index);
+float *simParameterField(SimParameters *params, int index);
+
+// Stable across runs for the same values - journals record it
+uint64_t simParametersHash(const SimParameters *params);
+
+#endif
@@ -0,0 +1,164 @@
+// Flight recorder reader - turns a flight.rec ring file into CSV for
+// post-mortems and plotting.
+//
+//   ./sub_recdump [-f depth,reactor_temp,...] [-t last_seconds] [-e every_nth] [-S] [-o out.csv] flight.rec
+//
+// Default columns are every recorded field. -S adds the switch mask as hex,
+// -e thins the output (e.g. -e 120 is one row per sim second at real time).
+// Time is the sim tick each record was taken at - under time compression
+// there is one record per warp step, so rows are further apart.
+
+#define _GNU_SOURCE
+#include "recorder.h"
+#include <string.h>
+
+#define MAX_COLUMNS 64
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-f fields] [-t last_seconds] [-e every_nth] [-S] [-o out.csv] flight.rec\n"
+          "  -f  comma separated fields (default: all)\n"
+          "  -t  only the last N sim seconds\n"
+          "  -e  keep every Nth record (default 1)\n"
+          "  -S  add the systems bit mask column\n"
+          "  -o  write the CSV here instead of stdout\n"
+          "fields:",
+          prog);
+  for (int i = 0; i < recorderFieldCount(); i++)
+    fprintf(stderr, " %s", recorderFieldName(i));
+  fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+  const char *fields = NULL;
+  const char *out_path = NULL;
+  const char *path = NULL;
+  float last_seconds = 0.0f;
+  long every = 1;
+  bool with_systems = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (strcmp(arg, "-f") == 0 && has_value)
+      fields = argv[++i];
+    else if (strcmp(arg, "-t") == 0 && has_value)
+      last_seconds = strtof(argv[++i], NULL);
+    else if (strcmp(arg, "-e") == 0 && has_value)
+      every = atol(argv[++i]);
+    else if (strcmp(arg, "-S") == 0)
+      with_systems = true;
+    else if (strcmp(arg, "-o") == 0 && has_value)
+      out_path = argv[++i];
+    else if (arg[0] != '-' && !path)
+      path = arg;
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (!path)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+  every = MAX(1, every);
+
+  int columns[MAX_COLUMNS];
+  int column_count = 0;
+  if (fields)
+  {
+    char list[1024];
+    snprintf(list, sizeof(list), "%s", fields);
+    for (char *name = strtok(list, ","); name && column_count < MAX_COLUMNS; name = strtok(NULL, ","))
+    {
+      int index = recorderFieldIndex(name);
+      if (index < 0)
+      {
+        fprintf(stderr, "unknown field '%s'\n", name);
+        usage(argv[0]);
+        return 1;
+      }
+      columns[column_count++] = index;
+    }
+  }
+  else
+  {
+    for (int i = 0; i < recorderFieldCount() && column_count < MAX_COLUMNS; i++)
+      columns[column_count++] = i;
+  }
+
+  FlightRecorder rec;
+  if (!recorderMap(&rec, path))
+  {
+    fprintf(stderr, "%s: not a readable flight recording (version %d)\n", path, RECORDER_VERSION);
+    return 1;
+  }
+
+  uint64_t first, end;
+  recorderRange(&rec, &first, &end);
+  float tick_dt = 1.0f / rec.header->tick_rate;
+  // Back from the newest record while the sim clock is within the window,
+  // stopping at a quick-load, where the tick jumps back
+  if (last_seconds > 0.0f && end > first)
+  {
+    uint64_t span = (uint64_t)(last_seconds * rec.header->tick_rate);
+    const FlightRecord *newest = recorderRecord(&rec, end - 1);
+    uint64_t start = end - 1, later_tick = newest ? newest->tick : 0;
+    while (newest && start > first)
+    {
+      const FlightRecord *r = recorderRecord(&rec, start - 1);
+      if (!r || r->tick > later_tick || r->tick + span < newest->tick)
+        break;
+      later_tick = r->tick;
+      start--;
+    }
+    first = start;
+  }
+
+  FILE *out = out_path ? fopen(out_path, "w") : stdout;
+  if (!out)
+  {
+    perror(out_path);
+    recorderClose(&rec);
+    return 1;
+  }
+
+  fprintf(out, "tick,time");
+  for (int c = 0; c < column_count; c++)
+    fprintf(out, ",%s", recorderFieldName(columns[c]));
+  fprintf(out, with_systems ? ",systems\n" : "\n");
+
+  long rows = 0, skipped = 0;
+  for (uint64_t seq = first; seq < end; seq += every)
+  {
+    const FlightRecord *r = recorderRecord(&rec, seq);
+    if (!r)
+    {
+      skipped++;
+      continue;
+    }
+
+    fprintf(out, "%llu,%.4f", (unsigned long long)r->tick, r->tick * tick_dt);
+    for (int c = 0; c < column_count; c++)
+      fprintf(out, ",%g", recorderFieldValue(r, columns[c]));
+    if (with_systems)
+      fprintf(out, ",%#llx", (unsigned long long)r->systems);
+    fprintf(out, "\n");
+    rows++;
+  }
+
+  if (out != stdout)
+    fclose(out);
+
+  fprintf(stderr, "%s: %ld rows, records %llu-%llu of %llu written%s\n", path, rows,
+          (unsigned long long)first, (unsigned long long)(end ? end - 1 : 0),
+          (unsigned long long)end, skipped ? " (some records damaged)" : "");
+  recorderClose(&rec);
+  return 0;
+}
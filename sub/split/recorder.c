@@ -0,0 +1,175 @@
+#define _GNU_SOURCE
+#include "recorder.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct
+{
+  const char *name;
+  size_t offset;
+} RecorderField;
+
+static const RecorderField recorderFields[] = {
+#define RECORDER_FIELD(name) {#name, offsetof(FlightRecord, name)},
+    RECORDER_FLOAT_FIELDS(RECORDER_FIELD)
+#undef RECORDER_FIELD
+};
+#define RECORDER_FIELD_COUNT ((int)(sizeof(recorderFields) / sizeof(recorderFields[0])))
+
+static bool mapFile(FlightRecorder *rec, int fd, size_t size, bool writable)
+{
+  // Populate up front so appends never take a page fault in the frame loop
+  int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void *map = mmap(NULL, size, prot, MAP_SHARED | (writable ? MAP_POPULATE : 0), fd, 0);
+  if (map == MAP_FAILED)
+    return false;
+
+  rec->fd = fd;
+  rec->writable = writable;
+  rec->map_size = size;
+  rec->header = map;
+  rec->records = (FlightRecord *)((char *)map + sizeof(FlightRecorderHeader));
+  return true;
+}
+
+bool recorderOpen(FlightRecorder *rec, const char *path, uint32_t capacity)
+{
+  memset(rec, 0, sizeof(*rec));
+  rec->fd = -1;
+  if (capacity < 2)
+    return false;
+
+  char previous[1024];
+  snprintf(previous, sizeof(previous), "%s.prev", path);
+  if (rename(path, previous) != 0 && errno != ENOENT)
+    return false;
+
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return false;
+
+  // Reserve the blocks now - a full disk later would be a SIGBUS mid-write
+  size_t size = sizeof(FlightRecorderHeader) + (size_t)capacity * sizeof(FlightRecord);
+  if (ftruncate(fd, size) != 0 || posix_fallocate(fd, 0, size) != 0 || !mapFile(rec, fd, size, true))
+  {
+    close(fd);
+    rec->fd = -1;
+    return false;
+  }
+
+  FlightRecorderHeader *h = rec->header;
+  memcpy(h->magic, RECORDER_MAGIC, sizeof(h->magic));
+  h->version = RECORDER_VERSION;
+  h->record_size = sizeof(FlightRecord);
+  h->capacity = capacity;
+  h->tick_rate = SIM_TICK_RATE;
+  h->written = 0;
+  return true;
+}
+
+void recorderAppend(FlightRecorder *rec, const SubmarineState *sub, uint64_t tick)
+{
+  FlightRecorderHeader *h = rec->header;
+  uint64_t seq = h->written;
+
+  FlightRecord *r = &rec->records[seq % h->capacity];
+  r->sequence = seq;
+  r->tick = tick;
+  r->systems = sub->systems;
+#define RECORDER_COPY(name) r->name = sub->name;
+  RECORDER_FLOAT_FIELDS(RECORDER_COPY)
+#undef RECORDER_COPY
+
+  // Publish after the record so a crash never exposes a half-written one
+  __atomic_store_n(&h->written, seq + 1, __ATOMIC_RELEASE);
+}
+
+bool recorderMap(FlightRecorder *rec, const char *path)
+{
+  memset(rec, 0, sizeof(*rec));
+  rec->fd = -1;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  FlightRecorderHeader h;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(h) || pread(fd, &h, sizeof(h), 0) != sizeof(h) ||
+      memcmp(h.magic, RECORDER_MAGIC, sizeof(h.magic)) != 0 || h.version != RECORDER_VERSION ||
+      h.record_size != sizeof(FlightRecord) || h.capacity < 2 ||
+      (size_t)st.st_size < sizeof(h) + (size_t)h.capacity * sizeof(FlightRecord))
+  {
+    close(fd);
+    return false;
+  }
+
+  if (!mapFile(rec, fd, sizeof(h) + (size_t)h.capacity * sizeof(FlightRecord), false))
+  {
+    close(fd);
+    return false;
+  }
+  return true;
+}
+
+void recorderRange(const FlightRecorder *rec, uint64_t *first, uint64_t *end)
+{
+  uint64_t written = __atomic_load_n(&rec->header->written, __ATOMIC_ACQUIRE);
+  uint64_t capacity = rec->header->capacity;
+
+  // Once the ring has wrapped the oldest slot is the one being overwritten
+  *end = written;
+  *first = written >= capacity ? written - capacity + 1 : 0;
+}
+
+const FlightRecord *recorderRecord(const FlightRecorder *rec, uint64_t seq)
+{
+  const FlightRecord *r = &rec->records[seq % rec->header->capacity];
+  return r->sequence == seq ? r : NULL;
+}
+
+void recorderClose(FlightRecorder *rec)
+{
+  if (rec->header)
+  {
+    if (rec->writable)
+      msync(rec->header, rec->map_size, MS_SYNC);
+    munmap(rec->header, rec->map_size);
+  }
+  if (rec->fd >= 0)
+    close(rec->fd);
+  memset(rec, 0, sizeof(*rec));
+  rec->fd = -1;
+}
+
+int recorderFieldCount(void)
+{
+  return RECORDER_FIELD_COUNT;
+}
+
+const char *recorderFieldName(int index)
+{
+  return index >= 0 && index < RECORDER_FIELD_COUNT ? recorderFields[index].name : NULL;
+}
+
+int recorderFieldIndex(const char *name)
+{
+  for (int i = 0; i < RECORDER_FIELD_COUNT; i++)
+  {
+    if (strcmp(recorderFields[i].name, name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+float recorderFieldValue(const FlightRecord *record, int index)
+{
+  float value;
+  memcpy(&value, (const char *)record + recorderFields[index].offset, sizeof(value));
+  return value;
+}
@@ -0,0 +1,99 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include "constants.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Flight recorder - one fixed-size record per model step in a
+// memory-mapped ring file. Appending is a memcpy into the mapping plus one
+// store, the kernel writes the pages back on its own, so the frame loop never
+// waits on disk and the file outlives a crash of the game.
+//
+// File layout: FlightRecorderHeader, then `capacity` FlightRecords. Record n
+// lives in slot n % capacity. The header's `written` count is bumped after
+// the record is complete, so everything below it is whole - except the
+// oldest slot, which the next append may have been halfway through.
+//
+// At real time a step is one tick. Under time compression it is one of the
+// warp's adaptive steps (up to TIMEWARP_MAX_STEP_TICKS), so records thin out
+// and each carries the sim tick it was taken at; a quick-load rewinds that
+// tick while the sequence number keeps counting.
+#define RECORDER_MAGIC "SUBFDR01"
+#define RECORDER_VERSION 3
+#define RECORDER_DEFAULT_SECONDS 600 // Ring length for the game at real time, ~7.5 MB at 120 Hz
+
+// Telemetry kept per record - add fields at the end and bump RECORDER_VERSION
+#define RECORDER_FLOAT_FIELDS(X) \
+  X(depth)                       \
+  X(speed)                       \
+  X(vertical_speed)              \
+  X(oxygen)                      \
+  X(reactor_temp)                \
+  X(reactor_power)               \
+  X(hull_integrity)              \
+  X(hull_temperature)            \
+  X(battery_level)               \
+  X(power_consumption)           \
+  X(nitrogen_level)              \
+  X(ballast_level)               \
+  X(thrust)                      \
+  X(trim_angle)                  \
+  X(target_depth)                \
+  X(water_temperature)           \
+  X(north)                       \
+  X(east)                        \
+  X(heading)                     \
+  X(forward_speed)
+
+typedef struct
+{
+  uint64_t sequence; // Records appended before this one
+  uint64_t tick;     // Sim time in SIM_TICK_DT steps when it was taken
+  uint64_t systems; // SubmarineSystem bits
+#define RECORDER_DECLARE_FLOAT(name) float name;
+  RECORDER_FLOAT_FIELDS(RECORDER_DECLARE_FLOAT)
+#undef RECORDER_DECLARE_FLOAT
+} FlightRecord;
+
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t capacity;  // Records in the ring
+  uint32_t tick_rate; // SIM_TICK_RATE of the writer
+  uint64_t written;   // Records ever appended (published last)
+  uint8_t reserved[32];
+} FlightRecorderHeader;
+
+typedef struct
+{
+  int fd;
+  bool writable;
+  size_t map_size;
+  FlightRecorderHeader *header;
+  FlightRecord *records;
+} FlightRecorder;
+
+// Writer: creates (or replaces) the ring file. An existing recording is kept
+// next to it as <path>.prev so relaunching after a crash doesn't eat it.
+bool recorderOpen(FlightRecorder *rec, const char *path, uint32_t capacity);
+void recorderAppend(FlightRecorder *rec, const SubmarineState *sub, uint64_t tick);
+
+// Reader: maps an existing file read-only, false if it isn't a flight recording
+bool recorderMap(FlightRecorder *rec, const char *path);
+
+// Sequence range [first, end) of intact records, and access by sequence number
+void recorderRange(const FlightRecorder *rec, uint64_t *first, uint64_t *end);
+const FlightRecord *recorderRecord(const FlightRecorder *rec, uint64_t seq);
+
+void recorderClose(FlightRecorder *rec);
+
+// Name-based access for tools - index is a position in RECORDER_FLOAT_FIELDS
+int recorderFieldCount(void);
+const char *recorderFieldName(int index);
+int recorderFieldIndex(const char *name); // -1 if unknown
+float recorderFieldValue(const FlightRecord *record, int index);
+
+#endif
@@ -1,4 +1,13 @@
+#include "alarms.h"
 #include "constants.h"
+#include "contacts.h"
+#include "currents.h"
+#include "environment.h"
+#include "flooding.h"
+#include "kinetics.h"
+#include "seabed.h"
+#include "sonar.h"
+#include "timewarp.h"
 #include <string.h>
 
 void drawButton(Button btn, Color color)
@@ -37,11 +46,38 @@ void drawSystemButton(int x, int y, const char *label, bool active, bool enabled
   DrawText(label, x + 18, y + 6, 14, textColor);
 }
 
-void drawSubSystemPanel(int x, int y, const char *title, SubmarineState sub)
+// Compartments fore to aft, water rising in each, breached hull outlined red;
+// doors in the gaps, green open and red shut (click to swing, input.c)
+static void drawDamageControl(const SubmarineState *sub)
+{
+  for (int c = 0; c < COMPARTMENT_COUNT; c++)
+  {
+    const FloodCompartmentInfo *info = floodCompartment(c);
+    int bx = DAMAGE_STRIP_X + c * (DAMAGE_BOX_WIDTH + DAMAGE_BOX_GAP);
+    float fill = sub->flood_water[c] / info->volume;
+    int water = (int)(fill * DAMAGE_BOX_HEIGHT);
+
+    DrawRectangle(bx, DAMAGE_STRIP_Y, DAMAGE_BOX_WIDTH, DAMAGE_BOX_HEIGHT, DARKGRAY);
+    DrawRectangle(bx, DAMAGE_STRIP_Y + DAMAGE_BOX_HEIGHT - water, DAMAGE_BOX_WIDTH, water, fill > 0.5f ? BLUE : SKYBLUE);
+    DrawRectangleLines(bx, DAMAGE_STRIP_Y, DAMAGE_BOX_WIDTH, DAMAGE_BOX_HEIGHT, sub->breach_area[c] > 0.0f ? RED : WHITE);
+    DrawText(info->label, bx + 1, DAMAGE_STRIP_Y + DAMAGE_BOX_HEIGHT + 2, 8, LIGHTGRAY);
+  }
+
+  for (int d = 0; d < DOOR_COUNT; d++)
+  {
+    FloodCompartment a, b;
+    floodDoorEnds(d, &a, &b);
+    int gx = DAMAGE_STRIP_X + MIN(a, b) * (DAMAGE_BOX_WIDTH + DAMAGE_BOX_GAP) + DAMAGE_BOX_WIDTH;
+    DrawRectangle(gx + 1, DAMAGE_STRIP_Y + DAMAGE_BOX_HEIGHT / 2 - 8, DAMAGE_BOX_GAP - 2, 16,
+                  floodDoorOpen(sub, d) ? GREEN : RED);
+  }
+}
+
+void drawSubSystemPanel(int x, int y, const char *title, const SubmarineState *sub)
 {
   // Check if backup power provides power for this panel type
-  bool backup_power_available = sub.backup_power_active;
-  bool main_power_available = sub.battery_level > 5.0f;
+  bool backup_power_available = systemOn(sub, SYS_BACKUP_POWER);
+  bool main_power_available = sub->battery_level > 5.0f;
   bool any_power_available = main_power_available || backup_power_available;
 
   if (strcmp(title, "REACTOR SYSTEMS") == 0)
@@ -51,22 +87,22 @@ void drawSubSystemPanel(int x, int y, const char *title, SubmarineState sub)
     DrawText(title, x + 10, y + 5, 16, YELLOW);
 
     // Control Rods - Always available (manual)
-    drawSystemButton(x + 10, y + 30, "Control Rods", !sub.reactor_control_rods_inserted, true);
+    drawSystemButton(x + 10, y + 30, "Control Rods", !systemOn(sub, SYS_CONTROL_RODS_INSERTED), true);
 
     // Coolant Pumps - Needs power (battery OR backup)
-    drawSystemButton(x + 140, y + 30, "Coolant Pumps", sub.reactor_coolant_pumps_active, any_power_available);
+    drawSystemButton(x + 140, y + 30, "Coolant Pumps", systemOn(sub, SYS_COOLANT_PUMPS), any_power_available);
 
     // Steam Generator - Needs power (battery OR backup)
-    drawSystemButton(x + 10, y + 60, "Power Gen", sub.reactor_steam_generator_active, any_power_available);
+    drawSystemButton(x + 10, y + 60, "Power Gen", systemOn(sub, SYS_STEAM_GENERATOR), any_power_available);
 
     // Power Turbine - Needs power (battery OR backup)
-    drawSystemButton(x + 140, y + 60, "Power Turbine", sub.reactor_power_turbine_active, any_power_available);
+    drawSystemButton(x + 140, y + 60, "Power Turbine", systemOn(sub, SYS_POWER_TURBINE), any_power_available);
 
     // Containment - Needs power (battery OR backup)
-    drawSystemButton(x + 10, y + 90, "Containment", sub.reactor_containment_active, any_power_available);
+    drawSystemButton(x + 10, y + 90, "Containment", systemOn(sub, SYS_CONTAINMENT), any_power_available);
 
     // Main Reactor - Always available (manual start/stop)
-    drawSystemButton(x + 75, y + 120, "MAIN REACTOR", sub.reactor_active, true);
+    drawSystemButton(x + 75, y + 120, "MAIN REACTOR", systemOn(sub, SYS_REACTOR), true);
 
     // Power status indicator
     if (backup_power_available && !main_power_available)
@@ -89,21 +125,19 @@ void drawSubSystemPanel(int x, int y, const char *title, SubmarineState sub)
     DrawText(title, x + 10, y + 5, 16, CYAN);
 
     // All life support systems need power (battery OR backup)
-    drawSystemButton(x + 10, y + 30, "Air Circulation", sub.air_circulation_active, any_power_available);
-    drawSystemButton(x + 140, y + 30, "CO2 Scrubbers", sub.oxygen_scrubbers_active, any_power_available);
-    drawSystemButton(x + 10, y + 60, "O2 Generator", sub.oxygen_generator_active, any_power_available);
-    drawSystemButton(x + 140, y + 60, "Hull Monitor", sub.hull_monitoring_active, any_power_available);
-    drawSystemButton(x + 10, y + 90, "MAIN O2 SYS", sub.oxygen_system_active, any_power_available);
+    drawSystemButton(x + 10, y + 30, "Air Circulation", systemOn(sub, SYS_AIR_CIRCULATION), any_power_available);
+    drawSystemButton(x + 140, y + 30, "CO2 Scrubbers", systemOn(sub, SYS_CO2_SCRUBBERS), any_power_available);
+    drawSystemButton(x + 10, y + 60, "O2 Generator", systemOn(sub, SYS_O2_GENERATOR), any_power_available);
+    drawSystemButton(x + 140, y + 60, "Hull Monitor", systemOn(sub, SYS_HULL_MONITORING), any_power_available);
+    drawSystemButton(x + 10, y + 90, "MAIN O2 SYS", systemOn(sub, SYS_OXYGEN_SYSTEM), any_power_available);
 
     // Life support status
-    int active_subsystems = (sub.air_circulation_active ? 1 : 0) +
-                            (sub.oxygen_scrubbers_active ? 1 : 0) +
-                            (sub.oxygen_generator_active ? 1 : 0);
+    int active_subsystems = countSystemsOn(sub, SYS_O2_SUBSYSTEMS);
 
     Color statusColor = (active_subsystems >= 2 && any_power_available) ? GREEN : (active_subsystems >= 1 ? ORANGE : RED);
     DrawText(TextFormat("SUB-SYSTEMS: %d/3", active_subsystems), x + 10, y + 120, 14, statusColor);
 
-    if (sub.oxygen_system_active && active_subsystems >= 2 && any_power_available)
+    if (systemOn(sub, SYS_OXYGEN_SYSTEM) && active_subsystems >= 2 && any_power_available)
     {
       DrawText("LIFE SUPPORT: OPERATIONAL", x + 10, y + 140, 14, GREEN);
     }
@@ -112,8 +146,8 @@ void drawSubSystemPanel(int x, int y, const char *title, SubmarineState sub)
       DrawText("LIFE SUPPORT: DEGRADED", x + 10, y + 140, 14, RED);
     }
 
-    DrawText(TextFormat("O2: %.1f%% (%.1f/min)", sub.oxygen,
-                        (sub.oxygen_system_active && any_power_available) ? 1.5f : -2.5f),
+    DrawText(TextFormat("O2: %.1f%% (%.1f/min)", sub->oxygen,
+                        (systemOn(sub, SYS_OXYGEN_SYSTEM) && any_power_available) ? 1.5f : -2.5f),
              x + 10, y + 160, 12, WHITE);
 
     // Power status indicator
@@ -132,22 +166,22 @@ void drawSubSystemPanel(int x, int y, const char *title, SubmarineState sub)
   }
   else if (strcmp(title, "NAVIGATION") == 0)
   {
-    bool nav_power_available = (sub.battery_level > 10.0f) || backup_power_available;
+    bool nav_power_available = (sub->battery_level > 10.0f) || backup_power_available;
 
     DrawRectangle(x, y, 280, 180, Fade(BLACK, 0.8f));
     DrawRectangleLines(x, y, 280, 180, WHITE);
     DrawText(title, x + 10, y + 5, 16, LIME);
 
     // Navigation systems need more power
-    drawSystemButton(x + 10, y + 30, "Gyroscope", sub.gyroscope_active, nav_power_available);
-    drawSystemButton(x + 140, y + 30, "Nav Computer", sub.navigation_computer_active, nav_power_available);
-    drawSystemButton(x + 10, y + 60, "Depth Control", sub.depth_control_active, nav_power_available);
+    drawSystemButton(x + 10, y + 30, "Gyroscope", systemOn(sub, SYS_GYROSCOPE), nav_power_available);
+    drawSystemButton(x + 140, y + 30, "Nav Computer", systemOn(sub, SYS_NAV_COMPUTER), nav_power_available);
+    drawSystemButton(x + 10, y + 60, "Depth Control", systemOn(sub, SYS_DEPTH_CONTROL), nav_power_available);
 
     // Ballast and Communications need power (battery > 0 OR backup)
-    bool ballast_power_available = (sub.battery_level > 0.0f) || backup_power_available;
+    bool ballast_power_available = (sub->battery_level > 0.0f) || backup_power_available;
 
-    drawSystemButton(x + 140, y + 60, "Ballast Ctrl", sub.ballast_control_active, ballast_power_available);
-    drawSystemButton(x + 10, y + 90, "Communications", sub.communications_active, ballast_power_available);
+    drawSystemButton(x + 140, y + 60, "Ballast Ctrl", systemOn(sub, SYS_BALLAST_CONTROL), ballast_power_available);
+    drawSystemButton(x + 10, y + 90, "Communications", systemOn(sub, SYS_COMMUNICATIONS), ballast_power_available);
 
     // Power status indicator
     if (backup_power_available && !nav_power_available)
@@ -170,41 +204,41 @@ void drawSubSystemPanel(int x, int y, const char *title, SubmarineState sub)
     DrawText(title, x + 10, y + 5, 16, RED); // Red for emergency
 
     // Row 1 - Power & Lighting
-    drawSystemButton(x + 10, y + 30, "BACKUP POWER", sub.backup_power_active, true); // Always available
-    drawSystemButton(x + 140, y + 30, "Emerg Lights", sub.emergency_lighting_active, true);
+    drawSystemButton(x + 10, y + 30, "BACKUP POWER", systemOn(sub, SYS_BACKUP_POWER), true); // Always available
+    drawSystemButton(x + 140, y + 30, "Emerg Lights", systemOn(sub, SYS_EMERGENCY_LIGHTING), true);
 
     // Row 2 - Cooling & Air
-    drawSystemButton(x + 10, y + 60, "EMERG COOLING", sub.emergency_cooling_active, true); // MOVED HERE
-    drawSystemButton(x + 140, y + 60, "Emerg Air", sub.emergency_air_supply_active, true);
+    drawSystemButton(x + 10, y + 60, "EMERG COOLING", systemOn(sub, SYS_EMERGENCY_COOLING), true); // MOVED HERE
+    drawSystemButton(x + 140, y + 60, "Emerg Air", systemOn(sub, SYS_EMERGENCY_AIR), true);
 
     // Row 3 - Pumps & Fire
-    drawSystemButton(x + 10, y + 90, "Manual Bilge", sub.manual_bilge_pumps_active, true);
-    drawSystemButton(x + 140, y + 90, "Fire Suppress", sub.fire_suppression_active, true);
+    drawSystemButton(x + 10, y + 90, "Manual Bilge", systemOn(sub, SYS_BILGE_PUMPS), true);
+    drawSystemButton(x + 140, y + 90, "Fire Suppress", systemOn(sub, SYS_FIRE_SUPPRESSION), true);
 
     // Row 4 - Surface & Beacon
-    drawSystemButton(x + 10, y + 120, "BALLAST BLOW", sub.manual_ballast_blow_active, true);
-    drawSystemButton(x + 140, y + 120, "Distress Beacon", sub.distress_beacon_active, true);
+    drawSystemButton(x + 10, y + 120, "BALLAST BLOW", systemOn(sub, SYS_BALLAST_BLOW), true);
+    drawSystemButton(x + 140, y + 120, "Distress Beacon", systemOn(sub, SYS_DISTRESS_BEACON), true);
 
     // Emergency status display
     Color statusColor = GREEN;
     const char *statusText = "READY";
 
-    if (sub.hull_integrity < 50.0f)
+    if (sub->hull_integrity < 50.0f)
     {
       statusColor = RED;
       statusText = "HULL BREACH";
     }
-    else if (sub.reactor_temp > 400.0f)
+    else if (sub->reactor_temp > 400.0f)
     {
       statusColor = RED;
       statusText = "REACTOR CRITICAL";
     }
-    else if (sub.oxygen < 30.0f)
+    else if (sub->oxygen < 30.0f)
     {
       statusColor = ORANGE;
       statusText = "LOW OXYGEN";
     }
-    else if (sub.battery_level < 10.0f && !sub.backup_power_active)
+    else if (sub->battery_level < 10.0f && !systemOn(sub, SYS_BACKUP_POWER))
     {
       statusColor = ORANGE;
       statusText = "LOW POWER";
@@ -214,11 +248,11 @@ void drawSubSystemPanel(int x, int y, const char *title, SubmarineState sub)
     DrawText(statusText, x + 10, y + 170, 14, statusColor);
 
     // Power source display
-    if (sub.backup_power_active)
+    if (systemOn(sub, SYS_BACKUP_POWER))
     {
       DrawText("BACKUP POWER: ACTIVE", x + 10, y + 190, 12, GREEN);
     }
-    else if (sub.battery_level > 0)
+    else if (sub->battery_level > 0)
     {
       DrawText("MAIN POWER: ACTIVE", x + 10, y + 190, 12, GREEN);
     }
@@ -227,24 +261,21 @@ void drawSubSystemPanel(int x, int y, const char *title, SubmarineState sub)
       DrawText("NO POWER AVAILABLE", x + 10, y + 190, 12, RED);
     }
 
-    // Emergency procedures
-    DrawText("EMERGENCY PROCEDURES:", x + 10, y + 220, 14, YELLOW);
-    DrawText("1. Start backup power", x + 10, y + 240, 10, LIGHTGRAY);
-    DrawText("2. Activate emergency air", x + 10, y + 255, 10, LIGHTGRAY);
-    DrawText("3. Manual ballast blow", x + 10, y + 270, 10, LIGHTGRAY);
-    DrawText("4. Emergency surface", x + 10, y + 285, 10, LIGHTGRAY);
-    DrawText("5. Activate distress beacon", x + 10, y + 300, 10, LIGHTGRAY);
+    // Damage control - flooding by compartment and the watertight doors
+    DrawText("DAMAGE CONTROL:", x + 10, y + 220, 14, YELLOW);
+    drawDamageControl(sub);
+    drawSystemButton(x + 10, DAMAGE_DOORS_BUTTON_Y, "Shut Doors", sub->doors_shut == (1u << DOOR_COUNT) - 1, true);
+    float flooded = floodTotalWater(sub);
+    DrawText(TextFormat("FLOODED: %.0f m3", flooded), x + 140, DAMAGE_DOORS_BUTTON_Y + 6, 12,
+             flooded > 0.0f ? RED : GREEN);
 
     // Active emergency systems count
-    int active_emergency = (sub.backup_power_active ? 1 : 0) +
-                           (sub.emergency_lighting_active ? 1 : 0) +
-                           (sub.manual_bilge_pumps_active ? 1 : 0) +
-                           (sub.emergency_air_supply_active ? 1 : 0) +
-                           (sub.manual_ballast_blow_active ? 1 : 0) +
-                           (sub.fire_suppression_active ? 1 : 0) +
-                           (sub.distress_beacon_active ? 1 : 0);
-
-    DrawText(TextFormat("ACTIVE SYSTEMS: %d/7", active_emergency), x + 10, y + 320, 12,
+    int active_emergency = countSystemsOn(sub, SYS_BIT(SYS_BACKUP_POWER) | SYS_BIT(SYS_EMERGENCY_LIGHTING) |
+                                                    SYS_BIT(SYS_BILGE_PUMPS) | SYS_BIT(SYS_EMERGENCY_AIR) |
+                                                    SYS_BIT(SYS_BALLAST_BLOW) | SYS_BIT(SYS_FIRE_SUPPRESSION) |
+                                                    SYS_BIT(SYS_DISTRESS_BEACON));
+
+    DrawText(TextFormat("ACTIVE SYSTEMS: %d/7", active_emergency), x + 10, y + 325, 12,
              active_emergency > 0 ? GREEN : GRAY);
   }
   else
@@ -255,25 +286,25 @@ void drawSubSystemPanel(int x, int y, const char *title, SubmarineState sub)
 
     if (strcmp(title, "REACTOR SYSTEMS") == 0)
     {
-      drawSystemButton(x + 10, y + 30, "Control Rods", !sub.reactor_control_rods_inserted, true);
-      drawSystemButton(x + 140, y + 30, "Coolant Pumps", sub.reactor_coolant_pumps_active, sub.battery_level > 5);
-      drawSystemButton(x + 10, y + 60, "Steam Gen", sub.reactor_steam_generator_active, sub.battery_level > 5);
-      drawSystemButton(x + 140, y + 60, "Power Turbine", sub.reactor_power_turbine_active, sub.battery_level > 5);
-      drawSystemButton(x + 10, y + 90, "Containment", sub.reactor_containment_active, sub.battery_level > 5);
-      drawSystemButton(x + 75, y + 120, "MAIN REACTOR", sub.reactor_active, sub.battery_level > 10);
+      drawSystemButton(x + 10, y + 30, "Control Rods", !systemOn(sub, SYS_CONTROL_RODS_INSERTED), true);
+      drawSystemButton(x + 140, y + 30, "Coolant Pumps", systemOn(sub, SYS_COOLANT_PUMPS), sub->battery_level > 5);
+      drawSystemButton(x + 10, y + 60, "Steam Gen", systemOn(sub, SYS_STEAM_GENERATOR), sub->battery_level > 5);
+      drawSystemButton(x + 140, y + 60, "Power Turbine", systemOn(sub, SYS_POWER_TURBINE), sub->battery_level > 5);
+      drawSystemButton(x + 10, y + 90, "Containment", systemOn(sub, SYS_CONTAINMENT), sub->battery_level > 5);
+      drawSystemButton(x + 75, y + 120, "MAIN REACTOR", systemOn(sub, SYS_REACTOR), sub->battery_level > 10);
 
       // Reactor status text - UPDATED for faster startup feedback
       Color statusColor = GREEN;
       const char *statusText = "READY";
 
-      if (sub.reactor_destroyed)
+      if (systemOn(sub, SYS_REACTOR_DESTROYED))
       {
         statusColor = RED;
         statusText = "DESTROYED";
       }
-      else if (sub.reactor_active && sub.reactor_temp > 50.0f) // LOWERED threshold
+      else if (systemOn(sub, SYS_REACTOR) && sub->reactor_temp > 50.0f) // LOWERED threshold
       {
-        if (sub.reactor_power > 10.0f) // LOWERED from 20%
+        if (sub->reactor_power > 10.0f) // LOWERED from 20%
         {
           statusColor = GREEN;
           statusText = "ONLINE";
@@ -284,11 +315,9 @@ void drawSubSystemPanel(int x, int y, const char *title, SubmarineState sub)
           statusText = "WARMING UP";
         }
       }
-      else if (!sub.reactor_control_rods_inserted && sub.reactor_coolant_pumps_active &&
-               sub.reactor_steam_generator_active && sub.reactor_power_turbine_active &&
-               sub.reactor_containment_active)
+      else if (!systemOn(sub, SYS_CONTROL_RODS_INSERTED) && allSystemsOn(sub, SYS_REACTOR_READY))
       {
-        if (sub.reactor_active)
+        if (systemOn(sub, SYS_REACTOR))
         {
           statusColor = ORANGE;
           statusText = "STARTING UP";
@@ -309,21 +338,19 @@ void drawSubSystemPanel(int x, int y, const char *title, SubmarineState sub)
     }
     else if (strcmp(title, "LIFE SUPPORT") == 0)
     {
-      drawSystemButton(x + 10, y + 30, "Air Circulation", sub.air_circulation_active, sub.battery_level > 5);
-      drawSystemButton(x + 140, y + 30, "CO2 Scrubbers", sub.oxygen_scrubbers_active, sub.battery_level > 5);
-      drawSystemButton(x + 10, y + 60, "O2 Generator", sub.oxygen_generator_active, sub.battery_level > 5);
-      drawSystemButton(x + 140, y + 60, "Hull Monitor", sub.hull_monitoring_active, sub.battery_level > 5);
-      drawSystemButton(x + 10, y + 90, "MAIN O2 SYS", sub.oxygen_system_active, sub.battery_level > 5);
+      drawSystemButton(x + 10, y + 30, "Air Circulation", systemOn(sub, SYS_AIR_CIRCULATION), sub->battery_level > 5);
+      drawSystemButton(x + 140, y + 30, "CO2 Scrubbers", systemOn(sub, SYS_CO2_SCRUBBERS), sub->battery_level > 5);
+      drawSystemButton(x + 10, y + 60, "O2 Generator", systemOn(sub, SYS_O2_GENERATOR), sub->battery_level > 5);
+      drawSystemButton(x + 140, y + 60, "Hull Monitor", systemOn(sub, SYS_HULL_MONITORING), sub->battery_level > 5);
+      drawSystemButton(x + 10, y + 90, "MAIN O2 SYS", systemOn(sub, SYS_OXYGEN_SYSTEM), sub->battery_level > 5);
 
       // Life support status
-      int active_subsystems = (sub.air_circulation_active ? 1 : 0) +
-                              (sub.oxygen_scrubbers_active ? 1 : 0) +
-                              (sub.oxygen_generator_active ? 1 : 0);
+      int active_subsystems = countSystemsOn(sub, SYS_O2_SUBSYSTEMS);
 
-      Color statusColor = (active_subsystems >= 2 && sub.battery_level > 5) ? GREEN : (active_subsystems >= 1 ? ORANGE : RED);
+      Color statusColor = (active_subsystems >= 2 && sub->battery_level > 5) ? GREEN : (active_subsystems >= 1 ? ORANGE : RED);
       DrawText(TextFormat("SUB-SYSTEMS: %d/3", active_subsystems), x + 10, y + 120, 14, statusColor);
 
-      if (sub.oxygen_system_active && active_subsystems >= 2 && sub.battery_level > 5)
+      if (systemOn(sub, SYS_OXYGEN_SYSTEM) && active_subsystems >= 2 && sub->battery_level > 5)
       {
         DrawText("LIFE SUPPORT: OPERATIONAL", x + 10, y + 140, 14, GREEN);
       }
@@ -332,28 +359,28 @@ void drawSubSystemPanel(int x, int y, const char *title, SubmarineState sub)
         DrawText("LIFE SUPPORT: DEGRADED", x + 10, y + 140, 14, RED);
       }
 
-      DrawText(TextFormat("O2: %.1f%% (%.1f/min)", sub.oxygen,
-                          (sub.oxygen_system_active && sub.battery_level > 5) ? 1.5f : -2.5f),
+      DrawText(TextFormat("O2: %.1f%% (%.1f/min)", sub->oxygen,
+                          (systemOn(sub, SYS_OXYGEN_SYSTEM) && sub->battery_level > 5) ? 1.5f : -2.5f),
                x + 10, y + 160, 12, WHITE);
     }
     else if (strcmp(title, "NAVIGATION") == 0)
     {
-      bool nav_power_available = (sub.battery_level > 10.0f) || backup_power_available;
+      bool nav_power_available = (sub->battery_level > 10.0f) || backup_power_available;
 
       DrawRectangle(x, y, 280, 180, Fade(BLACK, 0.8f));
       DrawRectangleLines(x, y, 280, 180, WHITE);
       DrawText(title, x + 10, y + 5, 16, LIME);
 
       // Navigation systems need more power
-      drawSystemButton(x + 10, y + 30, "Gyroscope", sub.gyroscope_active, nav_power_available);
-      drawSystemButton(x + 140, y + 30, "Nav Computer", sub.navigation_computer_active, nav_power_available);
-      drawSystemButton(x + 10, y + 60, "Depth Control", sub.depth_control_active, nav_power_available);
+      drawSystemButton(x + 10, y + 30, "Gyroscope", systemOn(sub, SYS_GYROSCOPE), nav_power_available);
+      drawSystemButton(x + 140, y + 30, "Nav Computer", systemOn(sub, SYS_NAV_COMPUTER), nav_power_available);
+      drawSystemButton(x + 10, y + 60, "Depth Control", systemOn(sub, SYS_DEPTH_CONTROL), nav_power_available);
 
       // Ballast and Communications need power (battery > 0 OR backup)
-      bool ballast_power_available = (sub.battery_level > 0.0f) || backup_power_available;
+      bool ballast_power_available = (sub->battery_level > 0.0f) || backup_power_available;
 
-      drawSystemButton(x + 140, y + 60, "Ballast Ctrl", sub.ballast_control_active, ballast_power_available);
-      drawSystemButton(x + 10, y + 90, "Communications", sub.communications_active, ballast_power_available);
+      drawSystemButton(x + 140, y + 60, "Ballast Ctrl", systemOn(sub, SYS_BALLAST_CONTROL), ballast_power_available);
+      drawSystemButton(x + 10, y + 90, "Communications", systemOn(sub, SYS_COMMUNICATIONS), ballast_power_available);
 
       // Power status indicator
       if (backup_power_available && !nav_power_available)
@@ -469,151 +496,73 @@ void initAudio(void)
   audioInitialized = true;
 }
 
-void drawTopAlarmBanners(SubmarineState sub)
+void drawTopAlarmBanners(const AlarmBoard *board, RenderState *view)
 {
   int banner_y = 0;
-  static float alarm_flash_timer = 0;
-  alarm_flash_timer += GetFrameTime();
+  view->alarm_flash_timer += GetFrameTime();
 
-  bool flash = (fmodf(alarm_flash_timer, 0.5f) < 0.25f); // Flash every 0.5 seconds
+  bool flash = (fmodf(view->alarm_flash_timer, 0.5f) < 0.25f); // Flash every 0.5 seconds
 
-  // REACTOR CRITICAL ALARMS
-  if (sub.reactor_destroyed)
-  {
-    Color banner_color = flash ? RED : MAROON;
-    DrawRectangle(0, banner_y, SCREEN_WIDTH, 40, banner_color);
-    DrawRectangleLines(0, banner_y, SCREEN_WIDTH, 40, WHITE);
-    DrawText("*** REACTOR CORE MELTDOWN *** ABANDON SHIP *** REACTOR CORE MELTDOWN ***",
-             SCREEN_WIDTH / 2 - 400, banner_y + 10, 20, WHITE);
-    banner_y += 45;
-  }
-  else if (sub.reactor_temp > REACTOR_CRITICAL_TEMP)
+  // Standing alarms in channel order; the text was formatted when the alarm was raised
+  for (int c = 0; c < ALARM_CHANNEL_COUNT; c++)
   {
-    Color banner_color = flash ? RED : DARKRED;
-    DrawRectangle(0, banner_y, SCREEN_WIDTH, 40, banner_color);
-    DrawRectangleLines(0, banner_y, SCREEN_WIDTH, 40, WHITE);
-    DrawText(TextFormat("*** REACTOR CRITICAL: %.0f°C *** EMERGENCY COOLING REQUIRED ***", sub.reactor_temp),
-             SCREEN_WIDTH / 2 - 350, banner_y + 10, 18, WHITE);
-    banner_y += 45;
-  }
-  else if (sub.reactor_temp > REACTOR_WARNING_TEMP)
-  {
-    Color banner_color = flash ? ORANGE : BROWN;
-    DrawRectangle(0, banner_y, SCREEN_WIDTH, 40, banner_color);
-    DrawRectangleLines(0, banner_y, SCREEN_WIDTH, 40, WHITE);
-    DrawText(TextFormat("*** REACTOR OVERHEATING: %.0f°C *** REDUCE POWER ***", sub.reactor_temp),
-             SCREEN_WIDTH / 2 - 280, banner_y + 10, 16, WHITE);
-    banner_y += 45;
-  }
+    const AlarmEntry *alarm = &board->active[c];
+    if (alarm->level == ALARM_NORMAL)
+      continue;
 
-  // HULL INTEGRITY ALARMS
-  if (sub.hull_integrity < 25.0f)
-  {
-    Color banner_color = flash ? RED : MAROON;
-    DrawRectangle(0, banner_y, SCREEN_WIDTH, 40, banner_color);
-    DrawRectangleLines(0, banner_y, SCREEN_WIDTH, 40, WHITE);
-    DrawText("*** HULL BREACH IMMINENT *** EMERGENCY SURFACE *** HULL BREACH IMMINENT ***",
-             SCREEN_WIDTH / 2 - 380, banner_y + 10, 18, WHITE);
-    banner_y += 45;
-  }
-  else if (sub.hull_integrity < 50.0f)
-  {
-    Color banner_color = flash ? ORANGE : BROWN;
-    DrawRectangle(0, banner_y, SCREEN_WIDTH, 40, banner_color);
-    DrawRectangleLines(0, banner_y, SCREEN_WIDTH, 40, WHITE);
-    DrawText(TextFormat("*** HULL DAMAGE: %.1f%% *** REDUCE DEPTH ***", sub.hull_integrity),
-             SCREEN_WIDTH / 2 - 220, banner_y + 10, 16, WHITE);
-    banner_y += 45;
-  }
-
-  // LIFE SUPPORT ALARMS
-  if (sub.oxygen < 15.0f)
-  {
-    Color banner_color = flash ? RED : MAROON;
-    DrawRectangle(0, banner_y, SCREEN_WIDTH, 40, banner_color);
-    DrawRectangleLines(0, banner_y, SCREEN_WIDTH, 40, WHITE);
-    DrawText("*** OXYGEN CRITICAL *** EMERGENCY SURFACE *** OXYGEN CRITICAL ***",
-             SCREEN_WIDTH / 2 - 320, banner_y + 10, 18, WHITE);
-    banner_y += 45;
-  }
-  else if (sub.oxygen < 30.0f)
-  {
-    Color banner_color = flash ? ORANGE : BROWN;
-    DrawRectangle(0, banner_y, SCREEN_WIDTH, 40, banner_color);
-    DrawRectangleLines(0, banner_y, SCREEN_WIDTH, 40, WHITE);
-    DrawText(TextFormat("*** LOW OXYGEN: %.1f%% *** ACTIVATE LIFE SUPPORT ***", sub.oxygen),
-             SCREEN_WIDTH / 2 - 250, banner_y + 10, 16, WHITE);
-    banner_y += 45;
-  }
+    bool severe = alarm->level >= ALARM_CRITICAL;
+    bool lit = flash || alarm->acknowledged; // Acknowledged alarms stay up but stop flashing
+    Color banner_color = severe ? (lit ? RED : MAROON) : (lit ? ORANGE : BROWN);
+    int font_size = alarm->level == ALARM_CASUALTY ? 20 : (severe ? 18 : 16);
 
-  // POWER ALARMS
-  if (sub.battery_level < 5.0f && !sub.backup_power_active)
-  {
-    Color banner_color = flash ? RED : MAROON;
     DrawRectangle(0, banner_y, SCREEN_WIDTH, 40, banner_color);
     DrawRectangleLines(0, banner_y, SCREEN_WIDTH, 40, WHITE);
-    DrawText("*** TOTAL POWER FAILURE *** ACTIVATE BACKUP POWER ***",
-             SCREEN_WIDTH / 2 - 280, banner_y + 10, 18, WHITE);
-    banner_y += 45;
-  }
-  else if (sub.battery_level < 15.0f && !sub.backup_power_active)
-  {
-    Color banner_color = flash ? ORANGE : BROWN;
-    DrawRectangle(0, banner_y, SCREEN_WIDTH, 40, banner_color);
-    DrawRectangleLines(0, banner_y, SCREEN_WIDTH, 40, WHITE);
-    DrawText(TextFormat("*** LOW POWER: %.1f%% *** START REACTOR ***", sub.battery_level),
-             SCREEN_WIDTH / 2 - 200, banner_y + 10, 16, WHITE);
+    DrawText(alarm->text, SCREEN_WIDTH / 2 - MeasureText(alarm->text, font_size) / 2, banner_y + 10, font_size, WHITE);
+    if (alarm->acknowledged)
+      DrawText("ACK", SCREEN_WIDTH - 50, banner_y + 12, 16, WHITE);
     banner_y += 45;
   }
 
-  // DEPTH ALARMS
-  if (sub.depth > REALISTIC_CRUSH_DEPTH)
+  if (board->unacknowledged > 0)
   {
-    Color banner_color = flash ? RED : MAROON;
-    DrawRectangle(0, banner_y, SCREEN_WIDTH, 40, banner_color);
-    DrawRectangleLines(0, banner_y, SCREEN_WIDTH, 40, WHITE);
-    DrawText("*** CRUSH DEPTH EXCEEDED *** EMERGENCY BALLAST BLOW ***",
-             SCREEN_WIDTH / 2 - 300, banner_y + 10, 18, WHITE);
-    banner_y += 45;
-  }
-  else if (sub.depth > REALISTIC_CRUSH_DEPTH * 0.8f)
-  {
-    Color banner_color = flash ? ORANGE : BROWN;
-    DrawRectangle(0, banner_y, SCREEN_WIDTH, 40, banner_color);
-    DrawRectangleLines(0, banner_y, SCREEN_WIDTH, 40, WHITE);
-    DrawText(TextFormat("*** APPROACHING CRUSH DEPTH: %.0fm ***", sub.depth),
-             SCREEN_WIDTH / 2 - 200, banner_y + 10, 16, WHITE);
-    banner_y += 45;
+    DrawText(TextFormat("%d UNACKNOWLEDGED - PRESS A", board->unacknowledged), 10, banner_y + 4, 16,
+             flash ? YELLOW : GOLD);
   }
 }
 
-void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
+void renderAlarmLog(const AlarmBoard *board, int x, int y, int lines)
 {
-  // Add this line at the beginning to declare hold_depth
-  static float hold_depth = -1.0f;
+  int shown = MIN((int)MIN(board->log_count, ALARM_LOG_SIZE), lines);
+  DrawRectangle(x, y, 520, 30 + lines * 16, Fade(BLACK, 0.8f));
+  DrawRectangleLines(x, y, 520, 30 + lines * 16, GRAY);
+  DrawText(TextFormat("ALARM LOG (%u events)", board->log_count), x + 10, y + 8, 14, WHITE);
+  for (int i = 0; i < shown; i++)
+    DrawText(alarmBoardLogLine(board, i), x + 10, y + 28 + i * 16, 12, i == 0 ? WHITE : LIGHTGRAY);
+}
 
+void renderSubmarine(const SubmarineState *sub, const AlarmBoard *alarms, RenderState *view, float deltaTime, Button buttons[])
+{
   // Draw alarm banners first (on top)
-  drawTopAlarmBanners(sub); // ADD THIS LINE
+  drawTopAlarmBanners(alarms, view); // ADD THIS LINE
 
   // Enhanced lighting
-  float light_level = expf(-sub.depth / LIGHT_PENETRATION_DEPTH);
-  light_level = MAX(0.001f, MIN(1.0f, light_level));
+  float light_level = environmentField(ENV_LIGHT_LEVEL, sub->depth);
 
   // More realistic water colors
   Color water_color;
-  if (sub.depth < 50)
+  if (sub->depth < 50)
   {
     water_color = (Color){30, 144, 255, 255};
   }
-  else if (sub.depth < 200)
+  else if (sub->depth < 200)
   {
     water_color = (Color){0, 100, 200, 255};
   }
-  else if (sub.depth < 1000)
+  else if (sub->depth < 1000)
   {
     water_color = (Color){0, 50, 150, 255};
   }
-  else if (sub.depth < 2000)
+  else if (sub->depth < 2000)
   {
     water_color = (Color){0, 20, 80, 255};
   }
@@ -629,7 +578,7 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
   DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, water_color);
 
   // Enhanced depth markers with smooth scrolling
-  int current_depth = (int)sub.depth;
+  int current_depth = (int)sub->depth;
   int marker_interval = 50;
 
   for (int i = -6; i <= 6; i++)
@@ -637,7 +586,7 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
     int marker_depth = ((current_depth / marker_interval) * marker_interval) + (i * marker_interval);
     if (marker_depth >= 0 && marker_depth <= MAX_DEPTH)
     {
-      float pixel_offset = (sub.depth - current_depth) * 1.6f;
+      float pixel_offset = (sub->depth - current_depth) * 1.6f;
       float y = SCREEN_HEIGHT / 2 + (i * 80) + pixel_offset;
 
       if (y > -50 && y < SCREEN_HEIGHT + 50)
@@ -653,10 +602,13 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
     }
   }
 
+  // Seabed on the same scale, when it's close enough to see
+  renderSeabedProfile(seabedTerrain, sub, 1.6f);
+
   // Enhanced submarine with rotation
   float subY = SCREEN_HEIGHT / 2;
   float subX = SCREEN_WIDTH / 2;
-  float rotation = sub.trim_angle;
+  float rotation = sub->trim_angle;
 
   // Submarine body with rotation effect
   Rectangle sub_hull = {subX - 60, subY - 12, 120, 24};
@@ -666,17 +618,17 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
   DrawRectangle(subX - 10, subY - 25, 20, 20, GRAY);
 
   // Propeller with thrust indicator
-  Color prop_color = fabsf(sub.thrust) > 10 ? ORANGE : LIGHTGRAY;
+  Color prop_color = fabsf(sub->thrust) > 10 ? ORANGE : LIGHTGRAY;
   DrawRectangle(subX - 75, subY - 6, 15, 12, prop_color);
 
   DrawText("SUB", subX - 15, subY - 5, 16, WHITE);
 
   // BALLAST BUBBLE EFFECTS
-  static float bubble_timer = 0;
-  bubble_timer += deltaTime;
+  view->bubble_timer += deltaTime;
+  float bubble_timer = view->bubble_timer;
 
   // Bubbles when draining ballast (normal operation)
-  if (!sub.ballast_tanks_filled && sub.ballast_level > 0.0f)
+  if (!systemOn(sub, SYS_BALLAST_TANKS_FILLED) && sub->ballast_level > 0.0f)
   {
     // Generate bubbles from ballast vents
     for (int i = 0; i < 8; i++)
@@ -695,7 +647,7 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
   }
 
   // EMERGENCY SURFACE BUBBLES (more intense)
-  if (sub.manual_ballast_blow_active || sub.emergency_surface)
+  if (systemOn(sub, SYS_BALLAST_BLOW) || systemOn(sub, SYS_EMERGENCY_SURFACE))
   {
     // Massive bubble stream during emergency blow
     for (int i = 0; i < 20; i++)
@@ -717,19 +669,18 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
   }
 
   // Enhanced lighting effects
-  if (sub.lights_active && sub.battery_level > 5.0f)
+  if (systemOn(sub, SYS_LIGHTS) && sub->battery_level > 5.0f)
   {
-    float intensity = 0.6f * (1.0f - light_level) * (sub.battery_level / 100.0f);
+    float intensity = 0.6f * (1.0f - light_level) * (sub->battery_level / 100.0f);
     DrawCircle(subX + 70, subY, 150, Fade(YELLOW, intensity * 0.3f));
     DrawCircle(subX + 70, subY, 100, Fade(WHITE, intensity * 0.2f));
   }
 
   // Enhanced sonar with ping indication
-  if (sub.sonar_active && sub.battery_level > 5.0f)
+  if (systemOn(sub, SYS_SONAR) && sub->battery_level > 5.0f)
   {
-    static float sonar_pulse = 0;
-    sonar_pulse += deltaTime * 2.0f;
-    float pulse = sinf(sonar_pulse);
+    view->sonar_pulse += deltaTime * 2.0f;
+    float pulse = sinf(view->sonar_pulse);
 
     // Normal sonar rings
     DrawCircleLines(subX, subY, 80 + pulse * 20, Fade(GREEN, 0.7f));
@@ -737,7 +688,7 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
     DrawCircleLines(subX, subY, 180 + pulse * 40, Fade(GREEN, 0.3f));
 
     // Ping indicator - bright flash when ping occurs
-    float ping_progress = sub.sonar_ping_timer / SONAR_PING_INTERVAL;
+    float ping_progress = sub->sonar_ping_timer / SONAR_PING_INTERVAL;
     if (ping_progress < 0.1f) // Flash for first 10% of ping cycle
     {
       float ping_intensity = (0.1f - ping_progress) / 0.1f; // Fade from 1 to 0
@@ -753,28 +704,28 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
   }
 
   // Hold/target depth markers
-  if (hold_depth >= 0)
+  if (view->hold_depth >= 0)
   {
-    float hold_offset = (hold_depth - sub.depth) * 1.6f;
+    float hold_offset = (view->hold_depth - sub->depth) * 1.6f;
     float hold_y = SCREEN_HEIGHT / 2 + hold_offset;
 
     if (hold_y > 0 && hold_y < SCREEN_HEIGHT)
     {
       DrawLine(0, hold_y, SCREEN_WIDTH, hold_y, Fade(YELLOW, 0.8f));
-      DrawText(TextFormat("HOLD: %.0fm", hold_depth),
+      DrawText(TextFormat("HOLD: %.0fm", view->hold_depth),
                SCREEN_WIDTH - 180, hold_y - 15, 16, YELLOW);
     }
   }
 
-  if (sub.autopilot_active)
+  if (systemOn(sub, SYS_AUTOPILOT))
   {
-    float target_offset = (sub.target_depth - sub.depth) * 1.6f;
+    float target_offset = (sub->target_depth - sub->depth) * 1.6f;
     float target_y = SCREEN_HEIGHT / 2 + target_offset;
 
     if (target_y > 0 && target_y < SCREEN_HEIGHT)
     {
       DrawLine(0, target_y, SCREEN_WIDTH, target_y, Fade(CYAN, 0.8f));
-      DrawText(TextFormat("TARGET: %.0fm", sub.target_depth),
+      DrawText(TextFormat("TARGET: %.0fm", sub->target_depth),
                SCREEN_WIDTH - 180, target_y + 5, 16, CYAN);
     }
   }
@@ -803,7 +754,7 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
     switch (i)
     {
     case 0: // Ballast - check if ballast control has power
-      if (sub.battery_level <= 0.0f && !sub.backup_power_active)
+      if (sub->battery_level <= 0.0f && !systemOn(sub, SYS_BACKUP_POWER))
         btnColor = DARKGRAY; // No power - ballast control disabled
       else
         btnColor = buttons[i].pressed ? GREEN : GRAY;
@@ -812,7 +763,7 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
       btnColor = buttons[i].pressed ? GREEN : GRAY;
       break;
     case 2: // Sonar - check if can be activated
-      if (sub.battery_level <= 5.0f)
+      if (sub->battery_level <= 5.0f)
         btnColor = DARKGRAY; // Can't activate
       else
         btnColor = buttons[i].pressed ? GREEN : GRAY;
@@ -822,8 +773,7 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
       break;
     case 4: // Autopilot - check if nav systems are operational
     {
-      bool nav_operational = sub.navigation_computer_active && sub.gyroscope_active &&
-                             sub.depth_control_active && sub.reactor_active;
+      bool nav_operational = allSystemsOn(sub, SYS_NAV_OPERATIONAL);
       if (!nav_operational)
         btnColor = DARKGRAY; // Can't activate
       else
@@ -832,7 +782,7 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
     break;
     case 5: // Cooling - check if cooling systems are available
     {
-      bool cooling_available = sub.reactor_coolant_pumps_active || sub.emergency_cooling_active;
+      bool cooling_available = systemOn(sub, SYS_COOLANT_PUMPS) || systemOn(sub, SYS_EMERGENCY_COOLING);
       if (!cooling_available)
         btnColor = DARKGRAY; // Can't activate
       else
@@ -858,15 +808,15 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
   int y_pos = 50;
   DrawText("NAVIGATION:", SCREEN_WIDTH - 410, y_pos, 16, YELLOW); // Bigger section headers
   y_pos += 25;
-  DrawText(TextFormat("DEPTH: %.1fm", sub.depth), SCREEN_WIDTH - 410, y_pos, 14, WHITE); // Bigger text
+  DrawText(TextFormat("DEPTH: %.1fm", sub->depth), SCREEN_WIDTH - 410, y_pos, 14, WHITE); // Bigger text
   y_pos += 18;
-  DrawText(TextFormat("V.SPEED: %.2fm/s", sub.vertical_speed), SCREEN_WIDTH - 410, y_pos, 12,
-           sub.vertical_speed > 0 ? RED : (sub.vertical_speed < -0.5f ? ORANGE : GREEN));
+  DrawText(TextFormat("V.SPEED: %.2fm/s", sub->vertical_speed), SCREEN_WIDTH - 410, y_pos, 12,
+           sub->vertical_speed > 0 ? RED : (sub->vertical_speed < -0.5f ? ORANGE : GREEN));
   y_pos += 18;
-  DrawText(TextFormat("SPEED: %.1f kts", sub.speed * 1.94f), SCREEN_WIDTH - 410, y_pos, 12, WHITE);
+  DrawText(TextFormat("SPEED: %.1f kts", sub->speed * 1.94f), SCREEN_WIDTH - 410, y_pos, 12, WHITE);
   y_pos += 18;
-  DrawText(TextFormat("TRIM: %.2f°", sub.trim_angle), SCREEN_WIDTH - 410, y_pos, 12,
-           fabsf(sub.trim_angle) > 15 ? RED : (fabsf(sub.trim_angle) > 5 ? ORANGE : GREEN));
+  DrawText(TextFormat("TRIM: %.2f°", sub->trim_angle), SCREEN_WIDTH - 410, y_pos, 12,
+           fabsf(sub->trim_angle) > 15 ? RED : (fabsf(sub->trim_angle) > 5 ? ORANGE : GREEN));
 
   // REACTOR STATUS
   y_pos += 30;
@@ -874,91 +824,97 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
   y_pos += 25;
 
   // Power output progress bar
-  Color power_color = sub.reactor_power < 25 ? RED : (sub.reactor_power < 50 ? ORANGE : GREEN);
-  drawProgressBar(SCREEN_WIDTH - 410, y_pos, 140, 15, sub.reactor_power, power_color, ""); // Bigger progress bar
+  Color power_color = sub->reactor_power < 25 ? RED : (sub->reactor_power < 50 ? ORANGE : GREEN);
+  drawProgressBar(SCREEN_WIDTH - 410, y_pos, 140, 15, sub->reactor_power, power_color, ""); // Bigger progress bar
   DrawText("POWER", SCREEN_WIDTH - 410, y_pos - 18, 12, WHITE);
   y_pos += 25;
 
   // Reactor temperature with color coding
   Color reactor_color;
-  if (sub.reactor_temp > 20000)
+  if (sub->reactor_temp > 20000)
     reactor_color = MAGENTA;
-  else if (sub.reactor_temp > 10000)
+  else if (sub->reactor_temp > 10000)
     reactor_color = RED;
-  else if (sub.reactor_temp > 5000)
+  else if (sub->reactor_temp > 5000)
     reactor_color = ORANGE;
-  else if (sub.reactor_temp > 1000)
+  else if (sub->reactor_temp > 1000)
     reactor_color = YELLOW;
-  else if (sub.reactor_temp > 200)
+  else if (sub->reactor_temp > 200)
     reactor_color = GREEN;
   else
     reactor_color = GREEN;
 
-  DrawText(TextFormat("TEMP: %.0f°C", sub.reactor_temp), SCREEN_WIDTH - 410, y_pos, 14, reactor_color);
+  DrawText(TextFormat("TEMP: %.0f°C", sub->reactor_temp), SCREEN_WIDTH - 410, y_pos, 14, reactor_color);
+  y_pos += 18;
+  DrawText(TextFormat("STATUS: %s", systemOn(sub, SYS_REACTOR_DESTROYED) ? "DESTROYED" : (systemOn(sub, SYS_REACTOR) ? "ONLINE" : "OFFLINE")),
+           SCREEN_WIDTH - 410, y_pos, 12, systemOn(sub, SYS_REACTOR_DESTROYED) ? MAGENTA : (systemOn(sub, SYS_REACTOR) ? GREEN : RED));
   y_pos += 18;
-  DrawText(TextFormat("STATUS: %s", sub.reactor_destroyed ? "DESTROYED" : (sub.reactor_active ? "ONLINE" : "OFFLINE")),
-           SCREEN_WIDTH - 410, y_pos, 12, sub.reactor_destroyed ? MAGENTA : (sub.reactor_active ? GREEN : RED));
+  DrawText(TextFormat("RODS: %.0f%% OUT  FLUX: %.1f%%", sub->rod_position * 100.0f, sub->neutron_power * 100.0f),
+           SCREEN_WIDTH - 410, y_pos, 12, sub->neutron_power > ROD_POWER_LIMIT ? ORANGE : WHITE);
 
   // POWER SYSTEMS
   y_pos += 30;
   DrawText("POWER:", SCREEN_WIDTH - 410, y_pos, 16, YELLOW);
   y_pos += 25;
 
-  Color battery_color = sub.battery_level < 20 ? RED : (sub.battery_level < 40 ? ORANGE : GREEN);
-  drawProgressBar(SCREEN_WIDTH - 410, y_pos, 140, 15, sub.battery_level, battery_color, "");
+  Color battery_color = sub->battery_level < 20 ? RED : (sub->battery_level < 40 ? ORANGE : GREEN);
+  drawProgressBar(SCREEN_WIDTH - 410, y_pos, 140, 15, sub->battery_level, battery_color, "");
   DrawText("BATTERY", SCREEN_WIDTH - 410, y_pos - 18, 12, WHITE);
   y_pos += 25;
 
-  DrawText(TextFormat("LOAD: %.1fkW", sub.power_consumption), SCREEN_WIDTH - 410, y_pos, 12,
-           sub.power_consumption > 80 ? RED : (sub.power_consumption > 60 ? ORANGE : GREEN));
+  DrawText(TextFormat("LOAD: %.1f / %.1fkW", sub->power_consumption, sub->power_supply), SCREEN_WIDTH - 410, y_pos, 12,
+           sub->power_consumption >= sub->power_supply ? RED : (sub->power_consumption > sub->power_supply * 0.8f ? ORANGE : GREEN));
+  y_pos += 18;
+  DrawText(TextFormat("SHED: %d LOADS", __builtin_popcountll(sub->power_shed)), SCREEN_WIDTH - 410, y_pos, 12,
+           sub->power_shed ? RED : GRAY);
   y_pos += 18;
-  DrawText(TextFormat("BACKUP: %s", sub.backup_power_active ? "ACTIVE" : "STANDBY"),
-           SCREEN_WIDTH - 410, y_pos, 12, sub.backup_power_active ? GREEN : GRAY);
+  DrawText(TextFormat("BACKUP: %s", systemOn(sub, SYS_BACKUP_POWER) ? "ACTIVE" : "STANDBY"),
+           SCREEN_WIDTH - 410, y_pos, 12, systemOn(sub, SYS_BACKUP_POWER) ? GREEN : GRAY);
 
   // HULL STATUS
   y_pos += 30;
   DrawText("HULL:", SCREEN_WIDTH - 410, y_pos, 16, YELLOW);
   y_pos += 25;
 
-  Color hull_color = sub.hull_integrity < 25 ? RED : (sub.hull_integrity < 50 ? ORANGE : GREEN);
-  drawProgressBar(SCREEN_WIDTH - 410, y_pos, 140, 15, sub.hull_integrity, hull_color, "");
+  Color hull_color = sub->hull_integrity < 25 ? RED : (sub->hull_integrity < 50 ? ORANGE : GREEN);
+  drawProgressBar(SCREEN_WIDTH - 410, y_pos, 140, 15, sub->hull_integrity, hull_color, "");
   DrawText("INTEGRITY", SCREEN_WIDTH - 410, y_pos - 18, 12, WHITE);
   y_pos += 25;
 
-  DrawText(TextFormat("PRESSURE: %.1f bar", sub.depth * 0.1f), SCREEN_WIDTH - 410, y_pos, 12,
-           sub.depth > 1500 ? RED : (sub.depth > 1000 ? ORANGE : GREEN));
+  DrawText(TextFormat("PRESSURE: %.1f bar", environmentField(ENV_PRESSURE, sub->depth)), SCREEN_WIDTH - 410, y_pos, 12,
+           sub->depth > 1500 ? RED : (sub->depth > 1000 ? ORANGE : GREEN));
 
   // LIFE SUPPORT
   y_pos += 30;
   DrawText("LIFE SUPPORT:", SCREEN_WIDTH - 410, y_pos, 16, YELLOW);
   y_pos += 25;
 
-  Color oxygen_color = sub.oxygen < 20 ? RED : (sub.oxygen < 40 ? ORANGE : GREEN);
-  drawProgressBar(SCREEN_WIDTH - 410, y_pos, 140, 15, sub.oxygen, oxygen_color, "");
+  Color oxygen_color = sub->oxygen < 20 ? RED : (sub->oxygen < 40 ? ORANGE : GREEN);
+  drawProgressBar(SCREEN_WIDTH - 410, y_pos, 140, 15, sub->oxygen, oxygen_color, "");
   DrawText("OXYGEN", SCREEN_WIDTH - 410, y_pos - 18, 12, WHITE);
   y_pos += 25;
 
-  Color hull_temp_color = sub.hull_temperature > 40 ? RED : (sub.hull_temperature > 30 ? ORANGE : (sub.hull_temperature < 5 ? BLUE : GREEN));
-  DrawText(TextFormat("INTERNAL: %.1f°C", sub.hull_temperature), SCREEN_WIDTH - 410, y_pos, 12, hull_temp_color);
+  Color hull_temp_color = sub->hull_temperature > 40 ? RED : (sub->hull_temperature > 30 ? ORANGE : (sub->hull_temperature < 5 ? BLUE : GREEN));
+  DrawText(TextFormat("INTERNAL: %.1f°C", sub->hull_temperature), SCREEN_WIDTH - 410, y_pos, 12, hull_temp_color);
   y_pos += 18;
-  DrawText(TextFormat("EXTERNAL: %.1f°C", sub.water_temperature), SCREEN_WIDTH - 410, y_pos, 12, CYAN);
+  DrawText(TextFormat("EXTERNAL: %.1f°C", sub->water_temperature), SCREEN_WIDTH - 410, y_pos, 12, CYAN);
 
   // BALLAST SYSTEM
   y_pos += 30;
   DrawText("BALLAST:", SCREEN_WIDTH - 410, y_pos, 16, YELLOW);
   y_pos += 25;
 
-  drawProgressBar(SCREEN_WIDTH - 410, y_pos, 140, 15, sub.ballast_level, BLUE, "");
+  drawProgressBar(SCREEN_WIDTH - 410, y_pos, 140, 15, sub->ballast_level, BLUE, "");
   DrawText("TANKS", SCREEN_WIDTH - 410, y_pos - 18, 12, WHITE);
   y_pos += 25;
 
-  if (sub.manual_ballast_blow_active)
+  if (systemOn(sub, SYS_BALLAST_BLOW))
     DrawText("EMERGENCY BLOW", SCREEN_WIDTH - 410, y_pos, 12, RED);
-  else if (!sub.ballast_tanks_filled && sub.ballast_level > 0.0f)
+  else if (!systemOn(sub, SYS_BALLAST_TANKS_FILLED) && sub->ballast_level > 0.0f)
     DrawText("DRAINING", SCREEN_WIDTH - 410, y_pos, 12, ORANGE);
-  else if (sub.ballast_tanks_filled && sub.ballast_level < 100.0f)
+  else if (systemOn(sub, SYS_BALLAST_TANKS_FILLED) && sub->ballast_level < 100.0f)
     DrawText("FILLING", SCREEN_WIDTH - 410, y_pos, 12, YELLOW);
-  else if (sub.ballast_tanks_filled)
+  else if (systemOn(sub, SYS_BALLAST_TANKS_FILLED))
     DrawText("FULL (DIVING)", SCREEN_WIDTH - 410, y_pos, 12, BLUE);
   else
     DrawText("EMPTY (SURFACE)", SCREEN_WIDTH - 410, y_pos, 12, GREEN);
@@ -968,20 +924,38 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
   DrawText("NAVIGATION:", SCREEN_WIDTH - 410, y_pos, 16, YELLOW);
   y_pos += 25;
 
-  bool nav_operational = sub.navigation_computer_active && sub.gyroscope_active && sub.depth_control_active;
+  bool nav_operational = systemOn(sub, SYS_NAV_COMPUTER) && systemOn(sub, SYS_GYROSCOPE) && systemOn(sub, SYS_DEPTH_CONTROL);
   DrawText(TextFormat("STATUS: %s", nav_operational ? "OPERATIONAL" : "OFFLINE"),
            SCREEN_WIDTH - 410, y_pos, 12, nav_operational ? GREEN : RED);
   y_pos += 18;
 
-  DrawText(TextFormat("AUTOPILOT: %s", sub.autopilot_active ? "ENGAGED" : "MANUAL"),
-           SCREEN_WIDTH - 410, y_pos, 12, sub.autopilot_active ? CYAN : GRAY);
+  DrawText(TextFormat("HDG: %03.0f  CRS: %03.0f  %.1f kn", sub->heading, sub->course, sub->forward_speed * 1.9438f),
+           SCREEN_WIDTH - 410, y_pos, 12, systemOn(sub, SYS_GYROSCOPE) ? WHITE : ORANGE);
+  y_pos += 18;
+  DrawText(TextFormat("POS: %.2fN %.2fE km  SET: %03.0f %.1f kn", sub->north / 1000.0, sub->east / 1000.0,
+                      wrapHeading(atan2f(sub->current_east, sub->current_north) / DEG2RAD),
+                      hypotf(sub->current_east, sub->current_north) * 1.9438f),
+           SCREEN_WIDTH - 410, y_pos, 12, WHITE);
+  y_pos += 18;
+  if (seabedTerrain)
+  {
+    float under_keel = sub->bottom_depth - SEABED_KEEL_DEPTH - sub->depth;
+    DrawText(TextFormat("BOTTOM: %.0fm  UNDER KEEL: %.0fm", sub->bottom_depth, under_keel), SCREEN_WIDTH - 410, y_pos,
+             12, under_keel < 1.0f ? RED : (under_keel < 50.0f ? ORANGE : WHITE));
+    y_pos += 18;
+  }
+
+  DrawText(TextFormat("AUTOPILOT: %s", !systemOn(sub, SYS_AUTOPILOT)               ? "MANUAL"
+                                        : systemOn(sub, SYS_AUTOPILOT_PREDICTIVE) ? "PREDICTIVE"
+                                                                                   : "ENGAGED"),
+           SCREEN_WIDTH - 410, y_pos, 12, systemOn(sub, SYS_AUTOPILOT) ? CYAN : GRAY);
   y_pos += 18;
 
-  if (sub.autopilot_active)
+  if (systemOn(sub, SYS_AUTOPILOT))
   {
-    DrawText(TextFormat("TARGET: %.0fm", sub.target_depth), SCREEN_WIDTH - 410, y_pos, 12, CYAN);
+    DrawText(TextFormat("TARGET: %.0fm", sub->target_depth), SCREEN_WIDTH - 410, y_pos, 12, CYAN);
     y_pos += 18;
-    float depth_error = fabsf(sub.target_depth - sub.depth);
+    float depth_error = fabsf(sub->target_depth - sub->depth);
     DrawText(TextFormat("ERROR: %.1fm", depth_error), SCREEN_WIDTH - 410, y_pos, 12,
              depth_error < 5 ? GREEN : (depth_error < 20 ? ORANGE : RED));
   }
@@ -992,20 +966,20 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
   y_pos += 25;
 
   // SONAR
-  if (sub.sonar_active)
+  if (systemOn(sub, SYS_SONAR))
     DrawText("SONAR: ACTIVE", SCREEN_WIDTH - 410, y_pos, 12, GREEN);
   else
     DrawText("SONAR: OFFLINE", SCREEN_WIDTH - 410, y_pos, 12, RED);
   y_pos += 18;
 
   // COOLING
-  DrawText(TextFormat("COOLING: %s", sub.cooling_active ? "ACTIVE" : "INACTIVE"),
-           SCREEN_WIDTH - 410, y_pos, 12, sub.cooling_active ? GREEN : RED);
+  DrawText(TextFormat("COOLING: %s", systemOn(sub, SYS_COOLING) ? "ACTIVE" : "INACTIVE"),
+           SCREEN_WIDTH - 410, y_pos, 12, systemOn(sub, SYS_COOLING) ? GREEN : RED);
   y_pos += 18;
 
   // LIGHTS
-  DrawText(TextFormat("LIGHTS: %s", sub.lights_active ? "ON" : "OFF"),
-           SCREEN_WIDTH - 410, y_pos, 12, sub.lights_active ? YELLOW : GRAY);
+  DrawText(TextFormat("LIGHTS: %s", systemOn(sub, SYS_LIGHTS) ? "ON" : "OFF"),
+           SCREEN_WIDTH - 410, y_pos, 12, systemOn(sub, SYS_LIGHTS) ? YELLOW : GRAY);
 
   // CRITICAL ALERTS (if space allows)
   y_pos += 30;
@@ -1014,38 +988,198 @@ void renderSubmarine(SubmarineState sub, float deltaTime, Button buttons[])
     DrawText("ALERTS:", SCREEN_WIDTH - 410, y_pos, 14, RED);
     y_pos += 20;
 
-    if (sub.reactor_destroyed)
+    if (systemOn(sub, SYS_REACTOR_DESTROYED))
     {
       DrawText(">>> REACTOR DESTROYED <<<", SCREEN_WIDTH - 410, y_pos, 12, MAGENTA);
       y_pos += 18;
     }
-    else if (sub.reactor_temp > 20000)
+    else if (sub->reactor_temp > 20000)
     {
       DrawText(">>> REACTOR CRITICAL <<<", SCREEN_WIDTH - 410, y_pos, 12, MAGENTA);
       y_pos += 18;
     }
-    else if (sub.reactor_temp > 1000)
+    else if (sub->reactor_temp > 1000)
     {
       DrawText(">>> REACTOR OVERHEATING <<<", SCREEN_WIDTH - 410, y_pos, 12, ORANGE);
       y_pos += 18;
     }
 
-    if (sub.hull_integrity < 25)
+    if (sub->hull_integrity < 25)
     {
       DrawText(">>> HULL BREACH IMMINENT <<<", SCREEN_WIDTH - 410, y_pos, 12, RED);
       y_pos += 18;
     }
 
-    if (sub.oxygen < 20)
+    if (sub->oxygen < 20)
     {
       DrawText(">>> OXYGEN CRITICAL <<<", SCREEN_WIDTH - 410, y_pos, 12, RED);
       y_pos += 18;
     }
 
-    if (sub.battery_level < 10 && !sub.backup_power_active)
+    if (sub->battery_level < 10 && !systemOn(sub, SYS_BACKUP_POWER))
     {
       DrawText(">>> POWER CRITICAL <<<", SCREEN_WIDTH - 410, y_pos, 12, ORANGE);
       y_pos += 18;
     }
   }
-}
\ No newline at end of file
+}
+// Hours until a resource at `level` % runs out at `rate` %/s, or "--" if it isn't falling
+static const char *enduranceText(float level, float rate)
+{
+  if (rate >= -1e-6f)
+    return "--";
+  float hours = level / -rate / 3600.0f;
+  return TextFormat("%.1f h", hours);
+}
+
+void renderTimeWarpSummary(const SubmarineState *sub, const TimeWarp *warp, uint64_t tick)
+{
+  int x = SCREEN_WIDTH / 2 - 300;
+  int y = SCREEN_HEIGHT / 2 - 260;
+
+  DrawRectangle(x, y, 600, 520, Fade(DARKBLUE, 0.4f));
+  DrawRectangleLines(x, y, 600, 520, CYAN);
+
+  uint64_t seconds = (uint64_t)(tick * SIM_TICK_DT);
+  DrawText(TextFormat("TIME COMPRESSION x%d", warp->factor), x + 20, y + 20, 32, YELLOW);
+  DrawText(TextFormat("MISSION TIME %02llu:%02llu:%02llu", (unsigned long long)(seconds / 3600),
+                      (unsigned long long)(seconds / 60 % 60), (unsigned long long)(seconds % 60)),
+           x + 20, y + 60, 20, WHITE);
+  DrawText(TextFormat("Model step %.2f s  (%llu steps, %llu rejected)", MIN(warp->step, (uint32_t)warp->factor) * SIM_TICK_DT,
+                      (unsigned long long)warp->steps, (unsigned long long)warp->rejected),
+           x + 20, y + 88, 14, LIGHTGRAY);
+
+  int line = y + 130;
+  DrawText(TextFormat("DEPTH   %.0f m   (target %.0f m)", sub->depth, sub->target_depth), x + 20, line, 20, CYAN);
+  line += 30;
+  DrawText(TextFormat("SPEED   %.1f km/h   vertical %.2f m/s", sub->speed, sub->vertical_speed), x + 20, line, 20, CYAN);
+  line += 30;
+  DrawText(TextFormat("REACTOR %.0f°C   %.0f%% power   %s", sub->reactor_temp, sub->reactor_power,
+                      systemOn(sub, SYS_REACTOR) ? "ONLINE" : "OFFLINE"),
+           x + 20, line, 20, sub->reactor_temp > REACTOR_WARNING_TEMP ? RED : GREEN);
+  line += 30;
+  DrawText(TextFormat("HULL    %.1f%%   internal %.1f°C", sub->hull_integrity, sub->hull_temperature), x + 20, line, 20,
+           sub->hull_integrity < 50.0f ? RED : GREEN);
+
+  // Endurance - the point of compressing a patrol
+  line += 50;
+  Color battery_color = sub->battery_level < 20 ? RED : (sub->battery_level < 40 ? ORANGE : GREEN);
+  drawProgressBar(x + 20, line, 260, 20, sub->battery_level, battery_color, "BATTERY");
+  DrawText(TextFormat("%+.2f %%/h   empty in %s", warp->battery_rate * 3600.0f, enduranceText(sub->battery_level, warp->battery_rate)),
+           x + 300, line + 2, 16, WHITE);
+  line += 60;
+  Color oxygen_color = sub->oxygen < 20 ? RED : (sub->oxygen < 50 ? ORANGE : GREEN);
+  drawProgressBar(x + 20, line, 260, 20, sub->oxygen, oxygen_color, "OXYGEN");
+  DrawText(TextFormat("%+.2f %%/h   empty in %s", warp->oxygen_rate * 3600.0f, enduranceText(sub->oxygen, warp->oxygen_rate)),
+           x + 300, line + 2, 16, WHITE);
+
+  DrawText("Press . to speed up, , to slow down - automatic trips drop back to real time", x + 20, y + 480, 14, LIGHTGRAY);
+}
+
+// Cross-section of the ground along the heading, stern on the left, as
+// columns SEABED_VIEW_COLUMN pixels wide filled down to the screen's edge
+#define SEABED_VIEW_COLUMN 8
+
+void renderSeabedProfile(SeabedTerrain *terrain, const SubmarineState *sub, float pixels_per_meter)
+{
+  if (!terrain)
+    return;
+
+  enum { columns = SCREEN_WIDTH / SEABED_VIEW_COLUMN + 1 };
+  float depths[columns];
+  float step = SEABED_VIEW_COLUMN / pixels_per_meter;
+  double astern = (SCREEN_WIDTH / 2) / pixels_per_meter + 0.5 * step; // seabedProfile starts half a step out
+  double heading = sub->heading * DEG2RAD;
+  seabedProfile(terrain, sub->east - sin(heading) * astern, sub->north - cos(heading) * astern, sub->heading, step,
+                columns, depths);
+
+  Color ground = {70, 58, 44, 255};
+  int previous_y = 0;
+  for (int i = 0; i < columns; i++)
+  {
+    int x = i * SEABED_VIEW_COLUMN;
+    int y = SCREEN_HEIGHT / 2 + (int)((depths[i] - sub->depth) * pixels_per_meter);
+    if (y < SCREEN_HEIGHT)
+      DrawRectangle(x, MAX(0, y), SEABED_VIEW_COLUMN, SCREEN_HEIGHT - MAX(0, y), ground);
+    if (i > 0)
+      DrawLine(x - SEABED_VIEW_COLUMN, previous_y, x, y, Fade(BEIGE, 0.8f));
+    previous_y = y;
+  }
+}
+
+// Loss picture, near field on the left: bright where a contact would be
+// heard, dark in shadow zones. 2x2 pixels per cell.
+void renderSonarField(const SonarField *field, float boat_depth, int x, int y)
+{
+  int width = SONAR_GRID_RANGE_CELLS * 2;
+  int height = SONAR_GRID_DEPTH_CELLS * 2;
+
+  DrawRectangle(x, y, width + 20, height + 50, Fade(BLACK, 0.8f));
+  DrawRectangleLines(x, y, width + 20, height + 50, WHITE);
+  DrawText("SONAR PROPAGATION", x + 10, y + 8, 14, WHITE);
+
+  int gx = x + 10, gy = y + 30;
+  for (int row = 0; row < SONAR_GRID_DEPTH_CELLS; row++)
+  {
+    for (int col = 0; col < SONAR_GRID_RANGE_CELLS; col++)
+    {
+      // 40 dB (loud) .. 100 dB (nothing) onto green intensity
+      float loss = field->tl[row][col];
+      float strength = MAX(0.0f, MIN(1.0f, (100.0f - loss) / 60.0f));
+      if (strength > 0.0f)
+        DrawRectangle(gx + col * 2, gy + row * 2, 2, 2, Fade(GREEN, strength));
+    }
+  }
+
+  // Seabed the rays bounced off
+  for (int col = 0; col < SONAR_GRID_RANGE_CELLS; col++)
+  {
+    float bottom = (field->bottom[col] - field->top) / SONAR_GRID_CELL * 2.0f;
+    if (bottom < height)
+      DrawRectangle(gx + col * 2, gy + (int)MAX(0.0f, bottom), 2, height - (int)MAX(0.0f, bottom), Fade(BEIGE, 0.5f));
+  }
+
+  // Boat and thermal layer
+  int boat_y = gy + (int)((boat_depth - field->top) / SONAR_GRID_CELL * 2.0f);
+  DrawRectangle(gx - 3, boat_y - 2, 6, 4, YELLOW);
+  float layer = (THERMAL_LAYER_DEPTH - field->top) / SONAR_GRID_CELL * 2.0f;
+  if (layer >= 0 && layer < height)
+  {
+    DrawLine(gx, gy + (int)layer, gx + width, gy + (int)layer, Fade(ORANGE, 0.6f));
+  }
+
+  DrawText(TextFormat("%.0f-%.0fm  range %.0fm", field->top, field->top + SONAR_GRID_DEPTH_CELLS * SONAR_GRID_CELL,
+                      SONAR_RANGE),
+           gx, gy + height + 4, 12, LIGHTGRAY);
+}
+
+void renderSonarContacts(const SonarField *field, const SonarDetection *heard, int count, int x, int y)
+{
+  static const Color typeColors[CONTACT_TYPE_COUNT] = {
+      [CONTACT_SURFACE_SHIP] = WHITE,
+      [CONTACT_SUBMARINE] = RED,
+      [CONTACT_BIOLOGIC] = SKYBLUE,
+      [CONTACT_WRECK] = GRAY,
+  };
+
+  // Every contact lands at its range and depth - the picture has no bearing
+  int gx = x + 10, gy = y + 30;
+  for (int i = 0; i < count; i++)
+  {
+    int px = gx + (int)(heard[i].range / SONAR_GRID_CELL * 2.0f);
+    int py = gy + (int)((heard[i].depth - field->top) / SONAR_GRID_CELL * 2.0f);
+    if (py >= gy && py < gy + SONAR_GRID_DEPTH_CELLS * 2)
+      DrawCircle(px, py, 3, typeColors[heard[i].type]);
+  }
+
+  int lx = x + SONAR_GRID_RANGE_CELLS * 2 + 30;
+  DrawRectangle(lx, y, 260, 210, Fade(BLACK, 0.8f));
+  DrawRectangleLines(lx, y, 260, 210, WHITE);
+  DrawText(TextFormat("CONTACTS: %d", count), lx + 10, y + 8, 14, WHITE);
+  for (int i = 0; i < count && i < 10; i++)
+  {
+    DrawText(TextFormat("%03.0f° %5.0fm %-9s %3.0fHz +%.0fdB", heard[i].bearing, heard[i].range,
+                        contactTypeName(heard[i].type), heard[i].signature, heard[i].signal_excess),
+             lx + 10, y + 30 + i * 17, 12, typeColors[heard[i].type]);
+  }
+}
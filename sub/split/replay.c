@@ -0,0 +1,129 @@
+// Headless journal replay - plays a session.journal back through the model
+// with no window, as fast as it will go, and checks the final state hash.
+//
+//   ./sub_replay [-n repeat] [-v] [-P file.params] [-C basin.cur|none] [-B seabed_seed] session.journal [more.journal...]
+//
+// Exit status is 0 when every journal with an end line reproduces its final
+// state exactly, 3 on any mismatch. -n replays each journal several times
+// (the standard profiling workload), -v prints the final state fields, -P
+// loads the parameter file the session was played with (params.h), -C the
+// ocean-current field (currents.h) - sub.currents if there is one, as the
+// game does, none for still water - and -B the seabed seed (seabed.h) - the
+// game's own unless told otherwise, 0 for open ocean. A journal that records
+// different parameters or a different current field is refused up front.
+
+#define _GNU_SOURCE
+#include "currents.h"
+#include "journal.h"
+#include "params.h"
+#include "seabed.h"
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static void printState(const SubmarineState *sub)
+{
+  printf("  depth %.6g  reactor_temp %.6g  reactor_power %.6g  hull %.6g  oxygen %.6g  battery %.6g\n",
+         sub->depth, sub->reactor_temp, sub->reactor_power, sub->hull_integrity, sub->oxygen, sub->battery_level);
+  printf("  north %.6g  east %.6g  heading %.6g  bottom %.6g\n", sub->north, sub->east, sub->heading, sub->bottom_depth);
+  printf("  systems %#llx  rng %#x  pings %u\n",
+         (unsigned long long)sub->systems, sub->rng_state, sub->sonar_ping_count);
+}
+
+int main(int argc, char **argv)
+{
+  int repeat = 1;
+  bool verbose = false;
+  int first_path = 0;
+  static CurrentField currents;
+  unsigned int seabed_seed = SEABED_SEED;
+  const char *currents_path = access(GAME_CURRENTS_PATH, R_OK) == 0 ? GAME_CURRENTS_PATH : NULL;
+
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++)
+  {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+      repeat = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-v") == 0)
+      verbose = true;
+    else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc)
+    {
+      if (!simParametersLoad(argv[++i], &simParameters))
+        return 1;
+    }
+    else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc)
+    {
+      currents_path = argv[++i];
+      if (strcmp(currents_path, "none") == 0)
+        currents_path = NULL;
+    }
+    else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc)
+      seabed_seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else
+      break;
+  }
+  first_path = i < argc && argv[i][0] != '-' ? i : 0;
+  if (first_path == 0)
+  {
+    fprintf(stderr, "usage: %s [-n repeat] [-v] [-P file.params] [-C basin.cur|none] [-B seabed_seed] session.journal [more.journal...]\n", argv[0]);
+    return 1;
+  }
+  repeat = MAX(1, repeat);
+  if (currents_path)
+  {
+    if (!currentFieldMap(&currents, currents_path))
+    {
+      fprintf(stderr, "%s: not an ocean-current field\n", currents_path);
+      return 1;
+    }
+    oceanCurrents = &currents;
+  }
+  if (seabed_seed)
+    seabedTerrain = seabedCreate(seabed_seed, 0);
+
+  int mismatches = 0;
+  for (int p = first_path; p < argc; p++)
+  {
+    Journal journal;
+    if (!journalLoad(argv[p], &journal))
+      return 1;
+
+    struct timespec start, end;
+    SubmarineState final_state;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < repeat; r++)
+    {
+      if (!replayJournal(&journal, &final_state))
+      {
+        journalFree(&journal);
+        return 1;
+      }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+    uint64_t played = journal.end_tick - (journal.has_start ? journal.start_tick : 0);
+    double ticks = (double)played * repeat;
+    uint64_t hash = submarineStateHash(&final_state);
+
+    const char *verdict = "unverified (no end line)";
+    if (journal.has_end)
+    {
+      verdict = hash == journal.final_hash ? "match" : "MISMATCH";
+      mismatches += hash != journal.final_hash;
+    }
+
+    printf("%s: %d commands, %llu ticks (%.1f sim s) x%d in %.3fs, %.2f Mticks/s, %.0f ns/tick, hash %016llx %s\n",
+           argv[p], journal.count, (unsigned long long)played, played * SIM_TICK_DT, repeat,
+           seconds, seconds > 0 ? ticks / seconds / 1e6 : 0.0, ticks > 0 ? seconds * 1e9 / ticks : 0.0,
+           (unsigned long long)hash, verdict);
+    if (verbose)
+      printState(&final_state);
+
+    journalFree(&journal);
+  }
+
+  seabedDestroy(seabedTerrain);
+  currentFieldClose(&currents);
+  return mismatches ? 3 : 0;
+}
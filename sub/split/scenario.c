@@ -0,0 +1,313 @@
+#define _GNU_SOURCE
+#include "scenario.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+static const char *const fieldNames[SCENARIO_FIELD_COUNT] = {
+#define SCENARIO_FIELD_NAME(name) #name,
+    SCENARIO_FIELDS(SCENARIO_FIELD_NAME)
+#undef SCENARIO_FIELD_NAME
+};
+
+const char *scenarioFieldName(ScenarioField field)
+{
+  return field < SCENARIO_FIELD_COUNT ? fieldNames[field] : "?";
+}
+
+static int fieldFromName(const char *name)
+{
+  for (int i = 0; i < SCENARIO_FIELD_COUNT; i++)
+    if (strcmp(fieldNames[i], name) == 0)
+      return i;
+  return -1;
+}
+
+static float *fieldOf(SubmarineState *sub, ScenarioField field)
+{
+  switch (field)
+  {
+#define SCENARIO_FIELD_CASE(name) \
+  case SCENARIO_FIELD_##name:     \
+    return &sub->name;
+    SCENARIO_FIELDS(SCENARIO_FIELD_CASE)
+#undef SCENARIO_FIELD_CASE
+  default:
+    return NULL;
+  }
+}
+
+static bool parseNumber(const char *text, float *out)
+{
+  char *end = NULL;
+  errno = 0;
+  *out = strtof(text, &end);
+  return end != text && *end == '\0' && errno == 0 && isfinite(*out);
+}
+
+bool scenarioCompile(const char *text, const char *source, ScenarioProgram *out)
+{
+  // Setup and events are collected apart and laid out setup first
+  static __thread ScenarioOp events[SCENARIO_MAX_OPS];
+  int event_count = 0;
+
+  memset(out, 0, sizeof(*out));
+  snprintf(out->name, sizeof(out->name), "%s", source);
+
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+    hash = (hash ^ *c) * 0x100000001b3ULL;
+  out->source_hash = hash;
+
+  const char *line = text;
+  int line_number = 0;
+  while (*line)
+  {
+    const char *end = strchr(line, '\n');
+    size_t len = end ? (size_t)(end - line) : strlen(line);
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%.*s", (int)MIN(len, sizeof(buf) - 1), line);
+    line = end ? end + 1 : line + len;
+    line_number++;
+
+    buf[strcspn(buf, "\r#")] = '\0';
+
+    char word[64], target[64], value_text[64];
+    int fields = sscanf(buf, " %63s %63s %63s", word, target, value_text);
+    if (fields <= 0)
+      continue; // Blank line
+
+    ScenarioOp op = {0};
+    bool setup = true;
+    bool ok = false;
+    float time;
+    if (strcmp(word, "name") == 0 && fields == 2)
+    {
+      snprintf(out->name, sizeof(out->name), "%.*s", (int)sizeof(out->name) - 1, target);
+      continue;
+    }
+    else if (strcmp(word, "set") == 0 && fields == 3)
+    {
+      int field = fieldFromName(target);
+      op = (ScenarioOp){0, SCENARIO_OP_SET, (uint16_t)field, 0.0f};
+      ok = field >= 0 && parseNumber(value_text, &op.value);
+    }
+    else if ((strcmp(word, "on") == 0 || strcmp(word, "off") == 0) && fields == 2)
+    {
+      SubmarineSystem system = submarineSystemFromName(target);
+      op = (ScenarioOp){0, SCENARIO_OP_SYSTEM, (uint16_t)system, word[1] == 'n' ? 1.0f : 0.0f};
+      ok = system != SYS_COUNT;
+    }
+    else if (fields >= 2 && parseNumber(word, &time) && time >= 0.0f && time * SIM_TICK_RATE < 4e9f)
+    {
+      setup = false;
+      op.tick = (uint32_t)lroundf(time * SIM_TICK_RATE);
+      op.kind = SCENARIO_OP_COMMAND;
+      if (strcmp(target, "fail") == 0)
+      {
+        SubmarineSystem system = fields == 3 ? submarineSystemFromName(value_text) : SYS_COUNT;
+        op.target = CMD_SYSTEM_FAILURE;
+        op.value = (float)system;
+        ok = system != SYS_COUNT;
+      }
+      else
+      {
+        SubmarineCommandType type = submarineCommandFromName(target);
+        op.target = (uint16_t)type;
+        ok = type != CMD_NONE && (fields == 2 || parseNumber(value_text, &op.value));
+      }
+    }
+
+    if (!ok)
+    {
+      fprintf(stderr, "%s:%d: bad scenario line: %s\n", source, line_number, buf);
+      return false;
+    }
+    if (out->op_count + event_count >= SCENARIO_MAX_OPS)
+    {
+      fprintf(stderr, "%s: more than %d scenario lines\n", source, SCENARIO_MAX_OPS);
+      return false;
+    }
+
+    if (setup)
+    {
+      out->ops[out->op_count++] = op;
+      continue;
+    }
+
+    // Insertion keeps events at the same tick in file order
+    int at = event_count++;
+    while (at > 0 && events[at - 1].tick > op.tick)
+    {
+      events[at] = events[at - 1];
+      at--;
+    }
+    events[at] = op;
+  }
+
+  out->setup_count = out->op_count;
+  memcpy(out->ops + out->op_count, events, event_count * sizeof(ScenarioOp));
+  out->op_count += event_count;
+  return true;
+}
+
+bool scenarioLoadFile(const char *path, ScenarioProgram *out)
+{
+  FILE *f = fopen(path, "rb");
+  if (!f)
+  {
+    perror(path);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  char *text = malloc(size + 1);
+  size_t got = fread(text, 1, size, f);
+  text[got] = '\0';
+  fclose(f);
+
+  bool ok = scenarioCompile(text, path, out);
+  free(text);
+  return ok;
+}
+
+static void applySetup(const ScenarioOp *op, SubmarineState *sub)
+{
+  if (op->kind == SCENARIO_OP_SET)
+    *fieldOf(sub, op->target) = op->value;
+  else if (op->kind == SCENARIO_OP_SYSTEM)
+    setSystem(sub, op->target, op->value != 0.0f);
+}
+
+SubmarineState scenarioInitialState(const ScenarioProgram *program)
+{
+  SubmarineState sub = initSubmarine();
+  for (int i = 0; i < program->setup_count; i++)
+    applySetup(&program->ops[i], &sub);
+  return sub;
+}
+
+void scenarioRunnerStart(ScenarioRunner *runner, const ScenarioProgram *program, uint64_t tick)
+{
+  runner->program = *program;
+  runner->start_tick = tick;
+  runner->next = program->setup_count;
+}
+
+void scenarioRunnerSeek(ScenarioRunner *runner, uint64_t tick)
+{
+  const ScenarioProgram *program = &runner->program;
+  uint64_t elapsed = tick > runner->start_tick ? tick - runner->start_tick : 0;
+  int next = program->setup_count;
+  while (next < program->op_count && program->ops[next].tick < elapsed)
+    next++;
+  runner->next = next;
+}
+
+int scenarioRunnerDue(ScenarioRunner *runner, uint64_t tick, SubmarineCommand *out, int max)
+{
+  const ScenarioProgram *program = &runner->program;
+  int count = 0;
+  while (count < max && runner->next < program->op_count &&
+         runner->start_tick + program->ops[runner->next].tick <= tick)
+  {
+    const ScenarioOp *op = &program->ops[runner->next++];
+    out[count++] = (SubmarineCommand){(SubmarineCommandType)op->target, op->value};
+  }
+  return count;
+}
+
+uint32_t scenarioRunnerTicksUntilNext(const ScenarioRunner *runner, uint64_t tick)
+{
+  const ScenarioProgram *program = &runner->program;
+  if (runner->next >= program->op_count)
+    return UINT32_MAX;
+  uint64_t due = runner->start_tick + program->ops[runner->next].tick;
+  return due > tick ? (uint32_t)MIN(due - tick, (uint64_t)UINT32_MAX) : 0;
+}
+
+int scenarioRunnerReload(ScenarioRunner *runner, const ScenarioProgram *updated, uint64_t tick, SubmarineState *sub)
+{
+  const ScenarioProgram *old = &runner->program;
+  int patched = 0;
+  for (int i = 0; i < updated->setup_count; i++)
+  {
+    const ScenarioOp *op = &updated->ops[i];
+
+    // Patch a value only if this is a new line or its value moved; the
+    // last matching line wins, as it did at startup
+    bool same = false;
+    for (int j = old->setup_count - 1; j >= 0; j--)
+    {
+      if (old->ops[j].kind == op->kind && old->ops[j].target == op->target)
+      {
+        same = old->ops[j].value == op->value;
+        break;
+      }
+    }
+    if (!same)
+    {
+      applySetup(op, sub);
+      patched++;
+    }
+  }
+
+  runner->program = *updated;
+  scenarioRunnerSeek(runner, tick);
+  return patched;
+}
+
+bool scenarioWatcherOpen(ScenarioWatcher *watcher, const char *path)
+{
+  // dirname and basename may modify their argument
+  char directory[256], file[256];
+  snprintf(directory, sizeof(directory), "%s", path);
+  snprintf(file, sizeof(file), "%s", path);
+  snprintf(watcher->file, sizeof(watcher->file), "%s", basename(file));
+
+  watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (watcher->fd < 0)
+    return false;
+  watcher->wd = inotify_add_watch(watcher->fd, dirname(directory), IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (watcher->wd < 0)
+  {
+    close(watcher->fd);
+    watcher->fd = -1;
+    return false;
+  }
+  return true;
+}
+
+bool scenarioWatcherChanged(ScenarioWatcher *watcher)
+{
+  if (watcher->fd < 0)
+    return false;
+
+  bool changed = false;
+  char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t got;
+  while ((got = read(watcher->fd, buffer, sizeof(buffer))) > 0)
+  {
+    for (char *p = buffer; p < buffer + got;)
+    {
+      const struct inotify_event *event = (const struct inotify_event *)p;
+      if (event->len > 0 && strcmp(event->name, watcher->file) == 0)
+        changed = true;
+      p += sizeof(struct inotify_event) + event->len;
+    }
+  }
+  return changed;
+}
+
+void scenarioWatcherClose(ScenarioWatcher *watcher)
+{
+  if (watcher->fd >= 0)
+    close(watcher->fd);
+  watcher->fd = -1;
+}
@@ -0,0 +1,130 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "constants.h"
+
+// Training scenarios as text files instead of edits to initSubmarine():
+//
+//   # reactor_drill.scn
+//   name reactor_drill
+//   set depth 120                 (starting value of any SCENARIO_FIELDS field)
+//   set reactor_temp 240
+//   on coolant_pumps              (starting switch positions, submarineSystemName)
+//   off control_rods_inserted
+//   30 fail coolant_pumps         (sim seconds from the start: the system trips out)
+//   45 emergency_cooling          (or any command, same lines as sub_batch scenarios)
+//   90 set_target_depth 200
+//
+// A file is compiled once into a ScenarioProgram - a flat array of fixed-size
+// ops, setup first and events in tick order - and the sim thread runs that.
+// While it runs, a ScenarioWatcher (inotify on the file's directory) reports
+// saves; only that file is re-parsed, starting values that changed are
+// written into the live state and the events are swapped in place, without
+// restarting the session.
+
+#define SCENARIO_MAX_OPS 256
+#define SCENARIO_SNAPSHOT_PATH "scenario.snap" // Journals of scenario sessions start here
+
+// Settable starting values - the physical state, not controller memory or timers
+#define SCENARIO_FIELDS(X) \
+  X(depth)                 \
+  X(speed)                 \
+  X(oxygen)                \
+  X(reactor_temp)          \
+  X(hull_integrity)        \
+  X(battery_level)         \
+  X(nitrogen_level)        \
+  X(ballast_level)         \
+  X(thrust)                \
+  X(trim_angle)            \
+  X(reactor_power)         \
+  X(target_depth)          \
+  X(hull_temperature)      \
+  X(water_temperature)     \
+  X(coolant_temp)          \
+  X(steam_generator_temp)  \
+  X(heading)               \
+  X(course)
+
+typedef enum
+{
+#define SCENARIO_FIELD_ENUM(name) SCENARIO_FIELD_##name,
+  SCENARIO_FIELDS(SCENARIO_FIELD_ENUM)
+#undef SCENARIO_FIELD_ENUM
+  SCENARIO_FIELD_COUNT
+} ScenarioField;
+
+typedef enum
+{
+  SCENARIO_OP_SET,     // Setup: target = ScenarioField
+  SCENARIO_OP_SYSTEM,  // Setup: target = SubmarineSystem, value 0 or 1
+  SCENARIO_OP_COMMAND, // Event: target = SubmarineCommandType
+} ScenarioOpKind;
+
+typedef struct
+{
+  uint32_t tick;   // Ticks after the scenario started, 0 for setup
+  uint16_t kind;   // ScenarioOpKind
+  uint16_t target;
+  float value;
+} ScenarioOp;
+
+typedef struct
+{
+  char name[32];
+  uint64_t source_hash; // FNV-1a of the text, an unchanged save is not a reload
+  int setup_count;      // ops[0, setup_count) are setup, the rest events
+  int op_count;
+  ScenarioOp ops[SCENARIO_MAX_OPS];
+} ScenarioProgram;
+
+// False (with a message naming source and line) on anything it doesn't understand
+bool scenarioCompile(const char *text, const char *source, ScenarioProgram *out);
+bool scenarioLoadFile(const char *path, ScenarioProgram *out);
+
+// initSubmarine() with the setup applied
+SubmarineState scenarioInitialState(const ScenarioProgram *program);
+
+const char *scenarioFieldName(ScenarioField field);
+
+// Events due as the session runs
+typedef struct
+{
+  ScenarioProgram program;
+  uint64_t start_tick; // Session tick the scenario's clock started at
+  int next;            // Next event op to fire
+} ScenarioRunner;
+
+void scenarioRunnerStart(ScenarioRunner *runner, const ScenarioProgram *program, uint64_t tick);
+
+// Skip to the first event not yet due at tick - after a quick-load or a reload
+void scenarioRunnerSeek(ScenarioRunner *runner, uint64_t tick);
+
+// Commands due at tick, at most max of them; the rest stay due
+int scenarioRunnerDue(ScenarioRunner *runner, uint64_t tick, SubmarineCommand *out, int max);
+
+// Ticks from tick until the next event, UINT32_MAX if none - time compression stops short of it
+uint32_t scenarioRunnerTicksUntilNext(const ScenarioRunner *runner, uint64_t tick);
+
+// Swap in a recompiled program at tick. Setup lines that are new or changed
+// are written into sub (removed ones leave the live value alone); events
+// already behind the scenario clock are not fired. Returns how many values
+// in sub were patched.
+int scenarioRunnerReload(ScenarioRunner *runner, const ScenarioProgram *updated, uint64_t tick, SubmarineState *sub);
+
+// inotify on the scenario's directory, so saves by rename (most editors) are seen too
+typedef struct
+{
+  int fd; // -1 when not watching
+  int wd;
+  char file[256]; // Name within the directory
+} ScenarioWatcher;
+
+bool scenarioWatcherOpen(ScenarioWatcher *watcher, const char *path);
+
+// Drains pending events without blocking; true if the file was written or replaced since the last call
+bool scenarioWatcherChanged(ScenarioWatcher *watcher);
+
+void scenarioWatcherClose(ScenarioWatcher *watcher);
+
+#endif
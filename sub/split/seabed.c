@@ -0,0 +1,454 @@
+#define _GNU_SOURCE
+#include "seabed.h"
+#include <pthread.h>
+#include <string.h>
+
+SeabedTerrain *seabedTerrain;
+
+#define SEABED_OCTAVES 6
+#define SEABED_BASE_SHIFT 9 // Coarsest octave's lattice is 2^9 points (12.8 km) across
+#define TILE_SHIFT 6 // log2(SEABED_TILE_CELLS)
+#define TILE_POINTS (SEABED_TILE_CELLS + 1)
+#define STREAM_QUEUE ((2 * SEABED_STREAM_RADIUS + 1) * (2 * SEABED_STREAM_RADIUS + 1))
+#define PROFILE_MISSES 8 // Tiles a profile fills in on the caller before it gives up on the rest
+#define COUNTER_STRIPES 16 // Hit/miss counters, one cache line each, shared out round-robin to querying threads
+
+_Static_assert(1 << TILE_SHIFT == SEABED_TILE_CELLS, "TILE_SHIFT is out of date");
+
+typedef enum
+{
+  TILE_EMPTY,
+  TILE_LOADING, // Reserved by a generator, heights not written yet
+  TILE_READY,
+} TileState;
+
+typedef struct
+{
+  int32_t tx, ty; // Tile (0, 0) has its south-west corner on the start point
+} TileKey;
+
+// Queries read resident tiles without the lock. version is even while the
+// slot is stable and odd while a generator owns it, bumped by the lock holder
+// before the key changes and again once the heights are written; a reader
+// checks it is the same even number before and after its four heights, and
+// falls back to the lattice (same bits) if not.
+typedef struct
+{
+  TileKey key;
+  TileState state;
+  uint64_t version;   // 0 = never used
+  uint64_t last_used; // Cache clock when a query last read it - racy stores, it's only a hint
+  float *heights;     // TILE_POINTS x TILE_POINTS, row 0 the southern edge
+} SeabedTile;
+
+typedef struct
+{
+  uint64_t hits, misses;
+} __attribute__((aligned(64))) QueryCounters;
+
+struct SeabedTerrain
+{
+  uint32_t seed;
+  SeabedTile tiles[SEABED_CACHE_TILES];
+  float *heights; // Every tile's points in one block, allocated once
+
+  QueryCounters counters[COUNTER_STRIPES];
+
+  pthread_mutex_t lock; // Everything below, and changes to the tiles' keys and states
+  pthread_cond_t requested;
+  TileKey requests[STREAM_QUEUE]; // Nearest first
+  int request_count;
+  uint64_t clock; // Ticks per load and per seabedStream, so a tile's last_used is an epoch, not a query
+  SeabedStats stats;
+
+  pthread_t *threads;
+  int thread_count;
+  bool shutdown;
+};
+
+// Per-thread guess at the tile the last query used - boats query where they
+// were a tick ago, so this nearly always saves the scan
+static __thread int tileHint;
+
+// This thread's counter stripe, -1 until its first query
+static __thread int counterStripe = -1;
+static int nextCounterStripe;
+
+static QueryCounters *queryCounters(SeabedTerrain *terrain)
+{
+  if (counterStripe < 0)
+    counterStripe = __atomic_fetch_add(&nextCounterStripe, 1, __ATOMIC_RELAXED) % COUNTER_STRIPES;
+  return &terrain->counters[counterStripe];
+}
+
+static inline uint32_t latticeHash(int64_t x, int64_t y, uint32_t salt)
+{
+  uint64_t h = (uint64_t)x * 0x9E3779B97F4A7C15ull ^ (uint64_t)y * 0xC2B2AE3D27D4EB4Full ^ salt;
+  h ^= h >> 31;
+  h *= 0xBF58476D1CE4E5B9ull;
+  h ^= h >> 29;
+  h *= 0x94D049BB133111EBull;
+  return (uint32_t)(h >> 32);
+}
+
+// Seabed depth at lattice point (gx, gy) - SEABED_OCTAVES of value noise,
+// each half the size and weight of the one before. Integer coordinates in,
+// so every caller asking about the same point gets the same bits back.
+static float latticeDepth(uint32_t seed, int64_t gx, int64_t gy)
+{
+  float sum = 0.0f, amplitude = 1.0f, total = 0.0f;
+  for (int octave = 0; octave < SEABED_OCTAVES; octave++)
+  {
+    int shift = SEABED_BASE_SHIFT - octave;
+    int64_t cx = gx >> shift, cy = gy >> shift; // Floor division - GCC shifts negatives arithmetically
+    float scale = 1.0f / (float)(1 << shift);
+    float fx = (float)(gx - cx * ((int64_t)1 << shift)) * scale;
+    float fy = (float)(gy - cy * ((int64_t)1 << shift)) * scale;
+    fx = fx * fx * (3.0f - 2.0f * fx);
+    fy = fy * fy * (3.0f - 2.0f * fy);
+
+    uint32_t salt = seed * 0x85EBCA6Bu + octave * 0x27D4EB2Fu;
+    float v00 = latticeHash(cx, cy, salt) * (2.0f / 4294967296.0f) - 1.0f;
+    float v10 = latticeHash(cx + 1, cy, salt) * (2.0f / 4294967296.0f) - 1.0f;
+    float v01 = latticeHash(cx, cy + 1, salt) * (2.0f / 4294967296.0f) - 1.0f;
+    float v11 = latticeHash(cx + 1, cy + 1, salt) * (2.0f / 4294967296.0f) - 1.0f;
+    float south = v00 + (v10 - v00) * fx;
+    float north = v01 + (v11 - v01) * fx;
+
+    sum += amplitude * (south + (north - south) * fy);
+    total += amplitude;
+    amplitude *= 0.5f;
+  }
+
+  // High noise is high ground
+  float depth = SEABED_MEAN_DEPTH - SEABED_RELIEF * sum / total;
+  return MAX(SEABED_SHOAL_DEPTH, MIN(MAX_DEPTH, depth));
+}
+
+// The one interpolation both query paths use, so they agree exactly
+static inline float bilinear(float south_west, float south_east, float north_west, float north_east, float fx, float fy)
+{
+  float south = south_west + (south_east - south_west) * fx;
+  float north = north_west + (north_east - north_west) * fx;
+  return south + (north - south) * fy;
+}
+
+static void generateTile(uint32_t seed, TileKey key, float *heights)
+{
+  int64_t gx = (int64_t)key.tx * SEABED_TILE_CELLS, gy = (int64_t)key.ty * SEABED_TILE_CELLS;
+  for (int j = 0; j < TILE_POINTS; j++)
+    for (int i = 0; i < TILE_POINTS; i++)
+      heights[j * TILE_POINTS + i] = latticeDepth(seed, gx + i, gy + j);
+}
+
+// Slot holding key in any state, or -1. Lock held.
+static int findTile(SeabedTerrain *terrain, TileKey key)
+{
+  int hint = tileHint;
+  if (hint < SEABED_CACHE_TILES && terrain->tiles[hint].state != TILE_EMPTY && terrain->tiles[hint].key.tx == key.tx &&
+      terrain->tiles[hint].key.ty == key.ty)
+    return hint;
+
+  for (int s = 0; s < SEABED_CACHE_TILES; s++)
+  {
+    const SeabedTile *tile = &terrain->tiles[s];
+    if (tile->state != TILE_EMPTY && tile->key.tx == key.tx && tile->key.ty == key.ty)
+    {
+      tileHint = s;
+      return s;
+    }
+  }
+  return -1;
+}
+
+// Claim a slot for key - an empty one, else the least recently used ready
+// one - and mark it loading. -1 if key is already there or on its way. Lock held.
+static int reserveTile(SeabedTerrain *terrain, TileKey key)
+{
+  if (findTile(terrain, key) >= 0)
+    return -1;
+
+  int victim = -1;
+  for (int s = 0; s < SEABED_CACHE_TILES; s++)
+  {
+    const SeabedTile *tile = &terrain->tiles[s];
+    if (tile->state == TILE_EMPTY)
+    {
+      victim = s;
+      break;
+    }
+    if (tile->state == TILE_READY &&
+        (victim < 0 || __atomic_load_n(&tile->last_used, __ATOMIC_RELAXED) <
+                           __atomic_load_n(&terrain->tiles[victim].last_used, __ATOMIC_RELAXED)))
+      victim = s;
+  }
+  if (victim < 0)
+    return -1; // Every slot is being generated - can't happen with the cache bigger than the streamers
+
+  // Odd before the key changes, so a reader halfway through the old tile retries
+  SeabedTile *tile = &terrain->tiles[victim];
+  if (tile->state == TILE_READY)
+    terrain->stats.evicted++;
+  __atomic_store_n(&tile->version, tile->version + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&tile->key.tx, key.tx, __ATOMIC_RELAXED);
+  __atomic_store_n(&tile->key.ty, key.ty, __ATOMIC_RELAXED);
+  tile->state = TILE_LOADING;
+  return victim;
+}
+
+// Generate key's heights on this thread and publish them. Lock not held;
+// the loading slot is this thread's alone until it's marked ready.
+static void loadTile(SeabedTerrain *terrain, TileKey key)
+{
+  pthread_mutex_lock(&terrain->lock);
+  int slot = reserveTile(terrain, key);
+  pthread_mutex_unlock(&terrain->lock);
+  if (slot < 0)
+    return;
+
+  SeabedTile *tile = &terrain->tiles[slot];
+  generateTile(terrain->seed, key, tile->heights);
+
+  pthread_mutex_lock(&terrain->lock);
+  tile->state = TILE_READY;
+  __atomic_store_n(&tile->last_used, __atomic_add_fetch(&terrain->clock, 1, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+  terrain->stats.generated++;
+  __atomic_store_n(&tile->version, tile->version + 1, __ATOMIC_RELEASE); // Even again: heights published
+  pthread_mutex_unlock(&terrain->lock);
+}
+
+static void *streamMain(void *arg)
+{
+  SeabedTerrain *terrain = arg;
+
+  pthread_mutex_lock(&terrain->lock);
+  for (;;)
+  {
+    while (!terrain->shutdown && terrain->request_count == 0)
+      pthread_cond_wait(&terrain->requested, &terrain->lock);
+    if (terrain->shutdown)
+      break;
+
+    TileKey key = terrain->requests[0];
+    terrain->request_count--;
+    memmove(terrain->requests, terrain->requests + 1, terrain->request_count * sizeof(TileKey));
+
+    pthread_mutex_unlock(&terrain->lock);
+    loadTile(terrain, key);
+    pthread_mutex_lock(&terrain->lock);
+  }
+  pthread_mutex_unlock(&terrain->lock);
+  return NULL;
+}
+
+SeabedTerrain *seabedCreate(unsigned int seed, int stream_threads)
+{
+  SeabedTerrain *terrain = calloc(1, sizeof(SeabedTerrain));
+  if (!terrain)
+    return NULL;
+  terrain->heights = malloc((size_t)SEABED_CACHE_TILES * TILE_POINTS * TILE_POINTS * sizeof(float));
+  if (!terrain->heights)
+  {
+    free(terrain);
+    return NULL;
+  }
+
+  terrain->seed = seed;
+  for (int s = 0; s < SEABED_CACHE_TILES; s++)
+    terrain->tiles[s].heights = terrain->heights + (size_t)s * TILE_POINTS * TILE_POINTS;
+  pthread_mutex_init(&terrain->lock, NULL);
+  pthread_cond_init(&terrain->requested, NULL);
+
+  if (stream_threads > 0)
+  {
+    terrain->threads = calloc(stream_threads, sizeof(pthread_t));
+    for (int t = 0; terrain->threads && t < stream_threads; t++)
+    {
+      if (pthread_create(&terrain->threads[t], NULL, streamMain, terrain) != 0)
+        break;
+      terrain->thread_count++;
+    }
+  }
+  return terrain;
+}
+
+void seabedDestroy(SeabedTerrain *terrain)
+{
+  if (!terrain)
+    return;
+
+  pthread_mutex_lock(&terrain->lock);
+  terrain->shutdown = true;
+  pthread_cond_broadcast(&terrain->requested);
+  pthread_mutex_unlock(&terrain->lock);
+  for (int t = 0; t < terrain->thread_count; t++)
+    pthread_join(terrain->threads[t], NULL);
+
+  pthread_cond_destroy(&terrain->requested);
+  pthread_mutex_destroy(&terrain->lock);
+  free(terrain->threads);
+  free(terrain->heights);
+  free(terrain);
+}
+
+static inline TileKey tileAt(int64_t gx, int64_t gy)
+{
+  return (TileKey){(int32_t)(gx >> TILE_SHIFT), (int32_t)(gy >> TILE_SHIFT)};
+}
+
+// Point (gx + fx, gy + fy) from its tile, without the lock - false if the
+// tile isn't resident and ready, or was replaced while we read it
+static bool depthResident(SeabedTerrain *terrain, TileKey key, int64_t gx, int64_t gy, float fx, float fy,
+                          float *depth)
+{
+  int slot = tileHint;
+  for (int s = -1; s < SEABED_CACHE_TILES; s++)
+  {
+    if (s >= 0)
+      slot = s;
+    SeabedTile *tile = &terrain->tiles[slot];
+    uint64_t version = __atomic_load_n(&tile->version, __ATOMIC_ACQUIRE);
+    if (version == 0 || (version & 1) || __atomic_load_n(&tile->key.tx, __ATOMIC_RELAXED) != key.tx ||
+        __atomic_load_n(&tile->key.ty, __ATOMIC_RELAXED) != key.ty)
+      continue;
+
+    const float *h = tile->heights + (gy - (int64_t)key.ty * SEABED_TILE_CELLS) * TILE_POINTS +
+                     (gx - (int64_t)key.tx * SEABED_TILE_CELLS);
+    float south_west = h[0], south_east = h[1], north_west = h[TILE_POINTS], north_east = h[TILE_POINTS + 1];
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&tile->version, __ATOMIC_RELAXED) != version)
+      return false;
+
+    uint64_t clock = __atomic_load_n(&terrain->clock, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&tile->last_used, __ATOMIC_RELAXED) != clock)
+      __atomic_store_n(&tile->last_used, clock, __ATOMIC_RELAXED);
+    tileHint = slot;
+    *depth = bilinear(south_west, south_east, north_west, north_east, fx, fy);
+    return true;
+  }
+  return false;
+}
+
+// One point, from its tile if resident, else straight off the lattice with
+// the tile noted in *missed. Never takes the lock.
+static float depthAt(SeabedTerrain *terrain, QueryCounters *counters, double east, double north, TileKey *missed,
+                     bool *miss)
+{
+  double x = floor(east / SEABED_SPACING), y = floor(north / SEABED_SPACING);
+  int64_t gx = (int64_t)x, gy = (int64_t)y;
+  float fx = (float)(east / SEABED_SPACING - x), fy = (float)(north / SEABED_SPACING - y);
+
+  TileKey key = tileAt(gx, gy);
+  float depth;
+  if (depthResident(terrain, key, gx, gy, fx, fy, &depth))
+  {
+    __atomic_fetch_add(&counters->hits, 1, __ATOMIC_RELAXED);
+    return depth;
+  }
+
+  __atomic_fetch_add(&counters->misses, 1, __ATOMIC_RELAXED);
+  *missed = key;
+  *miss = true;
+  uint32_t seed = terrain->seed;
+  return bilinear(latticeDepth(seed, gx, gy), latticeDepth(seed, gx + 1, gy), latticeDepth(seed, gx, gy + 1),
+                  latticeDepth(seed, gx + 1, gy + 1), fx, fy);
+}
+
+float seabedDepth(SeabedTerrain *terrain, double east, double north)
+{
+  if (!terrain)
+    return MAX_DEPTH;
+
+  TileKey missed;
+  bool miss = false;
+  float depth = depthAt(terrain, queryCounters(terrain), east, north, &missed, &miss);
+
+  // Nobody streaming - the next query here should find the tile
+  if (miss && terrain->thread_count == 0)
+    loadTile(terrain, missed);
+  return depth;
+}
+
+void seabedProfile(SeabedTerrain *terrain, double east, double north, float bearing, float step, int count,
+                   float *depths)
+{
+  if (!terrain)
+  {
+    for (int i = 0; i < count; i++)
+      depths[i] = MAX_DEPTH;
+    return;
+  }
+
+  double de = sin(bearing * DEG2RAD) * step, dn = cos(bearing * DEG2RAD) * step;
+  QueryCounters *counters = queryCounters(terrain);
+  TileKey missed[PROFILE_MISSES];
+  int missed_count = 0;
+
+  for (int i = 0; i < count; i++)
+  {
+    TileKey key;
+    bool miss = false;
+    depths[i] = depthAt(terrain, counters, east + de * (i + 0.5), north + dn * (i + 0.5), &key, &miss);
+    if (miss && missed_count < PROFILE_MISSES &&
+        (missed_count == 0 || missed[missed_count - 1].tx != key.tx || missed[missed_count - 1].ty != key.ty))
+      missed[missed_count++] = key;
+  }
+
+  if (terrain->thread_count == 0)
+    for (int m = 0; m < missed_count; m++)
+      loadTile(terrain, missed[m]);
+}
+
+void seabedStream(SeabedTerrain *terrain, double east, double north)
+{
+  if (!terrain || terrain->thread_count == 0)
+    return;
+
+  TileKey center = tileAt((int64_t)floor(east / SEABED_SPACING), (int64_t)floor(north / SEABED_SPACING));
+
+  pthread_mutex_lock(&terrain->lock);
+  terrain->request_count = 0;
+  uint64_t clock = __atomic_add_fetch(&terrain->clock, 1, __ATOMIC_RELAXED);
+  for (int ring = 0; ring <= SEABED_STREAM_RADIUS; ring++)
+  {
+    for (int dy = -ring; dy <= ring; dy++)
+    {
+      for (int dx = -ring; dx <= ring; dx++)
+      {
+        if (MAX(abs(dx), abs(dy)) != ring)
+          continue;
+
+        // Resident tiles in the window count as used, so the LRU keeps them
+        TileKey key = {center.tx + dx, center.ty + dy};
+        int slot = findTile(terrain, key);
+        if (slot >= 0)
+          __atomic_store_n(&terrain->tiles[slot].last_used, clock, __ATOMIC_RELAXED);
+        else
+          terrain->requests[terrain->request_count++] = key;
+      }
+    }
+  }
+  if (terrain->request_count > 0)
+    pthread_cond_broadcast(&terrain->requested);
+  pthread_mutex_unlock(&terrain->lock);
+}
+
+SeabedStats seabedStats(SeabedTerrain *terrain)
+{
+  if (!terrain)
+    return (SeabedStats){0};
+
+  pthread_mutex_lock(&terrain->lock);
+  SeabedStats stats = terrain->stats;
+  for (int c = 0; c < COUNTER_STRIPES; c++)
+  {
+    stats.hits += __atomic_load_n(&terrain->counters[c].hits, __ATOMIC_RELAXED);
+    stats.misses += __atomic_load_n(&terrain->counters[c].misses, __ATOMIC_RELAXED);
+  }
+  stats.resident = 0;
+  for (int s = 0; s < SEABED_CACHE_TILES; s++)
+    stats.resident += terrain->tiles[s].state == TILE_READY;
+  pthread_mutex_unlock(&terrain->lock);
+  return stats;
+}
@@ -0,0 +1,88 @@
+#ifndef SEABED_H
+#define SEABED_H
+
+#include "constants.h"
+
+// Procedural bathymetry - the depth of the seabed at any point of an
+// unbounded ocean, from a few octaves of value noise over a square lattice of
+// height points SEABED_SPACING apart, seeded so every run with the same seed
+// sails over the same ground.
+//
+// Heights are kept in square tiles of SEABED_TILE_CELLS cells (one row and
+// column of points overlapping the next tile, so a query never needs two).
+// The cache holds SEABED_CACHE_TILES of them and reuses the least recently
+// used, so memory is fixed however far the boat goes. seabedStream queues the
+// tiles around a position for the streaming threads to generate ahead of the
+// boat; a query that lands on a tile nobody has generated yet works its four
+// lattice points out directly instead of waiting, so it costs a few hundred
+// nanoseconds once rather than a tile's worth of noise. The lattice values
+// are a pure function of the seed and the point, so a tile and a direct
+// evaluation agree to the bit and the model stays deterministic whichever
+// thread got there first.
+//
+// Queries never take the cache's lock: a resident tile is read under a
+// per-slot version check, and one being replaced mid-read just sends the
+// query to the lattice. Only generating a tile locks, so the predictive
+// autopilot's rollout threads can each query the bottom every tick.
+
+#define SEABED_TILE_CELLS 64     // Cells along a tile's side
+#define SEABED_SPACING 25.0f     // m between height points
+#define SEABED_TILE_SIZE (SEABED_TILE_CELLS * SEABED_SPACING) // 1.6 km
+#define SEABED_CACHE_TILES 64    // ~1.1 MB of heights, whatever the distance run
+#define SEABED_STREAM_RADIUS 2   // Tiles kept loaded each side of the boat (5 x 5)
+#define SEABED_STREAM_THREADS 2  // Background generators in the game
+#define SEABED_SEED 1            // The game's ocean
+
+#define SEABED_MEAN_DEPTH 6000.0f // m
+#define SEABED_RELIEF 11000.0f    // m either side of the mean at full noise
+#define SEABED_SHOAL_DEPTH 120.0f // m, the shallowest any ground rises to
+
+// Grounding (submarine.c)
+#define SEABED_KEEL_DEPTH 6.0f        // m from the depth gauge's datum down to the keel
+#define SEABED_GROUNDING_SPEED 2.0f   // m/s the hull touches bottom at without harm
+#define SEABED_GROUNDING_DAMAGE 2.5f  // Hull integrity % per m/s over that
+
+_Static_assert(SEABED_CACHE_TILES >= 2 * (2 * SEABED_STREAM_RADIUS + 1) * (2 * SEABED_STREAM_RADIUS + 1),
+               "the cache must hold the streaming window with room to spare");
+
+typedef struct SeabedTerrain SeabedTerrain;
+
+typedef struct
+{
+  uint64_t hits;      // Queries answered from a resident tile
+  uint64_t misses;    // ... worked out from the lattice directly
+  uint64_t generated; // Tiles filled in, by the streamers or on a miss
+  uint64_t evicted;   // Tiles dropped to make room
+  int resident;
+} SeabedStats;
+
+// Process-wide seabed the model grounds on, NULL = open ocean down to
+// MAX_DEPTH. Set before any simulation threads start.
+extern SeabedTerrain *seabedTerrain;
+
+// stream_threads <= 0 generates tiles only on the thread whose query missed them
+SeabedTerrain *seabedCreate(unsigned int seed, int stream_threads);
+void seabedDestroy(SeabedTerrain *terrain);
+
+// Depth of the seabed (m, positive down) at a point, bilinear between
+// lattice points. terrain may be NULL, which is MAX_DEPTH everywhere.
+float seabedDepth(SeabedTerrain *terrain, double east, double north);
+
+// count depths along bearing (° true) from a point, the first step / 2 out
+// and then every step - the sonar's range columns or a cross-section. A
+// negative step looks astern.
+void seabedProfile(SeabedTerrain *terrain, double east, double north, float bearing, float step, int count,
+                   float *depths);
+
+// Ask the streamers for every tile within SEABED_STREAM_RADIUS of a point that
+// isn't resident yet, nearest first, replacing the last request. Never waits.
+void seabedStream(SeabedTerrain *terrain, double east, double north);
+
+SeabedStats seabedStats(SeabedTerrain *terrain);
+
+#ifndef SUB_HEADLESS
+// Bottom under and either side of the boat along its heading, on the main view's scale (renderer.c)
+void renderSeabedProfile(SeabedTerrain *terrain, const SubmarineState *sub, float pixels_per_meter);
+#endif
+
+#endif
@@ -0,0 +1,170 @@
+// Procedural seabed - sails a long straight transit over the terrain the way
+// the game does (streaming threads fed every second, the keel's depth
+// queried every tick, a sonar-length profile ahead every frame) and reports
+// what the cache did, then times the query paths: resident tile, direct off
+// the lattice, and a whole tile generated.
+//
+//   ./sub_seabed [-s seed] [-j stream_threads] [-k km] [-b bearing] [-n queries] [-o profile.csv]
+//
+// -o writes the bottom along the first 20 km of track every 25 m as CSV.
+
+#define _GNU_SOURCE
+#include "seabed.h"
+#include <string.h>
+#include <time.h>
+
+#define TRANSIT_SPEED MAX_SPEED // m/s
+#define TICKS_PER_SECOND ((long)SIM_TICK_RATE)
+#define FRAME_TICKS (TICKS_PER_SECOND / 60) // Ticks between the game's frames
+#define PROFILE_POINTS 160 // As many as the sonar's range columns
+#define PROFILE_STEP 12.5f
+#define CSV_LENGTH 20000.0f
+
+static double secondsSince(const struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static void transit(unsigned int seed, int threads, float km, float bearing)
+{
+  SeabedTerrain *terrain = seabedCreate(seed, threads);
+  double de = sin(bearing * DEG2RAD), dn = cos(bearing * DEG2RAD);
+  long ticks = (long)(km * 1000.0f / TRANSIT_SPEED * SIM_TICK_RATE);
+  float shallowest = MAX_DEPTH, deepest = 0.0f;
+  float profile[PROFILE_POINTS];
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (long tick = 0; tick < ticks; tick++)
+  {
+    double run = tick * (double)TRANSIT_SPEED * SIM_TICK_DT;
+    double east = de * run, north = dn * run;
+    if (tick % TICKS_PER_SECOND == 0)
+      seabedStream(terrain, east, north);
+    if (tick % FRAME_TICKS == 0)
+      seabedProfile(terrain, east, north, bearing, PROFILE_STEP, PROFILE_POINTS, profile);
+
+    float depth = seabedDepth(terrain, east, north);
+    shallowest = MIN(shallowest, depth);
+    deepest = MAX(deepest, depth);
+  }
+  double seconds = secondsSince(&start);
+
+  SeabedStats stats = seabedStats(terrain);
+  uint64_t queries = stats.hits + stats.misses;
+  printf("%.0f km on %03.0f at %.0f m/s, %d streaming thread%s: bottom %.0f-%.0f m\n", km, bearing, TRANSIT_SPEED,
+         threads, threads == 1 ? "" : "s", shallowest, deepest);
+  printf("  %llu queries, %.2f%% from the cache, %llu tiles generated, %llu evicted, %d resident (%.2f MB, fixed)\n",
+         (unsigned long long)queries, 100.0 * stats.hits / MAX(1, queries), (unsigned long long)stats.generated,
+         (unsigned long long)stats.evicted, stats.resident,
+         SEABED_CACHE_TILES * (SEABED_TILE_CELLS + 1) * (SEABED_TILE_CELLS + 1) * sizeof(float) / 1e6);
+  printf("  %.2fs wall, %.0f ns per tick\n", seconds, seconds * 1e9 / MAX(1, ticks));
+  seabedDestroy(terrain);
+}
+
+// Query costs on one thread, over scattered points in the 4 x 4 tiles around
+// the start: with those tiles resident, and with none (a terrain whose one
+// streamer is never asked for anything, so every query is a miss)
+static void timeQueries(unsigned int seed, int queries)
+{
+  SeabedTerrain *terrain = seabedCreate(seed, 0);
+  double *east = malloc(queries * sizeof(double)), *north = malloc(queries * sizeof(double));
+  float *direct = malloc(queries * sizeof(float));
+  for (int i = 0; i < queries; i++)
+  {
+    east[i] = (i * 0.6180339887 - floor(i * 0.6180339887)) * 4 * SEABED_TILE_SIZE - 2 * SEABED_TILE_SIZE;
+    north[i] = (i * 0.7548776662 - floor(i * 0.7548776662)) * 4 * SEABED_TILE_SIZE - 2 * SEABED_TILE_SIZE;
+  }
+
+  // Without streamers each first query loads its tile on the spot
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < 16; i++)
+    seabedDepth(terrain, (i % 4 - 2 + 0.5) * SEABED_TILE_SIZE, (i / 4 - 2 + 0.5) * SEABED_TILE_SIZE);
+  double generate = secondsSince(&start) / 16;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < queries; i++)
+    direct[i] = seabedDepth(terrain, east[i], north[i]);
+  double hit = secondsSince(&start) / queries;
+
+  SeabedTerrain *cold = seabedCreate(seed, 1); // A streamer that's never asked, so nothing is ever resident
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  float worst = 0.0f;
+  for (int i = 0; i < queries; i++)
+    worst = MAX(worst, fabsf(seabedDepth(cold, east[i], north[i]) - direct[i]));
+  double miss = secondsSince(&start) / queries;
+
+  printf("%d queries: %.0f ns from a resident tile, %.0f ns off the lattice, %.2f ms per tile generated, "
+         "paths differ by %.2g m\n",
+         queries, hit * 1e9, miss * 1e9, generate * 1e3, worst);
+
+  seabedDestroy(cold);
+  seabedDestroy(terrain);
+  free(east);
+  free(north);
+  free(direct);
+}
+
+static bool writeProfile(unsigned int seed, float bearing, const char *path)
+{
+  FILE *f = fopen(path, "w");
+  if (!f)
+    return false;
+
+  SeabedTerrain *terrain = seabedCreate(seed, 0);
+  int count = (int)(CSV_LENGTH / SEABED_SPACING);
+  float *depths = malloc(count * sizeof(float));
+  seabedProfile(terrain, 0.0, 0.0, bearing, SEABED_SPACING, count, depths);
+  fprintf(f, "range_m,bottom_m\n");
+  for (int i = 0; i < count; i++)
+    fprintf(f, "%.1f,%.1f\n", (i + 0.5f) * SEABED_SPACING, depths[i]);
+  free(depths);
+  seabedDestroy(terrain);
+  return fclose(f) == 0;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned int seed = SEABED_SEED;
+  int threads = SEABED_STREAM_THREADS;
+  float km = 100.0f, bearing = 45.0f;
+  int queries = 1 << 20;
+  const char *csv_path = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    bool has_value = i + 1 < argc;
+    if (strcmp(argv[i], "-s") == 0 && has_value)
+      seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "-j") == 0 && has_value)
+      threads = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-k") == 0 && has_value)
+      km = strtof(argv[++i], NULL);
+    else if (strcmp(argv[i], "-b") == 0 && has_value)
+      bearing = strtof(argv[++i], NULL);
+    else if (strcmp(argv[i], "-n") == 0 && has_value)
+      queries = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-o") == 0 && has_value)
+      csv_path = argv[++i];
+    else
+    {
+      fprintf(stderr, "usage: %s [-s seed] [-j stream_threads] [-k km] [-b bearing] [-n queries] [-o profile.csv]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  if (km > 0.0f)
+    transit(seed, threads, km, bearing);
+  if (queries > 0)
+    timeQueries(seed, queries);
+  if (csv_path && !writeProfile(seed, bearing, csv_path))
+  {
+    fprintf(stderr, "%s: could not write the profile\n", csv_path);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,392 @@
+#define _POSIX_C_SOURCE 200112L
+#include "simthread.h"
+#include "snapshot.h"
+#include <string.h>
+#include <time.h>
+
+#define QUEUE_MASK (SIM_QUEUE_CAPACITY - 1)
+#define SNAPSHOT_INDEX 3u
+#define MIN_SLEEP 0.0002 // s, below this just go round again
+
+bool simQueuePush(SimCommandQueue *queue, const SimMessage *msg)
+{
+  uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+  uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+  if (tail - head == SIM_QUEUE_CAPACITY)
+    return false;
+
+  queue->slots[tail & QUEUE_MASK] = *msg;
+  __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool simQueuePop(SimCommandQueue *queue, SimMessage *out)
+{
+  uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+  uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+  if (head == tail)
+    return false;
+
+  *out = queue->slots[head & QUEUE_MASK];
+  __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+double simThreadNow(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Fill the back slot and swap it into the middle for the reader
+static void publish(SimThread *sim, double now)
+{
+  SimTripleBuffer *buffer = &sim->snapshots;
+  SimSnapshot *slot = &buffer->slots[buffer->back];
+  slot->prev = sim->prev;
+  slot->sub = sim->sub;
+  slot->tick = sim->tick;
+  slot->tick_time = now;
+  slot->warp = sim->warp;
+  slot->paused = sim->paused;
+  slot->warp_trips = sim->warp_trips;
+  slot->loads = sim->loads;
+  slot->loaded_view = sim->loaded_view;
+  slot->scenario_reloads = sim->scenario_reloads;
+
+  buffer->back = __atomic_exchange_n(&buffer->middle, buffer->back | SIM_SNAPSHOT_FRESH, __ATOMIC_ACQ_REL) &
+                 SNAPSHOT_INDEX;
+}
+
+const SimSnapshot *simThreadLatest(SimThread *sim)
+{
+  SimTripleBuffer *buffer = &sim->snapshots;
+  if (__atomic_load_n(&buffer->middle, __ATOMIC_ACQUIRE) & SIM_SNAPSHOT_FRESH)
+    buffer->front = __atomic_exchange_n(&buffer->middle, buffer->front, __ATOMIC_ACQ_REL) & SNAPSHOT_INDEX;
+  return &buffer->slots[buffer->front];
+}
+
+// Every player and autopilot command goes through here so the journal sees exactly what the model saw
+static void applyCommand(SimThread *sim, SubmarineCommand cmd)
+{
+  journalCommand(&sim->journal, sim->tick, cmd);
+  timeWarpCommand(&sim->warp, &sim->sub, cmd);
+}
+
+// Alarm changes since the last check go to the render thread and the log
+static void checkAlarms(SimThread *sim)
+{
+  AlarmEvent events[ALARM_CHANNEL_COUNT];
+  int count = alarmMonitorUpdate(&sim->monitor, &sim->sub, sim->tick, events);
+  for (int i = 0; i < count; i++)
+  {
+    if (!alarmQueuePush(&sim->alarms, &events[i]))
+      sim->alarms_dropped++;
+    if (sim->alarm_log)
+    {
+      char line[ALARM_TEXT_LENGTH];
+      alarmEventLine(&events[i], line, sizeof(line));
+      fprintf(sim->alarm_log, "%s\n", line);
+    }
+  }
+}
+
+// The journal so far ends at the current state; the next one resumes from
+// the snapshot at snapshot_path, which holds `start` at `tick`
+static void restartJournal(SimThread *sim, const char *snapshot_path, uint64_t tick, const SubmarineState *start)
+{
+  journalClose(&sim->journal, sim->tick, &sim->sub);
+  if (journalOpen(&sim->journal, "session.journal"))
+    journalStart(&sim->journal, snapshot_path, tick, start);
+}
+
+static void quickLoad(SimThread *sim)
+{
+  SubmarineSnapshot snap;
+  if (!snapshotLoad(QUICKSAVE_PATH, &snap))
+  {
+    fprintf(stderr, "Quick-load: no usable snapshot in %s\n", QUICKSAVE_PATH);
+    return;
+  }
+
+  restartJournal(sim, QUICKSAVE_PATH, snap.tick, &snap.sub);
+
+  sim->sub = snap.sub;
+  sim->prev = sim->sub;
+  sim->tick = snap.tick;
+  sim->accumulator = snap.accumulator;
+  sim->warp = initTimeWarp(); // Snapshots don't carry the warp, replays start them at x1
+  sim->loaded_view = snap.view;
+  sim->loads++;
+  if (sim->has_scenario)
+    scenarioRunnerSeek(&sim->scenario, sim->tick);
+  if (sim->alarm_log)
+    fprintf(sim->alarm_log, "quick-load of %s at tick %llu\n", QUICKSAVE_PATH, (unsigned long long)snap.tick);
+  checkAlarms(sim);
+}
+
+// The scenario file was saved: recompile it and patch the running session.
+// A file that no longer compiles leaves the old program running.
+static bool reloadScenario(SimThread *sim)
+{
+  ScenarioProgram updated;
+  if (!scenarioLoadFile(sim->scenario_path, &updated))
+  {
+    fprintf(stderr, "Scenario reload: keeping the running version of %s\n", sim->scenario_path);
+    return false;
+  }
+  if (updated.source_hash == sim->scenario.program.source_hash)
+    return false; // Saved without changes
+
+  int patched = scenarioRunnerReload(&sim->scenario, &updated, sim->tick, &sim->sub);
+  if (patched > 0)
+  {
+    // The state moved outside a command, so replays resume from here
+    sim->prev = sim->sub;
+    RenderState view = initRenderState();
+    if (snapshotSave(SCENARIO_SNAPSHOT_PATH, sim->tick, sim->accumulator, &sim->sub, &view))
+      restartJournal(sim, SCENARIO_SNAPSHOT_PATH, sim->tick, &sim->sub);
+    else
+      fprintf(stderr, "Scenario reload: could not write %s, the journal won't replay\n", SCENARIO_SNAPSHOT_PATH);
+  }
+
+  sim->scenario_reloads++;
+  if (sim->alarm_log)
+  {
+    char stamp[32];
+    alarmClockStamp(sim->tick, stamp, sizeof(stamp));
+    fprintf(sim->alarm_log, "%s scenario %s reloaded, %d value%s patched\n", stamp, updated.name, patched,
+            patched == 1 ? "" : "s");
+  }
+  checkAlarms(sim);
+  return true;
+}
+
+static void handleMessage(SimThread *sim, const SimMessage *msg)
+{
+  switch (msg->type)
+  {
+  case SIM_MSG_COMMAND:
+    applyCommand(sim, msg->cmd);
+    break;
+  case SIM_MSG_PAUSE:
+    sim->paused = msg->paused;
+    break;
+  case SIM_MSG_QUICKSAVE:
+    if (!snapshotSave(QUICKSAVE_PATH, sim->tick, sim->accumulator, &sim->sub, &msg->view))
+      fprintf(stderr, "Quick-save to %s failed\n", QUICKSAVE_PATH);
+    break;
+  case SIM_MSG_QUICKLOAD:
+    quickLoad(sim);
+    break;
+  case SIM_MSG_ACKNOWLEDGE:
+    if (sim->alarm_log)
+    {
+      char stamp[32];
+      alarmClockStamp(sim->tick, stamp, sizeof(stamp));
+      fprintf(sim->alarm_log, "%s operator acknowledged\n", stamp);
+    }
+    break;
+  }
+}
+
+// Spend the banked time in fixed ticks. Under compression the bank grows
+// `factor` times faster and is spent in whole adaptive steps; a step that
+// doesn't fit yet waits for the next round, except that steps shorten to land
+// on the next scenario event. Returns the ticks run.
+static uint32_t runTicks(SimThread *sim, double elapsed)
+{
+  sim->accumulator += (float)elapsed * sim->warp.factor;
+  uint32_t maxTicks = SIM_MAX_CATCHUP_TICKS * sim->warp.factor;
+  uint32_t ticks = 0;
+  while (sim->accumulator >= SIM_TICK_DT && ticks < maxTicks)
+  {
+    sim->prev = sim->sub;
+
+    // Scripted scenario events, journaled like the player's
+    if (sim->has_scenario)
+    {
+      SubmarineCommand due[16];
+      int dueCount;
+      while ((dueCount = scenarioRunnerDue(&sim->scenario, sim->tick, due, 16)) > 0)
+        for (int i = 0; i < dueCount; i++)
+          applyCommand(sim, due[i]);
+    }
+
+    // The predictive autopilot's setpoints are journaled like keypresses
+    SubmarineCommand setpoints[3];
+    int setpointCount = predictiveAutopilotUpdate(&sim->pilot, &sim->sub, sim->tick, setpoints);
+    for (int i = 0; i < setpointCount; i++)
+      applyCommand(sim, setpoints[i]);
+
+    uint32_t budget = sim->warp.factor > 1 ? MIN(maxTicks - ticks, (uint32_t)(sim->accumulator / SIM_TICK_DT)) : 1;
+    // Compressed steps stop at the next event so it fires on its tick
+    uint32_t stop = sim->has_scenario ? MAX(1u, scenarioRunnerTicksUntilNext(&sim->scenario, sim->tick)) : UINT32_MAX;
+    uint32_t ran = timeWarpAdvance(&sim->warp, &sim->sub, budget, stop);
+    if (ran == 0)
+      break;
+    sim->tick += ran;
+    if (sim->recording)
+      recorderAppend(&sim->recorder, &sim->sub, sim->tick);
+    sim->accumulator -= ran * SIM_TICK_DT;
+    ticks += ran;
+    checkAlarms(sim);
+
+    // The boat tripped something - hand control back in real time
+    if (sim->warp.dropped)
+    {
+      sim->warp_trips++;
+      sim->prev = sim->sub;
+      sim->accumulator = fmodf(sim->accumulator, SIM_TICK_DT);
+      break;
+    }
+  }
+
+  // After a long hitch drop the backlog instead of spiralling
+  if (ticks >= maxTicks && sim->accumulator >= SIM_TICK_DT)
+    sim->accumulator = fmodf(sim->accumulator, SIM_TICK_DT);
+  return ticks;
+}
+
+static void *simThreadMain(void *arg)
+{
+  SimThread *sim = arg;
+  double last = simThreadNow();
+
+  while (__atomic_load_n(&sim->running, __ATOMIC_ACQUIRE))
+  {
+    bool changed = sim->has_scenario && scenarioWatcherChanged(&sim->watcher) && reloadScenario(sim);
+    SimMessage msg;
+    while (simQueuePop(&sim->queue, &msg))
+    {
+      handleMessage(sim, &msg);
+      changed = true;
+    }
+
+    double now = simThreadNow();
+    double elapsed = now - last;
+    last = now;
+    if (!sim->paused && runTicks(sim, elapsed) > 0)
+      changed = true;
+
+    if (changed)
+      publish(sim, simThreadNow());
+
+    // Sleep until the next tick is due, never longer than one tick so input stays prompt
+    double wait = sim->paused ? SIM_TICK_DT : (SIM_TICK_DT - sim->accumulator) / sim->warp.factor;
+    wait = MIN((double)SIM_TICK_DT, wait);
+    if (wait > MIN_SLEEP)
+    {
+      struct timespec pause = {0, (long)(wait * 1e9)};
+      nanosleep(&pause, NULL);
+    }
+  }
+  return NULL;
+}
+
+bool simThreadStart(SimThread *sim, const char *scenario_path)
+{
+  SubmarineState start = initSubmarine();
+  ScenarioProgram program;
+  sim->has_scenario = scenario_path != NULL;
+  sim->watcher.fd = -1;
+  if (sim->has_scenario)
+  {
+    if (!scenarioLoadFile(scenario_path, &program))
+      return false;
+    snprintf(sim->scenario_path, sizeof(sim->scenario_path), "%s", scenario_path);
+    start = scenarioInitialState(&program);
+    scenarioRunnerStart(&sim->scenario, &program, 0);
+    if (!scenarioWatcherOpen(&sim->watcher, scenario_path))
+      fprintf(stderr, "Scenario reload disabled: could not watch %s\n", scenario_path);
+  }
+
+  memset(&sim->queue, 0, sizeof(sim->queue));
+  memset(&sim->alarms, 0, sizeof(sim->alarms));
+  sim->snapshots.front = 0;
+  sim->snapshots.middle = 1;
+  sim->snapshots.back = 2;
+
+  sim->sub = start;
+  sim->prev = start;
+  sim->tick = 0;
+  sim->accumulator = 0.0f;
+  sim->warp = initTimeWarp();
+  sim->paused = false;
+  sim->warp_trips = 0;
+  sim->loads = 0;
+  sim->loaded_view = initRenderState();
+  sim->scenario_reloads = 0;
+
+  // Flight recorder - every model step goes to flight.rec for post-mortems (sub_recdump reads it)
+  sim->recording = recorderOpen(&sim->recorder, "flight.rec", RECORDER_DEFAULT_SECONDS * SIM_TICK_RATE);
+  if (!sim->recording)
+    fprintf(stderr, "Flight recorder disabled: could not map flight.rec\n");
+
+  // Input journal - sub_replay plays session.journal back headless, bit for bit
+  // A scenario's starting state isn't initSubmarine(), so its journal starts from a snapshot of it
+  if (!journalOpen(&sim->journal, "session.journal"))
+    fprintf(stderr, "Input journal disabled: could not write session.journal\n");
+  else if (sim->has_scenario)
+  {
+    if (snapshotSave(SCENARIO_SNAPSHOT_PATH, 0, 0.0f, &start, &sim->loaded_view))
+      journalStart(&sim->journal, SCENARIO_SNAPSHOT_PATH, 0, &start);
+    else
+      fprintf(stderr, "Could not write %s, the journal won't replay\n", SCENARIO_SNAPSHOT_PATH);
+  }
+
+  // Alarm history for training review, line buffered so it survives a crash
+  initAlarmMonitor(&sim->monitor);
+  sim->alarms_dropped = 0;
+  sim->alarm_log = fopen("alarms.log", "a");
+  if (sim->alarm_log)
+  {
+    setvbuf(sim->alarm_log, NULL, _IOLBF, 0);
+    time_t now = time(NULL);
+    char started[32];
+    strftime(started, sizeof(started), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    fprintf(sim->alarm_log, "session started %s\n", started);
+    if (sim->has_scenario)
+      fprintf(sim->alarm_log, "scenario %s from %s\n", sim->scenario.program.name, sim->scenario_path);
+  }
+  else
+    fprintf(stderr, "Alarm log disabled: could not write alarms.log\n");
+
+  // Predictive autopilot (P) - plans on every core from this thread
+  sim->pool = threadPoolCreate(0);
+  initPredictiveAutopilot(&sim->pilot, sim->pool, AUTOPILOT_DEFAULT_CANDIDATES);
+
+  checkAlarms(sim);
+  publish(sim, simThreadNow());
+
+  __atomic_store_n(&sim->running, 1, __ATOMIC_RELEASE);
+  if (pthread_create(&sim->thread, NULL, simThreadMain, sim) != 0)
+  {
+    sim->running = 0;
+    simThreadStop(sim);
+    return false;
+  }
+  return true;
+}
+
+void simThreadStop(SimThread *sim)
+{
+  if (__atomic_exchange_n(&sim->running, 0, __ATOMIC_ACQ_REL))
+    pthread_join(sim->thread, NULL);
+
+  journalClose(&sim->journal, sim->tick, &sim->sub);
+  if (sim->recording)
+    recorderClose(&sim->recorder);
+  sim->recording = false;
+  if (sim->alarm_log)
+  {
+    if (sim->alarms_dropped)
+      fprintf(sim->alarm_log, "%u alarm events dropped by a full queue\n", sim->alarms_dropped);
+    fclose(sim->alarm_log);
+  }
+  sim->alarm_log = NULL;
+  threadPoolDestroy(sim->pool);
+  sim->pool = NULL;
+  scenarioWatcherClose(&sim->watcher);
+}
@@ -0,0 +1,151 @@
+#ifndef SIMTHREAD_H
+#define SIMTHREAD_H
+
+#include "alarms.h"
+#include "autopilot.h"
+#include "constants.h"
+#include "journal.h"
+#include "recorder.h"
+#include "scenario.h"
+#include "threadpool.h"
+#include "timewarp.h"
+#include <pthread.h>
+
+// The simulation on its own thread. It owns the model, the fixed-step clock,
+// time compression, the journal, the flight recorder and the predictive
+// autopilot; the render thread never touches any of them.
+//
+// Render -> sim: SimMessages through a single-producer/single-consumer ring,
+// applied before the next tick and journaled at that tick, so replays are
+// unchanged. Sim -> render: after every batch of ticks the sim fills the back
+// slot of a triple buffer and swaps it into the middle. The render thread
+// swaps the middle into its front slot when there's a new one and reads it in
+// place - neither side ever waits on the other or copies a state to hand it
+// over. Alarm changes come back the same way as commands go out, through a
+// ring of their own (alarms.h), and are also written to alarms.log.
+//
+// A scenario file (scenario.h) sets the starting state and fires its events
+// through the same path as player commands, so they are journaled too. The sim
+// thread watches the file and reloads it in place when it is saved.
+
+#define SIM_QUEUE_CAPACITY 256 // Messages in flight, power of two
+#define QUICKSAVE_PATH "quicksave.snap"
+
+typedef enum
+{
+  SIM_MSG_COMMAND,   // cmd, journaled
+  SIM_MSG_PAUSE,     // paused
+  SIM_MSG_QUICKSAVE, // view goes into the snapshot with the model
+  SIM_MSG_QUICKLOAD,
+  SIM_MSG_ACKNOWLEDGE, // Operator acknowledged the standing alarms, for alarms.log
+} SimMessageType;
+
+typedef struct
+{
+  SimMessageType type;
+  SubmarineCommand cmd;
+  bool paused;
+  RenderState view;
+} SimMessage;
+
+typedef struct
+{
+  SimMessage slots[SIM_QUEUE_CAPACITY];
+  uint32_t head __attribute__((aligned(64))); // Next to pop, written by the sim thread
+  uint32_t tail __attribute__((aligned(64))); // Next to push, written by the render thread
+} SimCommandQueue;
+
+// What the renderer needs from one moment of the simulation
+typedef struct
+{
+  SubmarineState prev; // Model before the last tick, for interpolation
+  SubmarineState sub;  // Model after it
+  uint64_t tick;       // Ticks run
+  double tick_time;    // CLOCK_MONOTONIC seconds when sub was reached
+  TimeWarp warp;
+  bool paused;
+  uint32_t warp_trips; // Bumped whenever compression drops back to x1 on its own
+  uint32_t loads;      // Bumped on every quick-load, which also sets loaded_view
+  RenderState loaded_view;
+  uint32_t scenario_reloads; // Bumped whenever the scenario file was reloaded
+} SimSnapshot;
+
+#define SIM_SNAPSHOT_FRESH 4u // Flag on the middle index: published since the reader last looked
+
+typedef struct
+{
+  SimSnapshot slots[3];
+  uint32_t middle __attribute__((aligned(64))); // Slot index | SIM_SNAPSHOT_FRESH, swapped atomically
+  uint32_t back;                                // Writer's slot
+  uint32_t front __attribute__((aligned(64)));  // Reader's slot
+} SimTripleBuffer;
+
+typedef struct
+{
+  pthread_t thread;
+  int running; // Cleared to stop, atomic
+
+  SimCommandQueue queue;
+  SimTripleBuffer snapshots;
+  AlarmQueue alarms;
+
+  // Sim thread only while it runs
+  SubmarineState sub;
+  SubmarineState prev;
+  uint64_t tick;
+  float accumulator;
+  TimeWarp warp;
+  bool paused;
+  uint32_t warp_trips;
+  uint32_t loads;
+  RenderState loaded_view;
+  uint32_t scenario_reloads;
+  JournalWriter journal;
+  FlightRecorder recorder;
+  bool recording;
+  ThreadPool *pool; // Planner's
+  PredictiveAutopilot pilot;
+  AlarmMonitor monitor;
+  FILE *alarm_log;
+  uint32_t alarms_dropped; // Events the render thread had no room for
+  bool has_scenario;
+  char scenario_path[256];
+  ScenarioRunner scenario;
+  ScenarioWatcher watcher;
+} SimThread;
+
+// Queue, render thread side. False when the ring is full (the message is dropped).
+bool simQueuePush(SimCommandQueue *queue, const SimMessage *msg);
+bool simQueuePop(SimCommandQueue *queue, SimMessage *out);
+
+// Opens session.journal, flight.rec and alarms.log, publishes the starting state and starts
+// ticking. Starts from initSubmarine(), or from the scenario at scenario_path if not NULL;
+// false if that doesn't compile. ~200 KB, keep it static.
+bool simThreadStart(SimThread *sim, const char *scenario_path);
+
+// Joins the thread and closes the journal and recorder
+void simThreadStop(SimThread *sim);
+
+static inline bool simThreadSend(SimThread *sim, SimMessage msg)
+{
+  return simQueuePush(&sim->queue, &msg);
+}
+
+static inline bool simThreadCommand(SimThread *sim, SubmarineCommand cmd)
+{
+  return simThreadSend(sim, (SimMessage){.type = SIM_MSG_COMMAND, .cmd = cmd});
+}
+
+// CLOCK_MONOTONIC seconds, the clock tick_time is on
+double simThreadNow(void);
+
+// Newest published snapshot, valid until the next call. Render thread only.
+const SimSnapshot *simThreadLatest(SimThread *sim);
+
+// Next alarm change in the order they happened. Render thread only.
+static inline bool simThreadNextAlarm(SimThread *sim, AlarmEvent *out)
+{
+  return alarmQueuePop(&sim->alarms, out);
+}
+
+#endif
@@ -0,0 +1,85 @@
+#define _GNU_SOURCE
+#include "snapshot.h"
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SNAPSHOT_PAYLOAD_OFFSET (offsetof(SubmarineSnapshot, checksum) + sizeof(uint64_t))
+
+static uint64_t snapshotChecksum(const SubmarineSnapshot *snap)
+{
+  const unsigned char *bytes = (const unsigned char *)snap + SNAPSHOT_PAYLOAD_OFFSET;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < sizeof(*snap) - SNAPSHOT_PAYLOAD_OFFSET; i++)
+    hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  return hash;
+}
+
+bool snapshotSave(const char *path, uint64_t tick, float accumulator,
+                  const SubmarineState *sub, const RenderState *view)
+{
+  // Zeroed first so padding bytes are stable and the checksum is reproducible
+  SubmarineSnapshot snap;
+  memset(&snap, 0, sizeof(snap));
+  memcpy(snap.magic, SNAPSHOT_MAGIC, sizeof(snap.magic));
+  snap.version = SNAPSHOT_VERSION;
+  snap.size = sizeof(snap);
+  snap.state_size = sizeof(SubmarineState);
+  snap.tick_rate = (uint32_t)SIM_TICK_RATE;
+  snap.state_hash = submarineStateHash(sub);
+  snap.tick = tick;
+  snap.accumulator = accumulator;
+  memcpy(&snap.sub, sub, sizeof(*sub));
+  memcpy(&snap.view, view, sizeof(*view));
+  snap.checksum = snapshotChecksum(&snap);
+
+  char temp[1024];
+  snprintf(temp, sizeof(temp), "%s.tmp", path);
+  FILE *f = fopen(temp, "wb");
+  if (!f)
+    return false;
+
+  bool ok = fwrite(&snap, sizeof(snap), 1, f) == 1;
+  ok = fclose(f) == 0 && ok;
+  if (!ok || rename(temp, path) != 0)
+  {
+    remove(temp);
+    return false;
+  }
+  return true;
+}
+
+bool snapshotLoad(const char *path, SubmarineSnapshot *out)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size != (off_t)sizeof(SubmarineSnapshot))
+  {
+    close(fd);
+    return false;
+  }
+
+  const SubmarineSnapshot *snap = mmap(NULL, sizeof(*snap), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (snap == MAP_FAILED)
+    return false;
+
+  bool ok = memcmp(snap->magic, SNAPSHOT_MAGIC, sizeof(snap->magic)) == 0 &&
+            snap->version == SNAPSHOT_VERSION &&
+            snap->size == sizeof(SubmarineSnapshot) &&
+            snap->state_size == sizeof(SubmarineState) &&
+            snap->tick_rate == (uint32_t)SIM_TICK_RATE &&
+            snap->checksum == snapshotChecksum(snap);
+  if (ok)
+    memcpy(out, snap, sizeof(*out));
+
+  munmap((void *)snap, sizeof(*snap));
+  return ok;
+}
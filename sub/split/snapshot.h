@@ -0,0 +1,43 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "constants.h"
+
+// Session snapshots - the whole simulator (model, fixed-step clock, view
+// state) as one fixed-layout binary record. Loading maps the file, checks
+// the header and copies the payload out, so a restore is a few microseconds.
+//
+// The layout is this struct byte for byte on the machine that wrote it. Any
+// change to SubmarineState, RenderState or the fields below must bump
+// SNAPSHOT_VERSION; the size fields catch the ones that are forgotten.
+
+#define SNAPSHOT_MAGIC "SUBSNAP\0"
+#define SNAPSHOT_VERSION 8
+
+typedef struct
+{
+  // Header
+  char magic[8];
+  uint32_t version;
+  uint32_t size;       // sizeof(SubmarineSnapshot)
+  uint32_t state_size; // sizeof(SubmarineState)
+  uint32_t tick_rate;  // SIM_TICK_RATE of the writer
+  uint64_t checksum;   // FNV-1a over everything after this field
+  uint64_t state_hash; // submarineStateHash(&sub), for journals that start here
+
+  // Payload
+  uint64_t tick;        // Ticks run when the snapshot was taken
+  float accumulator;    // Unspent frame time in the fixed-step clock
+  uint32_t reserved;
+  SubmarineState sub;   // Includes the RNG, controller memory and model timers
+  RenderState view;     // hold_depth and the animation timers
+} SubmarineSnapshot;
+
+// Written through a temp file and renamed, so a crash mid-save keeps the old one
+bool snapshotSave(const char *path, uint64_t tick, float accumulator,
+                  const SubmarineState *sub, const RenderState *view);
+
+// False (and nothing touched) if the file is missing, damaged or from another version
+bool snapshotLoad(const char *path, SubmarineSnapshot *out);
+
+#endif
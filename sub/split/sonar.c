@@ -0,0 +1,267 @@
+#define _POSIX_C_SOURCE 200112L
+#include "sonar.h"
+#include "environment.h"
+#include <string.h>
+#include <time.h>
+
+#define FAN_RADIANS (SONAR_FAN_ANGLE * DEG2RAD)
+#define RAY_SPACING (2.0f * FAN_RADIANS / SONAR_RAYS)
+#define GRID_SPAN (SONAR_GRID_DEPTH_CELLS * SONAR_GRID_CELL)
+#define RAYS_PER_SLICE (SONAR_RAYS / SONAR_SLICES)
+
+#define SURFACE_REFLECTION 0.89f // 0.5 dB lost per surface bounce
+#define BOTTOM_REFLECTION 0.1f   // 10 dB per seabed bounce
+
+// Same vector-extension setup as fleet.c, one ray per lane
+typedef float vfloat __attribute__((vector_size(SONAR_LANES * sizeof(float))));
+typedef int32_t vint __attribute__((vector_size(SONAR_LANES * sizeof(int32_t))));
+
+static inline vfloat vselect(vint mask, vfloat a, vfloat b)
+{
+  return (vfloat)((mask & (vint)a) | (~mask & (vint)b));
+}
+
+static inline vfloat vmin(vfloat a, vfloat b) { return vselect(a < b, a, b); }
+static inline vfloat vmax(vfloat a, vfloat b) { return vselect(a > b, a, b); }
+static inline vfloat vsplat(float x) { return (vfloat){0} + x; }
+
+typedef struct
+{
+  SonarField *field;
+  const int *slices;
+  float depth;
+  float top;
+} TraceJob;
+
+// Thorp's absorption, dB per meter at SONAR_FREQUENCY
+static float absorptionPerMeter(void)
+{
+  float f2 = SONAR_FREQUENCY * SONAR_FREQUENCY;
+  return (0.11f * f2 / (1.0f + f2) + 44.0f * f2 / (4100.0f + f2) + 2.75e-4f * f2 + 0.003f) / 1000.0f;
+}
+
+void initSonarField(SonarField *field, ThreadPool *pool)
+{
+  memset(field, 0, sizeof(*field));
+  field->pool = pool;
+  field->source_depth = -1.0f;
+  for (int s = 0; s < SONAR_SLICES; s++)
+    field->slice_depth[s] = -1.0f;
+  for (int col = 0; col < SONAR_GRID_RANGE_CELLS; col++)
+    field->bottom[col] = MAX_DEPTH;
+  for (int row = 0; row < SONAR_GRID_DEPTH_CELLS; row++)
+    for (int col = 0; col < SONAR_GRID_RANGE_CELLS; col++)
+      field->tl[row][col] = SONAR_TL_MAX;
+}
+
+// Grid window for a boat at depth - snapped to whole cells so slices traced
+// for different depths line up row for row
+static float windowTop(float depth)
+{
+  float top = floorf(MAX(0.0f, depth - 0.5f * GRID_SPAN) / SONAR_GRID_CELL) * SONAR_GRID_CELL;
+  return MIN(MAX_DEPTH - GRID_SPAN, top);
+}
+
+// Sound speed and its vertical gradient for every lane, from the environment table rows
+static inline void gatherSoundSpeed(const float *speeds, vfloat z, vfloat *c, vfloat *gradient)
+{
+  vfloat position = vmax(vsplat(0.0f), vmin(vsplat(MAX_DEPTH), z)) * (1.0f / ENVIRONMENT_TABLE_STEP);
+  vint row = __builtin_convertvector(position, vint);
+  vfloat fraction = position - __builtin_convertvector(row, vfloat);
+  vfloat below, above;
+  for (int lane = 0; lane < SONAR_LANES; lane++)
+  {
+    below[lane] = speeds[row[lane]];
+    above[lane] = speeds[row[lane] + 1];
+  }
+  *c = below + (above - below) * fraction;
+  *gradient = (above - below) * (1.0f / ENVIRONMENT_TABLE_STEP);
+}
+
+// One slice's rays out to SONAR_RANGE. Rays march in range a cell at a time
+// carrying depth z and slope q = tan(grazing angle); the eikonal equation in
+// range form is dq/dr = -(1 + q^2) (dc/dz) / c. Each ray drops its share of
+// the source power into the cell it crosses in every column.
+static void traceSlice(SonarField *field, int slice, float depth, float top)
+{
+  const float *bottom_depth = field->bottom;
+  const float *speeds = environmentTables()->values[ENV_SOUND_SPEED];
+  float(*energy)[SONAR_GRID_RANGE_CELLS] = field->energy[slice];
+  memset(energy, 0, sizeof(field->energy[slice]));
+
+  for (int group = 0; group < RAYS_PER_SLICE; group += SONAR_LANES)
+  {
+    vfloat z = vsplat(depth), q, power;
+    for (int lane = 0; lane < SONAR_LANES; lane++)
+    {
+      int ray = slice + SONAR_SLICES * (group + lane); // Interleaved across the fan
+      float angle = -FAN_RADIANS + (ray + 0.5f) * RAY_SPACING;
+      q[lane] = tanf(angle);
+      power[lane] = 0.5f * cosf(angle) * RAY_SPACING; // Fraction of the sphere's power in this ray
+    }
+
+    for (int col = 0; col < SONAR_GRID_RANGE_CELLS; col++)
+    {
+      float dr = col == 0 ? 0.5f * SONAR_GRID_CELL : SONAR_GRID_CELL; // Land on column centers
+
+      vfloat c, gradient;
+      gatherSoundSpeed(speeds, z, &c, &gradient);
+      q -= (1.0f + q * q) * gradient / c * dr;
+      z += q * dr;
+
+      // Mirror at the surface and at the seabed under this column (taken as level)
+      vint surface = z < 0.0f;
+      z = vselect(surface, -z, z);
+      q = vselect(surface, -q, q);
+      power = vselect(surface, power * SURFACE_REFLECTION, power);
+
+      float floor_depth = bottom_depth[col];
+      vint bottom = z > floor_depth;
+      z = vselect(bottom, 2.0f * floor_depth - z, z);
+      q = vselect(bottom, -q, q);
+      power = vselect(bottom, power * BOTTOM_REFLECTION, power);
+
+      vfloat cell = (z - top) * (1.0f / SONAR_GRID_CELL);
+      for (int lane = 0; lane < SONAR_LANES; lane++)
+      {
+        if (cell[lane] >= 0.0f && cell[lane] < SONAR_GRID_DEPTH_CELLS)
+          energy[(int)cell[lane]][col] += power[lane];
+      }
+    }
+  }
+
+  field->slice_depth[slice] = depth;
+  field->slice_top[slice] = top;
+  field->slice_bottom[slice] = field->bottom_version;
+}
+
+static void traceJob(int index, void *ctx)
+{
+  TraceJob *job = ctx;
+  traceSlice(job->field, job->slices[index], job->depth, job->top);
+}
+
+// Sum every traced slice onto the current window and turn energy into dB.
+// Ray counting: power fraction E crossing a cell of height h at range r is an
+// intensity 2E / (r h) relative to the one at 1 m.
+static void rebuildGrid(SonarField *field, float top)
+{
+  int traced = 0;
+  int shift[SONAR_SLICES];
+  for (int s = 0; s < SONAR_SLICES; s++)
+  {
+    if (field->slice_depth[s] >= 0.0f)
+      traced++;
+    shift[s] = (int)lroundf((top - field->slice_top[s]) / SONAR_GRID_CELL);
+  }
+
+  // Slices not traced yet are filled in by the ones that are
+  float scale = traced > 0 ? (float)SONAR_SLICES / traced : 0.0f;
+  float absorption = absorptionPerMeter();
+
+  for (int row = 0; row < SONAR_GRID_DEPTH_CELLS; row++)
+  {
+    float sums[SONAR_GRID_RANGE_CELLS] = {0};
+    for (int s = 0; s < SONAR_SLICES; s++)
+    {
+      int source_row = row + shift[s];
+      if (field->slice_depth[s] < 0.0f || source_row < 0 || source_row >= SONAR_GRID_DEPTH_CELLS)
+        continue;
+      const float *energy = field->energy[s][source_row];
+      for (int col = 0; col < SONAR_GRID_RANGE_CELLS; col++)
+        sums[col] += energy[col];
+    }
+
+    for (int col = 0; col < SONAR_GRID_RANGE_CELLS; col++)
+    {
+      float range = (col + 0.5f) * SONAR_GRID_CELL;
+      float intensity = 2.0f * sums[col] * scale / (range * SONAR_GRID_CELL);
+      float loss = intensity > 0.0f ? -10.0f * log10f(intensity) + absorption * range : SONAR_TL_MAX;
+      field->tl[row][col] = MIN(SONAR_TL_MAX, loss);
+    }
+  }
+
+  field->top = top;
+}
+
+void sonarFieldSetBottom(SonarField *field, const float *depths)
+{
+  float moved = 0.0f;
+  for (int col = 0; col < SONAR_GRID_RANGE_CELLS; col++)
+    moved = MAX(moved, fabsf((depths ? depths[col] : MAX_DEPTH) - field->bottom[col]));
+  if (moved <= SONAR_RETRACE_BOTTOM)
+    return;
+
+  for (int col = 0; col < SONAR_GRID_RANGE_CELLS; col++)
+    field->bottom[col] = depths ? MAX(0.0f, MIN(MAX_DEPTH, depths[col])) : MAX_DEPTH;
+  field->bottom_version++;
+}
+
+int sonarFieldUpdate(SonarField *field, float depth, int max_slices)
+{
+  depth = MAX(0.0f, MIN(MAX_DEPTH, depth));
+  float top = windowTop(depth);
+
+  // Stale slices, round-robin so a long dive refreshes the whole fan evenly
+  int slices[SONAR_SLICES];
+  int count = 0;
+  for (int i = 0; i < SONAR_SLICES && count < max_slices; i++)
+  {
+    int s = (field->cursor + i) % SONAR_SLICES;
+    if (field->slice_depth[s] < 0.0f || fabsf(field->slice_depth[s] - depth) > SONAR_RETRACE_DEPTH ||
+        field->slice_bottom[s] != field->bottom_version)
+      slices[count++] = s;
+  }
+
+  if (count == 0 && top == field->top && field->source_depth >= 0.0f)
+    return 0;
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  if (count > 0)
+  {
+    field->cursor = (slices[count - 1] + 1) % SONAR_SLICES;
+
+    TraceJob job = {field, slices, depth, top};
+    if (field->pool)
+      threadPoolParallelFor(field->pool, count, traceJob, &job);
+    else
+      for (int i = 0; i < count; i++)
+        traceJob(i, &job);
+  }
+
+  rebuildGrid(field, top);
+  field->source_depth = depth;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  field->slices_traced += count;
+  field->ray_steps += (uint64_t)count * RAYS_PER_SLICE * SONAR_GRID_RANGE_CELLS;
+  field->trace_seconds += (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+  return count;
+}
+
+float sonarTransmissionLoss(const SonarField *field, float range, float depth)
+{
+  if (field->source_depth < 0.0f)
+    return SONAR_TL_MAX;
+
+  // Cell centers sit half a cell in
+  float col = range / SONAR_GRID_CELL - 0.5f;
+  float row = (depth - field->top) / SONAR_GRID_CELL - 0.5f;
+  if (range < 0.0f || col > SONAR_GRID_RANGE_CELLS - 0.5f || row < -0.5f || row > SONAR_GRID_DEPTH_CELLS - 0.5f)
+    return SONAR_TL_MAX;
+
+  col = MAX(0.0f, MIN(SONAR_GRID_RANGE_CELLS - 1.001f, col));
+  row = MAX(0.0f, MIN(SONAR_GRID_DEPTH_CELLS - 1.001f, row));
+  int c = (int)col, r = (int)row;
+  float fc = col - c, fr = row - r;
+  float upper = field->tl[r][c] + (field->tl[r][c + 1] - field->tl[r][c]) * fc;
+  float lower = field->tl[r + 1][c] + (field->tl[r + 1][c + 1] - field->tl[r + 1][c]) * fc;
+  return upper + (lower - upper) * fr;
+}
+
+float sonarSignalExcess(const SonarField *field, float range, float depth, float source_level)
+{
+  return source_level - sonarTransmissionLoss(field, range, depth) - SONAR_NOISE_LEVEL - SONAR_DETECT_THRESHOLD;
+}
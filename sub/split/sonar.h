@@ -0,0 +1,88 @@
+#ifndef SONAR_H
+#define SONAR_H
+
+#include "constants.h"
+#include "threadpool.h"
+
+// Acoustic propagation around the boat. A fan of rays leaves the sonar and is
+// bent through the sound-speed profile (environment.h - the thermal layer at
+// THERMAL_LAYER_DEPTH makes the shadow zone, pressure below it the deep
+// channel), bouncing off the surface and the seabed. Ray energy is counted
+// into a range x depth grid of transmission loss.
+//
+// The fan is split into interleaved slices, each with its own energy grid.
+// As the boat moves, sonarFieldUpdate retraces only the stale slices, a few
+// per call on the thread pool, so a dive refreshes the picture over a handful
+// of frames instead of stalling one.
+//
+// The seabed is a depth per range column (sonarFieldSetBottom - seabed.h
+// samples one along the boat's heading), flat at MAX_DEPTH until one is
+// given. Running over changing ground makes slices stale the same way a dive
+// does.
+
+#define SONAR_RAYS 2048            // Whole fan
+#define SONAR_SLICES 16            // Interleaved subsets retraced independently
+#define SONAR_LANES 8              // Rays per vector operation (one AVX register)
+#define SONAR_FAN_ANGLE 45.0f      // Degrees above and below horizontal
+#define SONAR_GRID_RANGE_CELLS 160 // Out to SONAR_RANGE
+#define SONAR_GRID_DEPTH_CELLS 80  // Centered on the boat
+#define SONAR_GRID_CELL 12.5f      // m, both axes
+#define SONAR_RETRACE_DEPTH 1.0f   // m the boat moves before a slice is stale
+#define SONAR_RETRACE_BOTTOM 5.0f  // m any column of the bottom moves before slices are stale
+#define SONAR_SLICES_PER_FRAME 4
+
+// Passive sonar equation: a contact is heard while
+// source level - TL - (noise - directivity) - threshold > 0
+#define SONAR_FREQUENCY 3.5f        // kHz, for absorption
+#define SONAR_TL_MAX 150.0f         // dB, cells no ray reaches
+#define SONAR_NOISE_LEVEL 60.0f     // dB, ambient noise less array gain
+#define SONAR_DETECT_THRESHOLD 10.0f // dB
+
+typedef struct
+{
+  ThreadPool *pool; // NULL traces on the calling thread
+
+  float tl[SONAR_GRID_DEPTH_CELLS][SONAR_GRID_RANGE_CELLS]; // dB, row 0 at top
+  float top;          // Depth of the grid's upper edge (a multiple of SONAR_GRID_CELL)
+  float source_depth; // Boat depth the grid was last rebuilt for, < 0 = never
+
+  // Ray energy per slice, each on the grid window it was traced for
+  float energy[SONAR_SLICES][SONAR_GRID_DEPTH_CELLS][SONAR_GRID_RANGE_CELLS];
+  float slice_depth[SONAR_SLICES]; // < 0 = never traced
+  float slice_top[SONAR_SLICES];
+  uint32_t slice_bottom[SONAR_SLICES]; // bottom_version each was traced over
+
+  float bottom[SONAR_GRID_RANGE_CELLS]; // Seabed depth at each column's center
+  uint32_t bottom_version;              // Bumped when the bottom moves past SONAR_RETRACE_BOTTOM
+  int cursor; // Next slice to consider, so stale ones are taken round-robin
+
+  // Counters since init
+  uint64_t slices_traced;
+  uint64_t ray_steps;
+  double trace_seconds;
+} SonarField;
+
+// ~1 MB, keep it static or on the heap
+void initSonarField(SonarField *field, ThreadPool *pool);
+
+// Seabed depth at every range column's center from the boat out (NULL is
+// flat at MAX_DEPTH). Slices go stale only if some column moved far enough.
+void sonarFieldSetBottom(SonarField *field, const float *depths);
+
+// Retrace at most max_slices stale slices for a boat at depth and rebuild the
+// grid. Returns the slices traced, 0 when the picture was already current.
+int sonarFieldUpdate(SonarField *field, float depth, int max_slices);
+
+// Loss from the boat to a point range meters out, bilinear between cells.
+// Outside the grid (or before the first update) it's SONAR_TL_MAX.
+float sonarTransmissionLoss(const SonarField *field, float range, float depth);
+
+// dB over the detection threshold for a source_level dB contact there
+float sonarSignalExcess(const SonarField *field, float range, float depth, float source_level);
+
+#ifndef SUB_HEADLESS
+// Transmission-loss picture at x, y, one pixel block per cell (renderer.c)
+void renderSonarField(const SonarField *field, float boat_depth, int x, int y);
+#endif
+
+#endif
@@ -0,0 +1,139 @@
+// Sonar propagation bench - traces the full fan for a boat at one depth and
+// writes the transmission-loss grid, then dives through the water column a
+// frame at a time the way the game does and reports the worst frame.
+//
+//   ./sub_sonar [-d depth] [-b bottom] [-j threads] [-n traces] [-D dive] [-o out.csv]
+//
+// The CSV has one row per grid cell (range, depth, loss); timings go to stderr.
+
+#define _GNU_SOURCE
+#include "sonar.h"
+#include <string.h>
+#include <time.h>
+
+#define FRAME_RATE 60.0f
+#define DIVE_SPEED 10.0f // m/s, a hard dive
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-d depth] [-b bottom] [-j threads] [-n traces] [-D dive] [-o out.csv]\n"
+          "  -d  boat depth in meters (default 200)\n"
+          "  -b  level seabed this many meters down (default: MAX_DEPTH)\n"
+          "  -j  tracing threads (default one per core)\n"
+          "  -n  full-fan traces to time (default 50)\n"
+          "  -D  meters to dive afterwards at %.0f m/s, one update per frame (default 400)\n"
+          "  -o  write the CSV here instead of stdout\n",
+          prog, DIVE_SPEED);
+}
+
+static double secondsSince(const struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+  float depth = 200.0f;
+  int threads = 0;
+  int traces = 50;
+  float dive = 400.0f;
+  float bottom = MAX_DEPTH;
+  const char *out_path = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (strcmp(arg, "-d") == 0 && has_value)
+      depth = strtof(argv[++i], NULL);
+    else if (strcmp(arg, "-b") == 0 && has_value)
+      bottom = strtof(argv[++i], NULL);
+    else if (strcmp(arg, "-j") == 0 && has_value)
+      threads = atoi(argv[++i]);
+    else if (strcmp(arg, "-n") == 0 && has_value)
+      traces = atoi(argv[++i]);
+    else if (strcmp(arg, "-D") == 0 && has_value)
+      dive = strtof(argv[++i], NULL);
+    else if (strcmp(arg, "-o") == 0 && has_value)
+      out_path = argv[++i];
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  FILE *out = out_path ? fopen(out_path, "w") : stdout;
+  if (!out)
+  {
+    perror(out_path);
+    return 1;
+  }
+
+  depth = MAX(0.0f, MIN(MAX_DEPTH, depth));
+  traces = MAX(1, traces);
+
+  static SonarField field; // ~1 MB
+  ThreadPool *pool = threadPoolCreate(threads);
+  if (!pool)
+  {
+    fprintf(stderr, "could not start a thread pool\n");
+    return 1;
+  }
+  float seabed[SONAR_GRID_RANGE_CELLS];
+  for (int col = 0; col < SONAR_GRID_RANGE_CELLS; col++)
+    seabed[col] = bottom;
+
+  // Full fan from scratch, timed over several runs
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int t = 0; t < traces; t++)
+  {
+    initSonarField(&field, pool);
+    sonarFieldSetBottom(&field, seabed);
+    sonarFieldUpdate(&field, depth, SONAR_SLICES);
+  }
+  double full = secondsSince(&start) / traces;
+  fprintf(stderr, "full fan: %d rays x %d cells on %d threads in %.2f ms, %.1f M ray steps/s\n", SONAR_RAYS,
+          SONAR_GRID_RANGE_CELLS, threadPoolWorkerCount(pool), full * 1000.0,
+          (double)SONAR_RAYS * SONAR_GRID_RANGE_CELLS / full / 1e6);
+
+  fprintf(out, "range,depth,loss\n");
+  for (int row = 0; row < SONAR_GRID_DEPTH_CELLS; row++)
+    for (int col = 0; col < SONAR_GRID_RANGE_CELLS; col++)
+      fprintf(out, "%.1f,%.1f,%.2f\n", (col + 0.5f) * SONAR_GRID_CELL, field.top + (row + 0.5f) * SONAR_GRID_CELL,
+              field.tl[row][col]);
+
+  fprintf(stderr, "loss at %.0f m range from %.0f m: %.1f dB level, %.1f dB 100 m up, %.1f dB 100 m down\n",
+          SONAR_RANGE / 2, depth, sonarTransmissionLoss(&field, SONAR_RANGE / 2, depth),
+          sonarTransmissionLoss(&field, SONAR_RANGE / 2, depth - 100.0f),
+          sonarTransmissionLoss(&field, SONAR_RANGE / 2, depth + 100.0f));
+
+  // Then dive, one budgeted update per frame
+  uint64_t steps_before = field.ray_steps;
+  int frames = (int)(fabsf(dive) / DIVE_SPEED * FRAME_RATE);
+  double worst = 0.0, total = 0.0;
+  for (int f = 1; f <= frames; f++)
+  {
+    float now = depth + copysignf(DIVE_SPEED, dive) * f / FRAME_RATE;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    sonarFieldUpdate(&field, now, SONAR_SLICES_PER_FRAME);
+    double frame = secondsSince(&start);
+    worst = MAX(worst, frame);
+    total += frame;
+  }
+
+  if (frames > 0)
+    fprintf(stderr, "dive: %d frames, %.3f ms/frame mean, %.3f ms worst, %.1f slices/frame\n", frames,
+            total * 1000.0 / frames, worst * 1000.0,
+            (double)(field.ray_steps - steps_before) / (SONAR_RAYS / SONAR_SLICES * SONAR_GRID_RANGE_CELLS) / frames);
+
+  threadPoolDestroy(pool);
+  if (out != stdout)
+    fclose(out);
+  return 0;
+}
@@ -1,4 +1,14 @@
 #include "constants.h"
+#include "currents.h"
+#include "electrical.h"
+#include "environment.h"
+#include "flooding.h"
+#include "kinetics.h"
+#include "params.h"
+#include "seabed.h"
+#include "subsystems.h"
+#include "thermal.h"
+#include <string.h>
 
 SubmarineState initSubmarine(void)
 {
@@ -13,47 +23,8 @@ SubmarineState initSubmarine(void)
       .nitrogen_level = 0,
       .pressure_hull_stress = 0,
 
-      // Main systems
-      .reactor_active = false,
-      .sonar_active = false,
-      .ballast_tanks_filled = false,
-      .lights_active = false,
-      .oxygen_system_active = false,
-      .emergency_surface = false,
-      .cooling_active = false,
-      .autopilot_active = false,
-
-      // Reactor sub-systems
-      .reactor_control_rods_inserted = true,   // Start with rods IN (safe)
-      .reactor_coolant_pumps_active = false,   // Coolant pumps OFF
-      .reactor_steam_generator_active = false, // Steam generator OFF
-      .reactor_power_turbine_active = false,   // Power turbine OFF
-
-      // Life support sub-systems
-      .oxygen_scrubbers_active = false, // CO2 scrubbers OFF
-      .oxygen_generator_active = false, // O2 generator OFF
-      .air_circulation_active = false,  // Air circulation OFF
-
-      // Navigation sub-systems
-      .navigation_computer_active = false, // Nav computer OFF
-      .gyroscope_active = false,           // Gyroscope OFF
-      .depth_control_active = false,       // Depth control OFF
-
-      // Additional subsystems
-      .reactor_containment_active = false, // Reactor containment
-      .emergency_cooling_active = false,   // Emergency cooling
-      .backup_power_active = false,        // Backup power
-      .hull_monitoring_active = false,     // Hull monitoring
-      .ballast_control_active = false,     // Ballast control
-      .communications_active = false,      // Communications
-
-      // Emergency/General subsystems - ALL MANUAL (no power required)
-      .manual_bilge_pumps_active = false,   // Manual bilge pumps
-      .emergency_lighting_active = false,   // Emergency lighting
-      .emergency_air_supply_active = false, // Emergency air supply
-      .manual_ballast_blow_active = false,  // Manual ballast blow
-      .distress_beacon_active = false,      // Distress beacon
-      .fire_suppression_active = false,     // Fire suppression
+      // All switches OFF except the control rods - start with rods IN (safe)
+      .systems = SYS_BIT(SYS_CONTROL_RODS_INSERTED),
 
       .power_consumption = 0,
       .ballast_level = 20,
@@ -63,461 +34,546 @@ SubmarineState initSubmarine(void)
       .target_depth = 0,
       .hull_temperature = 25,
       .water_temperature = 20,
-      .reactor_destroyed = false,
-      .sonar_ping_timer = 0};
+      .coolant_temp = 25,
+      .steam_generator_temp = 25,
+      .sonar_ping_timer = 0,
+      .helm_input = 0,
+      .gyro_drift_timer = 0,
+      .autopilot_integral = 0,
+      .autopilot_prev_error = 0,
+      .autopilot_ballast = 0,
+      .autopilot_trim = 0,
+      .autopilot_thrust = 0,
+      .rng_state = 0x9E3779B9u,
+      .sonar_ping_count = 0,
+      .subsystem_inputs = 0,
+
+      // Dry, sound and every watertight door open for passage
+      .flood_water = {0},
+      .breach_area = {0},
+      .doors_shut = 0,
+      .flood_wet = 0,
+
+      // Every breaker closed, nothing on the buses yet
+      .bus_demand = {0},
+      .power_supply = 0,
+      .propulsion_supply = 1,
+      .power_loads = 0,
+      .power_shed = 0,
+      .breakers_open = 0,
+
+      // Fresh core, rods in; the drives take them all the way out once the reactor is started
+      .neutron_power = 0,
+      .precursors = {0},
+      .rod_position = 0,
+      .rod_target = 1,
+
+      // At the start point, stopped, heading north
+      .north = 0,
+      .east = 0,
+      .heading = 0,
+      .course = 0,
+      .forward_speed = 0,
+      .current_east = 0,
+      .current_north = 0,
+      .bottom_depth = seabedDepth(seabedTerrain, 0.0, 0.0)};
 }
 
-// Helper function for button click detection
-static bool checkSubSystemButtonClick(int x, int y, int mouseX, int mouseY)
+static const char *commandNames[CMD_COUNT] = {
+    [CMD_NONE] = "none",
+    [CMD_CONTROL_RODS] = "control_rods",
+    [CMD_COOLANT_PUMPS] = "coolant_pumps",
+    [CMD_STEAM_GENERATOR] = "steam_generator",
+    [CMD_POWER_TURBINE] = "power_turbine",
+    [CMD_CONTAINMENT] = "containment",
+    [CMD_EMERGENCY_COOLING] = "emergency_cooling",
+    [CMD_MAIN_REACTOR] = "main_reactor",
+    [CMD_AIR_CIRCULATION] = "air_circulation",
+    [CMD_CO2_SCRUBBERS] = "co2_scrubbers",
+    [CMD_O2_GENERATOR] = "o2_generator",
+    [CMD_HULL_MONITORING] = "hull_monitoring",
+    [CMD_MAIN_O2_SYSTEM] = "main_o2_system",
+    [CMD_BACKUP_POWER] = "backup_power",
+    [CMD_GYROSCOPE] = "gyroscope",
+    [CMD_NAV_COMPUTER] = "nav_computer",
+    [CMD_DEPTH_CONTROL] = "depth_control",
+    [CMD_BALLAST_CONTROL] = "ballast_control",
+    [CMD_COMMUNICATIONS] = "communications",
+    [CMD_EMERGENCY_LIGHTING] = "emergency_lighting",
+    [CMD_EMERGENCY_COOLING_MANUAL] = "emergency_cooling_manual",
+    [CMD_EMERGENCY_AIR] = "emergency_air",
+    [CMD_BILGE_PUMPS] = "bilge_pumps",
+    [CMD_FIRE_SUPPRESSION] = "fire_suppression",
+    [CMD_BALLAST_BLOW] = "ballast_blow",
+    [CMD_DISTRESS_BEACON] = "distress_beacon",
+    [CMD_BALLAST] = "ballast",
+    [CMD_LIGHTS] = "lights",
+    [CMD_SONAR] = "sonar",
+    [CMD_EMERGENCY_SURFACE] = "emergency_surface",
+    [CMD_AUTOPILOT] = "autopilot",
+    [CMD_COOLING] = "cooling",
+    [CMD_HELM] = "helm",
+    [CMD_TARGET_DEPTH] = "target_depth",
+    [CMD_PREDICTIVE_AUTOPILOT] = "predictive_autopilot",
+    [CMD_AUTOPILOT_BALLAST] = "autopilot_ballast",
+    [CMD_AUTOPILOT_TRIM] = "autopilot_trim",
+    [CMD_AUTOPILOT_THRUST] = "autopilot_thrust",
+    [CMD_TIME_COMPRESSION] = "time_compression",
+    [CMD_SYSTEM_FAILURE] = "system_failure",
+    [CMD_WATERTIGHT_DOOR] = "watertight_door",
+    [CMD_BREAKER] = "breaker",
+    [CMD_ROD_POSITION] = "rod_position",
+    [CMD_COURSE] = "course",
+};
+
+static const char *systemNames[SYS_COUNT] = {
+    [SYS_REACTOR] = "reactor",
+    [SYS_SONAR] = "sonar",
+    [SYS_BALLAST_TANKS_FILLED] = "ballast_tanks_filled",
+    [SYS_LIGHTS] = "lights",
+    [SYS_OXYGEN_SYSTEM] = "oxygen_system",
+    [SYS_EMERGENCY_SURFACE] = "emergency_surface",
+    [SYS_COOLING] = "cooling",
+    [SYS_AUTOPILOT] = "autopilot",
+    [SYS_CONTROL_RODS_INSERTED] = "control_rods_inserted",
+    [SYS_COOLANT_PUMPS] = "coolant_pumps",
+    [SYS_STEAM_GENERATOR] = "steam_generator",
+    [SYS_POWER_TURBINE] = "power_turbine",
+    [SYS_CO2_SCRUBBERS] = "co2_scrubbers",
+    [SYS_O2_GENERATOR] = "o2_generator",
+    [SYS_AIR_CIRCULATION] = "air_circulation",
+    [SYS_NAV_COMPUTER] = "nav_computer",
+    [SYS_GYROSCOPE] = "gyroscope",
+    [SYS_DEPTH_CONTROL] = "depth_control",
+    [SYS_CONTAINMENT] = "containment",
+    [SYS_EMERGENCY_COOLING] = "emergency_cooling",
+    [SYS_HULL_MONITORING] = "hull_monitoring",
+    [SYS_BACKUP_POWER] = "backup_power",
+    [SYS_BALLAST_CONTROL] = "ballast_control",
+    [SYS_COMMUNICATIONS] = "communications",
+    [SYS_BILGE_PUMPS] = "bilge_pumps",
+    [SYS_EMERGENCY_LIGHTING] = "emergency_lighting",
+    [SYS_EMERGENCY_AIR] = "emergency_air",
+    [SYS_BALLAST_BLOW] = "ballast_blow",
+    [SYS_DISTRESS_BEACON] = "distress_beacon",
+    [SYS_FIRE_SUPPRESSION] = "fire_suppression",
+    [SYS_REACTOR_DESTROYED] = "reactor_destroyed",
+    [SYS_AUTOPILOT_PREDICTIVE] = "autopilot_predictive",
+};
+
+const char *submarineCommandName(SubmarineCommandType type)
 {
-  return (mouseX >= x && mouseX <= x + 120 && mouseY >= y && mouseY <= y + 25);
+  if (type < 0 || type >= CMD_COUNT)
+    return "none";
+  return commandNames[type];
 }
 
-// Subsystem input handling function
-void handleSubSystemInput(SubmarineState *sub)
+SubmarineCommandType submarineCommandFromName(const char *name)
 {
-  if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+  for (int i = 0; i < CMD_COUNT; i++)
   {
-    Vector2 mousePos = GetMousePosition();
-    int mx = (int)mousePos.x;
-    int my = (int)mousePos.y;
-
-    // REACTOR SYSTEMS PANEL (10, 10, 280, 180)
-    if (mx >= 10 && mx <= 290 && my >= 10 && my <= 190)
-    {
-      // Control Rods button (20, 40) - NO battery requirement (manual operation)
-      if (checkSubSystemButtonClick(20, 40, mx, my))
-      {
-        sub->reactor_control_rods_inserted = !sub->reactor_control_rods_inserted;
-      }
-      // Coolant Pumps button (150, 40) - Requires battery OR backup power
-      else if (checkSubSystemButtonClick(150, 40, mx, my) &&
-               (sub->battery_level > 5 || sub->backup_power_active))
-      {
-        sub->reactor_coolant_pumps_active = !sub->reactor_coolant_pumps_active;
-      }
-      // Steam Generator button (20, 70) - Requires battery OR backup power
-      else if (checkSubSystemButtonClick(20, 70, mx, my) &&
-               (sub->battery_level > 5 || sub->backup_power_active))
-      {
-        sub->reactor_steam_generator_active = !sub->reactor_steam_generator_active;
-      }
-      // Power Turbine button (150, 70) - Requires battery OR backup power
-      else if (checkSubSystemButtonClick(150, 70, mx, my) &&
-               (sub->battery_level > 5 || sub->backup_power_active))
-      {
-        sub->reactor_power_turbine_active = !sub->reactor_power_turbine_active;
-      }
-      // Containment button (20, 100) - Requires battery OR backup power
-      else if (checkSubSystemButtonClick(20, 100, mx, my) &&
-               (sub->battery_level > 5 || sub->backup_power_active))
-      {
-        sub->reactor_containment_active = !sub->reactor_containment_active;
-      }
-      // Emergency Cooling button (150, 100) - Requires battery OR backup power
-      else if (checkSubSystemButtonClick(150, 100, mx, my) &&
-               (sub->battery_level > 10 || sub->backup_power_active))
-      {
-        sub->emergency_cooling_active = !sub->emergency_cooling_active;
-      }
-      // Main Reactor button (75, 130) - NO battery requirement for manual start/stop
-      else if (checkSubSystemButtonClick(75, 130, mx, my))
-      {
-        bool reactor_can_operate = !sub->reactor_control_rods_inserted &&
-                                   sub->reactor_coolant_pumps_active &&
-                                   sub->reactor_steam_generator_active &&
-                                   sub->reactor_power_turbine_active &&
-                                   sub->reactor_containment_active;
-        if (reactor_can_operate || sub->reactor_active) // Allow shutdown even without all systems
-        {
-          sub->reactor_active = !sub->reactor_active;
-        }
-      }
-    }
-
-    // LIFE SUPPORT PANEL (10, 200, 280, 180)
-    else if (mx >= 10 && mx <= 290 && my >= 200 && my <= 380)
-    {
-      // Air Circulation button (20, 230)
-      if (checkSubSystemButtonClick(20, 230, mx, my) &&
-          (sub->battery_level > 5 || sub->backup_power_active))
-      {
-        sub->air_circulation_active = !sub->air_circulation_active;
-      }
-      // CO2 Scrubbers button (150, 230)
-      else if (checkSubSystemButtonClick(150, 230, mx, my) &&
-               (sub->battery_level > 5 || sub->backup_power_active))
-      {
-        sub->oxygen_scrubbers_active = !sub->oxygen_scrubbers_active;
-      }
-      // O2 Generator button (20, 260)
-      else if (checkSubSystemButtonClick(20, 260, mx, my) &&
-               (sub->battery_level > 5 || sub->backup_power_active))
-      {
-        sub->oxygen_generator_active = !sub->oxygen_generator_active;
-      }
-      // Hull Monitoring button (150, 260)
-      else if (checkSubSystemButtonClick(150, 260, mx, my) &&
-               (sub->battery_level > 5 || sub->backup_power_active))
-      {
-        sub->hull_monitoring_active = !sub->hull_monitoring_active;
-      }
-      // Main O2 System button (20, 290) - STRICT requirements
-      else if (checkSubSystemButtonClick(20, 290, mx, my) &&
-               (sub->battery_level > 5 || sub->backup_power_active))
-      {
-        int active_subsystems = (sub->air_circulation_active ? 1 : 0) +
-                                (sub->oxygen_scrubbers_active ? 1 : 0) +
-                                (sub->oxygen_generator_active ? 1 : 0);
-        if (active_subsystems >= 2 || sub->oxygen_system_active)
-        {
-          sub->oxygen_system_active = !sub->oxygen_system_active;
-        }
-      }
-      // Backup Power button (150, 290) - NO battery requirement (manual start)
-      else if (checkSubSystemButtonClick(150, 290, mx, my))
-      {
-        sub->backup_power_active = !sub->backup_power_active;
-      }
-    }
-
-    // NAVIGATION PANEL (10, 390, 280, 180)
-    else if (mx >= 10 && mx <= 290 && my >= 390 && my <= 570)
-    {
-      // Gyroscope button (20, 420)
-      if (checkSubSystemButtonClick(20, 420, mx, my) &&
-          (sub->battery_level > 10 || sub->backup_power_active))
-      {
-        sub->gyroscope_active = !sub->gyroscope_active;
-      }
-      // Nav Computer button (150, 420)
-      else if (checkSubSystemButtonClick(150, 420, mx, my) &&
-               (sub->battery_level > 10 || sub->backup_power_active))
-      {
-        sub->navigation_computer_active = !sub->navigation_computer_active;
-      }
-      // Depth Control button (20, 450)
-      else if (checkSubSystemButtonClick(20, 450, mx, my) &&
-               (sub->battery_level > 10 || sub->backup_power_active))
-      {
-        sub->depth_control_active = !sub->depth_control_active;
-      }
-      // Ballast Control button (150, 450) - Requires power (battery > 0 OR backup)
-      else if (checkSubSystemButtonClick(150, 450, mx, my) &&
-               (sub->battery_level > 0.0f || sub->backup_power_active))
-      {
-        sub->ballast_control_active = !sub->ballast_control_active;
-      }
-      // Communications button (20, 480)
-      else if (checkSubSystemButtonClick(20, 480, mx, my) &&
-               (sub->battery_level > 5 || sub->backup_power_active))
-      {
-        sub->communications_active = !sub->communications_active;
-      }
-    }
-
-    // EMERGENCY/GENERAL SYSTEMS PANEL (350, 10, 320, 360) - FIXED COORDINATES
-    else if (mx >= 350 && mx <= 670 && my >= 10 && my <= 370)
-    {
-      // Backup Power button (360, 40) - FIXED
-      if (checkSubSystemButtonClick(360, 40, mx, my))
-      {
-        sub->backup_power_active = !sub->backup_power_active;
-      }
-      // Emergency Lighting button (490, 40) - FIXED
-      else if (checkSubSystemButtonClick(490, 40, mx, my))
-      {
-        sub->emergency_lighting_active = !sub->emergency_lighting_active;
-      }
-      // Emergency Cooling button (360, 70) - FIXED
-      else if (checkSubSystemButtonClick(360, 70, mx, my))
-      {
-        sub->emergency_cooling_active = !sub->emergency_cooling_active;
-      }
-      // Emergency Air Supply button (490, 70) - FIXED
-      else if (checkSubSystemButtonClick(490, 70, mx, my))
-      {
-        sub->emergency_air_supply_active = !sub->emergency_air_supply_active;
-      }
-      // Manual Bilge Pumps button (360, 100) - FIXED
-      else if (checkSubSystemButtonClick(360, 100, mx, my))
-      {
-        sub->manual_bilge_pumps_active = !sub->manual_bilge_pumps_active;
-      }
-      // Fire Suppression button (490, 100) - FIXED
-      else if (checkSubSystemButtonClick(490, 100, mx, my))
-      {
-        sub->fire_suppression_active = !sub->fire_suppression_active;
-      }
-      // Manual Ballast Blow button (360, 130) - FIXED
-      else if (checkSubSystemButtonClick(360, 130, mx, my))
-      {
-        sub->manual_ballast_blow_active = !sub->manual_ballast_blow_active;
-        if (sub->manual_ballast_blow_active)
-        {
-          sub->ballast_tanks_filled = false;
-          sub->emergency_surface = true;
-        }
-      }
-      // Distress Beacon button (490, 130) - FIXED
-      else if (checkSubSystemButtonClick(490, 130, mx, my))
-      {
-        sub->distress_beacon_active = !sub->distress_beacon_active;
-      }
-    }
+    if (strcmp(commandNames[i], name) == 0)
+      return (SubmarineCommandType)i;
   }
+  return CMD_NONE;
 }
 
-static void updatePowerAndEnvironment(SubmarineState *sub, float deltaTime)
+const char *submarineSystemName(SubmarineSystem system)
 {
-  // Power consumption calculation - sub-systems consume power individually
-  sub->power_consumption = 0.1f; // Base consumption (emergency systems)
-
-  // Check if we have any power source
-  bool has_power = sub->battery_level > 0 || sub->backup_power_active;
-
-  // Main systems
-  if (sub->lights_active && has_power)
-    sub->power_consumption += LIGHT_POWER_DRAIN;
-  if (sub->sonar_active && has_power)
-    sub->power_consumption += SONAR_POWER_DRAIN;
-
-  // Reactor sub-systems
-  if (sub->reactor_coolant_pumps_active && has_power)
-    sub->power_consumption += 0.8f;
-  if (sub->reactor_steam_generator_active && has_power)
-    sub->power_consumption += 0.3f;
-  if (sub->reactor_power_turbine_active && has_power)
-    sub->power_consumption += 0.2f;
-  if (sub->reactor_containment_active && has_power)
-    sub->power_consumption += 0.4f;
-  if (sub->emergency_cooling_active && has_power)
-    sub->power_consumption += 1.5f; // High power consumption
-  if (sub->cooling_active && has_power)
-    sub->power_consumption += COOLING_SYSTEM_DRAIN;
-
-  // Life support sub-systems
-  if (sub->oxygen_scrubbers_active && has_power)
-    sub->power_consumption += 0.5f;
-  if (sub->oxygen_generator_active && has_power)
-    sub->power_consumption += 1.2f;
-  if (sub->air_circulation_active && has_power)
-    sub->power_consumption += 0.4f;
-  if (sub->hull_monitoring_active && has_power)
-    sub->power_consumption += 0.3f;
-
-  // Navigation sub-systems
-  if (sub->navigation_computer_active && has_power)
-    sub->power_consumption += 0.6f;
-  if (sub->gyroscope_active && has_power)
-    sub->power_consumption += 0.3f;
-  if (sub->depth_control_active && has_power)
-    sub->power_consumption += 0.7f;
-  if (sub->ballast_control_active && has_power)
-    sub->power_consumption += 0.5f;
-  if (sub->communications_active && has_power)
-    sub->power_consumption += 0.4f;
-
-  if (fabsf(sub->thrust) > 0 && has_power)
-    sub->power_consumption += PROPULSION_POWER_DRAIN * (fabsf(sub->thrust) / 100.0f);
-
-  // Backup power has its own consumption but reduces overall load
-  if (sub->backup_power_active)
+  if (system < 0 || system >= SYS_COUNT || !systemNames[system])
+    return "unknown";
+  return systemNames[system];
+}
+
+SubmarineSystem submarineSystemFromName(const char *name)
+{
+  for (int i = 0; i < SYS_COUNT; i++)
   {
-    sub->power_consumption += 0.5f; // Backup power consumes energy from battery
-    // But provides alternative power source for critical systems
+    if (systemNames[i] && strcmp(systemNames[i], name) == 0)
+      return (SubmarineSystem)i;
   }
+  return SYS_COUNT;
+}
 
-  // Water temperature based on depth
-  if (sub->depth < THERMAL_LAYER_DEPTH)
+// Apply one operator action. Returns false when an interlock or missing power
+// refuses it, exactly like clicking a dead button on the panel.
+bool applySubmarineCommand(SubmarineState *sub, SubmarineCommand cmd)
+{
+  // Panel switches need battery OR backup power, navigation needs a bit more
+  bool panel_power = sub->battery_level > 5 || systemOn(sub, SYS_BACKUP_POWER);
+  bool nav_power = sub->battery_level > 10 || systemOn(sub, SYS_BACKUP_POWER);
+  bool ballast_power = sub->battery_level > 0.0f || systemOn(sub, SYS_BACKUP_POWER);
+
+  switch (cmd.type)
   {
-    sub->water_temperature = 20.0f - (sub->depth / THERMAL_LAYER_DEPTH) * 15.0f;
-  }
-  else
+  // REACTOR SYSTEMS PANEL
+  case CMD_CONTROL_RODS: // NO battery requirement (manual operation)
+    toggleSystem(sub, SYS_CONTROL_RODS_INSERTED);
+    return true;
+  case CMD_ROD_POSITION: // Setpoint for the drives, which need power to move (kinetics.c)
+    if (!panel_power)
+      return false;
+    sub->rod_target = MAX(0.0f, MIN(100.0f, cmd.value)) / 100.0f;
+    return true;
+  case CMD_COOLANT_PUMPS:
+    if (!panel_power)
+      return false;
+    toggleSystem(sub, SYS_COOLANT_PUMPS);
+    return true;
+  case CMD_STEAM_GENERATOR:
+    if (!panel_power)
+      return false;
+    toggleSystem(sub, SYS_STEAM_GENERATOR);
+    return true;
+  case CMD_POWER_TURBINE:
+    if (!panel_power)
+      return false;
+    toggleSystem(sub, SYS_POWER_TURBINE);
+    return true;
+  case CMD_CONTAINMENT:
+    if (!panel_power)
+      return false;
+    toggleSystem(sub, SYS_CONTAINMENT);
+    return true;
+  case CMD_EMERGENCY_COOLING:
+    if (!(sub->battery_level > 10 || systemOn(sub, SYS_BACKUP_POWER)))
+      return false;
+    toggleSystem(sub, SYS_EMERGENCY_COOLING);
+    return true;
+  case CMD_MAIN_REACTOR: // NO battery requirement for manual start/stop
   {
-    sub->water_temperature = 5.0f - (sub->depth - THERMAL_LAYER_DEPTH) / 1000.0f;
+    bool reactor_can_operate = !systemOn(sub, SYS_CONTROL_RODS_INSERTED) &&
+                               allSystemsOn(sub, SYS_REACTOR_READY);
+    if (!reactor_can_operate && !systemOn(sub, SYS_REACTOR)) // Allow shutdown even without all systems
+      return false;
+    toggleSystem(sub, SYS_REACTOR);
+    return true;
   }
-  sub->water_temperature = MAX(2.0f, sub->water_temperature);
 
-  // Battery system
-  bool battery_overheated = sub->reactor_temp > 600.0f; // MUCH higher threshold
-  bool reactor_providing_power = sub->reactor_active && sub->reactor_power > 30.0f && !battery_overheated;
-
-  // Only drain battery if not being charged by reactor
-  if (!reactor_providing_power && sub->battery_level > 0)
+  // LIFE SUPPORT PANEL
+  case CMD_AIR_CIRCULATION:
+    if (!panel_power)
+      return false;
+    toggleSystem(sub, SYS_AIR_CIRCULATION);
+    return true;
+  case CMD_CO2_SCRUBBERS:
+    if (!panel_power)
+      return false;
+    toggleSystem(sub, SYS_CO2_SCRUBBERS);
+    return true;
+  case CMD_O2_GENERATOR:
+    if (!panel_power)
+      return false;
+    toggleSystem(sub, SYS_O2_GENERATOR);
+    return true;
+  case CMD_HULL_MONITORING:
+    if (!panel_power)
+      return false;
+    toggleSystem(sub, SYS_HULL_MONITORING);
+    return true;
+  case CMD_MAIN_O2_SYSTEM: // STRICT requirements
   {
-    float drain_multiplier = battery_overheated ? 2.0f : 1.0f;
-
-    // Only drain if systems are actually consuming power
-    if (has_power && sub->power_consumption > 0.1f)
+    if (!panel_power)
+      return false;
+    int active_subsystems = countSystemsOn(sub, SYS_O2_SUBSYSTEMS);
+    if (active_subsystems < 2 && !systemOn(sub, SYS_OXYGEN_SYSTEM))
+      return false;
+    toggleSystem(sub, SYS_OXYGEN_SYSTEM);
+    return true;
+  }
+  case CMD_BACKUP_POWER: // NO battery requirement (manual start)
+    toggleSystem(sub, SYS_BACKUP_POWER);
+    return true;
+
+  // NAVIGATION PANEL
+  case CMD_GYROSCOPE:
+    if (!nav_power)
+      return false;
+    toggleSystem(sub, SYS_GYROSCOPE);
+    return true;
+  case CMD_NAV_COMPUTER:
+    if (!nav_power)
+      return false;
+    toggleSystem(sub, SYS_NAV_COMPUTER);
+    return true;
+  case CMD_DEPTH_CONTROL:
+    if (!nav_power)
+      return false;
+    toggleSystem(sub, SYS_DEPTH_CONTROL);
+    return true;
+  case CMD_BALLAST_CONTROL:
+    if (!ballast_power)
+      return false;
+    toggleSystem(sub, SYS_BALLAST_CONTROL);
+    return true;
+  case CMD_COMMUNICATIONS:
+    if (!panel_power)
+      return false;
+    toggleSystem(sub, SYS_COMMUNICATIONS);
+    return true;
+
+  // EMERGENCY/GENERAL SYSTEMS PANEL - no power needed
+  case CMD_EMERGENCY_LIGHTING:
+    toggleSystem(sub, SYS_EMERGENCY_LIGHTING);
+    return true;
+  case CMD_EMERGENCY_COOLING_MANUAL:
+    toggleSystem(sub, SYS_EMERGENCY_COOLING);
+    return true;
+  case CMD_EMERGENCY_AIR:
+    toggleSystem(sub, SYS_EMERGENCY_AIR);
+    return true;
+  case CMD_BILGE_PUMPS:
+    toggleSystem(sub, SYS_BILGE_PUMPS);
+    return true;
+  case CMD_FIRE_SUPPRESSION:
+    toggleSystem(sub, SYS_FIRE_SUPPRESSION);
+    return true;
+  case CMD_BALLAST_BLOW:
+    toggleSystem(sub, SYS_BALLAST_BLOW);
+    if (systemOn(sub, SYS_BALLAST_BLOW))
     {
-      sub->battery_level = MAX(0, sub->battery_level -
-                                      (sub->power_consumption * BATTERY_DRAIN_RATE * drain_multiplier * deltaTime));
+      setSystem(sub, SYS_BALLAST_TANKS_FILLED, false);
+      setSystem(sub, SYS_EMERGENCY_SURFACE, true);
     }
-  }
-
-  if (battery_overheated && sub->battery_level > 0)
+    return true;
+  case CMD_DISTRESS_BEACON:
+    toggleSystem(sub, SYS_DISTRESS_BEACON);
+    return true;
+
+  // MAIN CONTROLS
+  case CMD_BALLAST: // Requires power for normal operation (emergency blow still works)
+    if (!ballast_power)
+      return false;
+    toggleSystem(sub, SYS_BALLAST_TANKS_FILLED);
+    setSystem(sub, SYS_AUTOPILOT, false); // Manual ballast overrides autopilot
+    setSystem(sub, SYS_AUTOPILOT_PREDICTIVE, false);
+    return true;
+  case CMD_LIGHTS:
+    if (sub->battery_level <= 5.0f)
+      return false;
+    toggleSystem(sub, SYS_LIGHTS);
+    return true;
+  case CMD_SONAR:
+    if (sub->battery_level <= 5.0f)
+      return false;
+    toggleSystem(sub, SYS_SONAR);
+    return true;
+  case CMD_EMERGENCY_SURFACE:
+    toggleSystem(sub, SYS_EMERGENCY_SURFACE);
+    return true;
+  case CMD_AUTOPILOT:
   {
-    sub->battery_level = MAX(0, sub->battery_level - 3.0f * deltaTime);
+    bool nav_operational = allSystemsOn(sub, SYS_NAV_OPERATIONAL);
+    if (!nav_operational)
+      return false;
+    toggleSystem(sub, SYS_AUTOPILOT);
+    setSystem(sub, SYS_AUTOPILOT_PREDICTIVE, false);
+    if (systemOn(sub, SYS_AUTOPILOT))
+      sub->target_depth = sub->depth;
+    return true;
   }
-
-  // Turn off systems that require power when power is lost
-  if (!has_power)
+  case CMD_PREDICTIVE_AUTOPILOT:
   {
-    sub->lights_active = false;
-    sub->sonar_active = false;
-    // Reactor systems already handled in updateReactorSubsystems
-    // Life support systems already handled in updateLifeSupportSubsystems
-    // Navigation systems already handled in updateNavigationSubsystems
+    if (systemOn(sub, SYS_AUTOPILOT) && systemOn(sub, SYS_AUTOPILOT_PREDICTIVE))
+    {
+      setSystem(sub, SYS_AUTOPILOT, false);
+      setSystem(sub, SYS_AUTOPILOT_PREDICTIVE, false);
+      return true;
+    }
+    if (!allSystemsOn(sub, SYS_NAV_OPERATIONAL))
+      return false;
+    setSystem(sub, SYS_AUTOPILOT, true);
+    setSystem(sub, SYS_AUTOPILOT_PREDICTIVE, true);
+    sub->target_depth = sub->depth;
+
+    // Hold whatever the boat is doing until the first plan arrives
+    sub->autopilot_ballast = sub->ballast_level;
+    sub->autopilot_trim = sub->trim_angle;
+    sub->autopilot_thrust = sub->thrust;
+    return true;
   }
-
-  // SUBMARINE INTERNAL TEMPERATURE CALCULATION
-  float base_internal_temp = sub->water_temperature + 10.0f; // Base: water temp + 10°C
-
-  // Reactor heat contribution
-  if (sub->reactor_active)
-  {
-    float reactor_heat_factor = (sub->reactor_temp - 50.0f) / 100.0f; // Heat above 50°C
-    reactor_heat_factor = MAX(0.0f, MIN(3.0f, reactor_heat_factor));  // Cap at 3x
-    base_internal_temp += reactor_heat_factor * 15.0f;                // Up to +45°C from reactor
+  case CMD_COOLING:
+    if (!systemOn(sub, SYS_COOLANT_PUMPS) && !systemOn(sub, SYS_EMERGENCY_COOLING))
+      return false;
+    toggleSystem(sub, SYS_COOLING);
+    return true;
+
+  // HELM
+  case CMD_HELM:
+    sub->helm_input = cmd.value < 0 ? -1 : (cmd.value > 0 ? 1 : 0);
+    return true;
+  case CMD_TARGET_DEPTH:
+    sub->target_depth = MAX(0.0f, MIN(MAX_DEPTH, cmd.value));
+    return true;
+  case CMD_COURSE:
+    sub->course = wrapHeading(cmd.value);
+    return true;
+
+  // PREDICTIVE AUTOPILOT SETPOINTS - only while it has the boat
+  case CMD_AUTOPILOT_BALLAST:
+  case CMD_AUTOPILOT_TRIM:
+  case CMD_AUTOPILOT_THRUST:
+    if (!systemOn(sub, SYS_AUTOPILOT) || !systemOn(sub, SYS_AUTOPILOT_PREDICTIVE))
+      return false;
+    if (cmd.type == CMD_AUTOPILOT_BALLAST)
+    {
+      sub->autopilot_ballast = MAX(0.0f, MIN(100.0f, cmd.value));
+      setSystem(sub, SYS_BALLAST_TANKS_FILLED, sub->autopilot_ballast > sub->ballast_level); // Panel shows the direction
+    }
+    else if (cmd.type == CMD_AUTOPILOT_TRIM)
+      sub->autopilot_trim = MAX(-30.0f, MIN(30.0f, cmd.value));
+    else
+      sub->autopilot_thrust = MAX(-100.0f, MIN(100.0f, cmd.value));
+    return true;
+
+  // SCENARIO FAULTS - the system trips out; the crew can try to bring it back
+  case CMD_SYSTEM_FAILURE:
+    if (cmd.value < 0.0f || cmd.value >= SYS_COUNT)
+      return false;
+    setSystem(sub, (SubmarineSystem)cmd.value, false);
+    return true;
+
+  // DAMAGE CONTROL - doors are hand-worked, no power needed
+  case CMD_WATERTIGHT_DOOR:
+    if (cmd.value < 0.0f)
+    {
+      uint32_t all = (1u << DOOR_COUNT) - 1;
+      sub->doors_shut = sub->doors_shut == all ? 0 : all;
+    }
+    else if (cmd.value < DOOR_COUNT)
+      sub->doors_shut ^= 1u << (int)cmd.value;
+    else
+      return false;
+    return true;
+
+  // ELECTRICAL PLANT - breakers are worked at the switchboard
+  case CMD_BREAKER:
+    if (cmd.value < 0.0f || cmd.value >= BREAKER_COUNT)
+      return false;
+    sub->breakers_open ^= 1u << (int)cmd.value;
+    return true;
+
+  default:
+    return false;
   }
+}
 
-  // Life support systems cooling effect
-  if (sub->air_circulation_active)
-  {
-    base_internal_temp -= 5.0f; // Air circulation cools
-  }
+// Small xorshift stream so runs are reproducible and boats don't share rand()
+static unsigned int nextRandom(SubmarineState *sub)
+{
+  unsigned int x = sub->rng_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  sub->rng_state = x;
+  return x;
+}
 
-  // Emergency cooling effect
-  if (sub->emergency_cooling_active)
+// Power draw per switch bit. Manual/pneumatic systems and status bits draw nothing.
+// The model reads params.h's copy, where the lights, sonar and cooling drains can be overridden.
+const float systemPowerDrawTable[64] = {
+    // Main systems
+    [SYS_LIGHTS] = LIGHT_POWER_DRAIN,
+    [SYS_SONAR] = SONAR_POWER_DRAIN,
+    [SYS_COOLING] = COOLING_SYSTEM_DRAIN,
+
+    // Reactor sub-systems
+    [SYS_COOLANT_PUMPS] = 0.8f,
+    [SYS_STEAM_GENERATOR] = 0.3f,
+    [SYS_POWER_TURBINE] = 0.2f,
+    [SYS_CONTAINMENT] = 0.4f,
+    [SYS_EMERGENCY_COOLING] = 1.5f, // High power consumption
+
+    // Life support sub-systems
+    [SYS_CO2_SCRUBBERS] = 0.5f,
+    [SYS_O2_GENERATOR] = 1.2f,
+    [SYS_AIR_CIRCULATION] = 0.4f,
+    [SYS_HULL_MONITORING] = 0.3f,
+
+    // Navigation sub-systems
+    [SYS_NAV_COMPUTER] = 0.6f,
+    [SYS_GYROSCOPE] = 0.3f,
+    [SYS_DEPTH_CONTROL] = 0.7f,
+    [SYS_BALLAST_CONTROL] = 0.5f,
+    [SYS_COMMUNICATIONS] = 0.4f,
+
+    // Backup power consumes energy from battery but keeps critical systems alive
+    [SYS_BACKUP_POWER] = 0.5f,
+};
+
+// Masked sum over all 64 bits - no branches, the compiler vectorizes it
+float systemsPowerDraw(uint64_t systems)
+{
+  const float *draw = activeSimParameters()->power_draw;
+  float total = 0.0f;
+  for (int bit = 0; bit < 64; bit++)
   {
-    base_internal_temp -= 8.0f; // Emergency cooling helps internal temp too
+    total += draw[bit] * (float)((systems >> bit) & 1);
   }
+  return total;
+}
 
-  // Depth pressure effect (deeper = colder hull)
-  float depth_factor = sub->depth / 1000.0f; // Per 1000m
-  base_internal_temp -= depth_factor * 2.0f;
+static void updatePowerAndEnvironment(SubmarineState *sub, float deltaTime)
+{
+  // Water temperature based on depth
+  sub->water_temperature = environmentField(ENV_WATER_TEMPERATURE, sub->depth);
 
-  // Hull breach effect (water flooding)
-  if (sub->hull_integrity < 50.0f)
-  {
-    float breach_factor = (50.0f - sub->hull_integrity) / 50.0f;
-    base_internal_temp = sub->water_temperature + (base_internal_temp - sub->water_temperature) * (1.0f - breach_factor);
-  }
+  // Battery system
+  bool battery_overheated = sub->reactor_temp > 600.0f; // MUCH higher threshold
+  bool reactor_providing_power = systemOn(sub, SYS_REACTOR) && sub->reactor_power > 30.0f && !battery_overheated;
+
+  // Buses, breakers and load shedding (electrical.c); the battery drains by
+  // the share of the load the turbine doesn't carry
+  updateElectricalPlant(sub, reactor_providing_power, battery_overheated ? 2.0f : 1.0f, deltaTime);
 
-  // Emergency heating
-  if (sub->emergency_lighting_active)
+  if (battery_overheated && sub->battery_level > 0)
   {
-    base_internal_temp += 2.0f; // Emergency lights provide some heat
+    sub->battery_level = MAX(0, sub->battery_level - 3.0f * deltaTime);
   }
 
-  // Smooth temperature change
-  float temp_change_rate = 0.5f; // How fast internal temp changes
-  sub->hull_temperature += (base_internal_temp - sub->hull_temperature) * temp_change_rate * deltaTime;
-  sub->hull_temperature = MAX(-10.0f, MIN(80.0f, sub->hull_temperature)); // Reasonable limits
+  // Cabin air temperature is a node of the reactor thermal network (thermal.c)
 }
 
 static void updateReactorSubsystems(SubmarineState *sub, float deltaTime)
 {
-  bool systems_powered = sub->battery_level > 5.0f || sub->backup_power_active;
-  bool battery_overheated = sub->reactor_temp > 600.0f;
-
-  // Systems fail when overheated at RUNAWAY temps, but backup power can keep them running
-  if (battery_overheated && !sub->backup_power_active)
-  {
-    sub->reactor_coolant_pumps_active = false;
-    sub->reactor_steam_generator_active = false;
-    sub->reactor_power_turbine_active = false;
-    if (sub->reactor_active)
-      sub->reactor_active = false; // Emergency shutdown
-  }
-  // Without any power, electric systems fail
-  else if (!systems_powered)
-  {
-    sub->reactor_coolant_pumps_active = false;
-    sub->reactor_steam_generator_active = false;
-    sub->reactor_power_turbine_active = false;
-  }
-
-  // REALISTIC CASCADING SHUTDOWNS:
-
-  // If coolant pumps fail while reactor is active and hot - EMERGENCY SHUTDOWN
-  if (sub->reactor_active && !sub->reactor_coolant_pumps_active && sub->reactor_temp > 100.0f)
-  {
-    sub->reactor_active = false; // Emergency shutdown - no coolant = danger
-  }
+  // Power loss, overheating, coolant and containment scrams are rules in subsystems.c
 
   // If steam generator fails - power generation stops
-  if (!sub->reactor_steam_generator_active && sub->reactor_active)
+  if (!systemOn(sub, SYS_STEAM_GENERATOR) && systemOn(sub, SYS_REACTOR))
   {
     // Reactor can stay on but won't generate power efficiently
     sub->reactor_power = MAX(0.0f, sub->reactor_power - 30.0f * deltaTime);
   }
 
   // If power turbine fails - no electrical generation
-  if (!sub->reactor_power_turbine_active && sub->reactor_active)
+  if (!systemOn(sub, SYS_POWER_TURBINE) && systemOn(sub, SYS_REACTOR))
   {
     // No electrical power generation from reactor
     // Battery won't charge even if reactor is running
   }
-
-  // If containment fails - reactor becomes dangerous
-  if (!sub->reactor_containment_active && sub->reactor_active && sub->reactor_temp > 200.0f)
-  {
-    // Force emergency shutdown if containment fails at high temps
-    sub->reactor_active = false;
-  }
 }
 
 static void updateLifeSupportSubsystems(SubmarineState *sub, float deltaTime)
 {
-  bool systems_powered = sub->battery_level > 5.0f || sub->backup_power_active;
-  bool battery_overheated = sub->reactor_temp > 600.0f;
-
-  // Life support sub-systems fail without power or when overheated
-  if (battery_overheated && !sub->backup_power_active)
-  {
-    sub->oxygen_scrubbers_active = false;
-    sub->oxygen_generator_active = false;
-    sub->air_circulation_active = false;
-    sub->oxygen_system_active = false;
-  }
-  else if (!systems_powered)
-  {
-    sub->oxygen_scrubbers_active = false;
-    sub->oxygen_generator_active = false;
-    sub->air_circulation_active = false;
-    sub->oxygen_system_active = false;
-  }
-
-  // REALISTIC LIFE SUPPORT DEPENDENCIES:
-
-  // Main O2 system requires at least 2 sub-systems active
-  int active_subsystems = (sub->oxygen_scrubbers_active ? 1 : 0) +
-                          (sub->oxygen_generator_active ? 1 : 0) +
-                          (sub->air_circulation_active ? 1 : 0);
-
-  // If main O2 system is on but not enough subsystems - automatic shutdown
-  if (sub->oxygen_system_active && active_subsystems < 2)
-  {
-    sub->oxygen_system_active = false;
-  }
+  // Power loss, overheating and the 2-of-3 sub-system rule for the main O2
+  // system are rules in subsystems.c
+  int active_subsystems = countSystemsOn(sub, SYS_O2_SUBSYSTEMS);
 
   // If O2 generator fails - scrubbers become critical
-  if (!sub->oxygen_generator_active && sub->oxygen_system_active)
+  if (!systemOn(sub, SYS_O2_GENERATOR) && systemOn(sub, SYS_OXYGEN_SYSTEM))
   {
     // O2 generation drops significantly
     // Crew must rely more on scrubbers and emergency air
   }
 
   // If air circulation fails - CO2 buildup accelerates
-  if (!sub->air_circulation_active && sub->oxygen_system_active)
+  if (!systemOn(sub, SYS_AIR_CIRCULATION) && systemOn(sub, SYS_OXYGEN_SYSTEM))
   {
     // Scrubbers work overtime, O2 consumption increases
   }
 
   // Enhanced oxygen consumption based on sub-system status
-  if (sub->oxygen_system_active && active_subsystems >= 2)
+  if (systemOn(sub, SYS_OXYGEN_SYSTEM) && active_subsystems >= 2)
   {
     float generation_rate = 1.5f;
 
@@ -533,7 +589,7 @@ static void updateLifeSupportSubsystems(SubmarineState *sub, float deltaTime)
 
     sub->oxygen = MIN(100, sub->oxygen + generation_rate * deltaTime);
   }
-  else if (sub->emergency_air_supply_active)
+  else if (systemOn(sub, SYS_EMERGENCY_AIR))
   {
     // Emergency air provides basic life support but limited
     float emergency_rate = 0.8f;
@@ -551,7 +607,7 @@ static void updateLifeSupportSubsystems(SubmarineState *sub, float deltaTime)
     }
 
     // No air circulation = CO2 buildup = much worse
-    if (!sub->air_circulation_active && !sub->emergency_air_supply_active)
+    if (!systemOn(sub, SYS_AIR_CIRCULATION) && !systemOn(sub, SYS_EMERGENCY_AIR))
     {
       consumption_rate *= 2.0f; // Double consumption
     }
@@ -560,82 +616,43 @@ static void updateLifeSupportSubsystems(SubmarineState *sub, float deltaTime)
   }
 }
 
-static void updateNavigationSubsystems(SubmarineState *sub)
+static void updateNavigationSubsystems(SubmarineState *sub, float deltaTime)
 {
-  bool systems_powered = sub->battery_level > 10.0f || sub->backup_power_active;
-  bool battery_overheated = sub->reactor_temp > 600.0f;
-
-  // Navigation systems fail without power or when overheated
-  if (battery_overheated && !sub->backup_power_active)
-  {
-    sub->navigation_computer_active = false;
-    sub->gyroscope_active = false;
-    sub->depth_control_active = false;
-    sub->autopilot_active = false;
-  }
-  else if (!systems_powered)
-  {
-    sub->navigation_computer_active = false;
-    sub->gyroscope_active = false;
-    sub->depth_control_active = false;
-    sub->autopilot_active = false;
-  }
+  // Power loss, overheating and the autopilot interlocks are rules in subsystems.c
 
   // REALISTIC NAVIGATION SYSTEM EFFECTS:
 
   // Without gyroscope - trim control becomes unstable
-  if (!sub->gyroscope_active)
+  if (!systemOn(sub, SYS_GYROSCOPE))
   {
     // Add random drift to trim angle
-    static float drift_timer = 0;
-    drift_timer += 0.016f;  // ~60fps
-    if (drift_timer > 2.0f) // Every 2 seconds
+    sub->gyro_drift_timer += deltaTime;
+    if (sub->gyro_drift_timer > 2.0f) // Every 2 seconds
     {
-      sub->trim_angle += (rand() % 3 - 1) * 0.5f; // Random drift ±0.5°
+      sub->trim_angle += ((int)(nextRandom(sub) % 3) - 1) * 0.5f; // Random drift ±0.5°
       sub->trim_angle = MAX(-20.0f, MIN(20.0f, sub->trim_angle));
-      drift_timer = 0;
+      sub->gyro_drift_timer = 0;
     }
   }
 
   // Without navigation computer - no precise depth readings
-  if (!sub->navigation_computer_active)
+  if (!systemOn(sub, SYS_NAV_COMPUTER))
   {
     // Depth readings become inaccurate (this affects display only)
     // Could add noise to depth display in renderer
   }
 
-  // Without depth control - ballast becomes manual only
-  if (!sub->depth_control_active)
-  {
-    // Autopilot cannot function
-    sub->autopilot_active = false;
-    // Ballast control becomes less precise
-  }
-
   // Ballast control affects ballast response
-  if (!sub->ballast_control_active)
+  if (!systemOn(sub, SYS_BALLAST_CONTROL))
   {
     // Ballast operates at 50% efficiency
     // This is handled in updatePhysics
   }
 
-  // Autopilot requires ALL navigation sub-systems
-  bool navigation_operational = sub->navigation_computer_active &&
-                                sub->gyroscope_active &&
-                                sub->depth_control_active &&
-                                sub->reactor_active;
-
-  if (sub->autopilot_active && !navigation_operational)
-  {
-    sub->autopilot_active = false;
-  }
-
-  // IMPROVED AUTOPILOT with PID control
-  if (sub->autopilot_active && navigation_operational)
+  // IMPROVED AUTOPILOT with PID control (the graph already dropped it if navigation is degraded).
+  // The predictive one works through setpoints instead, see updateHelm and updatePhysics.
+  if (systemOn(sub, SYS_AUTOPILOT) && !systemOn(sub, SYS_AUTOPILOT_PREDICTIVE))
   {
-    static float integral_error = 0.0f;
-    static float previous_error = 0.0f;
-
     float depth_error = sub->target_depth - sub->depth;
 
     // PID constants - tuned to prevent overshoot
@@ -644,26 +661,26 @@ static void updateNavigationSubsystems(SubmarineState *sub)
     float Kd = 0.08f;
 
     // Calculate PID terms
-    integral_error += depth_error * 0.016f;
-    integral_error = MAX(-50.0f, MIN(50.0f, integral_error));
+    sub->autopilot_integral += depth_error * deltaTime;
+    sub->autopilot_integral = MAX(-50.0f, MIN(50.0f, sub->autopilot_integral));
 
-    float derivative_error = (depth_error - previous_error) / 0.016f;
-    previous_error = depth_error;
+    float derivative_error = (depth_error - sub->autopilot_prev_error) / deltaTime;
+    sub->autopilot_prev_error = depth_error;
 
     // PID output
-    float control_output = (Kp * depth_error) + (Ki * integral_error) + (Kd * derivative_error);
+    float control_output = (Kp * depth_error) + (Ki * sub->autopilot_integral) + (Kd * derivative_error);
 
     // Apply control with deadband to prevent oscillation
     if (fabsf(depth_error) > 2.0f)
     {
       if (control_output > 0)
       {
-        sub->ballast_tanks_filled = true;
+        setSystem(sub, SYS_BALLAST_TANKS_FILLED, true);
         sub->trim_angle = MIN(10.0f, fabsf(control_output) * 2.0f);
       }
       else if (control_output < 0)
       {
-        sub->ballast_tanks_filled = false;
+        setSystem(sub, SYS_BALLAST_TANKS_FILLED, false);
         sub->trim_angle = MAX(-10.0f, -fabsf(control_output) * 2.0f);
       }
     }
@@ -681,104 +698,39 @@ static void updateNavigationSubsystems(SubmarineState *sub)
 
 static void updateReactor(SubmarineState *sub, float deltaTime)
 {
-  bool systems_powered = sub->battery_level > 5.0f || sub->backup_power_active;
+  const SimParameters *params = activeSimParameters();
+  bool systems_powered = sub->battery_level > 5.0f || systemOn(sub, SYS_BACKUP_POWER);
 
-  // Reactor heating - FASTER STARTUP WITH REALISTIC EXPONENTIAL HEATING
-  if (sub->reactor_active && !sub->reactor_control_rods_inserted)
-  {
-    // FAST STARTUP PHASE - when reactor is cold, heat up very quickly
-    if (sub->reactor_temp < REACTOR_NORMAL_TEMP * 0.5f) // Below 50% of normal temp
-    {
-      // Rapid startup heating
-      float startup_heating = REACTOR_WARMUP_RATE * deltaTime;
-      sub->reactor_temp += startup_heating;
-    }
-    else
-    {
-      // Normal operation heating with exponential curve
-      float base_heating = REACTOR_BASE_HEAT_RATE * deltaTime;
-
-      // Exponential heating based on current temperature (runaway effect)
-      float exponential_heating = sub->reactor_temp * REACTOR_EXPONENTIAL_FACTOR * deltaTime;
-
-      // Total heating rate increases exponentially with temperature
-      float total_heating = base_heating + exponential_heating;
-
-      sub->reactor_temp += total_heating;
-    }
-  }
-  else if (!sub->reactor_active || sub->reactor_control_rods_inserted)
-  {
-    // RESIDUAL/DECAY HEAT - reactors stay hot even when shut down
-    if (sub->reactor_temp > 20.0f) // Only if reactor has been heated
-    {
-      // Decay heat decreases over time but is always present
-      float decay_factor = MAX(0.1f, (sub->reactor_temp / REACTOR_NORMAL_TEMP));
-      float decay_heat = REACTOR_RESIDUAL_HEAT_RATE * decay_factor * deltaTime;
-      sub->reactor_temp += decay_heat;
-    }
-  }
+  // Core, coolant and cabin temperatures were already stepped by the
+  // thermal network (thermal.c) - this only handles trips and power output
 
-  // Cooling systems
-  float cooling_rate = 0.0f;
-
-  // Primary cooling (coolant pumps)
-  if (sub->reactor_coolant_pumps_active && systems_powered)
-  {
-    cooling_rate += REACTOR_COOL_RATE;
-  }
-
-  // Emergency cooling (more effective)
-  if (sub->emergency_cooling_active)
-  {
-    cooling_rate += REACTOR_EMERGENCY_COOL_RATE;
-  }
-
-  // Manual cooling system
-  if (sub->cooling_active)
-  {
-    cooling_rate += REACTOR_COOL_RATE * 0.8f;
-  }
-
-  // Apply cooling
-  sub->reactor_temp -= cooling_rate * deltaTime;
-
-  // Natural heat dissipation to hull (very slow)
-  float heat_dissipation = (sub->reactor_temp - sub->water_temperature) * 0.01f * deltaTime;
-  sub->reactor_temp -= heat_dissipation;
-
-  // Transfer heat to hull
-  if (sub->reactor_temp > sub->hull_temperature)
-  {
-    float heat_transfer = (sub->reactor_temp - sub->hull_temperature) * 0.005f * deltaTime;
-    sub->hull_temperature += heat_transfer;
-  }
-
-  // Minimum temperature (ambient)
-  sub->reactor_temp = MAX(sub->water_temperature, sub->reactor_temp);
-
-  // AUTOMATIC SAFETY SYSTEMS
-  if (sub->reactor_temp > REACTOR_SCRAM_TEMP && sub->reactor_active)
+  // AUTOMATIC SAFETY SYSTEMS - overtemperature and high flux
+  if ((sub->reactor_temp > REACTOR_SCRAM_TEMP || sub->neutron_power > REACTOR_OVERPOWER_TRIP) &&
+      systemOn(sub, SYS_REACTOR))
   {
     // Automatic reactor scram (emergency shutdown)
-    sub->reactor_active = false;
-    sub->reactor_control_rods_inserted = true;
+    setSystem(sub, SYS_REACTOR, false);
+    setSystem(sub, SYS_CONTROL_RODS_INSERTED, true);
   }
 
   // REACTOR DESTRUCTION
-  if (sub->reactor_temp > REACTOR_MELTDOWN_TEMP && !sub->reactor_destroyed)
+  if (sub->reactor_temp > REACTOR_MELTDOWN_TEMP && !systemOn(sub, SYS_REACTOR_DESTROYED))
   {
-    sub->reactor_destroyed = true;
-    sub->reactor_active = false;
+    setSystem(sub, SYS_REACTOR_DESTROYED, true);
+    setSystem(sub, SYS_REACTOR, false);
     sub->hull_integrity -= 50.0f;                       // Massive hull damage
     sub->reactor_temp = REACTOR_MELTDOWN_TEMP + 100.0f; // Stays very hot
+
+    // The blast opens the reactor compartment to the sea (flooding.h)
+    sub->breach_area[COMPARTMENT_REACTOR_COMPARTMENT] += 0.1f;
+    sub->flood_wet |= 1u << COMPARTMENT_REACTOR_COMPARTMENT;
   }
 
   // Power generation (only if all systems operational and not destroyed)
   // FASTER POWER GENERATION - start producing power at lower temperatures
-  if (sub->reactor_active && !sub->reactor_destroyed &&
-      sub->reactor_steam_generator_active &&
-      sub->reactor_power_turbine_active &&
+  if (systemOn(sub, SYS_REACTOR) && !systemOn(sub, SYS_REACTOR_DESTROYED) &&
+      systemOn(sub, SYS_STEAM_GENERATOR) &&
+      systemOn(sub, SYS_POWER_TURBINE) &&
       systems_powered)
   {
     // Power output based on temperature efficiency - LOWER threshold for power generation
@@ -796,14 +748,13 @@ static void updateReactor(SubmarineState *sub, float deltaTime)
       efficiency = 0.2f; // Poor efficiency when cold
     }
 
-    // FASTER power ramp-up - use a lower temperature threshold
-    float temp_factor = sub->reactor_temp / (REACTOR_NORMAL_TEMP * 0.7f); // Use 70% of normal temp as 100% power
-    sub->reactor_power = MIN(100.0f, temp_factor * 100.0f * efficiency);
+    // Output follows the fission rate (kinetics.c), derated by steam conditions
+    sub->reactor_power = MIN(100.0f, sub->neutron_power * 100.0f * efficiency);
 
     // Charge battery when reactor is producing power - LOWER threshold
     if (sub->reactor_power > 10.0f) // Reduced from 20% to 10%
     {
-      float charge_rate = (sub->reactor_power / 100.0f) * BATTERY_CHARGE_RATE * deltaTime;
+      float charge_rate = (sub->reactor_power / 100.0f) * params->battery_charge_rate * deltaTime;
       sub->battery_level += charge_rate;
       sub->battery_level = MIN(100.0f, sub->battery_level);
     }
@@ -816,96 +767,75 @@ static void updateReactor(SubmarineState *sub, float deltaTime)
 }
 static void updateCoolingSystem(SubmarineState *sub, float deltaTime)
 {
-  bool systems_powered = sub->battery_level > 10.0f || sub->backup_power_active;
-  bool cooling_systems_available = sub->reactor_coolant_pumps_active || sub->emergency_cooling_active;
+  bool systems_powered = sub->battery_level > 10.0f || systemOn(sub, SYS_BACKUP_POWER);
+  bool cooling_systems_available = systemOn(sub, SYS_COOLANT_PUMPS) || systemOn(sub, SYS_EMERGENCY_COOLING);
 
   // Turn off cooling if reactor is not active
-  if (!sub->reactor_active)
+  if (!systemOn(sub, SYS_REACTOR))
   {
-    sub->cooling_active = false;
+    setSystem(sub, SYS_COOLING, false);
     return;
   }
 
-  // ACTUALLY WORKING COOLING SYSTEM
-  if (sub->cooling_active && systems_powered && cooling_systems_available && !sub->reactor_destroyed)
-  {
-    // STRONG cooling that actually maintains temperature
-    float cooling_power = 500.0f; // Much stronger base cooling
-
-    // Emergency cooling is VERY effective
-    if (sub->emergency_cooling_active && sub->reactor_coolant_pumps_active)
-    {
-      cooling_power = 800.0f; // Extremely strong
-    }
-    else if (sub->emergency_cooling_active)
-    {
-      cooling_power = 650.0f; // Very strong
-    }
-
-    // Target temperature - stable at 120°C
-    float target_temp = sub->water_temperature + 95.0f;
-
-    // FORCE cooling towards target
-    if (sub->reactor_temp > target_temp)
-    {
-      float temp_diff = sub->reactor_temp - target_temp;
-      float cooling_rate = cooling_power + (temp_diff * 2.0f); // More cooling for higher temps
-      sub->reactor_temp = MAX(target_temp, sub->reactor_temp - cooling_rate * deltaTime);
-    }
-  }
-  else if (sub->cooling_active && (!systems_powered || !cooling_systems_available))
+  // The cooler itself is a loop in the thermal network (thermal.c), here it
+  // only trips when it loses power or has no coolant flow to work with
+  if (systemOn(sub, SYS_COOLING) && (!systems_powered || !cooling_systems_available))
   {
-    sub->cooling_active = false; // Cooling fails without power or pumps
+    setSystem(sub, SYS_COOLING, false); // Cooling fails without power or pumps
   }
 }
 static void updateSonar(SubmarineState *sub, float deltaTime)
 {
   bool systems_powered = sub->battery_level > 10.0f && sub->reactor_temp < 150.0f;
 
-  if (sub->sonar_active && systems_powered)
+  if (systemOn(sub, SYS_SONAR) && systems_powered)
   {
     sub->sonar_ping_timer += deltaTime;
 
     if (sub->sonar_ping_timer >= SONAR_PING_INTERVAL)
     {
       sub->sonar_ping_timer = 0.0f;
-
-      if (audioInitialized && !IsSoundPlaying(sonarPing))
-      {
-        float depth_factor = 1.0f - (sub->depth / SONAR_RANGE) * 0.3f;
-        depth_factor = MAX(0.3f, depth_factor);
-        SetSoundVolume(sonarPing, 0.6f * depth_factor);
-        PlaySound(sonarPing);
-      }
+      sub->sonar_ping_count++; // The UI side turns this into a ping sound
     }
   }
   else
   {
     sub->sonar_ping_timer = 0.0f;
-    if (sub->sonar_active && !systems_powered)
+    if (systemOn(sub, SYS_SONAR) && !systems_powered)
     {
-      sub->sonar_active = false;
+      setSystem(sub, SYS_SONAR, false);
     }
   }
 }
 
+// Hull taken onto the bottom at speed (m/s into it)
+static void groundingDamage(SubmarineState *sub, float speed)
+{
+  float excess = fabsf(speed) - SEABED_GROUNDING_SPEED;
+  if (excess > 0.0f)
+    sub->hull_integrity = MAX(0.0f, sub->hull_integrity - excess * SEABED_GROUNDING_DAMAGE);
+}
+
 // Replace the updatePhysics function with this much more aggressive version:
 
 static void updatePhysics(SubmarineState *sub, float deltaTime)
 {
+  const SimParameters *params = activeSimParameters();
   // Ballast tank physics - more realistic timing
   // ONLY work if ballast control is active AND has power (battery > 0 OR backup power)
-  bool ballast_has_power = sub->battery_level > 0.0f || sub->backup_power_active;
+  bool ballast_has_power = sub->battery_level > 0.0f || systemOn(sub, SYS_BACKUP_POWER);
+  bool level_control = systemOn(sub, SYS_BALLAST_CONTROL) && ballast_has_power && systemOn(sub, SYS_AUTOPILOT) &&
+                       systemOn(sub, SYS_AUTOPILOT_PREDICTIVE);
 
-  if (sub->ballast_control_active && ballast_has_power)
+  if (systemOn(sub, SYS_BALLAST_CONTROL) && ballast_has_power && !level_control)
   {
-    if (sub->ballast_tanks_filled && sub->ballast_level < 100.0f)
+    if (systemOn(sub, SYS_BALLAST_TANKS_FILLED) && sub->ballast_level < 100.0f)
     {
-      sub->ballast_level = MIN(100.0f, sub->ballast_level + BALLAST_FILL_RATE * deltaTime);
+      sub->ballast_level = MIN(100.0f, sub->ballast_level + params->ballast_fill_rate * deltaTime);
     }
-    else if (!sub->ballast_tanks_filled && sub->ballast_level > 0.0f)
+    else if (!systemOn(sub, SYS_BALLAST_TANKS_FILLED) && sub->ballast_level > 0.0f)
     {
-      sub->ballast_level = MAX(0.0f, sub->ballast_level - BALLAST_EMPTY_RATE * deltaTime);
+      sub->ballast_level = MAX(0.0f, sub->ballast_level - params->ballast_empty_rate * deltaTime);
     }
   }
   else if (!ballast_has_power)
@@ -915,9 +845,9 @@ static void updatePhysics(SubmarineState *sub, float deltaTime)
   }
 
   // Emergency ballast blow (always works - it's manual/pneumatic)
-  if (sub->manual_ballast_blow_active && sub->ballast_level > 0.0f)
+  if (systemOn(sub, SYS_BALLAST_BLOW) && sub->ballast_level > 0.0f)
   {
-    sub->ballast_level = MAX(0.0f, sub->ballast_level - BALLAST_EMPTY_RATE * 4.0f * deltaTime);
+    sub->ballast_level = MAX(0.0f, sub->ballast_level - params->ballast_empty_rate * 4.0f * deltaTime);
   }
 
   // MUCH MORE AGGRESSIVE BALLAST PHYSICS
@@ -927,27 +857,24 @@ static void updatePhysics(SubmarineState *sub, float deltaTime)
   // DIRECT linear effect - much more powerful
   float ballast_weight = ballast_factor * 50.0f; // Up to ±25 m/s target speed (INCREASED!)
 
-  // Hull breach flooding - makes submarine much heavier
-  if (sub->hull_integrity < 50.0f)
-  {
-    float flood_weight = (50.0f - sub->hull_integrity) / 50.0f * 12.0f; // Up to +12 m/s down
-    ballast_weight += flood_weight;
-  }
+  // Sea aboard from the compartments (flooding.h) - makes submarine much heavier
+  if (sub->flood_wet)
+    ballast_weight += floodTotalWater(sub) / floodHullVolume() * FLOOD_WEIGHT;
 
   // Navigation precision affects control but not force
   float nav_precision = 1.0f;
-  if (!sub->gyroscope_active)
+  if (!systemOn(sub, SYS_GYROSCOPE))
     nav_precision *= 0.85f;
-  if (!sub->depth_control_active)
+  if (!systemOn(sub, SYS_DEPTH_CONTROL))
     nav_precision *= 0.9f;
-  if (!sub->ballast_control_active || !ballast_has_power)
+  if (!systemOn(sub, SYS_BALLAST_CONTROL) || !ballast_has_power)
     nav_precision *= 0.5f; // MAJOR impact when ballast control fails
 
   // Trim angle - more responsive
   float trim_effect = sinf(sub->trim_angle * DEG2RAD) * 6.0f * nav_precision; // INCREASED
 
   // Thrust - direct effect
-  float thrust_effect = sub->thrust * 0.12f; // INCREASED
+  float thrust_effect = sub->thrust * 0.12f * sub->propulsion_supply; // INCREASED; a browned-out shaft turns slower
 
   // Calculate target vertical speed
   float target_speed = (ballast_weight + trim_effect + thrust_effect) * nav_precision;
@@ -964,26 +891,37 @@ static void updatePhysics(SubmarineState *sub, float deltaTime)
   sub->vertical_speed += speed_diff * acceleration_rate * deltaTime;
 
   // Less water drag - submarine moves more freely
-  float drag_coefficient = 0.92f; // REDUCED drag (was 0.88f)
-  sub->vertical_speed *= powf(drag_coefficient, deltaTime * 60.0f);
+  sub->vertical_speed *= waterDrag(deltaTime);
 
   // Update depth
+  float keel_floor = MAX(0.0f, sub->bottom_depth - SEABED_KEEL_DEPTH);
+  bool resting = sub->depth >= keel_floor;
   sub->depth += sub->vertical_speed * deltaTime;
   sub->depth = MAX(0.0f, MIN(MAX_DEPTH, sub->depth));
 
+  // Settling onto the seabed - the keel stops on it, and only the landing
+  // itself can dent the hull, not lying there heavy
+  if (seabedTerrain && sub->depth > keel_floor)
+  {
+    sub->depth = keel_floor;
+    if (!resting)
+      groundingDamage(sub, sub->vertical_speed);
+    sub->vertical_speed = MIN(0.0f, sub->vertical_speed);
+  }
+
   // Surface effects
   if (sub->depth <= 0.0f)
   {
     sub->depth = 0.0f;
     sub->vertical_speed = MAX(0.0f, sub->vertical_speed);
-    sub->emergency_surface = false;
+    setSystem(sub, SYS_EMERGENCY_SURFACE, false);
   }
 
   // Emergency surface - EXTREMELY aggressive
-  if (sub->emergency_surface)
+  if (systemOn(sub, SYS_EMERGENCY_SURFACE))
   {
-    sub->ballast_tanks_filled = false;
-    sub->manual_ballast_blow_active = true;
+    setSystem(sub, SYS_BALLAST_TANKS_FILLED, false);
+    setSystem(sub, SYS_BALLAST_BLOW, true);
     sub->thrust = -100.0f; // Maximum reverse thrust
 
     // Force VERY rapid emergency ascent
@@ -1001,25 +939,57 @@ static void updatePhysics(SubmarineState *sub, float deltaTime)
     sub->hull_integrity = MAX(0.0f, sub->hull_integrity - damage_rate * deltaTime);
   }
 
-  // Hull breach flooding - MUCH more severe and realistic
-  if (sub->hull_integrity < 25.0f)
+  // Predictive autopilot throttles the valves onto its level setpoint - last,
+  // so the tanks settle the same at any step size (the planner flies coarser steps)
+  if (level_control)
   {
-    // Water flooding rapidly increases ballast
-    float breach_severity = (25.0f - sub->hull_integrity) / 25.0f;
-    float flood_rate = breach_severity * 40.0f; // INCREASED flooding rate
-    sub->ballast_level = MIN(100.0f, sub->ballast_level + flood_rate * deltaTime);
-
-    // Power systems affected by flooding
-    if (sub->hull_integrity < 10.0f && sub->battery_level > 0)
-    {
-      sub->battery_level = MAX(0.0f, sub->battery_level - 5.0f * deltaTime);
-    }
+    float level_diff = sub->autopilot_ballast - sub->ballast_level;
+    sub->ballast_level += MAX(-params->ballast_empty_rate * deltaTime, MIN(params->ballast_fill_rate * deltaTime, level_diff));
   }
 
   // Speed calculation for display
   sub->speed = fabsf(sub->vertical_speed) * 3.6f;
 }
 
+// Along-track motion: the shaft drives the boat through the water, the helm
+// turns it onto the ordered course, and the current where it is sets it over
+// the ground - unless the ground ahead rises above the keel
+static void updateNavigation(SubmarineState *sub, float deltaTime)
+{
+  // Speed through the water closes on what the shaft turns for in MAX_SPEED / ACCELERATION seconds
+  float shaft_speed = MAX_SPEED * sub->thrust / 100.0f * sub->propulsion_supply;
+  sub->forward_speed += (shaft_speed - sub->forward_speed) * MIN(1.0f, ACCELERATION / MAX_SPEED * deltaTime);
+
+  // Course keeping needs the gyro and power for the steering gear; the
+  // rudder only bites with water flowing past it
+  bool steering_power = sub->battery_level > 0.0f || systemOn(sub, SYS_BACKUP_POWER);
+  if (systemOn(sub, SYS_GYROSCOPE) && steering_power)
+  {
+    float turn = NAV_TURN_RATE * MIN(1.0f, fabsf(sub->forward_speed) / MAX_SPEED) * deltaTime;
+    sub->heading = wrapHeading(sub->heading + MAX(-turn, MIN(turn, headingDifference(sub->course, sub->heading))));
+  }
+
+  CurrentSample current = sampleCurrent(oceanCurrents, (float)sub->east, (float)sub->north, sub->depth);
+  sub->current_east = current.east;
+  sub->current_north = current.north;
+
+  float heading = sub->heading * DEG2RAD;
+  double east = sub->east + (sub->forward_speed * sinf(heading) + current.east) * deltaTime;
+  double north = sub->north + (sub->forward_speed * cosf(heading) + current.north) * deltaTime;
+
+  // Ground rising above the keel ahead stops the boat where it is
+  float bottom = seabedDepth(seabedTerrain, east, north);
+  if (seabedTerrain && bottom - SEABED_KEEL_DEPTH < sub->depth)
+  {
+    groundingDamage(sub, sub->forward_speed);
+    sub->forward_speed = 0.0f;
+    return;
+  }
+  sub->east = east;
+  sub->north = north;
+  sub->bottom_depth = bottom;
+}
+
 static void updateNitrogenNarcosis(SubmarineState *sub, float deltaTime)
 {
   // Nitrogen narcosis starts affecting crew at depths > 1000m
@@ -1043,18 +1013,183 @@ static void updateNitrogenNarcosis(SubmarineState *sub, float deltaTime)
   }
 }
 
+// Manual helm - thrust and trim follow the held dive key, autopilot target moves instead when engaged
+static void updateHelm(SubmarineState *sub, float deltaTime)
+{
+  bool rise = sub->helm_input < 0;
+  bool dive = sub->helm_input > 0;
+
+  // Predictive autopilot drives planes and shaft at their manual slew rates,
+  // the dive key still moves the target
+  if (systemOn(sub, SYS_AUTOPILOT) && systemOn(sub, SYS_AUTOPILOT_PREDICTIVE))
+  {
+    if (rise)
+      sub->target_depth = MAX(0, sub->target_depth - 50.0f * deltaTime);
+    if (dive)
+      sub->target_depth = MIN(MAX_DEPTH, sub->target_depth + 50.0f * deltaTime);
+
+    float trim_step = 30.0f * deltaTime, thrust_step = 50.0f * deltaTime;
+    sub->trim_angle += MAX(-trim_step, MIN(trim_step, sub->autopilot_trim - sub->trim_angle));
+    sub->thrust += MAX(-thrust_step, MIN(thrust_step, sub->autopilot_thrust - sub->thrust));
+    return;
+  }
+
+  if (!systemOn(sub, SYS_AUTOPILOT))
+  {
+    if (rise && systemOn(sub, SYS_REACTOR))
+    {
+      sub->trim_angle = MAX(-30.0f, sub->trim_angle - 30.0f * deltaTime);
+      sub->thrust = MIN(100.0f, sub->thrust + 50.0f * deltaTime);
+    }
+    else if (dive)
+    {
+      sub->trim_angle = MIN(30.0f, sub->trim_angle + 30.0f * deltaTime);
+      sub->thrust = MAX(-50.0f, sub->thrust - 30.0f * deltaTime);
+    }
+    else
+    {
+      // Same settle rate as the old per-frame decay at 60fps
+      sub->trim_angle *= powf(0.9f, deltaTime * 60.0f);
+      sub->thrust *= powf(0.95f, deltaTime * 60.0f);
+    }
+  }
+  else
+  {
+    if (rise)
+      sub->target_depth = MAX(0, sub->target_depth - 50.0f * deltaTime);
+    if (dive)
+      sub->target_depth = MIN(MAX_DEPTH, sub->target_depth + 50.0f * deltaTime);
+  }
+
+  if (rise)
+  {
+    sub->thrust = MIN(100.0f, sub->thrust + 50.0f * deltaTime);
+  }
+  else if (dive)
+  {
+    sub->thrust = MAX(-100.0f, sub->thrust - 50.0f * deltaTime);
+  }
+  else
+  {
+    // Gradually reduce thrust when no input
+    if (sub->thrust > 0)
+      sub->thrust = MAX(0, sub->thrust - 25.0f * deltaTime);
+    else if (sub->thrust < 0)
+      sub->thrust = MIN(0, sub->thrust + 25.0f * deltaTime);
+  }
+}
+
+// Blend two consecutive ticks for rendering. Continuous values are lerped,
+// switches and counters are taken from the newer tick.
+SubmarineState interpolateSubmarineState(const SubmarineState *prev, const SubmarineState *curr, float alpha)
+{
+  SubmarineState out = *curr;
+  alpha = MAX(0.0f, MIN(1.0f, alpha));
+
+#define LERP_FIELD(f) out.f = prev->f + (curr->f - prev->f) * alpha
+  LERP_FIELD(depth);
+  LERP_FIELD(speed);
+  LERP_FIELD(vertical_speed);
+  LERP_FIELD(oxygen);
+  LERP_FIELD(reactor_temp);
+  LERP_FIELD(hull_integrity);
+  LERP_FIELD(battery_level);
+  LERP_FIELD(nitrogen_level);
+  LERP_FIELD(pressure_hull_stress);
+  LERP_FIELD(power_consumption);
+  LERP_FIELD(power_supply);
+  LERP_FIELD(ballast_level);
+  LERP_FIELD(thrust);
+  LERP_FIELD(trim_angle);
+  LERP_FIELD(reactor_power);
+  LERP_FIELD(hull_temperature);
+  LERP_FIELD(water_temperature);
+  LERP_FIELD(coolant_temp);
+  LERP_FIELD(steam_generator_temp);
+  LERP_FIELD(neutron_power);
+  LERP_FIELD(rod_position);
+  LERP_FIELD(north);
+  LERP_FIELD(east);
+  LERP_FIELD(bottom_depth);
+  LERP_FIELD(forward_speed);
+#undef LERP_FIELD
+
+  // The short way round through north
+  out.heading = wrapHeading(prev->heading + headingDifference(curr->heading, prev->heading) * alpha);
+
+  return out;
+}
+
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+{
+  const unsigned char *bytes = data;
+  for (size_t i = 0; i < size; i++)
+    hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  return hash;
+}
+
+uint64_t submarineStateHash(const SubmarineState *sub)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL;
+#define HASH_FIELD(name) hash = hashBytes(hash, &sub->name, sizeof(sub->name));
+  SUBMARINE_STATE_FIELDS(HASH_FIELD)
+#undef HASH_FIELD
+  return hash;
+}
+
+static void updateSubsystemCascades(SubmarineState *sub, float deltaTime)
+{
+  (void)deltaTime;
+  updateSubsystemGraph(sub);
+}
+
+static void updateDamageControl(SubmarineState *sub, float deltaTime)
+{
+  updateFlooding(sub, deltaTime);
+}
+
+// Same order as updateSubmarineState, which calls them directly so they can inline
+const SubmarineStage submarineStages[] = {
+    {"helm", updateHelm},
+    {"subsystem_graph", updateSubsystemCascades},
+    {"reactor_subsystems", updateReactorSubsystems},
+    {"life_support_subsystems", updateLifeSupportSubsystems},
+    {"navigation_subsystems", updateNavigationSubsystems},
+    {"cooling_system", updateCoolingSystem},
+    {"neutronics", updateReactorKinetics},
+    {"thermal_network", updateThermalNetwork},
+    {"reactor", updateReactor},
+    {"power_and_environment", updatePowerAndEnvironment},
+    {"flooding", updateDamageControl},
+    {"physics", updatePhysics},
+    {"navigation", updateNavigation},
+    {"sonar", updateSonar},
+    {"nitrogen_narcosis", updateNitrogenNarcosis},
+};
+const int submarineStageCount = sizeof(submarineStages) / sizeof(submarineStages[0]);
+
 void updateSubmarineState(SubmarineState *sub, float deltaTime)
 {
-  // Update all subsystems
+  // Apply helm input for this tick
+  updateHelm(sub, deltaTime);
+
+  // Settle the cascading shutdowns, then update all subsystems
+  updateSubsystemGraph(sub);
   updateReactorSubsystems(sub, deltaTime);
   updateLifeSupportSubsystems(sub, deltaTime);
-  updateNavigationSubsystems(sub);
+  updateNavigationSubsystems(sub, deltaTime);
   updateCoolingSystem(sub, deltaTime);
+  updateReactorKinetics(sub, deltaTime);
+  updateThermalNetwork(sub, deltaTime);
   updateReactor(sub, deltaTime);
   updatePowerAndEnvironment(sub, deltaTime);
 
-  // Update physics
+  // Water through breaches and doors, then the physics that carries it
+  updateFlooding(sub, deltaTime);
+
+  // Update physics, then where the boat has got to
   updatePhysics(sub, deltaTime);
+  updateNavigation(sub, deltaTime);
 
   // Update sonar
   updateSonar(sub, deltaTime);
@@ -0,0 +1,146 @@
+#define _POSIX_C_SOURCE 200112L
+#include "subsystems.h"
+#include <pthread.h>
+
+// Cascading shutdowns, upstream first. Rules only ever switch things off, so
+// settling always terminates - at worst every bit gets cleared once.
+static const SubsystemRule subsystemRules[] = {
+    // Runaway heat cooks the electronics unless backup power carries them
+    {"overheat_reactor", SYS_REACTOR_ELECTRIC | SYS_BIT(SYS_REACTOR), SIG_BIT(SIG_OVERHEATED), SYS_BIT(SYS_BACKUP_POWER), 0, 0, 0},
+    {"overheat_life_support", SYS_LIFE_SUPPORT, SIG_BIT(SIG_OVERHEATED), SYS_BIT(SYS_BACKUP_POWER), 0, 0, 0},
+    {"overheat_navigation", SYS_NAVIGATION, SIG_BIT(SIG_OVERHEATED), SYS_BIT(SYS_BACKUP_POWER), 0, 0, 0},
+
+    // Without any power, electric systems fail
+    {"unpowered_reactor", SYS_REACTOR_ELECTRIC, 0, SIG_BIT(SIG_PANEL_POWER), 0, 0, 0},
+    {"unpowered_life_support", SYS_LIFE_SUPPORT, 0, SIG_BIT(SIG_PANEL_POWER), 0, 0, 0},
+    {"unpowered_navigation", SYS_NAVIGATION, 0, SIG_BIT(SIG_NAV_POWER), 0, 0, 0},
+
+    // No coolant while hot = emergency shutdown, same for a containment failure
+    {"coolant_loss_scram", SYS_BIT(SYS_REACTOR), SYS_BIT(SYS_REACTOR) | SIG_BIT(SIG_REACTOR_HOT), SYS_BIT(SYS_COOLANT_PUMPS), 0, 0, 0},
+    {"containment_loss_scram", SYS_BIT(SYS_REACTOR), SYS_BIT(SYS_REACTOR) | SIG_BIT(SIG_REACTOR_VERY_HOT), SYS_BIT(SYS_CONTAINMENT), 0, 0, 0},
+
+    // Main O2 system requires at least 2 sub-systems active
+    {"o2_undersupplied", SYS_BIT(SYS_OXYGEN_SYSTEM), SYS_BIT(SYS_OXYGEN_SYSTEM), 0, 0, SYS_O2_SUBSYSTEMS, 2},
+
+    // Autopilot needs depth control, and ALL navigation sub-systems plus the reactor
+    {"autopilot_no_depth_control", SYS_BIT(SYS_AUTOPILOT), 0, SYS_BIT(SYS_DEPTH_CONTROL), 0, 0, 0},
+    {"autopilot_nav_degraded", SYS_BIT(SYS_AUTOPILOT), SYS_BIT(SYS_AUTOPILOT), 0, SYS_NAV_OPERATIONAL, 0, 0},
+};
+
+#define RULE_COUNT ((int)(sizeof(subsystemRules) / sizeof(subsystemRules[0])))
+#define RULE_WORDS ((RULE_COUNT + 63) / 64)
+
+// Reverse edges: which rules read each signal bit
+static uint64_t ruleReaders[64][RULE_WORDS];
+static pthread_once_t readersOnce = PTHREAD_ONCE_INIT;
+
+static void buildRuleReaders(void)
+{
+  for (int r = 0; r < RULE_COUNT; r++)
+  {
+    const SubsystemRule *rule = &subsystemRules[r];
+    uint64_t inputs = rule->when_all | rule->when_none | rule->unless_all | rule->count_mask | rule->targets;
+    for (int bit = 0; bit < 64; bit++)
+    {
+      if ((inputs >> bit) & 1)
+        ruleReaders[bit][r / 64] |= 1ULL << (r % 64);
+    }
+  }
+}
+
+int subsystemRuleCount(void)
+{
+  return RULE_COUNT;
+}
+
+const SubsystemRule *subsystemRule(int index)
+{
+  return index >= 0 && index < RULE_COUNT ? &subsystemRules[index] : NULL;
+}
+
+uint64_t subsystemSignals(const SubmarineState *sub)
+{
+  bool backup = systemOn(sub, SYS_BACKUP_POWER);
+  uint64_t signals = sub->systems;
+  if (sub->battery_level > 5.0f || backup)
+    signals |= SIG_BIT(SIG_PANEL_POWER);
+  if (sub->battery_level > 10.0f || backup)
+    signals |= SIG_BIT(SIG_NAV_POWER);
+  if (sub->reactor_temp > 600.0f)
+    signals |= SIG_BIT(SIG_OVERHEATED);
+  if (sub->reactor_temp > 100.0f)
+    signals |= SIG_BIT(SIG_REACTOR_HOT);
+  if (sub->reactor_temp > 200.0f)
+    signals |= SIG_BIT(SIG_REACTOR_VERY_HOT);
+  return signals;
+}
+
+static bool ruleFires(const SubsystemRule *rule, uint64_t signals)
+{
+  if ((signals & rule->when_all) != rule->when_all)
+    return false;
+  if (signals & rule->when_none)
+    return false;
+  if (rule->unless_all && (signals & rule->unless_all) == rule->unless_all)
+    return false;
+  if (rule->count_mask && __builtin_popcountll(signals & rule->count_mask) >= rule->min_count)
+    return false;
+  return true;
+}
+
+static void markReaders(uint64_t dirty[RULE_WORDS], uint64_t changed)
+{
+  while (changed)
+  {
+    int bit = __builtin_ctzll(changed);
+    changed &= changed - 1;
+    for (int w = 0; w < RULE_WORDS; w++)
+      dirty[w] |= ruleReaders[bit][w];
+  }
+}
+
+int updateSubsystemGraph(SubmarineState *sub)
+{
+  pthread_once(&readersOnce, buildRuleReaders);
+
+  // Nothing moved since the graph last settled - no rule can change its answer.
+  // Rules read their own targets, so a zeroed baseline (fresh boat) dirties
+  // every rule that still has something to switch off.
+  uint64_t signals = subsystemSignals(sub);
+  uint64_t changed = signals ^ sub->subsystem_inputs;
+  if (changed == 0)
+    return 0;
+
+  uint64_t dirty[RULE_WORDS] = {0};
+  markReaders(dirty, changed);
+
+  // Work through dirty rules lowest index first. A rule that clears bits
+  // dirties its readers, which may sit earlier in the table, so rescan.
+  int evaluated = 0;
+  int w = 0;
+  while (w < RULE_WORDS)
+  {
+    if (dirty[w] == 0)
+    {
+      w++;
+      continue;
+    }
+
+    int r = w * 64 + __builtin_ctzll(dirty[w]);
+    dirty[w] &= dirty[w] - 1;
+    evaluated++;
+
+    const SubsystemRule *rule = &subsystemRules[r];
+    uint64_t cleared = signals & rule->targets;
+    if (cleared && ruleFires(rule, signals))
+    {
+      signals &= ~cleared;
+      markReaders(dirty, cleared);
+      w = 0;
+    }
+  }
+
+  sub->systems = signals & (SYS_BIT(SYS_COUNT) - 1);
+  sub->subsystem_inputs = signals;
+  return evaluated;
+}
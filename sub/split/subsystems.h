@@ -0,0 +1,49 @@
+#ifndef SUBSYSTEMS_H
+#define SUBSYSTEMS_H
+
+#include "constants.h"
+
+// Subsystem dependency graph. The cascading shutdowns (no coolant -> scram,
+// too few O2 sub-systems -> O2 off, nav loss -> autopilot off ...) are rows
+// in a rule table instead of if-chains. Each tick only the rules downstream
+// of a signal that actually changed get re-evaluated.
+
+// Derived signals (power buses, temperature thresholds) share the 64-bit word
+// with the switch bits, packed right above them
+typedef enum
+{
+  SIG_PANEL_POWER = SYS_COUNT, // Battery > 5 or backup - reactor and life support panels
+  SIG_NAV_POWER,               // Battery > 10 or backup - navigation panel
+  SIG_OVERHEATED,              // Reactor > 600, batteries and electronics cooking
+  SIG_REACTOR_HOT,             // Reactor > 100, too hot to run without coolant
+  SIG_REACTOR_VERY_HOT,        // Reactor > 200, too hot to run without containment
+
+  SIG_COUNT
+} SubsystemSignal;
+
+#define SIG_BIT(s) (1ULL << (s))
+
+// A rule switches `targets` off while it fires. It fires when every bit of
+// when_all is set, no bit of when_none is set, not all of unless_all are set,
+// and fewer than min_count bits of count_mask are set (zero masks always pass).
+typedef struct
+{
+  const char *name;
+  uint64_t targets;
+  uint64_t when_all;
+  uint64_t when_none;
+  uint64_t unless_all;
+  uint64_t count_mask;
+  int min_count;
+} SubsystemRule;
+
+int subsystemRuleCount(void);
+const SubsystemRule *subsystemRule(int index);
+
+// Switch + derived signal word for the current state
+uint64_t subsystemSignals(const SubmarineState *sub);
+
+// Settle the graph for this tick, returns how many rules were evaluated
+int updateSubsystemGraph(SubmarineState *sub);
+
+#endif
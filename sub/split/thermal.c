@@ -0,0 +1,166 @@
+#include "params.h"
+#include "thermal.h"
+
+// Cabin air temperature the environment alone would settle at - water temp
+// plus the life support offsets. The reactor's share arrives through the network.
+static float cabinTarget(const SubmarineState *sub)
+{
+  float target = sub->water_temperature + 10.0f;
+
+  // Life support systems cooling effect
+  if (systemOn(sub, SYS_AIR_CIRCULATION))
+    target -= 5.0f;
+
+  // Emergency cooling helps internal temp too
+  if (systemOn(sub, SYS_EMERGENCY_COOLING))
+    target -= 8.0f;
+
+  // Depth pressure effect (deeper = colder hull)
+  target -= sub->depth / 1000.0f * 2.0f;
+
+  // Hull breach effect (water flooding)
+  if (sub->hull_integrity < 50.0f)
+  {
+    float breach_factor = (50.0f - sub->hull_integrity) / 50.0f;
+    target = sub->water_temperature + (target - sub->water_temperature) * (1.0f - breach_factor);
+  }
+
+  // Emergency lights provide some heat
+  if (systemOn(sub, SYS_EMERGENCY_LIGHTING))
+    target += 2.0f;
+
+  return target;
+}
+
+void thermalNetworkBuild(const SubmarineState *sub, ThermalNetwork *net)
+{
+  const SimParameters *params = activeSimParameters();
+  bool pumps_powered = sub->battery_level > 5.0f || systemOn(sub, SYS_BACKUP_POWER);
+  bool cooler_powered = sub->battery_level > 10.0f || systemOn(sub, SYS_BACKUP_POWER);
+
+  // Fission heat at the rate the neutronics left for this step (kinetics.c)
+  net->core_heat = params->reactor_fission_heat_rate * sub->neutron_power;
+  net->core_feedback = 0.0f;
+  bool running = systemOn(sub, SYS_REACTOR) && !systemOn(sub, SYS_CONTROL_RODS_INSERTED);
+  if (!running && sub->reactor_temp > 20.0f)
+  {
+    // Decay heat - reactors stay hot even when shut down, floored at 10%
+    if (sub->reactor_temp > REACTOR_NORMAL_TEMP * 0.1f)
+      net->core_feedback = params->reactor_residual_heat_rate / REACTOR_NORMAL_TEMP;
+    else
+      net->core_heat += params->reactor_residual_heat_rate * 0.1f;
+  }
+
+  net->core_coolant = systemOn(sub, SYS_COOLANT_PUMPS) && pumps_powered ? params->thermal_pumped_conductance : params->thermal_natural_conductance;
+  net->coolant_steam = systemOn(sub, SYS_STEAM_GENERATOR) ? params->thermal_steam_conductance : params->thermal_steam_idle_conductance;
+  net->steam_sea = systemOn(sub, SYS_POWER_TURBINE) ? params->thermal_turbine_conductance : params->thermal_turbine_idle_conductance;
+  net->coolant_sea = params->thermal_sea_conductance + (systemOn(sub, SYS_EMERGENCY_COOLING) ? params->thermal_emergency_conductance : 0.0f);
+  net->coolant_cabin = params->thermal_cabin_conductance;
+  net->cabin_environment = params->thermal_environment_conductance;
+
+  net->sea_temp = sub->water_temperature;
+  net->cabin_target = cabinTarget(sub);
+  net->cooler_temp = sub->water_temperature + params->thermal_cooler_setpoint;
+
+  // The active cooler only pulls heat out, and only while the loop is above its setpoint
+  net->cooler = 0.0f;
+  bool cooler_ready = systemOn(sub, SYS_COOLING) && cooler_powered && !systemOn(sub, SYS_REACTOR_DESTROYED) &&
+                      (systemOn(sub, SYS_COOLANT_PUMPS) || systemOn(sub, SYS_EMERGENCY_COOLING));
+  if (cooler_ready && sub->coolant_temp > net->cooler_temp)
+  {
+    net->cooler = params->thermal_cooler_conductance;
+    if (systemOn(sub, SYS_EMERGENCY_COOLING))
+      net->cooler *= systemOn(sub, SYS_COOLANT_PUMPS) ? 1.6f : 1.3f; // Emergency loop adds capacity
+  }
+}
+
+// dT/dt of every node
+static ThermalNodes thermalRates(const ThermalNetwork *net, const ThermalNodes *t)
+{
+  const SimParameters *params = activeSimParameters();
+  float to_core = net->core_coolant * (t->coolant - t->core);
+  float to_steam = net->coolant_steam * (t->coolant - t->steam_generator);
+  float to_cabin = net->coolant_cabin * (t->coolant - t->cabin);
+
+  return (ThermalNodes){
+      .core = (net->core_heat + net->core_feedback * t->core + to_core) / params->thermal_core_capacity,
+      .coolant = (-to_core - to_steam - to_cabin + net->coolant_sea * (net->sea_temp - t->coolant) +
+                  net->cooler * (net->cooler_temp - t->coolant)) /
+                 params->thermal_coolant_capacity,
+      .steam_generator = (to_steam + net->steam_sea * (net->sea_temp - t->steam_generator)) / params->thermal_steam_capacity,
+      .cabin = (to_cabin + net->cabin_environment * (net->cabin_target - t->cabin)) / params->thermal_cabin_capacity,
+  };
+}
+
+// Solve x - h * rates(x) = r. Each leaf is linear in the coolant temperature,
+// x_leaf = p + q * x_coolant, so substituting them leaves one scalar equation.
+static ThermalNodes thermalSolve(const ThermalNetwork *net, const ThermalNodes *r, float h)
+{
+  const SimParameters *params = activeSimParameters();
+  float core_d = params->thermal_core_capacity + h * (net->core_coolant - net->core_feedback);
+  float core_p = (params->thermal_core_capacity * r->core + h * net->core_heat) / core_d;
+  float core_q = h * net->core_coolant / core_d;
+
+  float steam_d = params->thermal_steam_capacity + h * (net->coolant_steam + net->steam_sea);
+  float steam_p = (params->thermal_steam_capacity * r->steam_generator + h * net->steam_sea * net->sea_temp) / steam_d;
+  float steam_q = h * net->coolant_steam / steam_d;
+
+  float cabin_d = params->thermal_cabin_capacity + h * (net->coolant_cabin + net->cabin_environment);
+  float cabin_p = (params->thermal_cabin_capacity * r->cabin + h * net->cabin_environment * net->cabin_target) / cabin_d;
+  float cabin_q = h * net->coolant_cabin / cabin_d;
+
+  float coolant_d = params->thermal_coolant_capacity +
+                    h * (net->core_coolant * (1.0f - core_q) + net->coolant_steam * (1.0f - steam_q) +
+                         net->coolant_cabin * (1.0f - cabin_q) + net->coolant_sea + net->cooler);
+  float coolant = (params->thermal_coolant_capacity * r->coolant +
+                   h * (net->core_coolant * core_p + net->coolant_steam * steam_p + net->coolant_cabin * cabin_p +
+                        net->coolant_sea * net->sea_temp + net->cooler * net->cooler_temp)) /
+                  coolant_d;
+
+  return (ThermalNodes){
+      .core = core_p + core_q * coolant,
+      .coolant = coolant,
+      .steam_generator = steam_p + steam_q * coolant,
+      .cabin = cabin_p + cabin_q * coolant,
+  };
+}
+
+void thermalNetworkStep(const ThermalNetwork *net, ThermalNodes *nodes, float deltaTime)
+{
+  const ThermalNodes t0 = *nodes;
+
+  // Trapezoid stage to gamma * dt
+  float h = 0.5f * TRBDF2_GAMMA * deltaTime;
+  ThermalNodes rate = thermalRates(net, &t0);
+  ThermalNodes r = {
+      t0.core + h * rate.core,
+      t0.coolant + h * rate.coolant,
+      t0.steam_generator + h * rate.steam_generator,
+      t0.cabin + h * rate.cabin,
+  };
+  ThermalNodes tg = thermalSolve(net, &r, h);
+
+  // BDF2 stage from t0 and the trapezoid point to dt
+  r = (ThermalNodes){
+      TRBDF2_A * tg.core - TRBDF2_B * t0.core,
+      TRBDF2_A * tg.coolant - TRBDF2_B * t0.coolant,
+      TRBDF2_A * tg.steam_generator - TRBDF2_B * t0.steam_generator,
+      TRBDF2_A * tg.cabin - TRBDF2_B * t0.cabin,
+  };
+  *nodes = thermalSolve(net, &r, TRBDF2_W * deltaTime);
+}
+
+void updateThermalNetwork(SubmarineState *sub, float deltaTime)
+{
+  ThermalNetwork net;
+  thermalNetworkBuild(sub, &net);
+
+  ThermalNodes nodes = {sub->reactor_temp, sub->coolant_temp, sub->steam_generator_temp, sub->hull_temperature};
+  thermalNetworkStep(&net, &nodes, deltaTime);
+
+  // Nothing in the loop is colder than the sea around it
+  sub->reactor_temp = MAX(sub->water_temperature, nodes.core);
+  sub->coolant_temp = MAX(sub->water_temperature, nodes.coolant);
+  sub->steam_generator_temp = MAX(sub->water_temperature, nodes.steam_generator);
+  sub->hull_temperature = MAX(-10.0f, MIN(80.0f, nodes.cabin)); // Reasonable limits
+}
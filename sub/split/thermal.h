@@ -0,0 +1,63 @@
+#ifndef THERMAL_H
+#define THERMAL_H
+
+#include "constants.h"
+
+// Lumped reactor thermal network. Four nodes hang off the coolant loop like a
+// star - core, steam generator and cabin air (hull_temperature) each exchange
+// heat only with the coolant and with their own fixed boundary (fission heat,
+// the sea through the condenser, the cabin's environment target):
+//
+//   core --- coolant --- steam generator --- sea
+//               |
+//               +--- sea (hull losses, emergency cooling, active cooler)
+//               |
+//   cabin ------+--- cabin environment target
+//
+// Heat is in core-°C (the core capacity is 1), conductances in heat per
+// second per °C. The step is TR-BDF2 - L-stable and second order - with the
+// fission runaway term inside the implicit matrix, so steps of several
+// seconds stay accurate and never blow up. The star shape makes each implicit
+// solve a closed-form elimination of three leaves into the coolant equation.
+
+// TR-BDF2 coefficients: a trapezoid stage to gamma * dt, then BDF2 to dt
+#define TRBDF2_GAMMA 0.58578644f // 2 - sqrt(2)
+#define TRBDF2_W 0.29289322f     // (1 - gamma) / (2 - gamma), BDF2 stage weight
+#define TRBDF2_A 1.20710678f     // 1 / (gamma * (2 - gamma))
+#define TRBDF2_B 0.20710678f     // (1 - gamma)^2 / (gamma * (2 - gamma))
+
+typedef struct
+{
+  float core;
+  float coolant;
+  float steam_generator;
+  float cabin;
+} ThermalNodes;
+
+// Everything the step needs, frozen for the step from the state at its start
+typedef struct
+{
+  float core_heat;     // Constant part of the core heat source
+  float core_feedback; // dHeat/dT of the core (runaway / decay heat), solved implicitly
+  float core_coolant;  // Conductances
+  float coolant_steam;
+  float steam_sea;
+  float coolant_sea;
+  float coolant_cabin;
+  float cabin_environment;
+  float cooler;      // Active cooling loop on the coolant, 0 when idle
+  float sea_temp;    // Boundary temperatures
+  float cabin_target;
+  float cooler_temp;
+} ThermalNetwork;
+
+// Conductances and sources for the current switches, power and sea
+void thermalNetworkBuild(const SubmarineState *sub, ThermalNetwork *net);
+
+// Advance the node temperatures by deltaTime (any size)
+void thermalNetworkStep(const ThermalNetwork *net, ThermalNodes *nodes, float deltaTime);
+
+// Build + step on the state's own temperatures
+void updateThermalNetwork(SubmarineState *sub, float deltaTime);
+
+#endif
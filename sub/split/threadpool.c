@@ -0,0 +1,139 @@
+#define _GNU_SOURCE
+#include "threadpool.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct ThreadPool
+{
+  pthread_t *threads;
+  int thread_count; // Spawned helpers - the caller is the extra worker
+
+  pthread_mutex_t lock;
+  pthread_cond_t work_ready;
+  pthread_cond_t work_done;
+
+  // Current batch
+  ThreadPoolJob job;
+  void *ctx;
+  int count;
+  int next_index;     // Claimed with atomics, no lock needed
+  int busy_threads;   // Helpers still inside the current batch
+  unsigned int batch; // Bumped for every parallel-for
+  bool shutdown;
+};
+
+static void runJobs(ThreadPool *pool)
+{
+  for (;;)
+  {
+    int index = __atomic_fetch_add(&pool->next_index, 1, __ATOMIC_RELAXED);
+    if (index >= pool->count)
+      break;
+    pool->job(index, pool->ctx);
+  }
+}
+
+static void *workerMain(void *arg)
+{
+  ThreadPool *pool = arg;
+  unsigned int seen_batch = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;)
+  {
+    while (!pool->shutdown && pool->batch == seen_batch)
+      pthread_cond_wait(&pool->work_ready, &pool->lock);
+    if (pool->shutdown)
+      break;
+
+    seen_batch = pool->batch;
+    pthread_mutex_unlock(&pool->lock);
+
+    runJobs(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->busy_threads == 0)
+      pthread_cond_signal(&pool->work_done);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+int threadPoolDefaultWorkers(void)
+{
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores > 0 ? (int)cores : 1;
+}
+
+ThreadPool *threadPoolCreate(int workers)
+{
+  if (workers <= 0)
+    workers = threadPoolDefaultWorkers();
+
+  ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+  if (!pool)
+    return NULL;
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work_ready, NULL);
+  pthread_cond_init(&pool->work_done, NULL);
+
+  pool->threads = calloc(workers, sizeof(pthread_t));
+  for (int i = 0; pool->threads && i < workers - 1; i++)
+  {
+    if (pthread_create(&pool->threads[pool->thread_count], NULL, workerMain, pool) != 0)
+      break; // Run with whatever we got - just the caller if even the list didn't fit
+    pool->thread_count++;
+  }
+  return pool;
+}
+
+int threadPoolWorkerCount(const ThreadPool *pool)
+{
+  return pool->thread_count + 1;
+}
+
+void threadPoolParallelFor(ThreadPool *pool, int count, ThreadPoolJob job, void *ctx)
+{
+  if (count <= 0)
+    return;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->job = job;
+  pool->ctx = ctx;
+  pool->count = count;
+  pool->next_index = 0;
+  pool->busy_threads = pool->thread_count;
+  pool->batch++;
+  pthread_cond_broadcast(&pool->work_ready);
+  pthread_mutex_unlock(&pool->lock);
+
+  runJobs(pool);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->busy_threads > 0)
+    pthread_cond_wait(&pool->work_done, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void threadPoolDestroy(ThreadPool *pool)
+{
+  if (!pool)
+    return;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = true;
+  pthread_cond_broadcast(&pool->work_ready);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < pool->thread_count; i++)
+    pthread_join(pool->threads[i], NULL);
+
+  pthread_cond_destroy(&pool->work_done);
+  pthread_cond_destroy(&pool->work_ready);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->threads);
+  free(pool);
+}
@@ -0,0 +1,17 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+// Tiny persistent worker pool with a blocking parallel-for.
+// The calling thread works too, so a pool of N runs N jobs at once.
+
+typedef void (*ThreadPoolJob)(int index, void *ctx);
+
+typedef struct ThreadPool ThreadPool;
+
+int threadPoolDefaultWorkers(void);                    // One per online core
+ThreadPool *threadPoolCreate(int workers);             // workers <= 0 means one per core, NULL if out of memory
+int threadPoolWorkerCount(const ThreadPool *pool);     // Including the caller
+void threadPoolParallelFor(ThreadPool *pool, int count, ThreadPoolJob job, void *ctx);
+void threadPoolDestroy(ThreadPool *pool);
+
+#endif
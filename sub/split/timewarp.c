@@ -0,0 +1,160 @@
+#include "timewarp.h"
+
+// Endurance rates are smoothed over roughly this much sim time
+#define TIMEWARP_RATE_WINDOW 60.0f
+
+// A checked step costs three model calls, so a 2-tick step that can't grow is
+// worse than plain ticks - fall back to those for a while before probing again
+#define TIMEWARP_PROBE_TICKS 32
+
+static const int warpFactors[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+#define WARP_FACTOR_COUNT ((int)(sizeof(warpFactors) / sizeof(warpFactors[0])))
+
+TimeWarp initTimeWarp(void)
+{
+  return (TimeWarp){.factor = 1, .step = 1};
+}
+
+int timeWarpNextFactor(int factor, int direction)
+{
+  int i = 0;
+  while (i < WARP_FACTOR_COUNT - 1 && warpFactors[i] < factor)
+    i++;
+  i = MAX(0, MIN(WARP_FACTOR_COUNT - 1, i + direction));
+  return warpFactors[i];
+}
+
+// Largest step allowed at this factor - at most `factor` ticks, so a step
+// never covers more than one real-time tick of wall clock at low factors
+static uint32_t maxStep(int factor)
+{
+  uint32_t cap = 1;
+  while (cap * 2 <= (uint32_t)factor && cap * 2 <= TIMEWARP_MAX_STEP_TICKS)
+    cap *= 2;
+  return cap;
+}
+
+bool timeWarpCommand(TimeWarp *warp, SubmarineState *sub, SubmarineCommand cmd)
+{
+  // Whatever the crew just did, resolve its effect from a single tick up
+  warp->step = 1;
+  warp->hold = 0;
+
+  if (cmd.type == CMD_TIME_COMPRESSION)
+  {
+    warp->factor = (int)MAX(1.0f, MIN((float)TIMEWARP_MAX_FACTOR, cmd.value));
+    warp->dropped = false;
+    return true;
+  }
+  return applySubmarineCommand(sub, cmd);
+}
+
+// Worst field error of the whole step against the two halves, 1 = at tolerance
+static float stepError(const SubmarineState *whole, const SubmarineState *halves)
+{
+  float error = 0.0f;
+#define WARP_FIELD_ERROR(field, tolerance)                                                            \
+  error = MAX(error, fabsf(whole->field - halves->field) /                                         \
+                         ((tolerance) + TIMEWARP_RELATIVE_ERROR * fmaxf(fabsf(whole->field), fabsf(halves->field))));
+  TIMEWARP_ERROR_FIELDS(WARP_FIELD_ERROR)
+#undef WARP_FIELD_ERROR
+  return error;
+}
+
+static void updateRates(TimeWarp *warp, const SubmarineState *before, const SubmarineState *after, float seconds)
+{
+  float blend = MIN(1.0f, seconds / TIMEWARP_RATE_WINDOW);
+  warp->battery_rate += ((after->battery_level - before->battery_level) / seconds - warp->battery_rate) * blend;
+  warp->oxygen_rate += ((after->oxygen - before->oxygen) / seconds - warp->oxygen_rate) * blend;
+}
+
+uint32_t timeWarpStep(TimeWarp *warp, SubmarineState *sub, uint32_t max_ticks)
+{
+  if (max_ticks == 0)
+    return 0;
+
+  // Real time is the plain fixed-step clock
+  if (warp->factor <= 1)
+  {
+    updateSubmarineState(sub, SIM_TICK_DT);
+    warp->steps++;
+    warp->evaluations++;
+    return 1;
+  }
+
+  uint32_t cap = maxStep(warp->factor);
+  SubmarineState before = *sub;
+  uint32_t step = MIN(warp->step, cap);
+  while (step > max_ticks)
+    step /= 2;
+
+  for (;;)
+  {
+    if (step == 1)
+    {
+      updateSubmarineState(sub, SIM_TICK_DT);
+      warp->evaluations++;
+      if (warp->hold > 0)
+        warp->hold--;
+      else if (sub->systems == before.systems)
+        warp->step = MIN(2, cap);
+      break;
+    }
+
+    SubmarineState whole = before, halves = before;
+    updateSubmarineState(&whole, step * SIM_TICK_DT);
+    updateSubmarineState(&halves, step / 2 * SIM_TICK_DT);
+    uint64_t midway = halves.systems;
+    updateSubmarineState(&halves, step / 2 * SIM_TICK_DT);
+    warp->evaluations += 3;
+
+    // A switch flipping inside the step gets narrowed down to its exact tick
+    bool event = whole.systems != before.systems || midway != before.systems || halves.systems != before.systems;
+    float error = event ? 2.0f : stepError(&whole, &halves);
+    if (error <= 1.0f)
+    {
+      *sub = halves;
+      warp->step = error < 0.25f ? MIN(step * 2, cap) : step;
+      if (warp->step == 2)
+      {
+        warp->step = 1;
+        warp->hold = TIMEWARP_PROBE_TICKS;
+      }
+      break;
+    }
+    warp->rejected++;
+    step /= 2;
+  }
+
+  warp->steps++;
+  updateRates(warp, &before, sub, step * SIM_TICK_DT);
+
+  // The boat switched something itself (scram, cascade, surfaced): back to real time
+  if (sub->systems != before.systems)
+  {
+    warp->factor = 1;
+    warp->step = 1;
+    warp->hold = 0;
+    warp->dropped = true;
+  }
+  return step;
+}
+
+uint32_t timeWarpAdvance(TimeWarp *warp, SubmarineState *sub, uint32_t budget, uint32_t stop)
+{
+  uint32_t done = 0;
+  warp->dropped = false;
+
+  // Whole steps only - one that doesn't fit waits for the next budget, unless
+  // the stop is within reach: then timeWarpStep halves it down to land there
+  bool landing = stop <= budget;
+  budget = MIN(budget, stop);
+  while (done < budget && (warp->factor <= 1 || landing || MIN(warp->step, maxStep(warp->factor)) <= budget - done))
+  {
+    bool compressed = warp->factor > 1;
+    done += timeWarpStep(warp, sub, budget - done);
+    if (compressed && warp->dropped)
+      break;
+  }
+  return done;
+}
@@ -0,0 +1,78 @@
+#ifndef TIMEWARP_H
+#define TIMEWARP_H
+
+#include "constants.h"
+
+// Time compression (x1 to x1000). Above x1 the model is advanced in adaptive
+// steps of 2^k ticks: each step is taken once whole and once as two halves,
+// and the halves are kept only if both agree within the tolerances below.
+// Fast processes (ballast fill, emergency surface, autopilot corrections)
+// shrink the step back towards single ticks, slow drifts on patrol run at
+// several seconds per updateSubmarineState call.
+//
+// The step schedule depends only on the state, never on frame timing: a step
+// that doesn't fit the tick budget waits for the next call. The one exception
+// is a tick the clock must stop on (a scenario event) - steps shorten to land
+// on it exactly. That keeps compressed sessions replayable from the journal
+// (time_compression commands), which stops on every command the same way.
+
+#define TIMEWARP_MAX_FACTOR 1000
+#define TIMEWARP_MAX_STEP_TICKS 512 // ~4.3 s of sim time per model call
+
+// Per-field error allowed for one step: this absolute part (state units)
+// plus TIMEWARP_RELATIVE_ERROR of the value
+#define TIMEWARP_RELATIVE_ERROR 0.002f
+#define TIMEWARP_ERROR_FIELDS(X) \
+  X(depth, 0.5f)                 \
+  X(vertical_speed, 0.05f)       \
+  X(ballast_level, 0.5f)         \
+  X(trim_angle, 0.1f)            \
+  X(oxygen, 0.02f)               \
+  X(battery_level, 0.02f)        \
+  X(hull_integrity, 0.02f)       \
+  X(nitrogen_level, 0.05f)       \
+  X(reactor_temp, 0.5f)          \
+  X(coolant_temp, 0.5f)          \
+  X(hull_temperature, 0.2f)
+
+typedef struct
+{
+  int factor;         // Sim seconds per wall second, 1 = real time
+  uint32_t step;      // Proposed step in ticks, power of two
+  uint32_t hold;      // Plain ticks left before trying to grow past one tick again
+  bool dropped;       // Last advance fell back to x1 because the boat changed a switch itself
+  float battery_rate; // Smoothed %/sim-second, for endurance estimates
+  float oxygen_rate;
+
+  // Counters since the warp was created
+  uint64_t steps;
+  uint64_t rejected;
+  uint64_t evaluations; // updateSubmarineState calls
+} TimeWarp;
+
+TimeWarp initTimeWarp(void);
+
+// Factor ladder for the +/- keys (1, 2, 5, 10, 20 ... 1000)
+int timeWarpNextFactor(int factor, int direction);
+
+// Commands go through here instead of applySubmarineCommand: CMD_TIME_COMPRESSION
+// changes the factor, every command restarts the step at one tick
+bool timeWarpCommand(TimeWarp *warp, SubmarineState *sub, SubmarineCommand cmd);
+
+// One accepted step of at most max_ticks (the proposal shrinks to fit).
+// Returns the ticks it covered - 1 at real time.
+uint32_t timeWarpStep(TimeWarp *warp, SubmarineState *sub, uint32_t max_ticks);
+
+// Advance by whole steps, at most budget ticks, stopping early if the warp
+// drops to x1. When stop (UINT32_MAX for none) is within the budget the steps
+// shorten to end exactly there. Returns the ticks run (0 when the next step
+// doesn't fit yet). Frame loops and replays use this one so the schedule
+// ignores frame timing.
+uint32_t timeWarpAdvance(TimeWarp *warp, SubmarineState *sub, uint32_t budget, uint32_t stop);
+
+#ifndef SUB_HEADLESS
+// Compact status screen drawn instead of the cockpit while compressed (renderer.c)
+void renderTimeWarpSummary(const SubmarineState *sub, const TimeWarp *warp, uint64_t tick);
+#endif
+
+#endif